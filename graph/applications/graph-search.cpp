@@ -40,6 +40,7 @@
 #include <snark/graph/search_graph.h>
 #include <snark/graph/serialization.h>
 #include <snark/graph/traits.h>
+#include <snark/io/record_store.h>
 #include <snark/visiting/traits.h>
 #include <boost/static_assert.hpp>
 
@@ -121,10 +122,11 @@ typedef snark::search_graph< node, edge > search_graph_t;
 typedef search_graph_t::type graph_t;
 typedef search_graph_t::vertex_iter vertex_iterator;
 typedef search_graph_t::vertex_desc vertex_descriptor;
-typedef boost::unordered_map< comma::uint32, std::string > records_t;
+typedef boost::unordered_map< comma::uint32, snark::record_store::offset_type > records_t;
 static bool verbose = false;
 static graph_t graph;
 static records_t records;
+static snark::record_store record_store;
 
 static void load_( graph_t& graph, const comma::csv::options& node_csv, const comma::csv::options& edge_csv )
 {
@@ -150,11 +152,17 @@ static void load_records_( records_t& r, const comma::csv::options& csv )
     {
         const search_graph_t::node* v = stream.read();
         if( !v ) { break; }
-        r[ v->id ] = csv.binary() ? std::string( stream.binary().last(), csv.format().size() ) : ( comma::join( stream.ascii().last(), csv.delimiter ) );
+        r[ v->id ] = csv.binary() ? record_store.append( stream.binary().last(), csv.format().size() ) : record_store.append( stream.ascii().last(), csv.delimiter );
     }
     ifs.close();
 }
 
+static void write_record_( comma::uint32 id )
+{
+    records_t::const_iterator it = records.find( id );
+    if( it != records.end() ) { std::cout.write( record_store.data( it->second ), record_store.size( it->second ) ); }
+}
+
 static double objective_function( const node& n ) { return -n.distance; }
 
 static boost::optional< node > advance( const node& from, const node& to ) { return node( to.position, from.distance + ( to.position - from.position ).norm() ); }
@@ -213,8 +221,7 @@ int main( int ac, char** av )
             const std::vector< vertex_descriptor >& p = best_path( *source_id, *target_id );
             for( std::size_t i = 0; i < p.size(); ++i )
             {
-                const std::string& s = records[ graph[ p[i] ].id ];
-                std::cout.write( &s[0], s.size() );
+                write_record_( graph[ p[i] ].id );
                 if( !node_csv.binary() ) { std::cout << std::endl; }
             }
         }
@@ -235,8 +242,7 @@ int main( int ac, char** av )
                     if( p.empty() ) { std::cerr << "graph-search: failed to find path from " << last_id << " to " << r->id << std::endl; return 1; }
                     for( std::size_t i = 0; i < p.size(); ++i )
                     {
-                        const std::string& s = records[ graph[ p[i] ].id ];
-                        std::cout.write( &s[0], s.size() );
+                        write_record_( graph[ p[i] ].id );
                         if( !node_csv.binary() ) { std::cout << csv.delimiter; }
                         std::cout.write( &last[0], last.size() );
                         if( !node_csv.binary() ) { std::cout << std::endl; }
@@ -0,0 +1,117 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_IO_BLOCK_READER_H
+#define SNARK_IO_BLOCK_READER_H
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
+#include <comma/base/types.h>
+#include <comma/csv/options.h>
+#include <comma/csv/stream.h>
+#include <comma/string/string.h>
+#include <snark/io/record_store.h>
+
+namespace snark {
+
+/// read csv stream block by block, i.e. in runs of consecutive records with the same block field,
+/// keeping input records in a record store, e.g. to echo them to output
+///
+/// the first record read does not belong to the block, since the block changes on it;
+/// it is kept and becomes the first record of the next block
+///
+/// the block id is taken from the first record of the stream, whatever its value
+///
+/// T: record type with comma::uint32 member block
+///
+/// usage:
+///     block_reader< input_t > reader( std::cin, csv );
+///     std::vector< block_reader< input_t >::record_type > points;
+///     record_store records;
+///     while( reader.read( points, records ) ) { ...; points.clear(); records.clear(); }
+template < typename T >
+class block_reader
+{
+    public:
+        /// record and offset of its input line in record store
+        typedef std::pair< T, record_store::offset_type > record_type;
+
+        /// constructor
+        block_reader( std::istream& is, const comma::csv::options& csv ) : csv_( csv ), istream_( is, csv ), is_( is ) {}
+
+        /// append records of the next block to records and their input lines to store
+        /// @return false, if there are no more records
+        bool read( std::vector< record_type >& records, record_store& store );
+
+        /// return id of the last block read
+        comma::uint32 block() const { return block_; }
+
+    private:
+        comma::csv::options csv_;
+        comma::csv::input_stream< T > istream_;
+        std::istream& is_;
+        boost::optional< T > last_;
+        std::string last_record_;
+        comma::uint32 block_;
+};
+
+template < typename T >
+inline bool block_reader< T >::read( std::vector< typename block_reader< T >::record_type >& records, record_store& store )
+{
+    std::size_t size = records.size();
+    if( last_ )
+    {
+        block_ = last_->block;
+        records.push_back( std::make_pair( *last_, store.append( last_record_ ) ) );
+        last_.reset();
+    }
+    while( !is_.bad() && !is_.eof() )
+    {
+        const T* p = istream_.read();
+        if( !p ) { break; }
+        if( records.size() == size ) { block_ = p->block; } // first record of the stream
+        else if( p->block != block_ )
+        {
+            last_ = *p;
+            if( csv_.binary() ) { last_record_.assign( istream_.binary().last(), csv_.format().size() ); }
+            else { last_record_ = comma::join( istream_.ascii().last(), csv_.delimiter ); }
+            break;
+        }
+        records.push_back( std::make_pair( *p, csv_.binary() ? store.append( istream_.binary().last(), csv_.format().size() ) : store.append( istream_.ascii().last(), csv_.delimiter ) ) );
+    }
+    return records.size() > size;
+}
+
+} // namespace snark {
+
+#endif // SNARK_IO_BLOCK_READER_H
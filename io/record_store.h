@@ -0,0 +1,231 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_IO_RECORD_STORE_H
+#define SNARK_IO_RECORD_STORE_H
+
+#ifndef WIN32
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <comma/base/exception.h>
+#include <comma/base/types.h>
+
+namespace snark {
+
+/// append-only store of raw records, e.g. binary or ascii csv input records that applications echo to output
+///
+/// records are copied one after another into large arenas, each record prefixed by its size;
+/// append() returns an offset, which remains valid until clear() or destruction
+///
+/// arenas are anonymous memory maps: pages get committed only when written to,
+/// thus a large arena costs address space, not memory; if spill directory is given,
+/// arenas are mapped to unlinked temporary files in it, so that under memory pressure
+/// the system writes them back to those files rather than to swap
+///
+/// clear() keeps arenas for reuse, e.g. for the next block of points
+///
+/// @note on windows, arenas are allocated on the heap and spill directory is not supported
+class record_store : public boost::noncopyable
+{
+    public:
+        typedef comma::uint64 offset_type;
+
+        enum { default_arena_size = 64 * 1024 * 1024 };
+
+        /// constructor
+        /// @param arena_size arena size in bytes; a record larger than that gets an arena of its own
+        /// @param spill_directory if not empty, map arenas to temporary files in this directory
+        record_store( std::size_t arena_size = default_arena_size, const std::string& spill_directory = "" );
+
+        /// destructor, unmap arenas
+        ~record_store();
+
+        /// append record, return its offset
+        offset_type append( const char* data, std::size_t size );
+
+        /// append record, return its offset
+        offset_type append( const std::string& s ) { return append( s.data(), s.size() ); }
+
+        /// append fields joined by delimiter, e.g. ascii csv record, without making a string first
+        offset_type append( const std::vector< std::string >& fields, char delimiter );
+
+        /// return record data
+        const char* data( offset_type offset ) const { return at_( offset ) + sizeof( comma::uint32 ); }
+
+        /// return record size
+        std::size_t size( offset_type offset ) const { comma::uint32 s; ::memcpy( &s, at_( offset ), sizeof( comma::uint32 ) ); return s; }
+
+        /// return number of records
+        std::size_t size() const { return size_; }
+
+        /// return number of bytes in use, including record size prefixes
+        comma::uint64 bytes() const { return bytes_; }
+
+        /// return number of mapped arenas
+        std::size_t arenas() const { return arenas_.size(); }
+
+        /// forget all records; arenas are kept for reuse
+        void clear();
+
+    private:
+        struct arena_
+        {
+            char* data;
+            std::size_t size;
+            std::size_t used;
+        };
+        std::vector< arena_ > arenas_;
+        std::size_t current_;
+        std::size_t arena_size_;
+        std::string spill_directory_;
+        std::size_t size_;
+        comma::uint64 bytes_;
+
+        enum { position_bits = 40 }; // offset: arena index in high bits, position in arena in low bits
+        const char* at_( offset_type offset ) const { return arenas_[ offset >> position_bits ].data + ( offset & ( ( offset_type( 1 ) << position_bits ) - 1 ) ); }
+        char* reserve_( std::size_t size, offset_type& offset );
+        arena_ map_( std::size_t size ) const;
+        static void unmap_( const arena_& a );
+};
+
+inline record_store::record_store( std::size_t arena_size, const std::string& spill_directory )
+    : current_( 0 )
+    , arena_size_( arena_size )
+    , spill_directory_( spill_directory )
+    , size_( 0 )
+    , bytes_( 0 )
+{
+    if( arena_size_ == 0 ) { COMMA_THROW( comma::exception, "expected positive arena size" ); }
+    #ifdef WIN32
+    if( !spill_directory_.empty() ) { COMMA_THROW( comma::exception, "spill directory not supported on windows" ); }
+    #endif
+}
+
+inline record_store::~record_store() { for( std::size_t i = 0; i < arenas_.size(); ++i ) { unmap_( arenas_[i] ); } }
+
+inline record_store::offset_type record_store::append( const char* data, std::size_t size )
+{
+    offset_type offset;
+    char* p = reserve_( size, offset );
+    ::memcpy( p, data, size );
+    return offset;
+}
+
+inline record_store::offset_type record_store::append( const std::vector< std::string >& fields, char delimiter )
+{
+    std::size_t size = fields.empty() ? 0 : fields.size() - 1;
+    for( std::size_t i = 0; i < fields.size(); ++i ) { size += fields[i].size(); }
+    offset_type offset;
+    char* p = reserve_( size, offset );
+    for( std::size_t i = 0; i < fields.size(); ++i )
+    {
+        if( i > 0 ) { *p++ = delimiter; }
+        ::memcpy( p, fields[i].data(), fields[i].size() );
+        p += fields[i].size();
+    }
+    return offset;
+}
+
+inline void record_store::clear()
+{
+    for( std::size_t i = 0; i < arenas_.size(); ++i ) { arenas_[i].used = 0; }
+    current_ = 0;
+    size_ = 0;
+    bytes_ = 0;
+}
+
+inline char* record_store::reserve_( std::size_t size, offset_type& offset )
+{
+    if( size > 0xffffffff ) { COMMA_THROW( comma::exception, "expected record size not greater than 4GB; got " << size << " bytes" ); }
+    std::size_t total = size + sizeof( comma::uint32 );
+    while( current_ < arenas_.size() && arenas_[ current_ ].used + total > arenas_[ current_ ].size ) { ++current_; }
+    if( current_ == arenas_.size() )
+    {
+        if( arenas_.size() >= ( std::size_t( 1 ) << ( 64 - position_bits ) ) ) { COMMA_THROW( comma::exception, "too many arenas: " << arenas_.size() ); }
+        arenas_.push_back( map_( total > arena_size_ ? total : arena_size_ ) );
+    }
+    arena_& a = arenas_[ current_ ];
+    offset = ( offset_type( current_ ) << position_bits ) | a.used;
+    char* p = a.data + a.used;
+    comma::uint32 s = size;
+    ::memcpy( p, &s, sizeof( comma::uint32 ) );
+    a.used += total;
+    ++size_;
+    bytes_ += total;
+    return p + sizeof( comma::uint32 );
+}
+
+inline record_store::arena_ record_store::map_( std::size_t size ) const
+{
+    arena_ a;
+    a.size = size;
+    a.used = 0;
+    #ifdef WIN32
+    a.data = new char[ size ];
+    #else
+    void* p;
+    if( spill_directory_.empty() )
+    {
+        p = ::mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    }
+    else
+    {
+        std::string name = spill_directory_ + "/snark-record-store-XXXXXX";
+        int fd = ::mkstemp( &name[0] );
+        if( fd < 0 ) { COMMA_THROW( comma::exception, "failed to create temporary file in " << spill_directory_ ); }
+        ::unlink( name.c_str() ); // quick and dirty: the file is removed once unmapped, even if we crash
+        if( ::ftruncate( fd, size ) != 0 ) { ::close( fd ); COMMA_THROW( comma::exception, "failed to resize temporary file in " << spill_directory_ << " to " << size << " bytes" ); }
+        p = ::mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+        ::close( fd ); // the mapping keeps the file
+    }
+    if( p == MAP_FAILED ) { COMMA_THROW( comma::exception, "failed to memory-map arena of " << size << " bytes" ); }
+    a.data = reinterpret_cast< char* >( p );
+    #endif
+    return a;
+}
+
+inline void record_store::unmap_( const record_store::arena_& a )
+{
+    #ifdef WIN32
+    delete[] a.data;
+    #else
+    ::munmap( a.data, a.size );
+    #endif
+}
+
+} // namespace snark {
+
+#endif // SNARK_IO_RECORD_STORE_H
@@ -0,0 +1,133 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <comma/base/types.h>
+#include <comma/visiting/traits.h>
+#include <snark/io/block_reader.h>
+
+namespace snark { namespace test {
+
+struct record
+{
+    double x;
+    comma::uint32 block;
+    record() : x( 0 ), block( 0 ) {}
+};
+
+} } // namespace snark { namespace test {
+
+namespace comma { namespace visiting {
+
+template <> struct traits< snark::test::record >
+{
+    template < typename K, typename V > static void visit( const K&, snark::test::record& p, V& v )
+    {
+        v.apply( "x", p.x );
+        v.apply( "block", p.block );
+    }
+
+    template < typename K, typename V > static void visit( const K&, const snark::test::record& p, V& v )
+    {
+        v.apply( "x", p.x );
+        v.apply( "block", p.block );
+    }
+};
+
+} } // namespace comma { namespace visiting {
+
+namespace snark {
+
+typedef block_reader< test::record > reader_type;
+
+static std::vector< std::string > read_block( reader_type& reader, record_store& store )
+{
+    std::vector< reader_type::record_type > records;
+    std::vector< std::string > lines;
+    if( !reader.read( records, store ) ) { return lines; }
+    for( std::size_t i = 0; i < records.size(); ++i ) { lines.push_back( std::string( store.data( records[i].second ), store.size( records[i].second ) ) ); }
+    return lines;
+}
+
+TEST( block_reader, blocks )
+{
+    std::istringstream is( "1,0\n2,0\n3,1\n4,1\n5,1\n6,3\n" );
+    comma::csv::options csv;
+    csv.fields = "x,block";
+    reader_type reader( is, csv );
+    record_store store;
+    std::vector< std::string > lines = read_block( reader, store );
+    ASSERT_EQ( 2u, lines.size() );
+    EXPECT_EQ( "1,0", lines[0] );
+    EXPECT_EQ( "2,0", lines[1] );
+    EXPECT_EQ( 0u, reader.block() );
+    lines = read_block( reader, store );
+    ASSERT_EQ( 3u, lines.size() );
+    EXPECT_EQ( "3,1", lines[0] );
+    EXPECT_EQ( "5,1", lines[2] );
+    EXPECT_EQ( 1u, reader.block() );
+    lines = read_block( reader, store );
+    ASSERT_EQ( 1u, lines.size() );
+    EXPECT_EQ( "6,3", lines[0] );
+    EXPECT_EQ( 3u, reader.block() );
+    EXPECT_TRUE( read_block( reader, store ).empty() );
+}
+
+TEST( block_reader, first_block_not_zero )
+{
+    std::istringstream is( "1,5\n2,5\n3,6\n" );
+    comma::csv::options csv;
+    csv.fields = "x,block";
+    reader_type reader( is, csv );
+    record_store store;
+    std::vector< std::string > lines = read_block( reader, store );
+    ASSERT_EQ( 2u, lines.size() );
+    EXPECT_EQ( "1,5", lines[0] );
+    EXPECT_EQ( 5u, reader.block() );
+    lines = read_block( reader, store );
+    ASSERT_EQ( 1u, lines.size() );
+    EXPECT_EQ( "3,6", lines[0] );
+    EXPECT_TRUE( read_block( reader, store ).empty() );
+}
+
+TEST( block_reader, empty )
+{
+    std::istringstream is( "" );
+    comma::csv::options csv;
+    csv.fields = "x,block";
+    reader_type reader( is, csv );
+    record_store store;
+    EXPECT_TRUE( read_block( reader, store ).empty() );
+}
+
+} // namespace snark {
@@ -0,0 +1,96 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <string>
+#include <vector>
+#include <boost/lexical_cast.hpp>
+#include <gtest/gtest.h>
+#include <snark/io/record_store.h>
+
+namespace snark {
+
+static std::string record( const record_store& s, record_store::offset_type offset ) { return std::string( s.data( offset ), s.size( offset ) ); }
+
+static std::string make_record( unsigned int i ) { return std::string( i % 23, char( 'a' + i % 26 ) ) + boost::lexical_cast< std::string >( i ); }
+
+TEST( record_store, append )
+{
+    record_store s( 64 );
+    std::vector< record_store::offset_type > offsets;
+    for( unsigned int i = 0; i < 1000; ++i ) { offsets.push_back( s.append( make_record( i ) ) ); }
+    EXPECT_EQ( s.size(), 1000u );
+    EXPECT_GT( s.arenas(), 1u );
+    for( unsigned int i = 0; i < 1000; ++i ) { EXPECT_EQ( record( s, offsets[i] ), make_record( i ) ); }
+    record_store::offset_type empty = s.append( "", 0 );
+    EXPECT_EQ( s.size( empty ), 0u );
+    std::string large( 1000, 'x' ); // larger than arena
+    record_store::offset_type offset = s.append( large );
+    EXPECT_EQ( record( s, offset ), large );
+    EXPECT_EQ( record( s, offsets[999] ), make_record( 999 ) );
+}
+
+TEST( record_store, fields )
+{
+    record_store s;
+    std::vector< std::string > fields;
+    EXPECT_EQ( record( s, s.append( fields, ',' ) ), "" );
+    fields.push_back( "1" );
+    EXPECT_EQ( record( s, s.append( fields, ',' ) ), "1" );
+    fields.push_back( "" );
+    fields.push_back( "hello" );
+    EXPECT_EQ( record( s, s.append( fields, ',' ) ), "1,,hello" );
+}
+
+TEST( record_store, clear )
+{
+    record_store s( 256 );
+    for( unsigned int i = 0; i < 1000; ++i ) { s.append( make_record( i ) ); }
+    std::size_t arenas = s.arenas();
+    s.clear();
+    EXPECT_EQ( s.size(), 0u );
+    EXPECT_EQ( s.bytes(), 0u );
+    std::vector< record_store::offset_type > offsets;
+    for( unsigned int i = 0; i < 1000; ++i ) { offsets.push_back( s.append( make_record( 1000 - i ) ) ); }
+    EXPECT_EQ( s.arenas(), arenas );
+    for( unsigned int i = 0; i < 1000; ++i ) { EXPECT_EQ( record( s, offsets[i] ), make_record( 1000 - i ) ); }
+}
+
+#ifndef WIN32
+TEST( record_store, spill )
+{
+    record_store s( 4096, "/tmp" );
+    std::vector< record_store::offset_type > offsets;
+    for( unsigned int i = 0; i < 10000; ++i ) { offsets.push_back( s.append( make_record( i ) ) ); }
+    for( unsigned int i = 0; i < 10000; ++i ) { EXPECT_EQ( record( s, offsets[i] ), make_record( i ) ); }
+    EXPECT_THROW( record_store( 4096, "/no/such/directory" ).append( "x" ), comma::exception );
+}
+#endif // #ifndef WIN32
+
+} // namespace snark {
@@ -0,0 +1,173 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <comma/base/exception.h>
+#include "./polytope_index.h"
+
+namespace snark { namespace geometry {
+
+static const std::size_t max_cells_per_polytope = 64; // quick and dirty: to keep the grid small for large sparse scenes
+
+polytope_index::polytope_index() : origin_( Eigen::Vector3d::Zero() ), resolution_( 0 ) { size_[0] = size_[1] = size_[2] = 0; }
+
+void polytope_index::add( const Eigen::Vector3d& min, const Eigen::Vector3d& max )
+{
+    Eigen::Matrix< double, 6, 3 > normals;
+    normals << 1, 0, 0
+             , 0, 1, 0
+             , 0, 0, 1
+             , -1, 0, 0
+             , 0, -1, 0
+             , 0, 0, -1;
+    Eigen::Matrix< double, 6, 1 > offsets;
+    offsets << min.x(), min.y(), min.z(), -max.x(), -max.y(), -max.z();
+    add( normals, offsets, min, max );
+}
+
+void polytope_index::add( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets, const Eigen::Vector3d& min, const Eigen::Vector3d& max )
+{
+    if( normals.cols() != 3 ) { COMMA_THROW( comma::exception, "expected normals of dimension 3, got " << normals.cols() ); }
+    if( normals.rows() > 6 ) { COMMA_THROW( comma::exception, "expected at most 6 half-spaces, got " << normals.rows() ); }
+    if( normals.rows() != offsets.rows() ) { COMMA_THROW( comma::exception, "normals and offsets should be of same size, got " << normals.rows() << " and " << offsets.rows() ); }
+    if( ( min.array() > max.array() ).any() ) { COMMA_THROW( comma::exception, "expected bounding box min not greater than max" ); }
+    polytope p;
+    p.normals.setZero(); // unused half-spaces: 0 * x >= 0, i.e. always true
+    p.offsets.setZero();
+    p.normals.topRows( normals.rows() ) = normals;
+    p.offsets.head( offsets.rows() ) = offsets;
+    p.min = min;
+    p.max = max;
+    polytopes_.push_back( p );
+    offsets_.clear(); // grid needs rebuilding
+}
+
+void polytope_index::build( double resolution )
+{
+    offsets_.clear();
+    indices_.clear();
+    if( polytopes_.empty() ) { return; }
+    Eigen::Vector3d min = polytopes_[0].min;
+    Eigen::Vector3d max = polytopes_[0].max;
+    double mean = 0;
+    for( std::size_t i = 0; i < polytopes_.size(); ++i )
+    {
+        min = min.cwiseMin( polytopes_[i].min );
+        max = max.cwiseMax( polytopes_[i].max );
+        mean += ( polytopes_[i].max - polytopes_[i].min ).maxCoeff();
+    }
+    mean /= polytopes_.size();
+    resolution_ = resolution > 0 ? resolution : mean;
+    Eigen::Vector3d extents = max - min;
+    if( !( resolution_ > 0 ) ) { resolution_ = extents.maxCoeff() > 0 ? extents.maxCoeff() : 1; } // e.g. all polytopes are flat
+    std::size_t limit = max_cells_per_polytope * polytopes_.size();
+    while( true ) // quick and dirty: coarsen the grid until it is small enough
+    {
+        double cells = 1;
+        for( unsigned int i = 0; i < 3; ++i ) { cells *= std::floor( extents[i] / resolution_ ) + 1; }
+        if( cells <= limit ) { break; }
+        resolution_ *= 2;
+    }
+    for( unsigned int i = 0; i < 3; ++i ) { size_[i] = static_cast< comma::uint32 >( std::floor( extents[i] / resolution_ ) ) + 1; }
+    origin_ = min;
+    std::size_t cells = std::size_t( size_[0] ) * size_[1] * size_[2];
+    offsets_.assign( cells + 1, 0 );
+    for( unsigned int pass = 0; pass < 2; ++pass ) // counting sort: count, then fill; polytopes remain in the order of add() in each cell
+    {
+        std::vector< comma::uint32 > positions;
+        if( pass == 1 )
+        {
+            for( std::size_t c = 1; c < offsets_.size(); ++c ) { offsets_[c] += offsets_[ c - 1 ]; }
+            indices_.resize( offsets_.back() );
+            positions.assign( offsets_.begin(), offsets_.end() - 1 );
+        }
+        for( std::size_t i = 0; i < polytopes_.size(); ++i )
+        {
+            comma::uint32 begin[3];
+            comma::uint32 end[3];
+            for( unsigned int k = 0; k < 3; ++k )
+            {
+                begin[k] = std::min( static_cast< comma::uint32 >( std::floor( ( polytopes_[i].min[k] - origin_[k] ) / resolution_ ) ), size_[k] - 1 );
+                end[k] = std::min( static_cast< comma::uint32 >( std::floor( ( polytopes_[i].max[k] - origin_[k] ) / resolution_ ) ), size_[k] - 1 ) + 1;
+            }
+            for( comma::uint32 x = begin[0]; x < end[0]; ++x )
+            {
+                for( comma::uint32 y = begin[1]; y < end[1]; ++y )
+                {
+                    for( comma::uint32 z = begin[2]; z < end[2]; ++z )
+                    {
+                        std::size_t c = ( std::size_t( x ) * size_[1] + y ) * size_[2] + z;
+                        if( pass == 0 ) { ++offsets_[ c + 1 ]; } else { indices_[ positions[c]++ ] = i; }
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool polytope_index::cell_( const Eigen::Vector3d& point, std::size_t& cell ) const
+{
+    if( offsets_.empty() ) { COMMA_THROW( comma::exception, "polytope index not built" ); }
+    Eigen::Vector3d d = ( point - origin_ ) / resolution_;
+    comma::uint32 index[3];
+    for( unsigned int k = 0; k < 3; ++k )
+    {
+        if( !( d[k] >= 0 ) ) { return false; } // also for nan
+        double i = std::floor( d[k] );
+        if( i >= size_[k] ) { return false; }
+        index[k] = static_cast< comma::uint32 >( i );
+    }
+    cell = ( std::size_t( index[0] ) * size_[1] + index[1] ) * size_[2] + index[2];
+    return true;
+}
+
+bool polytope_index::has( std::size_t i, const Eigen::Vector3d& point ) const
+{
+    const polytope& p = polytopes_[i];
+    if( ( point.array() < p.min.array() ).any() || ( point.array() > p.max.array() ).any() ) { return false; }
+    return ( ( p.normals * point - p.offsets ).array() >= 0 ).all();
+}
+
+boost::optional< std::size_t > polytope_index::find( const Eigen::Vector3d& point ) const
+{
+    std::size_t cell;
+    if( !cell_( point, cell ) ) { return boost::none; }
+    for( comma::uint32 j = offsets_[cell]; j < offsets_[ cell + 1 ]; ++j ) { if( has( indices_[j], point ) ) { return std::size_t( indices_[j] ); } }
+    return boost::none;
+}
+
+void polytope_index::find( const Eigen::Vector3d& point, std::vector< std::size_t >& indices ) const
+{
+    std::size_t cell;
+    if( !cell_( point, cell ) ) { return; }
+    for( comma::uint32 j = offsets_[cell]; j < offsets_[ cell + 1 ]; ++j ) { if( has( indices_[j], point ) ) { indices.push_back( indices_[j] ); } }
+}
+
+} } // namespace snark { namespace geometry {
@@ -0,0 +1,111 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_MATH_GEOMETRY_POLYTOPE_INDEX_H_
+#define SNARK_MATH_GEOMETRY_POLYTOPE_INDEX_H_
+
+#include <vector>
+#include <boost/optional.hpp>
+#include <Eigen/Core>
+#include <comma/base/types.h>
+
+namespace snark { namespace geometry {
+
+/// index of many convex polytopes, e.g. boxes, for point containment queries
+///
+/// a polytope is given by up to 6 half-spaces: normals * x >= offsets, same as convex_polytope
+///
+/// polytopes are bucketed into a uniform grid by their axis-aligned bounding boxes,
+/// thus a query tests only the polytopes overlapping the grid cell of the point,
+/// each against all its half-spaces at once with fixed-size matrices
+///
+/// usage:
+///     polytope_index index;
+///     index.add( min, max ); // box
+///     index.add( normals, offsets, min, max ); // polytope with its bounding box
+///     index.build();
+///     boost::optional< std::size_t > i = index.find( point ); // first polytope containing point in the order of add()
+class polytope_index
+{
+    public:
+        typedef Eigen::Matrix< double, 6, 3, Eigen::DontAlign > normals_type;
+        typedef Eigen::Matrix< double, 6, 1, Eigen::DontAlign > offsets_type;
+
+        /// constructor
+        polytope_index();
+
+        /// add axis-aligned box
+        void add( const Eigen::Vector3d& min, const Eigen::Vector3d& max );
+
+        /// add polytope
+        /// @param normals up to 6 rows of half-space normals
+        /// @param offsets half-space offsets
+        /// @param min, max bounding box of polytope; points outside of it are never tested
+        void add( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets, const Eigen::Vector3d& min, const Eigen::Vector3d& max );
+
+        /// build grid, call after all polytopes are added
+        /// @param resolution grid cell size; if 0, mean of the largest bounding box dimensions
+        void build( double resolution = 0 );
+
+        /// return index of the first polytope containing point in the order of add(), if any
+        boost::optional< std::size_t > find( const Eigen::Vector3d& point ) const;
+
+        /// append indices of all polytopes containing point in the order of add()
+        void find( const Eigen::Vector3d& point, std::vector< std::size_t >& indices ) const;
+
+        /// return true, if given polytope contains point
+        bool has( std::size_t i, const Eigen::Vector3d& point ) const;
+
+        /// return number of polytopes
+        std::size_t size() const { return polytopes_.size(); }
+
+        /// return grid resolution
+        double resolution() const { return resolution_; }
+
+    private:
+        struct polytope
+        {
+            normals_type normals;
+            offsets_type offsets;
+            Eigen::Vector3d min;
+            Eigen::Vector3d max;
+        };
+        std::vector< polytope > polytopes_;
+        Eigen::Vector3d origin_;
+        double resolution_;
+        comma::uint32 size_[3];
+        std::vector< comma::uint32 > offsets_; // offsets of cells in indices_
+        std::vector< comma::uint32 > indices_; // polytopes overlapping each cell in the order of add()
+        bool cell_( const Eigen::Vector3d& point, std::size_t& cell ) const;
+};
+
+} } // namespace snark { namespace geometry {
+
+#endif // SNARK_MATH_GEOMETRY_POLYTOPE_INDEX_H_
@@ -0,0 +1,108 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include <comma/base/exception.h>
+#include "../polytope.h"
+#include "../polytope_index.h"
+
+using namespace snark::geometry;
+
+static double random_( double from, double to ) { return from + ( to - from ) * ( double( ::rand() ) / RAND_MAX ); }
+
+TEST( polytope_index, box )
+{
+    polytope_index index;
+    index.add( Eigen::Vector3d( 0, 0, 0 ), Eigen::Vector3d( 1, 2, 3 ) );
+    index.add( Eigen::Vector3d( 0.5, 0.5, 0.5 ), Eigen::Vector3d( 5, 5, 5 ) );
+    index.build();
+    EXPECT_EQ( *index.find( Eigen::Vector3d( 0.1, 0.1, 0.1 ) ), 0u );
+    EXPECT_EQ( *index.find( Eigen::Vector3d( 1, 2, 3 ) ), 0u ); // boundary is inside
+    EXPECT_EQ( *index.find( Eigen::Vector3d( 0.6, 0.6, 0.6 ) ), 0u );
+    EXPECT_EQ( *index.find( Eigen::Vector3d( 4, 4, 4 ) ), 1u );
+    EXPECT_FALSE( index.find( Eigen::Vector3d( 6, 0, 0 ) ) );
+    EXPECT_FALSE( index.find( Eigen::Vector3d( -0.1, 0, 0 ) ) );
+    std::vector< std::size_t > indices;
+    index.find( Eigen::Vector3d( 0.6, 0.6, 0.6 ), indices );
+    ASSERT_EQ( indices.size(), 2u );
+    EXPECT_EQ( indices[0], 0u );
+    EXPECT_EQ( indices[1], 1u );
+}
+
+TEST( polytope_index, polytope )
+{
+    Eigen::MatrixXd A( 4, 3 );
+    Eigen::VectorXd b( 4 );
+    A << 1, 0, 0
+       , 0, 1, 0
+       , 0, 0, 1
+       , -1, -1, -1;
+    b << 0, 0, 0, -1;
+    polytope_index index;
+    index.add( A, b, Eigen::Vector3d( 0, 0, 0 ), Eigen::Vector3d( 1, 1, 1 ) );
+    index.build();
+    EXPECT_TRUE( index.find( Eigen::Vector3d( 0.1, 0.1, 0.1 ) ) );
+    EXPECT_FALSE( index.find( Eigen::Vector3d( 0.5, 0.5, 0.5 ) ) );
+    EXPECT_THROW( index.add( Eigen::MatrixXd::Zero( 7, 3 ), Eigen::VectorXd::Zero( 7 ), Eigen::Vector3d( 0, 0, 0 ), Eigen::Vector3d( 1, 1, 1 ) ), comma::exception );
+}
+
+TEST( polytope_index, random )
+{
+    ::srand( 1 );
+    polytope_index index;
+    std::vector< convex_polytope > polytopes;
+    for( unsigned int i = 0; i < 500; ++i )
+    {
+        Eigen::Vector3d min( random_( -100, 100 ), random_( -100, 100 ), random_( -5, 5 ) );
+        Eigen::Vector3d max = min + Eigen::Vector3d( random_( 0, 10 ), random_( 0, 10 ), random_( 0, 3 ) );
+        if( i % 50 == 0 ) { max += Eigen::Vector3d( 100, 100, 0 ); } // a few large ones
+        index.add( min, max );
+        Eigen::MatrixXd A( 6, 3 );
+        Eigen::VectorXd b( 6 );
+        A << 1, 0, 0, 0, 1, 0, 0, 0, 1, -1, 0, 0, 0, -1, 0, 0, 0, -1;
+        b << min, -max;
+        polytopes.push_back( convex_polytope( A, b ) );
+    }
+    index.build();
+    for( unsigned int i = 0; i < 20000; ++i )
+    {
+        Eigen::Vector3d p( random_( -110, 210 ), random_( -110, 210 ), random_( -10, 10 ) );
+        std::vector< std::size_t > expected;
+        for( std::size_t j = 0; j < polytopes.size(); ++j ) { if( polytopes[j].has( p ) ) { expected.push_back( j ); } }
+        std::vector< std::size_t > indices;
+        index.find( p, indices );
+        EXPECT_EQ( expected, indices );
+        boost::optional< std::size_t > first = index.find( p );
+        EXPECT_EQ( bool( first ), !expected.empty() );
+        if( first && !expected.empty() ) { EXPECT_EQ( *first, expected[0] ); }
+    }
+}
@@ -39,8 +39,12 @@
 #include <cmath>
 #include <string.h>
 #include <fstream>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
 #include <boost/array.hpp>
 #include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
 #include <comma/base/types.h>
@@ -48,7 +52,9 @@
 #include <comma/math/compare.h>
 #include <comma/string/string.h>
 #include <comma/visiting/traits.h>
+#include <snark/io/record_store.h>
 #include <snark/math/range_bearing_elevation.h>
+#include <snark/point_cloud/bearing_elevation_z_buffer.h>
 #include <snark/point_cloud/voxel_map.h>
 #include <snark/visiting/traits.h>
 //#include <google/profiler.h>
@@ -66,6 +72,19 @@ void usage( bool long_help = false )
     std::cerr << "    --range-threshold,-r=<value>: if present, output only the points" << std::endl;
     std::cerr << "                                  that have reference points nearer than range + range-threshold" << std::endl;
     std::cerr << "    --angle-threshold,-a=<value>: angular radius in radians" << std::endl;
+    std::cerr << "    --threads=<n>: number of threads; 0: as many as cores; default: 1" << std::endl;
+    std::cerr << "                   if more than 1, input points are buffered and traced in blocks; output order is the same" << std::endl;
+    std::cerr << "    --spill-directory=<directory>: keep reference records in memory-mapped temporary files in given directory" << std::endl;
+    std::cerr << "                                   rather than in anonymous memory, e.g. for reference point clouds larger than memory" << std::endl;
+    std::cerr << "    --z-buffer: trace in a dilated z-buffer of the reference point cloud instead of scanning reference points" << std::endl;
+    std::cerr << "                constant time per point and less memory, but the angular neighbourhood is a square of" << std::endl;
+    std::cerr << "                z-buffer cells covering the angular radius rather than a disk around the point" << std::endl;
+    std::cerr << "                guaranteed: a point is output if and only if it is surrounded by the reference points in its square;" << std::endl;
+    std::cerr << "                with --range-threshold, only if also none of them is nearer than range + range-threshold" << std::endl;
+    std::cerr << "                not guaranteed: same output as without --z-buffer; the square contains more reference points" << std::endl;
+    std::cerr << "                than the disk, thus some points may be output in addition and, with --range-threshold," << std::endl;
+    std::cerr << "                some points may be dropped; the reference point output may be different, too" << std::endl;
+    std::cerr << "    --z-buffer-resolution=<value>: z-buffer cell size in radians; default: angle-threshold / 2" << std::endl;
     std::cerr << "    --verbose,-v: more debug output" << std::endl;
     std::cerr << std::endl;
     std::cerr << "fields: r,b,e: range, bearing, elevation; default: r,b,e" << std::endl;
@@ -116,9 +135,9 @@ struct cell
     struct entry
     {
         point_t point;
-        comma::uint64 index;
+        snark::record_store::offset_type record;
         entry() {}
-        entry( const point_t& point, comma::uint64 index ) : point( point ), index( index ) {}
+        entry( const point_t& point, snark::record_store::offset_type record ) : point( point ), record( record ) {}
     };
 
     std::vector< entry > points;
@@ -234,6 +253,42 @@ struct cell
     }
 };
 
+typedef snark::voxel_map< cell, 2 > grid_t;
+typedef snark::bearing_elevation_z_buffer< snark::record_store::offset_type > z_buffer_t;
+static boost::scoped_ptr< grid_t > grid;
+static boost::scoped_ptr< z_buffer_t > z_buffer;
+static double threshold;
+static boost::optional< double > range_threshold;
+
+static boost::optional< snark::record_store::offset_type > trace_( const point_t& p ) // return record of the reference point, if any
+{
+    if( z_buffer )
+    {
+        const z_buffer_t::cell* c = z_buffer->trace( p.bearing(), p.elevation() );
+        if( !c || ( range_threshold && c->range < ( p.range() + *range_threshold ) ) ) { return boost::none; }
+        return c->value;
+    }
+    grid_t::const_iterator it = grid->find( grid_t::point_type( p.bearing(), p.elevation() ) );
+    if( it == grid->end() ) { return boost::none; }
+    const cell::entry* q = it->second.trace( p, threshold, range_threshold );
+    if( !q ) { return boost::none; }
+    return q->record;
+}
+
+struct query_t
+{
+    point_t point;
+    snark::record_store::offset_type record;
+    boost::optional< snark::record_store::offset_type > reference;
+};
+
+struct trace_body
+{
+    std::vector< query_t >& queries;
+    trace_body( std::vector< query_t >& queries ) : queries( queries ) {}
+    void operator()( const tbb::blocked_range< std::size_t >& r ) const { for( std::size_t i = r.begin(); i < r.end(); ++i ) { queries[i].reference = trace_( queries[i].point ); } }
+};
+
 int main( int argc, char** argv )
 {
     try
@@ -252,9 +307,12 @@ int main( int argc, char** argv )
         }
         csv.fields = comma::join( v, ',' );
         csv.full_xpath = false;
-        double threshold = options.value< double >( "--angle-threshold,-a" );
-        boost::optional< double > range_threshold = options.optional< double >( "--range-threshold,-r" );
-        std::vector< std::string > unnamed = options.unnamed( "--verbose,-v", "--binary,-b,--delimiter,-d,--fields,-f,--range-threshold,-r,--angle-threshold,-a" );
+        threshold = options.value< double >( "--angle-threshold,-a" );
+        range_threshold = options.optional< double >( "--range-threshold,-r" );
+        unsigned int threads = options.value( "--threads", 1u );
+        if( threads == 0 ) { threads = tbb::task_scheduler_init::default_num_threads(); }
+        tbb::task_scheduler_init init( threads );
+        std::vector< std::string > unnamed = options.unnamed( "--verbose,-v,--z-buffer", "--binary,-b,--delimiter,-d,--fields,-f,--range-threshold,-r,--angle-threshold,-a,--threads,--z-buffer-resolution,--spill-directory" );
         if( unnamed.empty() ) { std::cerr << "points-detect-change: please specify file with the reference point cloud" << std::endl; return 1; }
         if( unnamed.size() > 1 ) { std::cerr << "points-detect-change: expected file with the reference point cloud, got: " << comma::join( unnamed, ' ' ) << std::endl; return 1; }
         #ifdef WIN32
@@ -271,68 +329,68 @@ int main( int argc, char** argv )
         #endif
         if( !ifs.is_open() ) { std::cerr << "points-detect-change: failed to open \"" << unnamed[0] << "\"" << std::endl; return 1; }
         comma::csv::input_stream< point_t > ifstream( ifs, csv );
-        typedef snark::voxel_map< cell, 2 > grid_t;
         resolution = grid_t::point_type( threshold, threshold );
-        grid_t grid( resolution );
+        if( options.exists( "--z-buffer" ) ) { z_buffer.reset( new z_buffer_t( threshold, options.value( "--z-buffer-resolution", 0.0 ) ) ); }
+        else { grid.reset( new grid_t( resolution ) ); }
         if( verbose ) { std::cerr << "points-detect-change: loading reference point cloud..." << std::endl; }
         comma::signal_flag is_shutdown;
         comma::uint64 index = 0;
         //{ ProfilerStart( "points-detect-change.prof" );
-        std::deque< std::vector< char > > buffers;
+        snark::record_store records( snark::record_store::default_arena_size, options.value< std::string >( "--spill-directory", "" ) );
         while( ifs.good() && !ifs.eof() && !is_shutdown )
         {
             const point_t* p = ifstream.read();
             if( !p ) { break; }
-            cell::entry entry( *p, index );
-            for( int i = -1; i < 2; ++i )
-            {
-                for( int j = -1; j < 2; ++j )
-                {
-                    double bearing = p->bearing() + threshold * i;
-                    if( bearing < -M_PI ) { bearing += ( M_PI * 2 ); }
-                    else if( bearing >= M_PI ) { bearing -= ( M_PI * 2 ); }
-                    double elevation = p->elevation() + threshold * j;
-                    grid_t::iterator it = grid.touch_at( grid_t::point_type( bearing, elevation ) );
-                    it->second.add( entry ); //it->second.add_to_grid( entry );
-                }
-            }
-            buffers.push_back( std::vector< char >() ); // todo: quick and dirty; use memory map instead?
-            if( csv.binary() )
+            snark::record_store::offset_type record = csv.binary() ? records.append( ifstream.binary().last(), csv.format().size() ) : records.append( ifstream.ascii().last(), csv.delimiter );
+            if( z_buffer )
             {
-                static unsigned int s = ifstream.binary().binary().format().size();
-                buffers.back().resize( s );
-                ::memcpy( &buffers.back()[0], ifstream.binary().last(), s );
+                z_buffer->add( *p, record );
             }
             else
             {
-                std::string s = comma::join( ifstream.ascii().last(), csv.delimiter );
-                buffers.back().resize( s.size() );
-                ::memcpy( &buffers.back()[0], &s[0], s.size() );
+                cell::entry entry( *p, record );
+                for( int i = -1; i < 2; ++i )
+                {
+                    for( int j = -1; j < 2; ++j )
+                    {
+                        double bearing = p->bearing() + threshold * i;
+                        if( bearing < -M_PI ) { bearing += ( M_PI * 2 ); }
+                        else if( bearing >= M_PI ) { bearing -= ( M_PI * 2 ); }
+                        double elevation = p->elevation() + threshold * j;
+                        grid_t::iterator it = grid->touch_at( grid_t::point_type( bearing, elevation ) );
+                        it->second.add( entry ); //it->second.add_to_grid( entry );
+                    }
+                }
             }
             ++index;
         }
-        if( verbose ) { std::cerr << "points-detect-change: loaded reference point cloud: " << index << " points in a grid of size " << grid.size() << " voxels" << std::endl; }
+        if( z_buffer ) { z_buffer->build(); }
+        if( verbose ) { std::cerr << "points-detect-change: loaded reference point cloud: " << index << " points in a grid of size " << ( z_buffer ? z_buffer->size() : grid->size() ) << ( z_buffer ? " cells" : " voxels" ) << std::endl; }
         comma::csv::input_stream< point_t > istream( std::cin, csv );
+        std::vector< query_t > queries( threads == 1 ? 1 : 65536 ); // quick and dirty; reused for each block
+        snark::record_store query_records( threads == 1 ? 4096 : snark::record_store::default_arena_size ); // cleared for each block
         while( std::cin.good() && !std::cin.eof() && !is_shutdown )
         {
-            const point_t* p = istream.read();
-            if( !p ) { break; }
-            grid_t::const_iterator it = grid.find( grid_t::point_type( p->bearing(), p->elevation() ) );
-            if( it == grid.end() ) { continue; }
-            const cell::entry* q = it->second.trace( *p, threshold, range_threshold );
-            if( !q ) { continue; }
-            if( csv.binary() )
+            std::size_t size = 0;
+            query_records.clear();
+            for( ; size < queries.size() && !is_shutdown; ++size )
             {
-                static unsigned int is = istream.binary().binary().format().size();
-                std::cout.write( istream.binary().last(), is );
-                static unsigned int fs = ifstream.binary().binary().format().size();
-                std::cout.write( &buffers[q->index][0], fs );
+                const point_t* p = istream.read();
+                if( !p ) { break; }
+                queries[size].point = *p;
+                queries[size].record = csv.binary() ? query_records.append( istream.binary().last(), csv.format().size() ) : query_records.append( istream.ascii().last(), csv.delimiter );
             }
-            else
+            if( size == 0 ) { break; }
+            trace_body body( queries );
+            if( threads == 1 ) { body( tbb::blocked_range< std::size_t >( 0, size ) ); }
+            else { tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, size ), body ); }
+            for( std::size_t i = 0; i < size; ++i )
             {
-                std::cout << comma::join( istream.ascii().last(), csv.delimiter )
-                          << csv.delimiter
-                          << std::string( &buffers[q->index][0], buffers[q->index].size() ) << std::endl;
+                if( !queries[i].reference ) { continue; }
+                std::cout.write( query_records.data( queries[i].record ), query_records.size( queries[i].record ) );
+                if( !csv.binary() ) { std::cout << csv.delimiter; }
+                std::cout.write( records.data( *queries[i].reference ), records.size( *queries[i].reference ) );
+                if( !csv.binary() ) { std::cout << std::endl; }
             }
         }
         //} ProfilerStop();
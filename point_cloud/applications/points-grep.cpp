@@ -1,19 +1,26 @@
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
+#include <comma/base/exception.h>
 #include <comma/csv/stream.h>
 #include <comma/csv/traits.h>
 #include <comma/io/select.h>
 #include <comma/io/stream.h>
 #include <comma/name_value/parser.h>
 #include <snark/visiting/eigen.h>
+#include <algorithm>
 #include <iostream>
 #include <boost/tokenizer.hpp>
 #include <boost/thread.hpp>
 #include <Eigen/Dense>
 #include <snark/math/rotation_matrix.h>
-#include <snark/math/geometry/polytope.h>
+#include <snark/math/geometry/polytope_index.h>
 #include <snark/math/applications/frame.h>
+#include <snark/io/record_store.h>
 #include <string>
+#include <vector>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
 
 
 struct bounds_t
@@ -37,6 +44,13 @@ struct point
     comma::uint32 flag;
 };
 
+struct shape_t
+{
+    shape_t(): id(0){}
+    bounds_t bounds;
+    comma::uint32 id;
+};
+
 typedef snark::applications::frame::position_type bounding_point;
 
 struct joined_point
@@ -71,6 +85,20 @@ namespace comma
                 v.apply( "bottom", p.bottom );
             }
         };
+        template <> struct traits< shape_t >
+        {
+            template < typename K, typename V > static void visit( const K& k, shape_t& p, V& v )
+            {
+                traits< bounds_t >::visit( k, p.bounds, v );
+                v.apply( "id", p.id );
+            }
+
+            template < typename K, typename V > static void visit( const K& k, const shape_t& p, V& v )
+            {
+                traits< bounds_t >::visit( k, p.bounds, v );
+                v.apply( "id", p.id );
+            }
+        };
         template <> struct traits< point >
         {
             template < typename K, typename V > static void visit( const K&, point& p, V& v )
@@ -141,6 +169,16 @@ static void usage()
     std::cerr << "      --bounds=<front>,<back>,<right>,<left>,<top>,<bottom> the values represent the distances of the faces of the bounding box to the centre of the bounding stream in the bounding frame" << std::endl;
     std::cerr << "      --error-margin=<margin> error margin value added to bounds (for user convenience), default: 0.5" << std::endl;
     std::cerr << "      --output-all: output all points" << std::endl;
+    std::cerr << "      --shapes=<stream>: grep by many boxes in the bounding frame at once instead of --bounds" << std::endl;
+    std::cerr << "          <stream>: csv stream of boxes, e.g: \"boxes.csv;fields=front,back,right,left,top,bottom,id\"" << std::endl;
+    std::cerr << "          fields: " << comma::join( comma::csv::names< shape_t >( false ), ',' ) << "; default: " << comma::join( comma::csv::names< bounds_t >( false ), ',' ) << std::endl;
+    std::cerr << "          id: box id; default: position of box in the stream, starting from 1" << std::endl;
+    std::cerr << "          a box spans from -back to front, -left to right, and -top to bottom in the bounding frame;" << std::endl;
+    std::cerr << "          thus bounds may be negative for boxes not containing the bounding centre" << std::endl;
+    std::cerr << "          output: the id of the first box containing the point is appended after the flag, or 0 if none" << std::endl;
+    std::cerr << "      --threads=<n>: number of threads; 0: as many as cores; default: 1" << std::endl;
+    std::cerr << "      --batch-size=<n>: points are tested in batches of up to n points and output in input order; default: 65536" << std::endl;
+    std::cerr << "                        smaller batches are processed when no more input is immediately available" << std::endl;
     std::cerr << std::endl;
     std::cerr << "examples" << std::endl;
     std::cerr << "    cat points.csv | points-grep stream --fields=bounded \"nav.csv;fields=t,x,y,z,roll,pitch,yaw\" --bounds=1.0,2.0,1.0,2.0,1.0,2.0 --error-margin=0.1" << std::endl;
@@ -149,50 +187,128 @@ static void usage()
     std::cerr << std::endl;
     std::cerr << "    cat points.csv | points-grep shape --fields=bounded,bounding --bounds=1.0,2.0,1.0,2.0,1.0,2.0" << std::endl;
     std::cerr << "    cat points.csv | points-grep shape --fields=bounded/t,bounded/coordinates,bounded/flag,bounding/t,bounding/x,bounding/y,bounding/z,bounding/roll,bounding/pitch,bounding/yaw --bounds=1.0,1.0,1.0,1.0,1.0,1.0 --error-margin=1.0" << std::endl;
+    std::cerr << "    cat points.csv | points-grep shape --fields=bounded,bounding --shapes=\"boxes.csv;fields=id,front,back,right,left,top,bottom\" --error-margin=0 --output-all --threads=4" << std::endl;
     std::cerr << std::endl;
     exit( 0 );
 }
 
 static double offset;
 static bounds_t bounds;
+static snark::geometry::polytope_index shapes; // boxes in the bounding frame
+static std::vector< comma::uint32 > shape_ids;
+static bool has_shapes = false;
+static bool flag_exists = false;
+static bool output_all = false;
 
-void filter_point(joined_point& pq)
+static void add_shape( const bounds_t& b, comma::uint32 id )
 {
-    //get polygon from bounds
-    Eigen::MatrixXd origins(3,7); //origin, front, back, right, left, top, bottom
-
+    shapes.add( Eigen::Vector3d( -b.back - offset, -b.left - offset, -b.top - offset ), Eigen::Vector3d( b.front + offset, b.right + offset, b.bottom + offset ) );
+    shape_ids.push_back( id );
+}
 
-    origins<<0, bounds.front + offset, -bounds.back - offset, 0, 0, 0, 0,
-             0, 0, 0, bounds.right + offset, -bounds.left - offset, 0, 0,
-             0, 0, 0, 0, 0, -bounds.top - offset, bounds.bottom + offset;
+static void load_shapes( const std::string& option )
+{
+    comma::name_value::parser parser( "filename" );
+    comma::csv::options csv = parser.get< comma::csv::options >( option );
+    if( csv.fields.empty() ) { csv.fields = comma::join( comma::csv::names< bounds_t >( false ), ',' ); } // no id: ids are positions in the stream
+    bool has_id = csv.has_field( "id" );
+    comma::io::istream is( csv.filename, csv.binary() ? comma::io::mode::binary : comma::io::mode::ascii, comma::io::mode::blocking );
+    comma::csv::input_stream< shape_t > istream( *is, csv );
+    while( istream.ready() || ( is->good() && !is->eof() ) )
+    {
+        const shape_t* s = istream.read();
+        if( !s ) { break; }
+        add_shape( s->bounds, has_id ? s->id : shape_ids.size() + 1 );
+    }
+    if( shape_ids.empty() ) { COMMA_THROW( comma::exception, "no shapes in \"" << csv.filename << "\"" ); }
+}
 
+/// points are buffered and tested in batches, optionally in parallel, and output in input order
+///
+/// the point is transformed into the bounding frame once and then tested
+/// against all the shapes at once, using the shape index
+struct batch_t
+{
+    std::vector< joined_point > points;
+    std::vector< snark::record_store::offset_type > offsets;
+    std::vector< comma::uint32 > ids; // shape ids
+    snark::record_store records;
+    std::string line; // output line, reused between points
+    std::size_t size;
+    unsigned int threads;
 
-    //convert vehicle bounds to world coordinates
-    //get transformation
+    batch_t( std::size_t size, unsigned int threads ) : size( size ), threads( threads ) {}
 
-    Eigen::MatrixXd rot_matrix = snark::rotation_matrix::rotation(pq.bounding.value.orientation);
+    bool full() const { return points.size() >= size; }
 
-    for(int cntr2=0; cntr2<origins.cols(); cntr2++)
+    struct body
     {
-        origins.col(cntr2)=rot_matrix*origins.col(cntr2)+pq.bounding.value.coordinates;
-    }
-
-    //get plane equations
-    Eigen::MatrixXd A(6,3);
-    Eigen::VectorXd b(6);
+        batch_t& b;
+        body( batch_t& b ) : b( b ) {}
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
+        {
+            Eigen::Vector3d orientation;
+            Eigen::Matrix3d rotation;
+            for( std::size_t i = r.begin(); i != r.end(); ++i )
+            {
+                joined_point& pq = b.points[i];
+                if( i == r.begin() || pq.bounding.value.orientation != orientation ) // quick and dirty: subsequent points often have the same bounding position
+                {
+                    orientation = pq.bounding.value.orientation;
+                    rotation = snark::rotation_matrix::rotation( orientation ).transpose();
+                }
+                boost::optional< std::size_t > shape = shapes.find( rotation * ( pq.bounded.coordinates - pq.bounding.value.coordinates ) );
+                b.ids[i] = shape ? shape_ids[ *shape ] : 0;
+                if( shape ) { pq.bounded.flag = 0; } // use if statement not assignment because point might already be filtered
+            }
+        }
+    };
 
-    for(int cntr2=1; cntr2<origins.cols(); cntr2++)
+    template < typename S > void push( const joined_point& pq, const S& istream, const comma::csv::options& csv )
     {
-        A.row(cntr2-1)<<origins.col(0).transpose()-origins.col(cntr2).transpose();
-        b(cntr2-1)=origins.col(cntr2).transpose()*(origins.col(0)-origins.col(cntr2));
+        points.push_back( pq );
+        offsets.push_back( csv.binary() ? records.append( istream.binary().last(), csv.format().size() ) : records.append( istream.ascii().last(), csv.delimiter ) );
     }
 
-    //check polygon in 3d
-    // use if statement not assignment because point might already be filtered
-    if(snark::geometry::convex_polytope(A,b).has(pq.bounded.coordinates))
+    void process( comma::csv::output_stream< joined_point >& ostream )
     {
-        pq.bounded.flag=0;
+        if( points.empty() ) { return; }
+        ids.resize( points.size() );
+        if( threads == 1 ) { body( *this )( tbb::blocked_range< std::size_t >( 0, points.size() ) ); }
+        else { tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, points.size(), 1024 ), body( *this ) ); }
+        for( std::size_t i = 0; i < points.size(); ++i )
+        {
+            const joined_point& pq = points[i];
+            if(!pq.bounded.flag && !output_all) { continue; }
+            if(flag_exists && !has_shapes) { ostream.write(pq); continue; }
+            //append flag
+            if(ostream.is_binary())
+            {
+                ostream.write(pq,records.data( offsets[i] ));
+                if(!flag_exists) { std::cout.write( reinterpret_cast< const char* >( &pq.bounded.flag ), sizeof( comma::uint32 ) ); }
+                if(has_shapes) { std::cout.write( reinterpret_cast< const char* >( &ids[i] ), sizeof( comma::uint32 ) ); }
+            }
+            else
+            {
+                line.assign( records.data( offsets[i] ), records.size( offsets[i] ) );
+                if(!flag_exists) { line+=","+boost::lexical_cast<std::string>(pq.bounded.flag); }
+                if(has_shapes) { line+=","+boost::lexical_cast<std::string>(ids[i]); }
+                ostream.write(pq,line);
+            }
+        }
+        ostream.flush();
+        points.clear();
+        offsets.clear();
+        records.clear();
     }
+};
+
+/// return true, if more input is available without blocking
+template < typename S > static bool pending( const S& istream, comma::io::select& select )
+{
+    if( istream.ready() || std::cin.rdbuf()->in_avail() > 0 ) { return true; }
+    select.check();
+    return select.read().ready( 0 );
 }
 
 int main( int argc, char** argv )
@@ -203,14 +319,20 @@ int main( int argc, char** argv )
 
     bounds=comma::csv::ascii<bounds_t>().get(options.value("--bounds",std::string("0,0,0,0,0,0")));
 
-    bool output_all = options.exists( "--output-all");
+    output_all = options.exists( "--output-all");
+    unsigned int threads = options.value( "--threads", 1u );
+    if( threads == 0 ) { threads = tbb::task_scheduler_init::default_num_threads(); }
+    tbb::task_scheduler_init init( threads );
+    batch_t batch( std::max( options.value( "--batch-size", 65536u ), 1u ), threads );
+    has_shapes = options.exists( "--shapes" );
+    if( has_shapes ) { load_shapes( options.value< std::string >( "--shapes" ) ); } else { add_shape( bounds, 1 ); }
+    shapes.build();
     std::vector<std::string> unnamed=options.unnamed("--output-all,--verbose,-v","-.*");
 
     std::string operation=unnamed[0];
 
     comma::csv::options csv(options);
     csv.full_xpath=true;
-    bool flag_exists=false;
 
     if( operation == "stream" )
     {
@@ -324,7 +446,7 @@ int main( int argc, char** argv )
             //if we are done with the last bounded point get next
             if(next)
             {
-                if(!istream_ready) { continue; }
+                if(!istream_ready) { batch.process(ostream); continue; }
                 const joined_point* pq_ptr = istream.read();
                 if( !pq_ptr ) { break; }
                 pq=*pq_ptr;
@@ -343,6 +465,7 @@ int main( int argc, char** argv )
                 //do we have more data?
                 if(!bounding_data_available) { break; }
                 next=false;
+                batch.process(ostream);
                 continue;
             }
 
@@ -360,37 +483,15 @@ int main( int argc, char** argv )
             pq.bounding = is_first ? bounding_queue[0] : bounding_queue[1]; // assign bounding point
 
             //filter out object points
-            filter_point(pq);
-
-            if(!pq.bounded.flag && !output_all)
-            {
-                continue;
-            }
-
-            if(flag_exists)
-            {
-                ostream.write(pq);
-                ostream.flush();
-                continue;
-            }
-
-            //append flag
-            if(ostream.is_binary())
-            {
-                ostream.write(pq,istream.binary().last());
-                std::cout.write( reinterpret_cast< const char* >( &pq.bounded.flag ), sizeof( comma::uint32 ) );
-            }
-            else
-            {
-                std::string line=comma::join( istream.ascii().last(), csv.delimiter );
-                line+=","+boost::lexical_cast<std::string>(pq.bounded.flag);
-                ostream.write(pq,line);
-            }
-            ostream.flush();
+            batch.push(pq,istream,csv);
+            if(batch.full()) { batch.process(ostream); }
         }
+        batch.process(ostream);
     }
     else if(operation=="shape")
     {
+        comma::io::select input_select;
+        input_select.read().add(0);
         while(!is_shutdown && ( istream.ready() || ( std::cin.good() && !std::cin.eof() ) ))
         {
             const joined_point* pq_ptr = istream.read();
@@ -400,33 +501,10 @@ int main( int argc, char** argv )
             pq=*pq_ptr;
 
             //filter out object points
-            filter_point(pq);
-            if(!pq.bounded.flag && !output_all)
-            {
-                continue;
-            }
-
-            if(flag_exists)
-            {
-                ostream.write(pq);
-                ostream.flush();
-                continue;
-            }
-
-            //append flag
-            if(ostream.is_binary())
-            {
-                ostream.write(pq,istream.binary().last());
-                std::cout.write( reinterpret_cast< const char* >( &pq.bounded.flag ), sizeof( comma::uint32 ) );
-            }
-            else
-            {
-                std::string line=comma::join( istream.ascii().last(), csv.delimiter );
-                line+=","+boost::lexical_cast<std::string>(pq.bounded.flag);
-                ostream.write(pq,line);
-            }
-            ostream.flush();
+            batch.push(pq,istream,csv);
+            if(batch.full() || !pending(istream,input_select)) { batch.process(ostream); }
         }
+        batch.process(ostream);
     }
 
     return(0);
@@ -1,11 +1,18 @@
 #include <iostream>
 #include <vector>
 #include <Eigen/Dense>
+#include <boost/lexical_cast.hpp>
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
 #include <comma/csv/stream.h>
 #include <comma/csv/binary.h>
 #include <boost/tokenizer.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
+#include <snark/io/record_store.h>
+#include <snark/point_cloud/centroids.h>
+#include <snark/point_cloud/shards.h>
 
 struct point
 {
@@ -20,6 +27,7 @@ struct point
 };
 
 static bool outputsize=false;
+static bool outputcovariance=false;
 
 namespace comma
 {
@@ -52,82 +60,121 @@ namespace comma
     }
 }
 
-typedef std::vector< std::pair<point,std::string> > block_t;
+typedef std::pair< point, snark::record_store::offset_type > input_t;
 
-void partitions_to_centroids(block_t& block, block_t& centroids, std::vector<double>& sizes)
+/// a block of points, aggregated in a single pass as it is read
+/// serial: only the first point and its record are kept for each id
+/// parallel: all points are buffered, grouped by shard of their id once and then
+///           aggregated in shards; each shard is accumulated by one task over its
+///           own points in input order, thus sums are exactly the same as in serial aggregation
+struct block_t
 {
-    block_t::iterator itr;
+    std::vector< input_t > points; // serial: first point of each id in order of appearance; parallel: all points
+    snark::record_store records;
+    std::vector< comma::uint32 > shard_ids;
+    snark::shard_groups groups;
+    std::vector< snark::centroids > shards;
 
-    while(!block.empty())
-    {
-        itr=block.begin();
-        centroids.push_back(*itr); // store other information
-
-        comma::uint32 id=itr->first.id;
+    block_t( unsigned int threads ) : shards( threads, snark::centroids( outputcovariance ) ) {}
 
-        Eigen::MatrixXd points(3,1);
-        points(0,0)=itr->first.x;
-        points(1,0)=itr->first.y;
-        points(2,0)=itr->first.z;
+    bool parallel() const { return shards.size() > 1; }
 
-        block.erase(itr);
+    /// add point; return true, if its record needs to be stored as points.back().second
+    bool add( const point& p )
+    {
+        if( !parallel() && !shards[0].add( p.id, Eigen::Vector3d( p.x, p.y, p.z ), points.size() ) ) { return false; }
+        points.push_back( std::make_pair( p, 0 ) );
+        return true;
+    }
 
-        while(itr!=block.end())
+    struct shard_body
+    {
+        block_t& b;
+        shard_body( block_t& b ) : b( b ) {}
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
         {
-            if(itr->first.id==id)
+            for( std::size_t s = r.begin(); s != r.end(); ++s )
             {
-                points.conservativeResize(Eigen::NoChange,points.cols()+1);
-                points(0,points.cols()-1)=itr->first.x;
-                points(1,points.cols()-1)=itr->first.y;
-                points(2,points.cols()-1)=itr->first.z;
-
-                block.erase(itr);
-            }
-            else
-            {
-                itr++;
+                snark::centroids& c = b.shards[s];
+                for( snark::shard_groups::const_iterator it = b.groups.begin( s ); it != b.groups.end( s ); ++it )
+                {
+                    const point& p = b.points[ *it ].first;
+                    c.add( p.id, Eigen::Vector3d( p.x, p.y, p.z ), *it );
+                }
             }
         }
+    };
 
-        //get centroid
-        Eigen::MatrixXd Mean=points.rowwise().mean();
-        centroids.back().first.x=Mean(0,0);
-        centroids.back().first.y=Mean(1,0);
-        centroids.back().first.z=Mean(2,0);
-
-        //get bounding box
-        Eigen::MatrixXd Mins=points.rowwise().minCoeff();
-        Eigen::MatrixXd Maxs=points.rowwise().maxCoeff();
-        Eigen::MatrixXd Extents=Maxs-Mins;
-        sizes.push_back(Extents.maxCoeff());
+    void aggregate()
+    {
+        if( !parallel() ) { return; }
+        shard_ids.resize( points.size() );
+        for( std::size_t i = 0; i < points.size(); ++i ) { shard_ids[i] = shard_of_( points[i].first.id, shards.size() ); }
+        groups.assign( shard_ids, shards.size() );
+        tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, shards.size(), 1 ), shard_body( *this ) );
     }
-}
 
+    void clear()
+    {
+        points.clear();
+        records.clear();
+        for( std::size_t s = 0; s < shards.size(); ++s ) { shards[s].clear(); }
+    }
 
-void publish_centroids(const block_t& centroids, const std::vector<double>& sizes, comma::csv::output_stream<point>& ostream)
+    static std::size_t shard_of_( comma::uint32 id, std::size_t size ) { return ( id * 2654435761u ) % size; } // quick and dirty: ids are often consecutive
+};
+
+static void publish_centroid( const block_t& block, const snark::centroid& c, comma::csv::output_stream<point>& ostream, std::string& line )
 {
-    //publish centroids
-    for(unsigned int cntr=0; cntr<centroids.size(); cntr++)
+    const input_t& first = block.points[ c.first ];
+    point p = first.first; // store other information
+    Eigen::Vector3d mean = c.mean();
+    p.x = mean.x();
+    p.y = mean.y();
+    p.z = mean.z();
+    double size = c.extents().maxCoeff();
+    Eigen::Matrix3d covariance;
+    if( outputcovariance ) { covariance = c.covariance(); }
+    line.assign( block.records.data( first.second ), block.records.size( first.second ) );
+    if(ostream.is_binary())
     {
-        if(ostream.is_binary())
+        ostream.write(p,line);
+        if(outputsize) { std::cout.write( reinterpret_cast< const char* >( &size ), sizeof( double ) ); }
+        if(outputcovariance)
         {
-            ostream.write(centroids.at(cntr).first,centroids.at(cntr).second);
-            if(outputsize)
-            {
-                std::cout.write( reinterpret_cast< const char* >( &sizes.at(cntr) ), sizeof( double ) );
-            }
+            for( unsigned int i = 0; i < 3; ++i ) { for( unsigned int j = i; j < 3; ++j ) { std::cout.write( reinterpret_cast< const char* >( &covariance( i, j ) ), sizeof( double ) ); } }
         }
-        else
+    }
+    else
+    {
+        if(outputsize) { line+=","+boost::lexical_cast<std::string>(size); }
+        if(outputcovariance)
         {
-            std::string line=centroids.at(cntr).second;
-            if(outputsize)
-            {
-                line+=","+boost::lexical_cast<std::string>(sizes.at(cntr));
-            }
-            ostream.write(centroids.at(cntr).first,line);
+            for( unsigned int i = 0; i < 3; ++i ) { for( unsigned int j = i; j < 3; ++j ) { line+=","+boost::lexical_cast<std::string>(covariance(i,j)); } }
         }
+        ostream.write(p,line);
     }
+}
+
+struct publish_
+{
+    const block_t& block;
+    comma::csv::output_stream< point >& ostream;
+    std::string line; // reused for each centroid
+    publish_( const block_t& block, comma::csv::output_stream< point >& ostream ) : block( block ), ostream( ostream ) {}
+    void operator()( snark::centroids::const_iterator it ) { publish_centroid( block, it->second, ostream, line ); }
+};
+
+/// publish centroids of all shards in the order of the first point of each id, i.e. exactly as serial aggregation does
+void publish_centroids(block_t& block, comma::csv::output_stream<point>& ostream)
+{
+    block.aggregate();
+    std::vector< std::pair< snark::centroids::const_iterator, snark::centroids::const_iterator > > ranges( block.shards.size() );
+    for( std::size_t s = 0; s < block.shards.size(); ++s ) { ranges[s] = std::make_pair( block.shards[s].begin(), block.shards[s].end() ); }
+    publish_ publish( block, ostream );
+    snark::merge_shards( ranges, publish );
     ostream.flush();
+    block.clear();
 }
 
 int main( int argc, char** argv )
@@ -145,14 +192,25 @@ int main( int argc, char** argv )
             std::cerr << "input: partitioned point cloud where field id corresponds to the partition number" << std::endl;
             std::cerr << std::endl;
             std::cerr << "output: the centroid of each partition with a size field optionally appended" << std::endl;
+            std::cerr << "        centroids of each block are output in the order of the first point of each partition" << std::endl;
             std::cerr << std::endl;
             std::cerr << "<options>" << std::endl;
             std::cerr << "    --output-size: if present output partition size" << std::endl;
+            std::cerr << "    --output-covariance: if present output partition covariance after size, if any" << std::endl;
+            std::cerr << "                         as xx,xy,xz,yy,yz,zz; binary: 6d" << std::endl;
+            std::cerr << "    --threads=<n>: number of threads; 0: as many as cores; default: 1" << std::endl;
+            std::cerr << "                   if more than 1, points of each block are buffered and aggregated" << std::endl;
+            std::cerr << "                   in shards by id, which helps for blocks with many partitions" << std::endl;
+            std::cerr << "                   output is the same as with one thread" << std::endl;
             std::cerr << comma::csv::options::usage() << std::endl;
             std::cerr << std::endl;
             exit(-1);
         }
         outputsize=options.exists("--output-size");
+        outputcovariance=options.exists("--output-covariance");
+        unsigned int threads = options.value( "--threads", 1u );
+        if( threads == 0 ) { threads = tbb::task_scheduler_init::default_num_threads(); }
+        tbb::task_scheduler_init init( threads );
         comma::csv::options csv( options );
         comma::csv::input_stream<point> istream(std::cin,csv);
         comma::csv::output_stream<point> ostream(std::cout,csv);
@@ -164,41 +222,19 @@ int main( int argc, char** argv )
         comma::uint32 last_block = std::numeric_limits< comma::uint32 >::max();
 
 
-        std::vector< std::pair<point,std::string> > block;
+        block_t block( threads );
 
         while(!is_shutdown && std::cin.good() && !std::cin.eof())
         {
             const point* input=istream.read();
-            block_t centroids;
-            std::vector<double> sizes;
             if(!input)
             {
                 //parition last block
-                if(!block.empty())
-                {
-                    partitions_to_centroids(block,centroids,sizes);
-                    publish_centroids(centroids,sizes,ostream);
-                }
+                if(!block.points.empty()) { publish_centroids(block,ostream); }
                 return(0);
             }
-            if(input->block != last_block && !block.empty())
-            {
-                partitions_to_centroids(block,centroids,sizes);
-                publish_centroids(centroids,sizes,ostream);
-            }
-            std::string line;
-            if( csv.binary() )
-            {
-                line.resize( csv.format().size() );
-                ::memcpy( &line[0], istream.binary().last(), csv.format().size() );
-            }
-            else
-            {
-                line = comma::join( istream.ascii().last(), csv.delimiter );
-            }
-            std::pair<point,std::string> input_pair = std::make_pair( *input, line );
-
-            block.push_back(input_pair);
+            if(input->block != last_block && !block.points.empty()) { publish_centroids(block,ostream); }
+            if( block.add( *input ) ) { block.points.back().second = csv.binary() ? block.records.append( istream.binary().last(), csv.format().size() ) : block.records.append( istream.ascii().last(), csv.delimiter ); }
             last_block=input->block;
         }
 
@@ -35,25 +35,27 @@
 #include <fcntl.h>
 #include <io.h>
 #endif
-#include <deque>
 #include <iostream>
 #include <limits>
 #include <map>
 #include <sstream>
 #include <vector>
+#include <tbb/concurrent_queue.h>
 #include <tbb/pipeline.h>
 #include <tbb/task_scheduler_init.h>
-#include <boost/array.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
+#include <comma/base/exception.h>
 #include <comma/base/types.h>
 #include <comma/csv/stream.h>
 #include <comma/string/string.h>
 #include <comma/sync/synchronized.h>
 #include <comma/visiting/traits.h>
+#include <snark/io/record_store.h>
 #include <snark/math/interval.h>
 #include <snark/point_cloud/partition.h>
 #include <snark/tbb/bursty_reader.h>
@@ -80,6 +82,10 @@ static void usage()
     std::cerr << "        --resolution <resolution>: default: 0.2 metres" << std::endl;
     std::cerr << "    data flow options:" << std::endl;
     std::cerr << "        --discard,-d: if present, partition as many points as possible, discard the rest" << std::endl;
+    std::cerr << "        --threads=<n>: number of blocks to partition in parallel, 0: number of cores; default: 1" << std::endl;
+    std::cerr << "                       memory for at most n + 2 blocks is allocated and reused" << std::endl;
+    std::cerr << "        --threads-per-block=<n>: number of threads to find partitions in each block, e.g. for a single large block;" << std::endl;
+    std::cerr << "                                 0: number of cores; default: 1; output is the same for any number of threads" << std::endl;
     std::cerr << "        --output-all: output all points, even non-partitioned; the latter with id: max uint32" << std::endl;
     std::cerr << "        --verbose, -v: output progress info" << std::endl;
     std::cerr << std::endl;
@@ -116,6 +122,7 @@ static comma::csv::options csv;
 static comma::uint32 min_id;
 static bool discard;
 static bool output_all;
+static unsigned int threads_per_block;
 static boost::scoped_ptr< snark::partition > partition;
 
 struct input_t
@@ -149,71 +156,72 @@ template <> struct traits< input_t >
 
 } } // namespace ark { namespace visiting {
 
-struct block_t // quick and dirty, no optimization for now
+struct block_t
 {
-    typedef std::pair< input_t, std::string > pair_t;
-    typedef std::deque< pair_t > pairs_t;
+    typedef std::pair< input_t, snark::record_store::offset_type > pair_t;
+    typedef std::vector< pair_t > pairs_t;
 
-    boost::scoped_ptr< pairs_t > points;
+    pairs_t points; // capacity is reused between blocks
+    snark::record_store records; // input records to output; arenas are reused between blocks
     comma::uint32 id;
-    volatile bool empty;
-    boost::scoped_ptr< snark::partition > partition;
+    boost::scoped_ptr< snark::partition > partition; // created once, then reset for each block
 
-    block_t() : id( 0 ), empty( true ) {}
-    void clear() { partition.reset(); points.reset(); empty = true; }
+    block_t() : id( 0 ) {}
+    void clear() { points.clear(); records.clear(); }
 };
 
 static comma::signal_flag is_shutdown;
 static boost::scoped_ptr< snark::tbb::bursty_reader< block_t* > > bursty_reader;
 
+static boost::ptr_vector< block_t > blocks; // pool of blocks reused in turn; see --threads
+static ::tbb::concurrent_queue< block_t* > free_blocks; // blocks of the pool not in the pipeline; returned by write_block_()
+
 static block_t* read_block_impl_( ::tbb::flow_control* flow = NULL )
 {
-    static boost::array< block_t, 3 > blocks;
-    static boost::optional< block_t::pair_t > last;
+    static block_t discarded; // quick and dirty, only with --discard: if no block is free, read into it and drop
+    static boost::optional< input_t > last;
+    static std::string last_record; // quick and dirty: the record of the first point of the next block has to outlive the current block
     static comma::uint32 block_id = 0;
-    block_t::pairs_t* points = new block_t::pairs_t;
+    static bool stopped = false;
+    static comma::csv::input_stream< input_t > istream( std::cin, csv );
     while( true ) // quick and dirty, only if --discard
     {
-        static comma::csv::input_stream< input_t > istream( std::cin, csv );
-        points->clear();
+        block_t* block = NULL;
+        if( !free_blocks.try_pop( block ) )
+        {
+            if( !discard ) { COMMA_THROW( comma::exception, "no free block in the pool of " << blocks.size() << " blocks; pipeline holds more blocks than tokens" ); }
+            block = &discarded;
+            block->clear();
+        }
         while( true )
         {
             if( last )
             {
-                block_id = last->first.block;
-                points->push_back( *last );
+                block_id = last->block;
+                block->points.push_back( std::make_pair( *last, block->records.append( last_record ) ) );
                 last.reset();
             }
             if( is_shutdown || std::cout.bad() || std::cin.bad() || std::cin.eof() )
             {
                 if( bursty_reader ) { bursty_reader->stop(); } // quick and dirty, it sucks...
                 if( flow ) { flow->stop(); }
+                stopped = true;
                 break;
             }
             const input_t* p = istream.read();
             if( !p ) { break; }
-            std::string line;
-            if( csv.binary() )
-            {
-                line.resize( csv.format().size() );
-                ::memcpy( &line[0], istream.binary().last(), csv.format().size() );
-            }
-            else
+            if( p->block != block_id )
             {
-                line = comma::join( istream.ascii().last(), csv.delimiter );
+                last = *p;
+                if( csv.binary() ) { last_record.assign( istream.binary().last(), csv.format().size() ); }
+                else { last_record = comma::join( istream.ascii().last(), csv.delimiter ); }
+                break;
             }
-            last = std::make_pair( *p, line );
-            if( p->block != block_id ) { break; }
-        }
-        for( unsigned int i = 0; i < blocks.size(); ++i )
-        {
-            if( !blocks[i].empty ) { continue; }
-            blocks[i].clear();
-            blocks[i].id = block_id;
-            blocks[i].points.reset( points );
-            blocks[i].empty = false;
-            return &blocks[i];
+            block->points.push_back( std::make_pair( *p, csv.binary() ? block->records.append( istream.binary().last(), csv.format().size() ) : block->records.append( istream.ascii().last(), csv.delimiter ) ) );
         }
+        if( block == &discarded ) { if( stopped ) { return NULL; } continue; }
+        block->id = block_id;
+        return block;
     }
 }
 
@@ -223,32 +231,34 @@ static block_t* read_block_bursty_() { return read_block_impl_(); }
 static void write_block_( block_t* block )
 {
     if( !block ) { return; } // quick and dirty for now, only if --discard
-    for( std::size_t i = 0; i < block->points->size(); ++i )
+    for( std::size_t i = 0; i < block->points.size(); ++i )
     {
-        const block_t::pair_t& p = block->points->operator[]( i );
+        const block_t::pair_t& p = block->points[i];
         if( !( p.first.id && *p.first.id ) && !output_all ) { continue; }
         comma::uint32 id = p.first.id && *p.first.id ? **p.first.id : std::numeric_limits< comma::uint32 >::max();
-        std::cout.write( &p.second[0], p.second.size() );
+        std::cout.write( block->records.data( p.second ), block->records.size( p.second ) );
         if( csv.binary() ) { std::cout.write( reinterpret_cast< const char* >( &id ), sizeof( comma::uint32 ) ); }
         else { std::cout << csv.delimiter << id << std::endl; }
     }
     std::cout.flush();
     block->clear();
+    free_blocks.push( block );
 }
 
 static block_t* partition_( block_t* block )
 {
     if( !block ) { return NULL; } // quick and dirty for now, only if --discard
-    if( block->points->empty() ) { return block; }
+    if( block->points.empty() ) { return block; }
     snark::math::closed_interval< double, 3 > extents;
-    for( std::size_t i = 0; i < block->points->size(); ++i ) { extents.set_hull( block->points->operator[](i).first.point ); }
-    block->partition.reset( new snark::partition( extents, resolution, min_points_per_voxel ) );
-    for( std::size_t i = 0; i < block->points->size(); ++i )
+    for( std::size_t i = 0; i < block->points.size(); ++i ) { extents.set_hull( block->points[i].first.point ); }
+    if( block->partition ) { block->partition->reset( extents ); }
+    else { block->partition.reset( new snark::partition( extents, resolution, min_points_per_voxel ) ); }
+    for( std::size_t i = 0; i < block->points.size(); ++i )
     {
-        block_t::pair_t& p = block->points->operator[]( i );
+        block_t::pair_t& p = block->points[i];
         if( p.first.flag ) { p.first.id = &block->partition->insert( p.first.point ); }
     }
-    block->partition->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density );
+    block->partition->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density, threads_per_block );
     return block;
 }
 
@@ -273,7 +283,13 @@ int main( int ac, char** av )
         discard = options.exists( "--discard,-d" );
         min_id = options.value( "--min-id", 0 );
         output_all = options.exists( "--output-all" );
-        ::tbb::filter_t< block_t*, block_t* > partition_filter( ::tbb::filter::serial_in_order, &partition_ );
+        unsigned int threads = options.value( "--threads", 1u );
+        if( threads == 0 ) { threads = ::tbb::task_scheduler_init::default_num_threads(); }
+        threads_per_block = options.value( "--threads-per-block", 1u );
+        if( threads_per_block == 0 ) { threads_per_block = ::tbb::task_scheduler_init::default_num_threads(); }
+        ::tbb::task_scheduler_init init( threads );
+        for( unsigned int i = 0; i < threads + 2; ++i ) { blocks.push_back( new block_t ); free_blocks.push( &blocks.back() ); } // one more block being read, one more being written
+        ::tbb::filter_t< block_t*, block_t* > partition_filter( threads == 1 ? ::tbb::filter::serial_in_order : ::tbb::filter::parallel, &partition_ );
         ::tbb::filter_t< block_t*, void > write_filter( ::tbb::filter::serial_in_order, &write_block_ );
         #ifdef PROFILE
         ProfilerStart( "points-to-partitions.prof" ); {
@@ -282,14 +298,14 @@ int main( int ac, char** av )
         {
             bursty_reader.reset( new snark::tbb::bursty_reader< block_t* >( &read_block_bursty_ ) );
             ::tbb::filter_t< void, void > filters = bursty_reader->filter() & partition_filter & write_filter;
-            while( bursty_reader->wait() ) { ::tbb::parallel_pipeline( 3, filters ); }
+            while( bursty_reader->wait() ) { ::tbb::parallel_pipeline( blocks.size(), filters ); }
             bursty_reader->join();
         }
         else
         {
             ::tbb::filter_t< void, block_t* > read_filter( ::tbb::filter::serial_in_order, &read_block_ );
             ::tbb::filter_t< void, void > filters = read_filter & partition_filter & write_filter;
-            ::tbb::parallel_pipeline( 3, filters );
+            ::tbb::parallel_pipeline( blocks.size(), filters );
         }
         #ifdef PROFILE
         ProfilerStop(); }
@@ -31,6 +31,10 @@
 #include <boost/array.hpp>
 #include <boost/optional.hpp>
 #include <boost/program_options.hpp>
+#include <boost/shared_ptr.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
 #include <comma/base/exception.h>
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
@@ -40,7 +44,9 @@
 #include <comma/csv/impl/program_options.h>
 #include <comma/visiting/traits.h>
 #include <snark/visiting/eigen.h>
+#include <snark/point_cloud/shards.h>
 #include <snark/point_cloud/voxel_map.h>
+#include <snark/point_cloud/voxel_neighbourhood.h>
 
 struct input_point
 {
@@ -56,16 +62,162 @@ struct centroid
     Eigen::Vector3d mean;
     comma::uint32 size;
     comma::uint32 block;
+    Eigen::Vector3d sum; /// accumulated without division, mean is calculated on output
+    comma::uint64 first; /// sequence number of the first point in the voxel
     
-    centroid() : size( 0 ), block( 0 ) {}
+    centroid() : size( 0 ), block( 0 ), sum( Eigen::Vector3d::Zero() ), first( 0 ) {}
     
     void operator+=( const Eigen::Vector3d& point )
     {
         ++size;
-        mean = ( mean * ( size - 1 ) + point ) / size;
+        sum += point;
     }
 };
 
+typedef snark::voxel_map< centroid, 3, Eigen::Vector3d, snark::voxel_storage::flat > voxel_map_t;
+typedef voxel_map_t::index_type index_type;
+typedef std::vector< boost::shared_ptr< voxel_map_t > > shards_t;
+
+static std::size_t shard_of_( const index_type& index, std::size_t size ) // quick and dirty spatial hash
+{
+    return ( comma::uint32( index[0] ) * 73856093u ^ comma::uint32( index[1] ) * 19349663u ^ comma::uint32( index[2] ) * 83492791u ) % size;
+}
+
+struct neighbourhood_sum
+{
+    comma::uint64 size; /// number of points or of voxels, see --neighbourhood-weight
+    comma::uint64 points;
+    Eigen::Vector3d sum;
+    
+    neighbourhood_sum() : size( 0 ), points( 0 ), sum( Eigen::Vector3d::Zero() ) {}
+    neighbourhood_sum( comma::uint64 size, comma::uint64 points, const Eigen::Vector3d& sum ) : size( size ), points( points ), sum( sum ) {}
+    void operator+=( const neighbourhood_sum& rhs ) { size += rhs.size; points += rhs.points; sum += rhs.sum; }
+    void operator-=( const neighbourhood_sum& rhs ) { size -= rhs.size; points -= rhs.points; sum -= rhs.sum; }
+};
+
+typedef snark::voxel_neighbourhood< neighbourhood_sum > neighbourhood_t;
+
+static boost::shared_ptr< neighbourhood_t > make_neighbourhood_( const shards_t& shards, comma::uint32 radius, bool weighted )
+{
+    boost::shared_ptr< neighbourhood_t > n;
+    if( radius == 0 ) { return n; }
+    n.reset( new neighbourhood_t( radius ) );
+    for( std::size_t s = 0; s < shards.size(); ++s )
+    {
+        for( voxel_map_t::const_iterator it = shards[s]->begin(); it != shards[s]->end(); ++it ) { n->add( it->first, neighbourhood_sum( weighted ? it->second.size : 1, it->second.size, it->second.sum ) ); }
+    }
+    n->build();
+    return n;
+}
+
+/// parallel voxelisation of a block: points are sharded by voxel index
+/// each shard is accumulated by one task over its own points in input order,
+/// thus sums are exactly the same as in serial voxelisation
+struct sharded_block
+{
+    std::vector< input_point > points;
+    std::vector< index_type > indices;
+    std::vector< comma::uint16 > shard_ids;
+    snark::shard_groups groups;
+    shards_t shards;
+    Eigen::Vector3d origin;
+    Eigen::Vector3d resolution;
+    
+    sharded_block( const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution, unsigned int size ) : shards( size ), origin( origin ), resolution( resolution ) {}
+    
+    struct index_body
+    {
+        sharded_block& b;
+        index_body( sharded_block& b ) : b( b ) {}
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
+        {
+            for( std::size_t i = r.begin(); i != r.end(); ++i )
+            {
+                b.indices[i] = voxel_map_t::index_of( b.points[i].point, b.origin, b.resolution );
+                b.shard_ids[i] = shard_of_( b.indices[i], b.shards.size() );
+            }
+        }
+    };
+    
+    struct shard_body
+    {
+        sharded_block& b;
+        shard_body( sharded_block& b ) : b( b ) {}
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
+        {
+            for( std::size_t s = r.begin(); s != r.end(); ++s )
+            {
+                voxel_map_t& voxels = *b.shards[s];
+                for( snark::shard_groups::const_iterator it = b.groups.begin( s ); it != b.groups.end( s ); ++it )
+                {
+                    centroid& c = voxels[ b.indices[ *it ] ];
+                    if( c.size == 0 ) { c.first = *it; }
+                    c += b.points[ *it ].point;
+                }
+            }
+        }
+    };
+    
+    void voxelise()
+    {
+        for( std::size_t s = 0; s < shards.size(); ++s ) { shards[s].reset( new voxel_map_t( origin, resolution ) ); }
+        indices.resize( points.size() );
+        shard_ids.resize( points.size() );
+        tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, points.size(), 4096 ), index_body( *this ) );
+        groups.assign( shard_ids, shards.size() );
+        tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, shards.size(), 1 ), shard_body( *this ) );
+    }
+};
+
+static void write_( comma::csv::output_stream< centroid >& ostream
+                  , const index_type& key
+                  , centroid c
+                  , unsigned int block
+                  , const Eigen::Vector3d& origin
+                  , const Eigen::Vector3d& resolution
+                  , const neighbourhood_t* neighbourhood
+                  , bool weighted )
+{
+    c.block = block;
+    c.mean = c.sum / c.size;
+    c.index = voxel_map_t::index_of( c.mean, origin, resolution );
+    if( !neighbourhood ) { ostream.write( c ); return; }
+    neighbourhood_sum n = neighbourhood->sum( key );
+    if( weighted ) // as before: the voxel itself is counted twice
+    {
+        c.size += n.points;
+        c.sum += n.sum;
+        c.mean = c.sum / c.size;
+    }
+    else
+    {
+        c.size = n.size;
+        c.mean = n.sum / n.points;
+    }
+    ostream.write( c );
+}
+
+struct write_voxel_
+{
+    comma::csv::output_stream< centroid >& ostream;
+    unsigned int block;
+    const Eigen::Vector3d& origin;
+    const Eigen::Vector3d& resolution;
+    const neighbourhood_t* neighbourhood;
+    bool weighted;
+    write_voxel_( comma::csv::output_stream< centroid >& ostream, unsigned int block, const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution, const neighbourhood_t* neighbourhood, bool weighted ) : ostream( ostream ), block( block ), origin( origin ), resolution( resolution ), neighbourhood( neighbourhood ), weighted( weighted ) {}
+    void operator()( voxel_map_t::const_iterator it ) { write_( ostream, it->first, it->second, block, origin, resolution, neighbourhood, weighted ); }
+};
+
+/// write voxels of all shards in the order of their first points, i.e. exactly as serial voxelisation does
+static void write_ordered_( comma::csv::output_stream< centroid >& ostream, const shards_t& shards, unsigned int block, const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution, const neighbourhood_t* neighbourhood, bool weighted )
+{
+    std::vector< std::pair< voxel_map_t::const_iterator, voxel_map_t::const_iterator > > ranges( shards.size() );
+    for( std::size_t s = 0; s < shards.size(); ++s ) { ranges[s] = std::make_pair( voxel_map_t::const_iterator( shards[s]->begin() ), voxel_map_t::const_iterator( shards[s]->end() ) ); }
+    write_voxel_ write( ostream, block, origin, resolution, neighbourhood, weighted );
+    snark::merge_shards( ranges, write );
+}
+
 namespace comma { namespace visiting {
 
 template <> struct traits< input_point >
@@ -122,11 +274,16 @@ int main( int argc, char** argv )
         std::string resolution_string;
         boost::program_options::options_description description( "options" );
         comma::uint32 neighbourhood_radius;
+        unsigned int threads;
+        std::string neighbourhood_weight;
         description.add_options()
             ( "help,h", "display help message" )
             ( "resolution", boost::program_options::value< std::string >( &resolution_string ), "voxel map resolution, e.g. \"0.2\" or \"0.2,0.2,0.5\"" )
             ( "origin", boost::program_options::value< std::string >( &origin_string )->default_value( "0,0,0" ), "voxel map origin" )
-            ( "neighbourhood-radius,r", boost::program_options::value< comma::uint32 >( &neighbourhood_radius )->default_value( 0 ), "calculate count of neighbours at given radius" );
+            ( "neighbourhood-radius,r", boost::program_options::value< comma::uint32 >( &neighbourhood_radius )->default_value( 0 ), "calculate count of neighbours at given radius; memory per occupied brick of voxels is bounded, since bricks are at most 16x16x16 voxels; for radius over 7, neighbourhoods span more bricks, thus the time grows with the radius" )
+            ( "neighbourhood-weight", boost::program_options::value< std::string >( &neighbourhood_weight )->default_value( "points" ), "with --neighbourhood-radius, <what>: points: output number of points in the neighbourhood (the voxel itself counted twice, as before); voxels: output number of occupied voxels in the neighbourhood" )
+            ( "threads", boost::program_options::value< unsigned int >( &threads )->default_value( 1 ), "number of threads; 0: as many as cores; if more than 1, points of each block are buffered and voxelised in shards by voxel index; output is the same as with one thread" )
+            ( "unordered", "with --threads, output voxels shard by shard, rather than in the order of their first points; a bit faster, same voxels" );
         description.add( comma::csv::program_options::description( "x,y,z,block" ) );
         boost::program_options::variables_map vm;
         boost::program_options::store( boost::program_options::parse_command_line( argc, argv, description), vm );
@@ -152,6 +309,12 @@ int main( int argc, char** argv )
         comma::csv::ascii< Eigen::Vector3d >().get( origin, origin_string );
         if( resolution_string.find_first_of( ',' ) == std::string::npos ) { resolution_string = resolution_string + ',' + resolution_string + ',' + resolution_string; }
         comma::csv::ascii< Eigen::Vector3d >().get( resolution, resolution_string );
+        if( threads == 0 ) { threads = tbb::task_scheduler_init::default_num_threads(); }
+        if( threads > 65536 ) { COMMA_THROW( comma::exception, "expected --threads not more than 65536; got " << threads ); }
+        bool ordered = vm.count( "unordered" ) == 0;
+        if( neighbourhood_weight != "points" && neighbourhood_weight != "voxels" ) { COMMA_THROW( comma::exception, "expected --neighbourhood-weight points or voxels; got \"" << neighbourhood_weight << "\"" ); }
+        bool weighted = neighbourhood_weight == "points";
+        tbb::task_scheduler_init init( threads );
         comma::csv::input_stream< input_point > istream( std::cin, csv );
         comma::csv::options output_csv = csv;
         output_csv.full_xpath = true;
@@ -171,78 +334,36 @@ int main( int argc, char** argv )
         const input_point* last = NULL;
         while( !is_shutdown && !std::cin.eof() && std::cin.good() )
         {
-            snark::voxel_map< centroid, 3 > voxels( origin, resolution );
-            if( last ) { voxels.touch_at( last->point )->second += last->point; }
-            while( !is_shutdown && !std::cin.eof() && std::cin.good() )
-            {
-                last = istream.read();
-                if( !last || last->block != block ) { break; }
-                voxels.touch_at( last->point )->second += last->point;
-            }
-            if( is_shutdown ) { break; }
-//             for( snark::voxel_map< centroid, 3 >::iterator it = voxels.begin(); it != voxels.end(); ++it )
-//             {
-//                 it->second.block = block;
-//                 it->second.index = snark::voxel_map< centroid, 3 >::index_of( it->second.mean, origin, resolution );
-//                 if( neighbourhood_radius > 0 ) // quick and dirty
-//                 {
-//                     snark::voxel_map< centroid, 3 >::index_type index;
-//                     snark::voxel_map< centroid, 3 >::index_type begin = {{ it->first[0] - neighbourhood_radius, it->first[1] - neighbourhood_radius, it->first[2] - neighbourhood_radius }};
-//                     snark::voxel_map< centroid, 3 >::index_type end = {{ it->first[0] + neighbourhood_radius + 1, it->first[1] + neighbourhood_radius + 1, it->first[2] + neighbourhood_radius + 1 }};
-//                     std::size_t size = 0;
-//                     Eigen::Vector3d mean( 0, 0, 0 );
-//                     for( index[0] = begin[0]; index[0] < end[0]; ++index[0] )                        
-//                     {
-//                         for( index[1] = begin[1]; index[1] < end[1]; ++index[1] )
-//                         {
-//                             for( index[2] = begin[2]; index[2] < end[2]; ++index[2] )
-//                             {
-//                                 snark::voxel_map< centroid, 3 >::const_iterator nit = voxels.find( index );
-//                                 if( nit == voxels.end() ) { continue; }
-//                                 ostream.write( it->second ); // todo: remove!!
-//                                 size += nit->second.size;
-//                                 //mean += ( nit->second.mean * nit->second.size );
-//                             }
-//                         }
-//                     }
-//                     //it->second.size = size;
-//                     
-//                     //mean /= size;
-//                     //it->second.mean = mean;
-//                 }
-//                 ostream.write( it->second );
-//             }
-
-            for( snark::voxel_map< centroid, 3 >::iterator it = voxels.begin(); it != voxels.end(); ++it )
+            if( threads > 1 )
             {
-                it->second.block = block;
-                it->second.index = snark::voxel_map< centroid, 3 >::index_of( it->second.mean, origin, resolution );
-                if( neighbourhood_radius == 0 )
+                sharded_block b( origin, resolution, threads );
+                if( last ) { b.points.push_back( *last ); }
+                while( !is_shutdown && !std::cin.eof() && std::cin.good() )
                 {
-                    ostream.write( it->second );
+                    last = istream.read();
+                    if( !last || last->block != block ) { break; }
+                    b.points.push_back( *last );
                 }
-                else
+                if( is_shutdown ) { break; }
+                b.voxelise();
+                boost::shared_ptr< neighbourhood_t > neighbourhood = make_neighbourhood_( b.shards, neighbourhood_radius, weighted );
+                if( ordered ) { write_ordered_( ostream, b.shards, block, origin, resolution, neighbourhood.get(), weighted ); }
+                else { for( std::size_t s = 0; s < b.shards.size(); ++s ) { for( voxel_map_t::const_iterator it = b.shards[s]->begin(); it != b.shards[s]->end(); ++it ) { write_( ostream, it->first, it->second, block, origin, resolution, neighbourhood.get(), weighted ); } } }
+            }
+            else
+            {
+                shards_t shards( 1, boost::shared_ptr< voxel_map_t >( new voxel_map_t( origin, resolution ) ) );
+                voxel_map_t& voxels = *shards[0];
+                if( last ) { voxels.touch_at( last->point )->second += last->point; }
+                while( !is_shutdown && !std::cin.eof() && std::cin.good() )
                 {
-                    centroid c = it->second;
-                    snark::voxel_map< centroid, 3 >::index_type index;
-                    snark::voxel_map< centroid, 3 >::index_type begin = {{ it->first[0] - neighbourhood_radius, it->first[1] - neighbourhood_radius, it->first[2] - neighbourhood_radius }};
-                    snark::voxel_map< centroid, 3 >::index_type end = {{ it->first[0] + neighbourhood_radius + 1, it->first[1] + neighbourhood_radius + 1, it->first[2] + neighbourhood_radius + 1 }};
-                    for( index[0] = begin[0]; index[0] < end[0]; ++index[0] )                        
-                    {
-                        for( index[1] = begin[1]; index[1] < end[1]; ++index[1] )
-                        {
-                            for( index[2] = begin[2]; index[2] < end[2]; ++index[2] )
-                            {
-                                snark::voxel_map< centroid, 3 >::const_iterator nit = voxels.find( index );
-                                if( nit == voxels.end() ) { continue; }
-                                c.size += nit->second.size;
-                                c.mean += ( nit->second.mean * nit->second.size );
-                            }
-                        }
-                    }
-                    c.mean /= c.size;
-                    ostream.write( c );
+                    last = istream.read();
+                    if( !last || last->block != block ) { break; }
+                    voxels.touch_at( last->point )->second += last->point;
                 }
+                if( is_shutdown ) { break; }
+                boost::shared_ptr< neighbourhood_t > neighbourhood = make_neighbourhood_( shards, neighbourhood_radius, weighted );
+                for( voxel_map_t::const_iterator it = voxels.begin(); it != voxels.end(); ++it ) { write_( ostream, it->first, it->second, block, origin, resolution, neighbourhood.get(), weighted ); }
             }
             if( !last ) { break; }
             block = last->block;
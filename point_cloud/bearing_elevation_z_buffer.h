@@ -0,0 +1,257 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_BEARING_ELEVATION_Z_BUFFER_H
+#define SNARK_POINT_CLOUD_BEARING_ELEVATION_Z_BUFFER_H
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <boost/multi_array.hpp>
+#include <comma/base/exception.h>
+#include <comma/math/compare.h>
+#include <snark/math/range_bearing_elevation.h>
+#include <snark/point_cloud/spherical_grid.h>
+
+namespace snark {
+
+/// dilated z-buffer on bearing_elevation_grid for occlusion queries against a reference point cloud
+///
+/// each angular cell keeps the nearest reference point and the angular extents
+/// of all the reference points within the given angular radius of the cell;
+/// the table is dilated once in build(), thus a query is a single lookup,
+/// whatever the density of the reference point cloud
+///
+/// the neighbourhood is a square of cells: all reference points within ceil( radius / resolution )
+/// cells of the query cell along bearing and elevation are taken into account, i.e. the
+/// neighbourhood contains, but is larger than a disk of given radius around the query direction;
+/// finer resolution gives a tighter neighbourhood at the cost of memory
+///
+/// therefore the results are not those of an exact query on the disk: more reference points
+/// contribute to the extents, thus trace() may find a direction surrounded, where the disk would
+/// not; but also the nearest range is taken over more reference points, thus it may be nearer
+/// than on the disk; e.g. with a range threshold on the nearest range, points may be both
+/// gained and lost with respect to the exact query, i.e. results are neither a superset nor a subset
+///
+/// memory: one cell per resolution x resolution over the elevation span of the reference cloud
+///
+/// usage:
+///     bearing_elevation_z_buffer< comma::uint64 > z( radius );
+///     for( ... ) { z.add( point, index ); }
+///     z.build();
+///     for( ... ) { const bearing_elevation_z_buffer< comma::uint64 >::cell* c = z.trace( bearing, elevation ); ... } // thread-safe
+template < typename T >
+class bearing_elevation_z_buffer
+{
+    public:
+        /// nearest reference point and angular extents of the reference points in the neighbourhood of a cell
+        struct cell
+        {
+            double range; /// range of the nearest point
+            T value; /// value of the nearest point
+            double bearing_min; /// bearing extents relative to the beginning of the cell
+            double bearing_max;
+            double elevation_min;
+            double elevation_max;
+
+            cell() : range( std::numeric_limits< double >::max() ), value(), bearing_min( 0 ), bearing_max( 0 ), elevation_min( 0 ), elevation_max( 0 ) {}
+
+            bool empty() const { return range == std::numeric_limits< double >::max(); }
+
+            /// merge with another cell, whose bearing extents are shifted by given offset
+            void merge( const cell& rhs, double bearing_offset );
+        };
+
+        /// constructor
+        /// @param radius angular radius in radians
+        /// @param resolution cell size in radians; default: radius / 2
+        bearing_elevation_z_buffer( double radius, double resolution = 0 );
+
+        /// add reference point; call before build()
+        void add( const range_bearing_elevation& point, const T& value );
+
+        /// build the dilated table and release the added points; call once
+        void build();
+
+        /// @return cell covering given direction, if it has any reference points within radius, otherwise NULL
+        const cell* find( double bearing, double elevation ) const;
+
+        /// @return cell covering given direction, if the direction is inside of the angular extents of the reference points
+        ///         within radius, i.e. the direction is surrounded by the reference points, otherwise NULL
+        const cell* trace( double bearing, double elevation ) const;
+
+        /// number of cells
+        std::size_t size() const { return cells_.num_elements(); }
+
+        double radius() const { return radius_; }
+
+        double resolution() const { return resolution_; }
+
+    private:
+        struct entry_
+        {
+            range_bearing_elevation point;
+            T value;
+            entry_( const range_bearing_elevation& point, const T& value ) : point( point ), value( value ) {}
+        };
+        double radius_;
+        double resolution_;
+        std::vector< entry_ > points_;
+        bearing_elevation_grid::index index_;
+        boost::multi_array< cell, 2 > cells_;
+        std::size_t bearings_;
+        std::size_t elevations_;
+        bool built_;
+
+        bool index_of_( double bearing, double elevation, bearing_elevation_grid::index::type& i ) const;
+        double bearing_of_( std::size_t i ) const { return -M_PI + resolution_ * i; }
+        static double wrap_( double a ) { return a >= M_PI ? a - M_PI * 2 : a < -M_PI ? a + M_PI * 2 : a; } // quick and dirty: a is a difference of two normalized bearings
+};
+
+template < typename T >
+inline void bearing_elevation_z_buffer< T >::cell::merge( const typename bearing_elevation_z_buffer< T >::cell& rhs, double bearing_offset )
+{
+    if( rhs.empty() ) { return; }
+    if( empty() )
+    {
+        *this = rhs;
+        bearing_min += bearing_offset;
+        bearing_max += bearing_offset;
+        return;
+    }
+    if( rhs.range < range ) { range = rhs.range; value = rhs.value; }
+    bearing_min = std::min( bearing_min, rhs.bearing_min + bearing_offset );
+    bearing_max = std::max( bearing_max, rhs.bearing_max + bearing_offset );
+    elevation_min = std::min( elevation_min, rhs.elevation_min );
+    elevation_max = std::max( elevation_max, rhs.elevation_max );
+}
+
+template < typename T >
+inline bearing_elevation_z_buffer< T >::bearing_elevation_z_buffer( double radius, double resolution )
+    : radius_( radius )
+    , resolution_( resolution == 0 ? radius / 2 : resolution )
+    , bearings_( 0 )
+    , elevations_( 0 )
+    , built_( false )
+{
+    if( !( radius_ > 0 ) ) { COMMA_THROW( comma::exception, "expected positive radius; got " << radius ); }
+    if( !( resolution_ > 0 ) ) { COMMA_THROW( comma::exception, "expected positive resolution; got " << resolution ); }
+}
+
+template < typename T >
+inline void bearing_elevation_z_buffer< T >::add( const range_bearing_elevation& point, const T& value )
+{
+    if( built_ ) { COMMA_THROW( comma::exception, "cannot add points after build()" ); }
+    points_.push_back( entry_( point, value ) );
+}
+
+template < typename T >
+inline void bearing_elevation_z_buffer< T >::build()
+{
+    if( built_ ) { COMMA_THROW( comma::exception, "already built" ); }
+    built_ = true;
+    if( points_.empty() ) { return; }
+    double min = points_[0].point.elevation();
+    double max = min;
+    for( std::size_t i = 1; i < points_.size(); ++i ) { min = std::min( min, points_[i].point.elevation() ); max = std::max( max, points_[i].point.elevation() ); }
+    std::size_t k = std::ceil( radius_ / resolution_ );
+    index_ = bearing_elevation_grid::index( -M_PI, std::max( -M_PI / 2, min - resolution_ * ( k + 1 ) ), resolution_ );
+    bearings_ = M_PI * 2 / resolution_; // as in bearing_elevation_grid::index: the last partial cell wraps into the first one
+    elevations_ = index_( 0, max )[1] + k + 1;
+    boost::multi_array< cell, 2 > raw( boost::extents[ bearings_ ][ elevations_ ] );
+    for( std::size_t n = 0; n < points_.size(); ++n )
+    {
+        const range_bearing_elevation& p = points_[n].point;
+        const bearing_elevation_grid::index::type& i = index_( p.bearing(), p.elevation() );
+        cell c;
+        c.range = p.range();
+        c.value = points_[n].value;
+        c.bearing_min = c.bearing_max = wrap_( p.bearing() - bearing_of_( i[0] ) );
+        c.elevation_min = c.elevation_max = p.elevation();
+        raw[ i[0] ][ i[1] ].merge( c, 0 );
+    }
+    std::vector< entry_ >().swap( points_ );
+    boost::multi_array< cell, 2 > dilated( boost::extents[ bearings_ ][ elevations_ ] ); // dilation is separable: first along bearing, wrapping around...
+    int b = bearings_;
+    for( int i = 0; i < b; ++i )
+    {
+        for( int d = -int( k ); d <= int( k ); ++d )
+        {
+            int s = ( i + d ) % b;
+            if( s < 0 ) { s += b; }
+            double offset = wrap_( bearing_of_( s ) - bearing_of_( i ) );
+            for( std::size_t j = 0; j < elevations_; ++j ) { dilated[i][j].merge( raw[s][j], offset ); }
+        }
+    }
+    cells_.resize( boost::extents[ bearings_ ][ elevations_ ] ); // ...then along elevation
+    int e = elevations_;
+    for( int i = 0; i < b; ++i )
+    {
+        for( int j = 0; j < e; ++j )
+        {
+            for( int t = std::max( 0, j - int( k ) ); t <= std::min( e - 1, j + int( k ) ); ++t ) { cells_[i][j].merge( dilated[i][t], 0 ); }
+        }
+    }
+}
+
+template < typename T >
+inline bool bearing_elevation_z_buffer< T >::index_of_( double bearing, double elevation, bearing_elevation_grid::index::type& i ) const
+{
+    if( cells_.num_elements() == 0 || comma::math::less( elevation, index_.begin().e() ) ) { return false; }
+    i = index_( bearing, elevation );
+    return i[0] < bearings_ && i[1] < elevations_;
+}
+
+template < typename T >
+inline const typename bearing_elevation_z_buffer< T >::cell* bearing_elevation_z_buffer< T >::find( double bearing, double elevation ) const
+{
+    bearing_elevation_grid::index::type i;
+    if( !index_of_( bearing, elevation, i ) ) { return NULL; }
+    const cell& c = cells_[ i[0] ][ i[1] ];
+    return c.empty() ? NULL : &c;
+}
+
+template < typename T >
+inline const typename bearing_elevation_z_buffer< T >::cell* bearing_elevation_z_buffer< T >::trace( double bearing, double elevation ) const
+{
+    bearing_elevation_grid::index::type i;
+    if( !index_of_( bearing, elevation, i ) ) { return NULL; }
+    const cell& c = cells_[ i[0] ][ i[1] ];
+    if( c.empty() ) { return NULL; }
+    double b = wrap_( bearing - bearing_of_( i[0] ) );
+    return    comma::math::less( b, c.bearing_min )
+           || comma::math::less( c.bearing_max, b )
+           || !comma::math::less( c.elevation_min, elevation )
+           || !comma::math::less( elevation, c.elevation_max ) ? NULL : &c;
+}
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_BEARING_ELEVATION_Z_BUFFER_H
@@ -0,0 +1,132 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_CENTROIDS_H
+#define SNARK_POINT_CLOUD_CENTROIDS_H
+
+#include <Eigen/Core>
+#include <comma/base/types.h>
+#include <snark/point_cloud/flat_voxel_map.h>
+
+namespace snark {
+
+/// running statistics of a set of points: number of points, sum, extents and, optionally, second moments
+struct centroid
+{
+    std::size_t size;
+    Eigen::Vector3d sum;
+    Eigen::Vector3d min;
+    Eigen::Vector3d max;
+    Eigen::Vector3d shift; // first point: second moments are accumulated relative to it for numerical stability
+    Eigen::Matrix3d moments;
+    comma::uint64 first; // index of the first point, e.g. to output points in order
+
+    centroid() : size( 0 ), sum( Eigen::Vector3d::Zero() ), min( Eigen::Vector3d::Zero() ), max( Eigen::Vector3d::Zero() ), shift( Eigen::Vector3d::Zero() ), moments( Eigen::Matrix3d::Zero() ), first( 0 ) {}
+
+    /// add point
+    /// @param index index of the point, e.g. its position in the input
+    /// @param covariance if true, accumulate second moments; should be the same for all points
+    void add( const Eigen::Vector3d& p, comma::uint64 index, bool covariance = false );
+
+    /// return mean
+    Eigen::Vector3d mean() const { return sum / size; }
+
+    /// return extents of the bounding box
+    Eigen::Vector3d extents() const { return max - min; }
+
+    /// return population covariance, if points were added with covariance
+    Eigen::Matrix3d covariance() const;
+};
+
+/// centroids of points by id, e.g. by partition id
+///
+/// single pass: centroids are kept in a flat hash map and iterated
+/// in the order of the first point of each id
+///
+/// usage:
+///     centroids c;
+///     for( ... ) { c.add( id, point, index ); }
+///     for( centroids::const_iterator it = c.begin(); it != c.end(); ++it ) { std::cout << centroids::id( it ) << ": " << it->second.mean() << std::endl; }
+///     c.clear(); // e.g. for the next block of points, keeps memory
+class centroids
+{
+    public:
+        typedef flat_voxel_map< centroid, 1 > map_type;
+        typedef map_type::const_iterator const_iterator;
+
+        /// constructor
+        /// @param covariance if true, accumulate second moments for covariance
+        centroids( bool covariance = false ) : covariance_( covariance ) {}
+
+        /// add point; return true, if it is the first point with this id
+        bool add( comma::uint32 id, const Eigen::Vector3d& p, comma::uint64 index );
+
+        const_iterator begin() const { return map_.begin(); }
+        const_iterator end() const { return map_.end(); }
+        std::size_t size() const { return map_.size(); }
+        bool empty() const { return map_.empty(); }
+
+        /// clear, keeping allocated memory
+        void clear() { map_.clear(); }
+
+        /// return id of the centroid
+        static comma::uint32 id( const_iterator it ) { return comma::uint32( it->first[0] ); }
+
+    private:
+        map_type map_;
+        bool covariance_;
+};
+
+inline void centroid::add( const Eigen::Vector3d& p, comma::uint64 index, bool covariance )
+{
+    if( size == 0 ) { min = max = shift = p; first = index; }
+    else { min = min.cwiseMin( p ); max = max.cwiseMax( p ); }
+    sum += p;
+    ++size;
+    if( covariance ) { Eigen::Vector3d d = p - shift; moments += d * d.transpose(); }
+}
+
+inline Eigen::Matrix3d centroid::covariance() const
+{
+    Eigen::Vector3d d = mean() - shift;
+    return moments / size - d * d.transpose();
+}
+
+inline bool centroids::add( comma::uint32 id, const Eigen::Vector3d& p, comma::uint64 index )
+{
+    map_type::key_type key = {{ comma::int32( id ) }};
+    std::pair< map_type::iterator, bool > r = map_.insert( map_type::value_type( key, centroid() ) );
+    r.first->second.add( p, index, covariance_ );
+    return r.second;
+}
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_CENTROIDS_H
@@ -0,0 +1,165 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_CONNECTED_COMPONENTS_H_
+#define SNARK_POINT_CLOUD_CONNECTED_COMPONENTS_H_
+
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <comma/base/types.h>
+
+namespace snark {
+
+/// disjoint sets of integers 0 to size - 1, union by rank, path halving
+class disjoint_sets
+{
+    public:
+        disjoint_sets( std::size_t size ) : parents_( size ), ranks_( size, 0 ) { for( std::size_t i = 0; i < size; ++i ) { parents_[i] = i; } }
+
+        /// return representative of the set of i
+        comma::uint32 find( comma::uint32 i )
+        {
+            while( parents_[i] != i ) { parents_[i] = parents_[ parents_[i] ]; i = parents_[i]; }
+            return i;
+        }
+
+        /// merge sets of i and j
+        void unite( comma::uint32 i, comma::uint32 j )
+        {
+            i = find( i );
+            j = find( j );
+            if( i == j ) { return; }
+            if( ranks_[i] < ranks_[j] ) { std::swap( i, j ); }
+            parents_[j] = i;
+            if( ranks_[i] == ranks_[j] ) { ++ranks_[i]; }
+        }
+
+        std::size_t size() const { return parents_.size(); }
+
+    private:
+        std::vector< comma::uint32 > parents_;
+        std::vector< comma::uint8 > ranks_;
+};
+
+namespace impl {
+
+/// unite each element in [begin, end) with its neighbours preceding it in the iteration order;
+/// neighbours preceding first are not united, but appended to seams
+template < typename It, typename N, typename Tr >
+inline void unite_neighbours( const std::vector< It >& elements, disjoint_sets& sets, comma::uint32 first, comma::uint32 begin, comma::uint32 end, std::vector< std::pair< comma::uint32, comma::uint32 > >* seams )
+{
+    for( comma::uint32 i = begin; i < end; ++i )
+    {
+        const It& it = elements[i];
+        for( typename N::iterator nit = N::begin( it ); nit != N::end( it ); ++nit )
+        {
+            if( Tr::skip( *nit ) || !Tr::visited( *nit ) || !Tr::same( *it, *nit ) ) { continue; }
+            comma::uint32 j = Tr::id( *nit );
+            if( j >= i ) { continue; } // the neighbourhood is symmetric, thus it is enough to look back
+            if( j >= first ) { sets.unite( i, j ); } else { seams->push_back( std::make_pair( i, j ) ); }
+        }
+    }
+}
+
+} // namespace impl {
+
+/// partition elements of container into connected components
+///
+/// same as equivalence_classes (with the same traits), but uses
+/// disjoint sets: elements are enumerated, united with their neighbours,
+/// and then relabelled in a single pass, thus the cost is close to linear
+/// in the number of elements, whatever the shape of partitions
+///
+/// partition ids are consecutive, starting from min_id, in the iteration order
+/// of the first element of each partition; for the same input, the
+/// partitions are the same as of equivalence_classes, up to their ids
+///
+/// if threads > 1, elements are split into as many tiles in the iteration
+/// order (e.g. slabs of a voxel grid); tiles are labelled in parallel, and
+/// then united across the seams; the result is the same as for one thread
+///
+/// requirements
+///     - neighbourhood and Tr::same() are symmetric
+///     - Tr::id() can hold index of an element
+///     - concurrent neighbourhood iteration is safe, if threads > 1
+///
+/// @param threads number of threads
+template < typename It, typename N, typename Tr >
+inline std::map< comma::uint32, std::list< It > > connected_components( const It& begin, const It& end, comma::uint32 min_id, unsigned int threads = 1 )
+{
+    std::vector< It > elements;
+    for( It it = begin; it != end; ++it )
+    {
+        if( Tr::skip( *it ) ) { continue; }
+        Tr::set_visited( *it, true );
+        Tr::set_id( *it, elements.size() );
+        elements.push_back( it );
+    }
+    disjoint_sets sets( elements.size() );
+    comma::uint32 size = elements.size();
+    if( threads < 2 || size < threads )
+    {
+        impl::unite_neighbours< It, N, Tr >( elements, sets, 0, 0, size, NULL );
+    }
+    else
+    {
+        std::vector< std::vector< std::pair< comma::uint32, comma::uint32 > > > seams( threads );
+        boost::thread_group group;
+        for( unsigned int t = 0; t < threads; ++t ) // tiles write only to their own ranges of sets
+        {
+            comma::uint32 first = comma::uint64( size ) * t / threads;
+            comma::uint32 last = comma::uint64( size ) * ( t + 1 ) / threads;
+            group.create_thread( boost::bind( &impl::unite_neighbours< It, N, Tr >, boost::cref( elements ), boost::ref( sets ), first, first, last, &seams[t] ) );
+        }
+        group.join_all();
+        for( unsigned int t = 0; t < threads; ++t ) { for( std::size_t k = 0; k < seams[t].size(); ++k ) { sets.unite( seams[t][k].first, seams[t][k].second ); } }
+    }
+    static const comma::uint32 none = comma::uint32( -1 );
+    std::vector< comma::uint32 > labels( size, none );
+    std::vector< std::list< It > > lists;
+    for( comma::uint32 i = 0; i < size; ++i )
+    {
+        comma::uint32& label = labels[ sets.find( i ) ];
+        if( label == none ) { label = lists.size(); lists.push_back( std::list< It >() ); }
+        Tr::set_id( *elements[i], min_id + label );
+        lists[label].push_back( elements[i] );
+    }
+    std::map< comma::uint32, std::list< It > > partitions;
+    for( std::size_t i = 0; i < lists.size(); ++i ) { partitions.insert( partitions.end(), std::make_pair( min_id + comma::uint32( i ), std::list< It >() ) )->second.swap( lists[i] ); }
+    return partitions;
+}
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_CONNECTED_COMPONENTS_H_
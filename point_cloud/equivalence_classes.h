@@ -43,6 +43,7 @@
 namespace snark {
 
 /// partition elements of container
+/// @note connected_components() in connected_components.h gives the same partitions (up to ids) much faster on large inputs
 template < typename It, typename N, typename Tr >
 inline std::map< comma::uint32, std::list< It > > equivalence_classes( const It& begin, const It& end, comma::uint32 minId )
 {
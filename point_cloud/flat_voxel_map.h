@@ -0,0 +1,184 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_FLAT_VOXEL_MAP_H
+#define SNARK_POINT_CLOUD_FLAT_VOXEL_MAP_H
+
+#include <deque>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <boost/array.hpp>
+#include <boost/static_assert.hpp>
+#include <comma/base/exception.h>
+#include <comma/base/types.h>
+
+namespace snark {
+
+/// open addressing hash map from voxel index to voxel, a drop-in alternative to
+/// boost::unordered_map< boost::array< comma::int32, D >, V > for voxel_map
+///
+/// the table stores only voxel indices and positions of voxels, thus probing
+/// is linear over a contiguous array of integers without following pointers;
+/// indices are stored as they are, i.e. any comma::int32 index is accepted,
+/// e.g. of georeferenced points far from the origin
+///
+/// voxels themselves are stored densely in insertion order in a deque, so that:
+///     - iteration is sequential in memory and deterministic
+///     - references to voxels remain valid when the map grows
+///     - iterators remain valid, except end()
+///
+/// erasing single voxels is not supported
+template < typename V, unsigned int D >
+class flat_voxel_map
+{
+    public:
+        BOOST_STATIC_ASSERT( D > 0 );
+
+        typedef boost::array< comma::int32, D > key_type;
+        typedef V mapped_type;
+        typedef std::pair< const key_type, V > value_type;
+        typedef typename std::deque< value_type >::iterator iterator;
+        typedef typename std::deque< value_type >::const_iterator const_iterator;
+        typedef std::size_t size_type;
+
+        /// constructor
+        flat_voxel_map() : mask_( 0 ) {}
+
+        iterator begin() { return values_.begin(); }
+        iterator end() { return values_.end(); }
+        const_iterator begin() const { return values_.begin(); }
+        const_iterator end() const { return values_.end(); }
+        size_type size() const { return values_.size(); }
+        bool empty() const { return values_.empty(); }
+
+        /// find voxel by index; end(), if not found
+        iterator find( const key_type& key ) { std::size_t slot; return find_( key, slot ) ? values_.begin() + positions_[slot] : values_.end(); }
+
+        /// find voxel by index; end(), if not found
+        const_iterator find( const key_type& key ) const { std::size_t slot; return find_( key, slot ) ? values_.begin() + positions_[slot] : values_.end(); }
+
+        /// insert voxel, if it does not exist; same semantics as std::map::insert()
+        std::pair< iterator, bool > insert( const value_type& value );
+
+        /// return voxel, insert default-constructed one, if it does not exist
+        V& operator[]( const key_type& key ) { return insert( value_type( key, V() ) ).first->second; }
+
+        /// number of elements equal to key: 0 or 1
+        size_type count( const key_type& key ) const { std::size_t slot; return find_( key, slot ) ? 1 : 0; }
+
+        /// prepare for given number of voxels without growing
+        void reserve( size_type size );
+
+        /// remove all voxels
+        void clear();
+
+    private:
+        std::vector< key_type > keys_;
+        std::vector< comma::uint32 > positions_; // position of voxel in values_; empty_() for empty slot
+        std::deque< value_type > values_;
+        std::size_t mask_;
+
+        static comma::uint32 empty_() { return std::numeric_limits< comma::uint32 >::max(); } // never a valid position, see insert()
+        static std::size_t hash_( const key_type& key );
+        bool find_( const key_type& key, std::size_t& slot ) const;
+        void rehash_( std::size_t capacity );
+};
+
+template < typename V, unsigned int D >
+inline std::size_t flat_voxel_map< V, D >::hash_( const key_type& key ) // fibonacci hashing, mixes all bits of all dimensions into high bits
+{
+    comma::uint64 h = 0;
+    for( unsigned int i = 0; i < D; ++i ) { h = ( h ^ comma::uint32( key[i] ) ) * 0x9E3779B97F4A7C15ULL; }
+    return static_cast< std::size_t >( h >> 32 );
+}
+
+template < typename V, unsigned int D >
+inline bool flat_voxel_map< V, D >::find_( const key_type& key, std::size_t& slot ) const
+{
+    if( keys_.empty() ) { return false; }
+    for( slot = hash_( key ) & mask_; positions_[slot] != empty_(); slot = ( slot + 1 ) & mask_ )
+    {
+        if( keys_[slot] == key ) { return true; }
+    }
+    return false; // slot is the empty slot, where the key would go
+}
+
+template < typename V, unsigned int D >
+inline std::pair< typename flat_voxel_map< V, D >::iterator, bool > flat_voxel_map< V, D >::insert( const value_type& value )
+{
+    std::size_t slot = 0;
+    if( find_( value.first, slot ) ) { return std::make_pair( values_.begin() + positions_[slot], false ); }
+    if( values_.size() >= empty_() ) { COMMA_THROW( comma::exception, "too many voxels" ); }
+    if( ( values_.size() + 1 ) * 2 > keys_.size() ) // keep load factor under 0.5
+    {
+        rehash_( keys_.empty() ? 64 : keys_.size() * 2 );
+        slot = hash_( value.first ) & mask_;
+        while( positions_[slot] != empty_() ) { slot = ( slot + 1 ) & mask_; }
+    }
+    keys_[slot] = value.first;
+    positions_[slot] = values_.size();
+    values_.push_back( value );
+    return std::make_pair( values_.end() - 1, true );
+}
+
+template < typename V, unsigned int D >
+inline void flat_voxel_map< V, D >::reserve( size_type size )
+{
+    std::size_t capacity = 64;
+    while( capacity < size * 2 ) { capacity *= 2; }
+    if( capacity > keys_.size() ) { rehash_( capacity ); }
+}
+
+template < typename V, unsigned int D >
+inline void flat_voxel_map< V, D >::clear()
+{
+    std::fill( positions_.begin(), positions_.end(), empty_() );
+    values_.clear();
+}
+
+template < typename V, unsigned int D >
+inline void flat_voxel_map< V, D >::rehash_( std::size_t capacity )
+{
+    keys_.resize( capacity );
+    positions_.assign( capacity, empty_() );
+    mask_ = capacity - 1;
+    for( std::size_t i = 0; i < values_.size(); ++i ) // voxels stay in place, only the table gets rebuilt
+    {
+        std::size_t slot = hash_( values_[i].first ) & mask_;
+        while( positions_[slot] != empty_() ) { slot = ( slot + 1 ) & mask_; }
+        keys_[slot] = values_[i].first;
+        positions_[slot] = i;
+    }
+}
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_FLAT_VOXEL_MAP_H
@@ -0,0 +1,495 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_IMPL_BRICK_PIN_SCREEN_H_
+#define SNARK_POINT_CLOUD_IMPL_BRICK_PIN_SCREEN_H_
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+#include <boost/array.hpp>
+#include <Eigen/Core>
+#include <comma/base/types.h>
+#include <snark/point_cloud/flat_voxel_map.h>
+
+namespace snark {
+
+/// sparse alternative to pin_screen with the same interface, except for column access
+///
+/// elements are stored in lazily allocated bricks of 8x8x8 elements with
+/// dense arrays and occupancy bits inside, indexed by a hashed directory;
+/// thus memory grows with the number of occupied bricks rather than with
+/// the 2D extents of the grid, and access does not walk a tree
+///
+/// iteration and neighbourhood iteration are in the same order as for pin_screen,
+/// i.e. lexicographic by index, thus algorithms like equivalence_classes
+/// produce the same results with either
+///
+/// limitations
+///     - indices are limited to 2^34, i.e. about 17 billion elements along each axis, since brick indices are stored as int32
+///     - references to elements remain valid, until erased; iterators get
+///       invalidated, if an element is added to a new brick
+///     - begin() sorts bricks, if new bricks have been added; do not call it concurrently
+///     - erasing elements does not release bricks
+///     - clear() keeps allocated bricks for reuse, e.g. for the next block of data
+template < typename T >
+class brick_pin_screen
+{
+    public:
+        /// value type
+        typedef T value_type;
+
+        /// index type
+        typedef Eigen::Matrix< std::size_t, 1, 3 > index_type;
+
+        /// size type
+        typedef Eigen::Matrix< std::size_t, 1, 2 > size_type;
+
+        /// column type, returned by value
+        typedef std::map< std::size_t, T > column_type;
+
+        /// brick edge
+        enum { edge = 8 };
+
+        /// constructor
+        brick_pin_screen( std::size_t size1, std::size_t size2 ) : size_( size1, size2 ), used_( 0 ), sorted_( true ) {}
+
+        /// constructor
+        brick_pin_screen( size_type size ) : size_( size ), used_( 0 ), sorted_( true ) {}
+
+        /// return 2D array size
+        size_type size() const { return size_; }
+
+        /// return copy of column; slow, use iterators or find() instead
+        column_type column( std::size_t i, std::size_t j ) const;
+
+        /// return column height
+        std::size_t height( std::size_t i, std::size_t j ) const;
+
+        /// return true, if element exists
+        bool exists( std::size_t i, std::size_t j, std::size_t k ) const { return find( i, j, k ) != NULL; }
+
+        /// return true, if element exists
+        bool exists( const index_type& i ) const { return exists( i[0], i[1], i[2] ); }
+
+        /// return pointer to element, if exists
+        T* find( std::size_t i, std::size_t j, std::size_t k ) { return const_cast< T* >( static_cast< const brick_pin_screen* >( this )->find( i, j, k ) ); }
+
+        /// return pointer to element, if exists
+        T* find( const index_type& i ) { return find( i[0], i[1], i[2] ); }
+
+        /// return pointer to element, if exists
+        const T* find( std::size_t i, std::size_t j, std::size_t k ) const;
+
+        /// return pointer to element, if exists
+        const T* find( const index_type& i ) const { return find( i[0], i[1], i[2] ); }
+
+        /// return reference to element; creates element, if it does not exist
+        T& operator()( std::size_t i, std::size_t j, std::size_t k ) { return touch( i, j, k ); }
+
+        /// return reference to element; crashes, if element does not exist (thus check exists() first)
+        const T& operator()( std::size_t i, std::size_t j, std::size_t k ) const { return *find( i, j, k ); }
+
+        /// return reference to element; creates element, if it does not exist
+        T& operator()( const index_type& i ) { return touch( i[0], i[1], i[2] ); }
+
+        /// return reference to element; crashes, if element does not exist (thus check exists() first)
+        const T& operator()( const index_type& i ) const { return *find( i ); }
+
+        /// return reference to element, create, if it does not exist
+        T& touch( std::size_t i, std::size_t j, std::size_t k );
+
+        /// return reference to element, create, if it does not exist
+        T& touch( const index_type& i ) { return touch( i[0], i[1], i[2] ); }
+
+        /// erase element
+        void erase( std::size_t i, std::size_t j, std::size_t k );
+
+        /// erase element
+        void erase( const index_type& i ) { erase( i[0], i[1], i[2] ); }
+
+        /// clear; allocated bricks are kept for reuse
+        void clear();
+
+        /// clear and set new 2D array size
+        void resize( size_type size ) { clear(); size_ = size; }
+
+        /// return number of bricks in use
+        std::size_t bricks() const { return used_; }
+
+        template < typename V > class basic_iterator;
+
+        /// iterator
+        typedef basic_iterator< T > iterator;
+
+        /// const iterator
+        typedef basic_iterator< const T > const_iterator;
+
+        /// return begin
+        iterator begin() { sort_(); return iterator( this, 0 ); }
+
+        /// return begin
+        const_iterator begin() const { sort_(); return const_iterator( this, 0 ); }
+
+        /// return end
+        iterator end() { return iterator( this ); }
+
+        /// return end
+        const_iterator end() const { return const_iterator( this ); }
+
+        /// neighbourhood iterator, same neighbourhood as for pin_screen
+        class neighbourhood_iterator;
+
+    private:
+        typedef boost::array< comma::int32, 3 > key_type;
+        struct brick_type
+        {
+            key_type key;
+            boost::array< comma::uint8, edge * edge > occupied; // bit k of occupied[ i * edge + j ] is set, if element i, j, k exists
+            boost::array< T, edge * edge * edge > values;
+            brick_type( const key_type& key ) : key( key ) { occupied.assign( 0 ); }
+            void reset( const key_type& k ) { key = k; occupied.assign( 0 ); values.assign( T() ); }
+        };
+        size_type size_;
+        flat_voxel_map< std::size_t, 3 > directory_;
+        std::deque< brick_type > bricks_; // bricks beyond used_ are allocated, but not in use
+        std::size_t used_;
+        mutable std::vector< std::size_t > order_; // bricks sorted by key
+        mutable bool sorted_;
+
+        static key_type key_of_( std::size_t i, std::size_t j, std::size_t k ) { key_type key = {{ comma::int32( i / edge ), comma::int32( j / edge ), comma::int32( k / edge ) }}; return key; }
+        static unsigned int column_of_( std::size_t i, std::size_t j ) { return ( i % edge ) * edge + j % edge; }
+        static unsigned int offset_of_( std::size_t i, std::size_t j, std::size_t k ) { return column_of_( i, j ) * edge + k % edge; }
+        const brick_type* brick_( std::size_t i, std::size_t j, std::size_t k ) const;
+        struct less_;
+        void sort_() const;
+        std::size_t stack_end_( std::size_t p ) const;
+        std::size_t group_end_( std::size_t p ) const;
+};
+
+/// iterator in lexicographic order of indices
+template < typename T >
+template < typename V >
+class brick_pin_screen< T >::basic_iterator
+{
+    public:
+        /// value type
+        typedef V value_type;
+
+        /// index type
+        typedef typename brick_pin_screen< T >::index_type index_type;
+
+        /// size type
+        typedef typename brick_pin_screen< T >::size_type size_type;
+
+        /// dimensions
+        enum { Dimensions = 3 };
+
+        bool operator==( const basic_iterator& rhs ) const { return value_ == rhs.value_; }
+        bool operator!=( const basic_iterator& rhs ) const { return value_ != rhs.value_; }
+        bool operator<( const basic_iterator& rhs ) const { return index_[0] < rhs.index_[0] || ( index_[0] == rhs.index_[0] && ( index_[1] < rhs.index_[1] || ( index_[1] == rhs.index_[1] && index_[2] < rhs.index_[2] ) ) ); }
+        V& operator*() const { return *value_; }
+        V* operator->() const { return value_; }
+        const index_type& operator()() const { return index_; }
+        const basic_iterator& operator++() { next_(); return *this; }
+
+        operator basic_iterator< const T >() const
+        {
+            basic_iterator< const T > it;
+            it.screen_ = screen_; it.value_ = value_; it.index_ = index_;
+            it.group_begin_ = group_begin_; it.group_end_ = group_end_; it.stack_begin_ = stack_begin_; it.stack_end_ = stack_end_; it.brick_ = brick_;
+            it.i_ = i_; it.j_ = j_; it.k_ = k_;
+            return it;
+        }
+
+        basic_iterator() : screen_( NULL ), value_( NULL ), index_( 0, 0, 0 ) {}
+
+    protected:
+        friend class brick_pin_screen< T >;
+        template < typename W > friend class brick_pin_screen< T >::basic_iterator;
+        const brick_pin_screen< T >* screen_;
+        V* value_; // NULL for end
+        index_type index_;
+        std::size_t group_begin_; // bricks with the same key[0] in order_
+        std::size_t group_end_;
+        std::size_t stack_begin_; // bricks with the same key[0], key[1] in order_
+        std::size_t stack_end_;
+        std::size_t brick_; // current brick in order_
+        unsigned int i_; // row in brick
+        unsigned int j_; // column in brick
+        int k_; // layer in brick, -1 before the first layer
+
+        basic_iterator( const brick_pin_screen< T >* screen ) : screen_( screen ), value_( NULL ), index_( 0, 0, 0 ) {}
+
+        basic_iterator( const brick_pin_screen< T >* screen, std::size_t ) : screen_( screen ), value_( NULL ), index_( 0, 0, 0 ), group_begin_( 0 ), i_( 0 ), j_( 0 ), k_( -1 )
+        {
+            if( screen_->order_.empty() ) { return; }
+            group_end_ = screen_->group_end_( 0 );
+            stack_begin_ = brick_ = 0;
+            stack_end_ = screen_->stack_end_( 0 );
+            next_();
+        }
+
+        void next_();
+};
+
+template < typename T >
+template < typename V >
+inline void brick_pin_screen< T >::basic_iterator< V >::next_()
+{
+    const std::vector< std::size_t >& order = screen_->order_;
+    while( group_begin_ < order.size() )
+    {
+        const brick_type& b = screen_->bricks_[ order[ brick_ ] ];
+        unsigned int bits = k_ + 1 < edge ? b.occupied[ i_ * edge + j_ ] >> ( k_ + 1 ) : 0;
+        if( bits )
+        {
+            for( ++k_; !( bits & 1 ); bits >>= 1, ++k_ );
+            value_ = const_cast< V* >( &b.values[ ( i_ * edge + j_ ) * edge + k_ ] );
+            index_ = index_type( std::size_t( b.key[0] ) * edge + i_, std::size_t( b.key[1] ) * edge + j_, std::size_t( b.key[2] ) * edge + k_ );
+            return;
+        }
+        k_ = -1;
+        if( ++brick_ < stack_end_ ) { continue; } // next brick up the stack
+        brick_ = stack_begin_;
+        if( ++j_ < edge ) { continue; } // next column of the stack
+        j_ = 0;
+        if( stack_end_ < group_end_ ) { brick_ = stack_begin_ = stack_end_; stack_end_ = screen_->stack_end_( stack_begin_ ); continue; } // next stack in the row
+        brick_ = stack_begin_ = group_begin_;
+        stack_end_ = screen_->stack_end_( stack_begin_ );
+        if( ++i_ < edge ) { continue; } // next row
+        i_ = 0;
+        brick_ = stack_begin_ = group_begin_ = group_end_;
+        if( group_begin_ == order.size() ) { break; }
+        group_end_ = screen_->group_end_( group_begin_ );
+        stack_end_ = screen_->stack_end_( stack_begin_ );
+    }
+    value_ = NULL;
+}
+
+/// neighbourhood iterator: same neighbourhood and order as for pin_screen
+template < typename T >
+class brick_pin_screen< T >::neighbourhood_iterator : public brick_pin_screen< T >::iterator
+{
+    public:
+        /// itself
+        typedef typename brick_pin_screen< T >::neighbourhood_iterator iterator;
+
+        /// index type
+        typedef typename brick_pin_screen< T >::index_type index_type;
+
+        /// increment
+        const neighbourhood_iterator& operator++() { next_(); return *this; }
+
+        /// return begin
+        static neighbourhood_iterator begin( const typename brick_pin_screen< T >::iterator& center );
+
+        /// return end
+        static neighbourhood_iterator end( const typename brick_pin_screen< T >::iterator& center );
+
+    private:
+        index_type center_;
+        index_type begin_;
+        index_type end_;
+        key_type key_; // last brick looked up: the neighbourhood mostly is in one brick
+        const brick_type* brick_;
+        using brick_pin_screen< T >::iterator::screen_;
+        using brick_pin_screen< T >::iterator::value_;
+        using brick_pin_screen< T >::iterator::index_;
+        void init_( const typename brick_pin_screen< T >::iterator& center );
+        void next_();
+};
+
+template < typename T >
+inline void brick_pin_screen< T >::neighbourhood_iterator::init_( const typename brick_pin_screen< T >::iterator& center )
+{
+    screen_ = center.screen_;
+    center_ = center();
+    begin_[0] = center_[0] - ( center_[0] > 0 ? 1 : 0 );
+    begin_[1] = center_[1] - ( center_[1] > 0 ? 1 : 0 );
+    begin_[2] = center_[2] - ( center_[2] > 0 ? 1 : 0 );
+    end_[0] = center_[0] + 1 + ( center_[0] < screen_->size_[0] - 1 ? 1 : 0 );
+    end_[1] = center_[1] + 1 + ( center_[1] < screen_->size_[1] - 1 ? 1 : 0 );
+    end_[2] = center_[2] + 1 + 1; // pin screen can grow upwards without limits
+}
+
+template < typename T >
+inline void brick_pin_screen< T >::neighbourhood_iterator::next_()
+{
+    while( true )
+    {
+        if( ++index_[2] >= end_[2] )
+        {
+            index_[2] = begin_[2];
+            if( ++index_[1] >= end_[1] )
+            {
+                index_[1] = begin_[1];
+                if( ++index_[0] >= end_[0] ) { value_ = NULL; return; }
+            }
+        }
+        if( index_ == center_ ) { continue; }
+        key_type key = key_of_( index_[0], index_[1], index_[2] );
+        if( key != key_ ) { key_ = key; brick_ = screen_->brick_( index_[0], index_[1], index_[2] ); }
+        if( !brick_ || !( brick_->occupied[ column_of_( index_[0], index_[1] ) ] & ( 1 << ( index_[2] % edge ) ) ) ) { continue; }
+        value_ = const_cast< T* >( &brick_->values[ offset_of_( index_[0], index_[1], index_[2] ) ] );
+        return;
+    }
+}
+
+template < typename T >
+inline typename brick_pin_screen< T >::neighbourhood_iterator brick_pin_screen< T >::neighbourhood_iterator::begin( const typename brick_pin_screen< T >::iterator& center )
+{
+    neighbourhood_iterator it;
+    it.init_( center );
+    it.key_ = key_of_( it.center_[0], it.center_[1], it.center_[2] );
+    it.brick_ = it.screen_->brick_( it.center_[0], it.center_[1], it.center_[2] );
+    it.index_ = it.begin_;
+    --it.index_[2]; // quick and dirty: wraps around for 0, incremented right away
+    it.next_();
+    return it;
+}
+
+template < typename T >
+inline typename brick_pin_screen< T >::neighbourhood_iterator brick_pin_screen< T >::neighbourhood_iterator::end( const typename brick_pin_screen< T >::iterator& center )
+{
+    neighbourhood_iterator it;
+    it.init_( center );
+    return it;
+}
+
+template < typename T >
+inline const typename brick_pin_screen< T >::brick_type* brick_pin_screen< T >::brick_( std::size_t i, std::size_t j, std::size_t k ) const
+{
+    flat_voxel_map< std::size_t, 3 >::const_iterator it = directory_.find( key_of_( i, j, k ) );
+    return it == directory_.end() ? NULL : &bricks_[ it->second ];
+}
+
+template < typename T >
+inline const T* brick_pin_screen< T >::find( std::size_t i, std::size_t j, std::size_t k ) const
+{
+    const brick_type* b = brick_( i, j, k );
+    if( !b || !( b->occupied[ column_of_( i, j ) ] & ( 1 << ( k % edge ) ) ) ) { return NULL; }
+    return &b->values[ offset_of_( i, j, k ) ];
+}
+
+template < typename T >
+inline T& brick_pin_screen< T >::touch( std::size_t i, std::size_t j, std::size_t k )
+{
+    std::pair< flat_voxel_map< std::size_t, 3 >::iterator, bool > r = directory_.insert( std::make_pair( key_of_( i, j, k ), used_ ) );
+    if( r.second )
+    {
+        if( used_ == bricks_.size() ) { bricks_.push_back( brick_type( r.first->first ) ); } else { bricks_[ used_ ].reset( r.first->first ); }
+        order_.push_back( used_++ );
+        sorted_ = false;
+    }
+    brick_type& b = bricks_[ r.first->second ];
+    b.occupied[ column_of_( i, j ) ] |= 1 << ( k % edge );
+    return b.values[ offset_of_( i, j, k ) ];
+}
+
+template < typename T >
+inline void brick_pin_screen< T >::erase( std::size_t i, std::size_t j, std::size_t k )
+{
+    brick_type* b = const_cast< brick_type* >( brick_( i, j, k ) );
+    if( !b ) { return; }
+    b->occupied[ column_of_( i, j ) ] &= ~( 1 << ( k % edge ) );
+    b->values[ offset_of_( i, j, k ) ] = T();
+}
+
+template < typename T >
+inline void brick_pin_screen< T >::clear()
+{
+    directory_.clear();
+    order_.clear();
+    used_ = 0;
+    sorted_ = true;
+}
+
+template < typename T >
+inline typename brick_pin_screen< T >::column_type brick_pin_screen< T >::column( std::size_t i, std::size_t j ) const
+{
+    column_type c;
+    for( const_iterator it = begin(); it != end(); ++it ) { if( it()[0] == i && it()[1] == j ) { c[ it()[2] ] = *it; } } // quick and dirty
+    return c;
+}
+
+template < typename T >
+inline std::size_t brick_pin_screen< T >::height( std::size_t i, std::size_t j ) const
+{
+    std::size_t h = 0;
+    for( std::size_t n = 0; n < used_; ++n )
+    {
+        const brick_type& b = bricks_[n];
+        if( std::size_t( b.key[0] ) != i / edge || std::size_t( b.key[1] ) != j / edge ) { continue; }
+        unsigned int bits = b.occupied[ column_of_( i, j ) ];
+        if( !bits ) { continue; }
+        unsigned int k = edge - 1;
+        for( ; !( bits & ( 1 << k ) ); --k );
+        h = std::max( h, std::size_t( b.key[2] ) * edge + k );
+    }
+    return h;
+}
+
+template < typename T >
+struct brick_pin_screen< T >::less_
+{
+    const std::deque< brick_type >& bricks;
+    less_( const std::deque< brick_type >& bricks ) : bricks( bricks ) {}
+    bool operator()( std::size_t lhs, std::size_t rhs ) const { return bricks[lhs].key < bricks[rhs].key; }
+};
+
+template < typename T >
+inline void brick_pin_screen< T >::sort_() const
+{
+    if( sorted_ ) { return; }
+    std::sort( order_.begin(), order_.end(), less_( bricks_ ) );
+    sorted_ = true;
+}
+
+template < typename T >
+inline std::size_t brick_pin_screen< T >::stack_end_( std::size_t p ) const
+{
+    const key_type& key = bricks_[ order_[p] ].key;
+    for( ++p; p < order_.size() && bricks_[ order_[p] ].key[0] == key[0] && bricks_[ order_[p] ].key[1] == key[1]; ++p );
+    return p;
+}
+
+template < typename T >
+inline std::size_t brick_pin_screen< T >::group_end_( std::size_t p ) const
+{
+    comma::int32 k = bricks_[ order_[p] ].key[0];
+    for( ++p; p < order_.size() && bricks_[ order_[p] ].key[0] == k; ++p );
+    return p;
+}
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_IMPL_BRICK_PIN_SCREEN_H_
@@ -121,6 +121,9 @@ class pin_screen
         /// clean
         void clear();
 
+        /// clean and set new 2D array size
+        void resize( size_type size ) { m_grid.resize( size[0], size[1] ); clear(); }
+
         /// iterator, quick and dirty
         class iterator;
 
@@ -384,8 +387,14 @@ template < typename T >
 inline const typename pin_screen< T >::neighbourhood_iterator& pin_screen< T >::neighbourhood_iterator::operator++()
 {
     if( m_it != ( *m_grid )( m_column[0], m_column[1] ).end() && m_it->first < m_end[2] ) { ++m_it; }
-    while( m_it == ( *m_grid )( m_column[0], m_column[1] ).end() || m_it->first >= m_end[2] || this->operator()() == m_center )
+    while( true )
     {
+        if( m_it != ( *m_grid )( m_column[0], m_column[1] ).end() && m_it->first < m_end[2] )
+        {
+            if( this->operator()() != m_center ) { break; }
+            ++m_it; // skip centre, but not the rest of its column
+            continue;
+        }
         ++m_column[1];
         if( m_column[1] >= m_end[1] )
         {
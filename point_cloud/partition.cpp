@@ -30,7 +30,7 @@
 /// @author vsevolod vlaskine
 
 #include <cmath>
-#include <snark/point_cloud/equivalence_classes.h>
+#include <snark/point_cloud/connected_components.h>
 #include <snark/point_cloud/partition.h>
 #include <snark/point_cloud/voxel_grid.h>
 
@@ -55,17 +55,20 @@ class partition::impl_
             return voxel->id;
         }
 
+        void reset( const partition::extents_type& extents ) { voxels_.reset( expanded_( extents, voxels_.resolution() ) ); }
+
         void commit( std::size_t min_voxels_per_partition
                    , std::size_t min_points_per_partition
                    , comma::uint32 min_id
-                   , double min_density )
+                   , double min_density
+                   , unsigned int threads )
         {
             for( voxels_type_::iterator it = voxels_.begin(); it != voxels_.end(); ++it ) { if( it->count < min_points_per_voxel_ ) { it->count = 0; } }
             typedef std::list< voxels_type_::iterator > Set;
             typedef std::map< comma::uint32, Set > partitions;
             typedef voxels_type_::iterator It;
             typedef voxels_type_::neighbourhood_iterator Nit;
-            const partitions& parts = snark::equivalence_classes< It, Nit, Methods_ >( voxels_.begin(), voxels_.end(), min_id );
+            const partitions& parts = snark::connected_components< It, Nit, Methods_ >( voxels_.begin(), voxels_.end(), min_id, threads );
             bool check_points_per_partitions = min_density > 0 || ( min_points_per_partition > min_voxels_per_partition * min_points_per_voxel_ );
             for( partitions::const_iterator it = parts.begin(); it != parts.end(); ++it )
             {
@@ -104,7 +107,7 @@ class partition::impl_
             static void set_id( voxel_& e, comma::uint32 id ) { e.id = id; }
         };
 
-        typedef voxel_grid< voxel_ > voxels_type_;
+        typedef voxel_grid< voxel_, Eigen::Vector3d, voxel_grid_storage::bricks > voxels_type_;
         voxels_type_ voxels_;
         boost::optional< comma::uint32 > none_;
         std::size_t min_points_per_voxel_;
@@ -132,17 +135,23 @@ const boost::optional< comma::uint32 >& partition::insert( const Eigen::Vector3d
     return pimpl_->insert( point );
 }
 
+void partition::reset( const partition::extents_type& extents )
+{
+    pimpl_->reset( extents );
+}
+
 void partition::commit()
 {
-    pimpl_->commit( 1, 1, 0, 0 );
+    pimpl_->commit( 1, 1, 0, 0, 1 );
 }
 
 void partition::commit( std::size_t min_voxels_per_partition
                       , std::size_t min_points_per_partition
                       , comma::uint32 min_id
-                      , double min_density )
+                      , double min_density
+                      , unsigned int threads )
 {
-    pimpl_->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density );
+    pimpl_->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density, threads );
 }
 
 } // namespace snark {
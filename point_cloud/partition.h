@@ -51,14 +51,20 @@ class partition
 
         const boost::optional< comma::uint32 >& insert( const Eigen::Vector3d& point );
 
+        /// clear and set new extents, keeping allocated memory for reuse, e.g. for the next block of points
+        /// @note invalidates ids returned by insert()
+        void reset( const extents_type& extents );
+
         void commit();
 
         /// @param min_density is number of points in partition / number of voxels in partition
+        /// @param threads number of threads to find connected components; the result is the same for any number of threads
         /// @todo define better signature for commit()
         void commit( std::size_t min_voxels_per_partition
                    , std::size_t min_points_per_partition
                    , comma::uint32 min_id = 0
-                   , double min_density = 0 );
+                   , double min_density = 0
+                   , unsigned int threads = 1 );
 
     private:
         class impl_;
@@ -0,0 +1,113 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_SHARDS_H
+#define SNARK_POINT_CLOUD_SHARDS_H
+
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include <comma/base/types.h>
+
+namespace snark {
+
+/// indices of items of a block grouped by shard, e.g. by voxel or by partition id,
+/// so that each shard can be accumulated by one task over its own items only
+///
+/// grouping is a stable counting sort: items of each shard remain in input order,
+/// thus accumulating shards in parallel gives exactly the same sums as serial accumulation
+///
+/// usage:
+///     std::vector< comma::uint16 > shard_of( points.size() ); // shard of each point
+///     ...
+///     shard_groups groups;
+///     groups.assign( shard_of, shards );
+///     // in task for shard s:
+///     for( shard_groups::const_iterator it = groups.begin( s ); it != groups.end( s ); ++it ) { accumulate( points[*it], *it ); }
+class shard_groups
+{
+    public:
+        typedef std::vector< comma::uint32 >::const_iterator const_iterator;
+
+        /// group indices of items by shard
+        /// @param shard_of shard of each item
+        /// @param shards number of shards
+        template < typename S > void assign( const std::vector< S >& shard_of, std::size_t shards );
+
+        /// return number of shards
+        std::size_t size() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+
+        /// return indices of items in shard in input order
+        const_iterator begin( std::size_t shard ) const { return indices_.begin() + offsets_[ shard ]; }
+        const_iterator end( std::size_t shard ) const { return indices_.begin() + offsets_[ shard + 1 ]; }
+
+    private:
+        std::vector< comma::uint32 > offsets_;
+        std::vector< comma::uint32 > indices_;
+        std::vector< comma::uint32 > positions_;
+};
+
+/// merge elements of shards into a single sequence in the order of their first items,
+/// i.e. exactly as serial accumulation would output them
+///
+/// @param ranges begin and end of each shard; elements in each shard have to be already
+///               in the order of their first items, e.g. flat_voxel_map, in which
+///               elements are in insertion order; the first item of an element is it->second.first
+/// @param output functor called with the iterator of each element in order
+template < typename It, typename Output >
+inline void merge_shards( std::vector< std::pair< It, It > > ranges, Output& output )
+{
+    typedef std::pair< comma::uint64, std::size_t > head_t; // first item, shard
+    std::priority_queue< head_t, std::vector< head_t >, std::greater< head_t > > heads;
+    for( std::size_t s = 0; s < ranges.size(); ++s ) { if( ranges[s].first != ranges[s].second ) { heads.push( head_t( ranges[s].first->second.first, s ) ); } }
+    while( !heads.empty() )
+    {
+        std::size_t s = heads.top().second;
+        heads.pop();
+        output( ranges[s].first );
+        if( ++ranges[s].first != ranges[s].second ) { heads.push( head_t( ranges[s].first->second.first, s ) ); }
+    }
+}
+
+template < typename S >
+inline void shard_groups::assign( const std::vector< S >& shard_of, std::size_t shards )
+{
+    offsets_.assign( shards + 1, 0 );
+    for( std::size_t i = 0; i < shard_of.size(); ++i ) { ++offsets_[ shard_of[i] + 1 ]; }
+    for( std::size_t s = 1; s < offsets_.size(); ++s ) { offsets_[s] += offsets_[ s - 1 ]; }
+    indices_.resize( shard_of.size() );
+    positions_.assign( offsets_.begin(), offsets_.end() - 1 );
+    for( std::size_t i = 0; i < shard_of.size(); ++i ) { indices_[ positions_[ shard_of[i] ]++ ] = i; }
+}
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_SHARDS_H
@@ -0,0 +1,134 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <gtest/gtest.h>
+#include <comma/base/types.h>
+#include <snark/point_cloud/bearing_elevation_z_buffer.h>
+
+namespace snark {
+
+typedef bearing_elevation_z_buffer< comma::uint64 > z_buffer_t;
+
+static double angular_distance( double b0, double e0, double b1, double e1 ) // quick and dirty, as in points-detect-change
+{
+    double db = std::abs( b0 - b1 );
+    if( db > M_PI ) { db = M_PI * 2 - db; }
+    double de = e0 - e1;
+    return std::sqrt( db * db + de * de );
+}
+
+TEST( bearing_elevation_z_buffer, wall )
+{
+    z_buffer_t z( 0.02 );
+    comma::uint64 n = 0;
+    for( double b = -0.5; b < 0.5; b += 0.005 ) { for( double e = -0.2; e < 0.2; e += 0.005 ) { z.add( range_bearing_elevation( 10 + b, b, e ), n++ ); } }
+    z.build();
+    const z_buffer_t::cell* c = z.trace( 0.1, 0.1 );
+    ASSERT_TRUE( c );
+    EXPECT_LT( c->range, 10.1 );
+    EXPECT_GT( c->range, 10.1 - 0.05 );
+    EXPECT_TRUE( !z.trace( 0.7, 0.1 ) );
+    EXPECT_TRUE( !z.find( 0.7, 0.1 ) );
+    EXPECT_TRUE( !z.trace( 0.1, 0.5 ) );
+    EXPECT_TRUE( !z.trace( 0.1, -1.5 ) );
+    EXPECT_TRUE( z.find( 0.5, 0.1 ) ); // next to the wall
+    EXPECT_TRUE( !z.trace( 0.5, 0.1 ) ); // but not surrounded by it
+}
+
+TEST( bearing_elevation_z_buffer, nearest )
+{
+    z_buffer_t z( 0.1 );
+    z.add( range_bearing_elevation( 7, 0.01, 0.01 ), 0 );
+    z.add( range_bearing_elevation( 3, -0.01, -0.01 ), 1 );
+    z.add( range_bearing_elevation( 5, 0.3, 0.01 ), 2 );
+    z.build();
+    const z_buffer_t::cell* c = z.trace( 0, 0 );
+    ASSERT_TRUE( c );
+    EXPECT_EQ( c->range, 3 );
+    EXPECT_EQ( c->value, 1u );
+    c = z.find( 0.3, 0.01 );
+    ASSERT_TRUE( c );
+    EXPECT_EQ( c->value, 2u );
+}
+
+TEST( bearing_elevation_z_buffer, bearing_wraparound )
+{
+    z_buffer_t z( 0.05 );
+    z.add( range_bearing_elevation( 4, M_PI - 0.01, -0.01 ), 0 );
+    z.add( range_bearing_elevation( 2, -M_PI + 0.01, 0.01 ), 1 );
+    z.build();
+    for( double b = M_PI - 0.005; b < M_PI + 0.005; b += 0.001 )
+    {
+        const z_buffer_t::cell* c = z.trace( b, 0 );
+        ASSERT_TRUE( c );
+        EXPECT_EQ( c->value, 1u );
+    }
+}
+
+TEST( bearing_elevation_z_buffer, neighbourhood )
+{
+    double radius = 0.03;
+    z_buffer_t z( radius );
+    std::vector< range_bearing_elevation > points;
+    ::srand( 1 );
+    for( unsigned int i = 0; i < 5000; ++i )
+    {
+        range_bearing_elevation p( 1 + 50 * double( ::rand() ) / RAND_MAX, M_PI * ( 2 * double( ::rand() ) / RAND_MAX - 1 ), 0.5 * ( double( ::rand() ) / RAND_MAX - 0.5 ) );
+        points.push_back( p );
+        z.add( p, i );
+    }
+    z.build();
+    double margin = z.resolution() * 2 * std::sqrt( 2.0 ); // quick and dirty: neighbourhood is a square of cells, not a disk
+    for( unsigned int i = 0; i < 2000; ++i )
+    {
+        double b = M_PI * ( 2 * double( ::rand() ) / RAND_MAX - 1 );
+        double e = 0.6 * ( double( ::rand() ) / RAND_MAX - 0.5 );
+        double inner = std::numeric_limits< double >::max();
+        double outer = std::numeric_limits< double >::max();
+        for( std::size_t j = 0; j < points.size(); ++j )
+        {
+            double d = angular_distance( b, e, points[j].bearing(), points[j].elevation() );
+            if( d <= radius ) { inner = std::min( inner, points[j].range() ); }
+            if( d <= radius + margin ) { outer = std::min( outer, points[j].range() ); }
+        }
+        const z_buffer_t::cell* c = z.find( b, e );
+        if( inner < std::numeric_limits< double >::max() ) { ASSERT_TRUE( c ); }
+        if( !c ) { continue; }
+        EXPECT_LE( c->range, inner );
+        EXPECT_GE( c->range, outer );
+        EXPECT_EQ( c->range, points[ c->value ].range() );
+    }
+}
+
+} // namespace snark {
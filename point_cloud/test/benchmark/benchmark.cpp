@@ -0,0 +1,128 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <comma/application/command_line_options.h>
+#include <comma/string/string.h>
+#include "./benchmark.h"
+
+namespace snark { namespace benchmark {
+
+volatile double sink = 0;
+
+void print_header( std::ostream& os ) { os << "name,points,seconds,ns/point,points/s,size" << std::endl; }
+
+void print( std::ostream& os, const result& r )
+{
+    os << r.name << "," << r.points << "," << r.seconds
+       << "," << ( r.points == 0 ? 0.0 : r.seconds * 1e9 / r.points )
+       << "," << ( r.seconds == 0 ? 0.0 : r.points / r.seconds )
+       << "," << r.size << std::endl;
+}
+
+double now()
+{
+    static const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6;
+}
+
+std::vector< Eigen::Vector3d > make_points( unsigned int size )
+{
+    std::vector< Eigen::Vector3d > points( size );
+    comma::uint32 seed = 12345;
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        double r[3];
+        for( unsigned int k = 0; k < 3; ++k ) { seed = seed * 1664525 + 1013904223; r[k] = double( seed >> 8 ) / ( 1 << 24 ); } // quick and dirty: deterministic and cheap
+        switch( i % 4 )
+        {
+            case 0: case 1: points[i] = Eigen::Vector3d( r[0] * 200 - 100, r[1] * 20 - 10, 0.05 * std::sin( r[0] * 50 ) ); break; // ground
+            case 2: points[i] = Eigen::Vector3d( r[0] * 200 - 100, r[1] < 0.5 ? -10 : 10, r[2] * 8 ); break; // walls
+            default: points[i] = Eigen::Vector3d( r[0] * 200 - 100, r[1] * 20 - 10, r[2] * 3 ); break; // clutter
+        }
+    }
+    return points;
+}
+
+} } // namespace snark { namespace benchmark {
+
+static void usage()
+{
+    std::cerr << std::endl;
+    std::cerr << "point cloud benchmarks on a synthetic point cloud in memory" << std::endl;
+    std::cerr << "output: csv, one line per benchmark, to diff between versions" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "usage: point_cloud_benchmark [<options>]" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "options" << std::endl;
+    std::cerr << "    --points=<n>: number of points; default 2000000" << std::endl;
+    std::cerr << "    --resolution=<metres>: voxel size; default 0.1" << std::endl;
+    std::cerr << "    --no-header: do not output csv header" << std::endl;
+    std::cerr << "    --only=<groups>: run only given comma-separated groups: voxel_map,neighbourhood,voxel_grid,components; default: all" << std::endl;
+    std::cerr << "    --repeat=<n>: run each benchmark n times, output the fastest run; default 1" << std::endl;
+    std::cerr << std::endl;
+    exit( -1 );
+}
+
+int main( int ac, char** av )
+{
+    try
+    {
+        comma::command_line_options options( ac, av );
+        if( options.exists( "--help,-h" ) ) { usage(); }
+        using namespace snark;
+        std::vector< Eigen::Vector3d > points = benchmark::make_points( options.value( "--points", 2000000u ) );
+        double resolution = options.value( "--resolution", 0.1 );
+        std::vector< std::string > only = comma::split( options.value< std::string >( "--only", "voxel_map,neighbourhood,voxel_grid,components" ), ',' );
+        unsigned int repeat = options.value( "--repeat", 1u );
+        std::vector< benchmark::result > results;
+        for( unsigned int i = 0; i < repeat; ++i )
+        {
+            std::vector< benchmark::result > r;
+            for( std::size_t j = 0; j < only.size(); ++j )
+            {
+                if( only[j] == "voxel_map" ) { benchmark::voxel_map( points, resolution, r ); }
+                else if( only[j] == "neighbourhood" ) { benchmark::neighbourhood( points, resolution, r ); }
+                else if( only[j] == "voxel_grid" ) { benchmark::voxel_grid( points, resolution, r ); }
+                else if( only[j] == "components" ) { benchmark::components( points, resolution, r ); }
+                else { std::cerr << "point_cloud_benchmark: expected benchmark group, got \"" << only[j] << "\"" << std::endl; return 1; }
+            }
+            if( results.empty() ) { results = r; continue; }
+            for( std::size_t k = 0; k < r.size(); ++k ) { if( r[k].seconds < results[k].seconds ) { results[k] = r[k]; } }
+        }
+        if( !options.exists( "--no-header" ) ) { benchmark::print_header( std::cout ); }
+        for( std::size_t i = 0; i < results.size(); ++i ) { benchmark::print( std::cout, results[i] ); }
+        return 0;
+    }
+    catch( std::exception& ex ) { std::cerr << "point_cloud_benchmark: " << ex.what() << std::endl; }
+    catch( ... ) { std::cerr << "point_cloud_benchmark: unknown exception" << std::endl; }
+    return 1;
+}
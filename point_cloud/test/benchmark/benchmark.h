@@ -0,0 +1,82 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_TEST_BENCHMARK_BENCHMARK_H_
+#define SNARK_POINT_CLOUD_TEST_BENCHMARK_BENCHMARK_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <comma/base/types.h>
+
+namespace snark { namespace benchmark {
+
+/// benchmark result, printed as one csv line
+struct result
+{
+    std::string name;
+    comma::uint64 points;
+    double seconds;
+    comma::uint64 size; /// size of the result, e.g. number of voxels, 0 if not applicable
+
+    result( const std::string& name, comma::uint64 points, double seconds, comma::uint64 size = 0 ) : name( name ), points( points ), seconds( seconds ), size( size ) {}
+};
+
+/// print csv header
+void print_header( std::ostream& os );
+
+/// print result as csv: name,points,seconds,ns/point,points/s,size
+void print( std::ostream& os, const result& r );
+
+/// return monotonic time in seconds
+double now();
+
+/// make synthetic point cloud of a street-like scene: ground, walls, and clutter, in random order
+std::vector< Eigen::Vector3d > make_points( unsigned int size );
+
+/// keeps results alive, so that the compiler does not optimise the benchmarked code away
+extern volatile double sink;
+
+/// voxel_map: touch_at, find, and iteration with unordered and flat storage
+void voxel_map( const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results );
+
+/// neighbourhood sums: hash lookups per neighbour vs voxel_neighbourhood, for a few radii
+void neighbourhood( const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results );
+
+/// voxel_grid: touch_at and neighbourhood iteration with columns and bricks storage
+void voxel_grid( const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results );
+
+/// partitioning a voxel grid: equivalence_classes vs connected_components
+void components( const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results );
+
+} } // namespace snark { namespace benchmark {
+
+#endif // SNARK_POINT_CLOUD_TEST_BENCHMARK_BENCHMARK_H_
@@ -0,0 +1,85 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <snark/point_cloud/connected_components.h>
+#include <snark/point_cloud/equivalence_classes.h>
+#include <snark/point_cloud/voxel_grid.h>
+#include "./benchmark.h"
+
+namespace snark { namespace benchmark {
+
+struct voxel
+{
+    bool visited;
+    comma::uint32 id;
+    voxel() : visited( false ), id( 0 ) {}
+};
+
+struct methods
+{
+    static bool skip( const voxel& ) { return false; }
+    static bool same( const voxel&, const voxel& ) { return true; }
+    static bool visited( const voxel& e ) { return e.visited; }
+    static void set_visited( voxel& e, bool v ) { e.visited = v; }
+    static comma::uint32 id( const voxel& e ) { return e.id; }
+    static void set_id( voxel& e, comma::uint32 id ) { e.id = id; }
+};
+
+typedef snark::voxel_grid< voxel, Eigen::Vector3d, voxel_grid_storage::bricks > grid_type;
+typedef std::map< comma::uint32, std::list< grid_type::iterator > > partitions_type;
+
+static grid_type make_grid( const std::vector< Eigen::Vector3d >& points, double resolution )
+{
+    grid_type grid( math::closed_interval< double, 3 >( Eigen::Vector3d( -101, -11, -1 ), Eigen::Vector3d( 101, 11, 9 ) ), Eigen::Vector3d( resolution, resolution, resolution ) );
+    for( std::size_t i = 0; i < points.size(); ++i ) { grid.touch_at( points[i] ); }
+    return grid;
+}
+
+void components( const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results )
+{
+    {
+        grid_type grid = make_grid( points, resolution );
+        double start = now();
+        const partitions_type& p = equivalence_classes< grid_type::iterator, grid_type::neighbourhood_iterator, methods >( grid.begin(), grid.end(), 0 );
+        double elapsed = now() - start;
+        results.push_back( result( "components/equivalence_classes", points.size(), elapsed, p.size() ) );
+    }
+    static const unsigned int threads[] = { 1, 4 };
+    for( unsigned int i = 0; i < 2; ++i )
+    {
+        grid_type grid = make_grid( points, resolution );
+        double start = now();
+        const partitions_type& p = connected_components< grid_type::iterator, grid_type::neighbourhood_iterator, methods >( grid.begin(), grid.end(), 0, threads[i] );
+        double elapsed = now() - start;
+        results.push_back( result( std::string( "components/connected_components/" ) + ( threads[i] == 1 ? "1" : "4" ), points.size(), elapsed, p.size() ) );
+    }
+}
+
+} } // namespace snark { namespace benchmark {
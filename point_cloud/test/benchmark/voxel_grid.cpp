@@ -0,0 +1,65 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <snark/point_cloud/voxel_grid.h>
+#include "./benchmark.h"
+
+namespace snark { namespace benchmark {
+
+template < typename S >
+static void run( const std::string& name, const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results )
+{
+    typedef snark::voxel_grid< comma::uint32, Eigen::Vector3d, S > grid_type;
+    double start = now();
+    grid_type grid( math::closed_interval< double, 3 >( Eigen::Vector3d( -101, -11, -1 ), Eigen::Vector3d( 101, 11, 9 ) ), Eigen::Vector3d( resolution, resolution, resolution ) );
+    for( std::size_t i = 0; i < points.size(); ++i ) { comma::uint32* v = grid.touch_at( points[i] ); if( v ) { ++*v; } }
+    double elapsed = now() - start;
+    comma::uint64 size = 0;
+    for( typename grid_type::iterator it = grid.begin(); it != grid.end(); ++it ) { ++size; }
+    results.push_back( result( "voxel_grid/" + name + "/touch_at", points.size(), elapsed, size ) );
+    comma::uint64 sum = 0;
+    start = now();
+    for( typename grid_type::iterator it = grid.begin(); it != grid.end(); ++it )
+    {
+        typename grid_type::neighbourhood_iterator end = grid_type::neighbourhood_iterator::end( it );
+        for( typename grid_type::neighbourhood_iterator nit = grid_type::neighbourhood_iterator::begin( it ); nit != end; ++nit ) { sum += *nit; }
+    }
+    elapsed = now() - start;
+    results.push_back( result( "voxel_grid/" + name + "/neighbourhood", size, elapsed, size ) );
+    sink = sum;
+}
+
+void voxel_grid( const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results )
+{
+    run< voxel_grid_storage::columns >( "columns", points, resolution, results );
+    run< voxel_grid_storage::bricks >( "bricks", points, resolution, results );
+}
+
+} } // namespace snark { namespace benchmark {
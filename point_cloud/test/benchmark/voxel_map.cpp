@@ -0,0 +1,69 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <snark/point_cloud/voxel_map.h>
+#include "./benchmark.h"
+
+namespace snark { namespace benchmark {
+
+template < typename S >
+static void run( const std::string& name, const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results )
+{
+    typedef snark::voxel_map< comma::uint32, 3, Eigen::Vector3d, S > map_type;
+    map_type map( Eigen::Vector3d( resolution, resolution, resolution ) );
+    double start = now();
+    for( std::size_t i = 0; i < points.size(); ++i ) { ++map.touch_at( points[i] )->second; }
+    double elapsed = now() - start;
+    results.push_back( result( "voxel_map/" + name + "/touch_at", points.size(), elapsed, map.size() ) );
+    comma::uint64 sum = 0;
+    start = now();
+    for( std::size_t i = 0; i < points.size(); ++i )
+    {
+        Eigen::Vector3d p = points[i];
+        p.z() += resolution * 10; // about a half of lookups miss
+        typename map_type::const_iterator it = map.find( p );
+        if( it != map.end() ) { sum += it->second; }
+    }
+    elapsed = now() - start;
+    results.push_back( result( "voxel_map/" + name + "/find", points.size(), elapsed, map.size() ) );
+    start = now();
+    for( unsigned int k = 0; k < 10; ++k ) { for( typename map_type::const_iterator it = map.begin(); it != map.end(); ++it ) { sum += it->second + it->first[0]; } }
+    elapsed = now() - start;
+    results.push_back( result( "voxel_map/" + name + "/iterate", map.size() * 10, elapsed, map.size() ) );
+    sink = sum;
+}
+
+void voxel_map( const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results )
+{
+    run< voxel_storage::unordered >( "unordered", points, resolution, results );
+    run< voxel_storage::flat >( "flat", points, resolution, results );
+}
+
+} } // namespace snark { namespace benchmark {
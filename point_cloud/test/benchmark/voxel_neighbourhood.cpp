@@ -0,0 +1,85 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <boost/lexical_cast.hpp>
+#include <snark/point_cloud/voxel_map.h>
+#include <snark/point_cloud/voxel_neighbourhood.h>
+#include "./benchmark.h"
+
+namespace snark { namespace benchmark {
+
+typedef snark::voxel_map< comma::uint32, 3, Eigen::Vector3d, voxel_storage::flat > map_type;
+
+static void lookups( const map_type& voxels, int radius, std::vector< result >& results )
+{
+    double start = now();
+    comma::uint64 sum = 0;
+    for( map_type::const_iterator it = voxels.begin(); it != voxels.end(); ++it )
+    {
+        map_type::index_type index;
+        for( index[0] = it->first[0] - radius; index[0] <= it->first[0] + radius; ++index[0] )
+        {
+            for( index[1] = it->first[1] - radius; index[1] <= it->first[1] + radius; ++index[1] )
+            {
+                for( index[2] = it->first[2] - radius; index[2] <= it->first[2] + radius; ++index[2] )
+                {
+                    map_type::const_iterator n = voxels.find( index );
+                    if( n != voxels.end() ) { sum += n->second; }
+                }
+            }
+        }
+    }
+    double elapsed = now() - start;
+    results.push_back( result( "neighbourhood/lookups/" + boost::lexical_cast< std::string >( radius ), voxels.size(), elapsed, voxels.size() ) );
+    sink = sum;
+}
+
+static void bricks( const map_type& voxels, unsigned int radius, std::vector< result >& results )
+{
+    double start = now();
+    voxel_neighbourhood< comma::uint64 > n( radius );
+    for( map_type::const_iterator it = voxels.begin(); it != voxels.end(); ++it ) { n.add( it->first, it->second ); }
+    n.build();
+    comma::uint64 sum = 0;
+    for( map_type::const_iterator it = voxels.begin(); it != voxels.end(); ++it ) { sum += n.sum( it->first ); }
+    double elapsed = now() - start;
+    results.push_back( result( "neighbourhood/bricks/" + boost::lexical_cast< std::string >( radius ), voxels.size(), elapsed, n.bricks() ) );
+    sink = sum;
+}
+
+void neighbourhood( const std::vector< Eigen::Vector3d >& points, double resolution, std::vector< result >& results )
+{
+    map_type voxels( Eigen::Vector3d( resolution, resolution, resolution ) );
+    for( std::size_t i = 0; i < points.size(); ++i ) { ++voxels.touch_at( points[i] )->second; }
+    static const unsigned int radii[] = { 1, 3, 5 };
+    for( unsigned int i = 0; i < 3; ++i ) { lookups( voxels, radii[i], results ); bricks( voxels, radii[i], results ); }
+}
+
+} } // namespace snark { namespace benchmark {
@@ -0,0 +1,186 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <vector>
+#include <gtest/gtest.h>
+#include <snark/point_cloud/equivalence_classes.h>
+#include <snark/point_cloud/impl/brick_pin_screen.h>
+#include <snark/point_cloud/impl/pin_screen.h>
+#include <snark/point_cloud/voxel_grid.h>
+
+namespace snark { namespace Robotics {
+
+typedef brick_pin_screen< int > bricks_type;
+typedef pin_screen< int > columns_type;
+
+TEST( brick_pin_screen, grid )
+{
+    bricks_type grid( 10, 12 );
+    grid( 2, 3, 4 ) = 5;
+    EXPECT_EQ( grid.size(), ( bricks_type::size_type( 10, 12 ) ) );
+    EXPECT_EQ( grid( 2, 3, 4 ), 5 );
+    EXPECT_TRUE( grid.exists( 2, 3, 4 ) );
+    EXPECT_TRUE( !grid.exists( 2, 3, 5 ) );
+    EXPECT_TRUE( !grid.exists( 200, 300, 5 ) );
+    EXPECT_EQ( grid.column( 2, 3 ).size(), 1u );
+    EXPECT_EQ( grid.height( 2, 3 ), 4u );
+    grid( 2, 3, 10 ) = 6;
+    EXPECT_TRUE( grid.exists( 2, 3, 10 ) );
+    EXPECT_EQ( grid.column( 2, 3 ).size(), 2u );
+    EXPECT_EQ( grid.height( 2, 3 ), 10u );
+    EXPECT_EQ( grid.bricks(), 2u );
+    grid.erase( 2, 3, 4 );
+    grid.erase( 2, 3, 10 );
+    EXPECT_TRUE( !grid.exists( 2, 3, 4 ) );
+    EXPECT_EQ( grid.column( 2, 3 ).size(), 0u );
+    EXPECT_EQ( grid.height( 2, 3 ), 0u );
+    EXPECT_TRUE( grid.begin() == grid.end() );
+    grid.clear();
+    EXPECT_EQ( grid.bricks(), 0u );
+    grid.touch( 2, 3, 5 ) = 7;
+    grid.clear(); // clear() keeps allocated bricks; make sure a reused brick is reset
+    EXPECT_EQ( grid.touch( 4, 4, 4 ), 0 );
+    EXPECT_EQ( grid.bricks(), 1u );
+    EXPECT_TRUE( !grid.exists( 2, 3, 5 ) );
+    EXPECT_EQ( grid.touch( 2, 3, 5 ), 0 );
+}
+
+template < typename G >
+static std::vector< std::pair< columns_type::index_type, int > > elements( const G& g )
+{
+    std::vector< std::pair< columns_type::index_type, int > > v;
+    for( typename G::const_iterator it = g.begin(); it != g.end(); ++it ) { v.push_back( std::make_pair( it(), *it ) ); }
+    return v;
+}
+
+template < typename G >
+static std::vector< columns_type::index_type > neighbours( G&, const typename G::iterator& it )
+{
+    std::vector< columns_type::index_type > v;
+    typename G::neighbourhood_iterator end = G::neighbourhood_iterator::end( it );
+    for( typename G::neighbourhood_iterator nit = G::neighbourhood_iterator::begin( it ); nit != end; ++nit ) { v.push_back( nit() ); }
+    return v;
+}
+
+TEST( brick_pin_screen, same_as_pin_screen )
+{
+    for( unsigned int size = 3; size < 40; size += 12 )
+    {
+        columns_type columns( size, size + 5 );
+        bricks_type bricks( size, size + 5 );
+        ::srand( size );
+        for( unsigned int n = 0; n < size * size; ++n )
+        {
+            std::size_t i = ::rand() % size;
+            std::size_t j = ::rand() % ( size + 5 );
+            std::size_t k = ::rand() % 20;
+            int v = ::rand();
+            columns( i, j, k ) = v;
+            bricks( i, j, k ) = v;
+            if( n % 7 == 0 ) { columns.erase( i, j, k / 2 ); bricks.erase( i, j, k / 2 ); }
+        }
+        EXPECT_EQ( elements( columns ), elements( bricks ) );
+        columns_type::iterator c = columns.begin();
+        bricks_type::iterator b = bricks.begin();
+        for( ; c != columns.end() && b != bricks.end(); ++c, ++b )
+        {
+            EXPECT_EQ( c(), b() );
+            EXPECT_EQ( neighbours( columns, c ), neighbours( bricks, b ) );
+            EXPECT_EQ( columns.height( c()[0], c()[1] ), bricks.height( b()[0], b()[1] ) );
+            EXPECT_EQ( columns.column( c()[0], c()[1] ), bricks.column( b()[0], b()[1] ) );
+        }
+        EXPECT_TRUE( c == columns.end() );
+        EXPECT_TRUE( b == bricks.end() );
+    }
+}
+
+TEST( brick_pin_screen, iterators )
+{
+    bricks_type grid( 20, 20 );
+    grid( 9, 9, 9 ) = 1;
+    bricks_type::iterator it = grid.begin();
+    bricks_type::const_iterator cit = it;
+    EXPECT_EQ( 1, *cit );
+    EXPECT_TRUE( cit() == bricks_type::index_type( 9, 9, 9 ) );
+    *it = 2;
+    EXPECT_EQ( 2, grid( 9, 9, 9 ) );
+    EXPECT_TRUE( ++it == grid.end() );
+    const bricks_type& g = grid;
+    EXPECT_TRUE( g.begin() != g.end() );
+}
+
+struct voxel
+{
+    bool visited;
+    comma::uint32 id;
+    voxel() : visited( false ), id( 0 ) {}
+};
+
+struct methods
+{
+    static bool skip( const voxel& ) { return false; }
+    static bool same( const voxel&, const voxel& ) { return true; }
+    static bool visited( const voxel& e ) { return e.visited; }
+    static void set_visited( voxel& e, bool v ) { e.visited = v; }
+    static comma::uint32 id( const voxel& e ) { return e.id; }
+    static void set_id( voxel& e, comma::uint32 id ) { e.id = id; }
+};
+
+template < typename S >
+static std::map< comma::uint32, std::vector< columns_type::index_type > > partition( const std::vector< Eigen::Vector3d >& points )
+{
+    typedef voxel_grid< voxel, Eigen::Vector3d, S > grid_type;
+    grid_type grid( math::closed_interval< double, 3 >( Eigen::Vector3d( 0, 0, 0 ), Eigen::Vector3d( 30, 30, 5 ) ), Eigen::Vector3d( 0.5, 0.5, 0.5 ) );
+    for( std::size_t i = 0; i < points.size(); ++i ) { grid.touch_at( points[i] ); }
+    typedef std::map< comma::uint32, std::list< typename grid_type::iterator > > partitions_type;
+    const partitions_type& p = equivalence_classes< typename grid_type::iterator, typename grid_type::neighbourhood_iterator, methods >( grid.begin(), grid.end(), 0 );
+    std::map< comma::uint32, std::vector< columns_type::index_type > > r;
+    for( typename partitions_type::const_iterator it = p.begin(); it != p.end(); ++it )
+    {
+        for( typename std::list< typename grid_type::iterator >::const_iterator j = it->second.begin(); j != it->second.end(); ++j ) { r[ it->first ].push_back( ( *j )() ); }
+    }
+    return r;
+}
+
+TEST( brick_pin_screen, voxel_grid_partitions )
+{
+    std::vector< Eigen::Vector3d > points;
+    ::srand( 1 );
+    for( unsigned int i = 0; i < 3000; ++i ) { points.push_back( Eigen::Vector3d( ::rand() % 3000 / 100., ::rand() % 3000 / 100., ::rand() % 500 / 100. ) ); }
+    std::map< comma::uint32, std::vector< columns_type::index_type > > columns = partition< voxel_grid_storage::columns >( points );
+    std::map< comma::uint32, std::vector< columns_type::index_type > > bricks = partition< voxel_grid_storage::bricks >( points );
+    EXPECT_LT( 10u, columns.size() );
+    EXPECT_TRUE( columns == bricks );
+}
+
+} } // namespace snark { namespace Robotics {
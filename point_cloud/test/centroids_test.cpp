@@ -0,0 +1,118 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <map>
+#include <vector>
+#include <gtest/gtest.h>
+#include <snark/point_cloud/centroids.h>
+
+namespace snark {
+
+TEST( centroid, add )
+{
+    centroid c;
+    c.add( Eigen::Vector3d( 1, 2, 3 ), 5, true );
+    c.add( Eigen::Vector3d( 3, 2, 1 ), 6, true );
+    c.add( Eigen::Vector3d( 2, 5, 2 ), 7, true );
+    EXPECT_EQ( c.size, 3u );
+    EXPECT_EQ( c.first, 5u );
+    EXPECT_TRUE( c.mean().isApprox( Eigen::Vector3d( 2, 3, 2 ) ) );
+    EXPECT_TRUE( c.extents().isApprox( Eigen::Vector3d( 2, 3, 2 ) ) );
+    Eigen::Matrix3d expected;
+    expected << 2, 0, -2
+              , 0, 6, 0
+              , -2, 0, 2;
+    EXPECT_TRUE( ( c.covariance() * 3 ).isApprox( expected ) );
+}
+
+TEST( centroid, covariance_far_from_origin )
+{
+    centroid c;
+    for( unsigned int i = 0; i < 1000; ++i ) { c.add( Eigen::Vector3d( 1e6 + ( i % 2 ), 1e6, -1e6 + ( i % 4 ) ), i, true ); }
+    Eigen::Matrix3d covariance = c.covariance();
+    EXPECT_NEAR( covariance( 0, 0 ), 0.25, 1e-9 );
+    EXPECT_NEAR( covariance( 1, 1 ), 0, 1e-9 );
+    EXPECT_NEAR( covariance( 2, 2 ), 1.25, 1e-9 );
+    EXPECT_NEAR( covariance( 0, 2 ), 0.25, 1e-9 );
+}
+
+TEST( centroids, order )
+{
+    centroids c;
+    static const comma::uint32 ids[] = { 7, 3, 7, 0xffffffff, 3, 0, 7 };
+    for( unsigned int i = 0; i < 7; ++i ) { EXPECT_EQ( c.add( ids[i], Eigen::Vector3d( i, 0, 0 ), i ), i < 2 || i == 3 || i == 5 ); }
+    EXPECT_EQ( c.size(), 4u );
+    centroids::const_iterator it = c.begin();
+    EXPECT_EQ( centroids::id( it ), 7u );
+    EXPECT_EQ( it->second.size, 3u );
+    EXPECT_EQ( it->second.first, 0u );
+    EXPECT_DOUBLE_EQ( it->second.mean().x(), 8.0 / 3 );
+    ++it;
+    EXPECT_EQ( centroids::id( it ), 3u );
+    EXPECT_DOUBLE_EQ( it->second.mean().x(), 2.5 );
+    ++it;
+    EXPECT_EQ( centroids::id( it ), 0xffffffffu );
+    EXPECT_EQ( it->second.first, 3u );
+    ++it;
+    EXPECT_EQ( centroids::id( it ), 0u );
+    ++it;
+    EXPECT_TRUE( it == c.end() );
+    c.clear();
+    EXPECT_TRUE( c.empty() );
+    EXPECT_TRUE( c.add( 7, Eigen::Vector3d( 1, 1, 1 ), 0 ) );
+    EXPECT_EQ( c.size(), 1u );
+}
+
+TEST( centroids, many )
+{
+    centroids c;
+    std::map< comma::uint32, std::pair< unsigned int, double > > expected;
+    for( unsigned int i = 0; i < 100000; ++i )
+    {
+        comma::uint32 id = ( i * 7919 ) % 30011;
+        double x = std::sin( double( i ) );
+        c.add( id, Eigen::Vector3d( x, 0, 0 ), i );
+        expected[id].first += 1;
+        expected[id].second += x;
+    }
+    EXPECT_EQ( c.size(), expected.size() );
+    comma::uint64 first = 0;
+    for( centroids::const_iterator it = c.begin(); it != c.end(); ++it )
+    {
+        if( it != c.begin() ) { EXPECT_LT( first, it->second.first ); }
+        first = it->second.first;
+        const std::pair< unsigned int, double >& e = expected[ centroids::id( it ) ];
+        EXPECT_EQ( it->second.size, e.first );
+        EXPECT_DOUBLE_EQ( it->second.sum.x(), e.second );
+    }
+}
+
+} // namespace snark {
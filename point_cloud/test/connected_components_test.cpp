@@ -0,0 +1,148 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include <gtest/gtest.h>
+#include <snark/point_cloud/connected_components.h>
+#include <snark/point_cloud/equivalence_classes.h>
+#include <snark/point_cloud/voxel_grid.h>
+
+namespace snark { namespace test {
+
+TEST( connected_components, disjoint_sets )
+{
+    disjoint_sets s( 6 );
+    s.unite( 0, 1 );
+    s.unite( 2, 3 );
+    s.unite( 3, 1 );
+    EXPECT_EQ( s.find( 0 ), s.find( 2 ) );
+    EXPECT_NE( s.find( 0 ), s.find( 4 ) );
+    EXPECT_NE( s.find( 4 ), s.find( 5 ) );
+    s.unite( 5, 4 );
+    EXPECT_EQ( s.find( 4 ), s.find( 5 ) );
+}
+
+struct voxel
+{
+    bool visited;
+    comma::uint32 id;
+    bool empty;
+    voxel() : visited( false ), id( 0 ), empty( false ) {}
+};
+
+struct methods
+{
+    static bool skip( const voxel& e ) { return e.empty; }
+    static bool same( const voxel&, const voxel& ) { return true; }
+    static bool visited( const voxel& e ) { return e.visited; }
+    static void set_visited( voxel& e, bool v ) { e.visited = v; }
+    static comma::uint32 id( const voxel& e ) { return e.id; }
+    static void set_id( voxel& e, comma::uint32 id ) { e.id = id; }
+};
+
+typedef voxel_grid< voxel, Eigen::Vector3d, voxel_grid_storage::bricks > grid_type;
+typedef std::map< comma::uint32, std::list< grid_type::iterator > > partitions_type;
+typedef std::set< std::set< std::vector< std::size_t > > > shapes_type;
+
+static void fill( grid_type& grid, unsigned int size, unsigned int seed )
+{
+    ::srand( seed );
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        voxel* v = grid.touch_at( Eigen::Vector3d( ::rand() % 3000 / 100., ::rand() % 3000 / 100., ::rand() % 500 / 100. ) );
+        if( i % 10 == 0 ) { v->empty = true; }
+    }
+}
+
+static shapes_type shapes( const partitions_type& partitions )
+{
+    shapes_type s;
+    for( partitions_type::const_iterator it = partitions.begin(); it != partitions.end(); ++it )
+    {
+        std::set< std::vector< std::size_t > > p;
+        for( std::list< grid_type::iterator >::const_iterator j = it->second.begin(); j != it->second.end(); ++j )
+        {
+            std::vector< std::size_t > index( 3 );
+            for( unsigned int k = 0; k < 3; ++k ) { index[k] = ( *j )()[k]; }
+            p.insert( index );
+            EXPECT_EQ( it->first, ( *j )->id );
+        }
+        s.insert( p );
+    }
+    return s;
+}
+
+static grid_type make_grid() { return grid_type( math::closed_interval< double, 3 >( Eigen::Vector3d( 0, 0, 0 ), Eigen::Vector3d( 31, 31, 6 ) ), Eigen::Vector3d( 0.5, 0.5, 0.5 ) ); }
+
+TEST( connected_components, same_as_equivalence_classes )
+{
+    for( unsigned int size = 100; size < 10000; size *= 3 )
+    {
+        grid_type g = make_grid();
+        grid_type h = make_grid();
+        fill( g, size, size );
+        fill( h, size, size );
+        partitions_type expected = equivalence_classes< grid_type::iterator, grid_type::neighbourhood_iterator, methods >( g.begin(), g.end(), 5 );
+        partitions_type components = connected_components< grid_type::iterator, grid_type::neighbourhood_iterator, methods >( h.begin(), h.end(), 5 );
+        EXPECT_EQ( shapes( expected ), shapes( components ) );
+        EXPECT_EQ( expected.size(), components.size() );
+        comma::uint32 id = 5;
+        for( partitions_type::const_iterator it = components.begin(); it != components.end(); ++it, ++id ) { EXPECT_EQ( id, it->first ); }
+    }
+}
+
+TEST( connected_components, parallel )
+{
+    for( unsigned int threads = 2; threads < 9; threads += 3 )
+    {
+        grid_type g = make_grid();
+        grid_type h = make_grid();
+        fill( g, 5000, threads );
+        fill( h, 5000, threads );
+        partitions_type serial = connected_components< grid_type::iterator, grid_type::neighbourhood_iterator, methods >( g.begin(), g.end(), 0 );
+        partitions_type parallel = connected_components< grid_type::iterator, grid_type::neighbourhood_iterator, methods >( h.begin(), h.end(), 0, threads );
+        EXPECT_EQ( shapes( serial ), shapes( parallel ) );
+        partitions_type::const_iterator s = serial.begin();
+        partitions_type::const_iterator p = parallel.begin();
+        for( ; s != serial.end() && p != parallel.end(); ++s, ++p ) { EXPECT_EQ( s->first, p->first ); EXPECT_EQ( s->second.front()(), p->second.front()() ); }
+    }
+}
+
+TEST( connected_components, empty )
+{
+    grid_type g = make_grid();
+    EXPECT_TRUE( ( connected_components< grid_type::iterator, grid_type::neighbourhood_iterator, methods >( g.begin(), g.end(), 0, 4 ).empty() ) );
+}
+
+} } // namespace snark { namespace test {
@@ -97,6 +97,28 @@ TEST( voxel_grid, test )
     }
 }
 
+template < typename S >
+static void test_reset()
+{
+    snark::voxel_grid< int, point, S > grid( extents_type( point( 0, 0, 0 ), point( 10, 10, 5 ) ), point( 0.2, 0.2, 0.2 ) );
+    *grid.touch_at( point( 1, 1, 1 ) ) = 5;
+    grid.reset( extents_type( point( -10, -10, -5 ), point( 0, 0, 0 ) ) );
+    EXPECT_TRUE( grid.begin() == grid.end() );
+    EXPECT_TRUE( !grid.covers( point( 1, 1, 1 ) ) );
+    EXPECT_TRUE( grid.covers( point( -1, -1, -1 ) ) );
+    EXPECT_EQ( grid.size(), ( typename snark::voxel_grid< int, point, S >::size_type( 50, 50 ) ) );
+    int* v = grid.touch_at( point( -1, -1, -1 ) );
+    EXPECT_TRUE( v );
+    EXPECT_EQ( *v, 0 );
+    EXPECT_EQ( grid.index_of( point( -1, -1, -1 ) ), index_type( 45, 45, 20 ) );
+}
+
+TEST( voxel_grid, reset )
+{
+    test_reset< snark::voxel_grid_storage::columns >();
+    test_reset< snark::voxel_grid_storage::bricks >();
+}
+
 } } // namespace snark {  namespace test {
 
 int main(int argc, char *argv[])
@@ -28,8 +28,10 @@
 // IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <limits>
 #include <snark/point_cloud/voxel_map.h>
 #include <gtest/gtest.h>
+#include <comma/base/exception.h>
 
 namespace snark { namespace Robotics {
 
@@ -161,5 +163,91 @@ TEST( voxel_map, neighbourhood )
     }
 }
 
+typedef voxel_map< int, 3, Eigen::Matrix< double, 3, 1 >, voxel_storage::flat > flat_map_type;
+
+TEST( voxel_map, flat_operations )
+{
+    flat_map_type m( flat_map_type::point_type( 1, 1, 1 ) );
+    EXPECT_TRUE( m.empty() );
+    EXPECT_TRUE( ( m.find( flat_map_type::point_type( 1, 1, 1 ) ) == m.end() ) );
+    m.touch_at( flat_map_type::point_type( 1, 1, 1 ) )->second = 111;
+    m.touch_at( flat_map_type::point_type( -0.1, -0.1, -0.1 ) )->second = -111;
+    EXPECT_EQ( 2u, m.size() );
+    EXPECT_EQ( 111, m.find( flat_map_type::point_type( 1.5, 1.5, 1.5 ) )->second );
+    EXPECT_EQ( -111, m.find( flat_map_type::point_type( -1, -1, -1 ) )->second );
+    EXPECT_EQ( 111, m.touch_at( flat_map_type::point_type( 1.1, 1.1, 1.1 ) )->second );
+    EXPECT_EQ( 2u, m.size() );
+    EXPECT_FALSE( m.insert( flat_map_type::point_type( 1, 1, 1 ), 5 ).second );
+    EXPECT_TRUE( m.insert( flat_map_type::point_type( 0, 0, 0 ), 5 ).second );
+    flat_map_type::index_type index = {{ 0, 0, 0 }};
+    EXPECT_EQ( 5, m.find( index )->second );
+    flat_map_type::index_type absent = {{ 0, 0, 1 }};
+    EXPECT_TRUE( m.find( absent ) == m.end() );
+    flat_map_type::index_type edge = {{ std::numeric_limits< comma::int32 >::min(), std::numeric_limits< comma::int32 >::max(), 0 }};
+    EXPECT_TRUE( m.find( edge ) == m.end() );
+    EXPECT_TRUE( m.base_type::insert( std::make_pair( edge, 7 ) ).second );
+    EXPECT_EQ( 7, m.find( edge )->second );
+    m.clear();
+    EXPECT_TRUE( m.empty() );
+    EXPECT_TRUE( m.find( edge ) == m.end() );
+}
+
+TEST( voxel_map, flat_same_as_unordered )
+{
+    map_type u( map_type::point_type( 0.3, 0.3, 0.3 ) );
+    flat_map_type f( flat_map_type::point_type( 0.3, 0.3, 0.3 ) );
+    comma::uint32 seed = 1;
+    for( unsigned int i = 0; i < 100000; ++i )
+    {
+        double c[3];
+        for( unsigned int k = 0; k < 3; ++k ) { seed = seed * 1664525 + 1013904223; c[k] = double( seed >> 8 ) / ( 1 << 24 ) * 60 - 30; }
+        map_type::point_type p( c[0], c[1], c[2] );
+        ++u.touch_at( p )->second;
+        ++f.touch_at( p )->second;
+    }
+    EXPECT_EQ( u.size(), f.size() );
+    for( map_type::const_iterator it = u.begin(); it != u.end(); ++it )
+    {
+        flat_map_type::const_iterator fit = f.find( it->first );
+        ASSERT_TRUE( fit != f.end() );
+        EXPECT_EQ( it->second, fit->second );
+    }
+    std::size_t count = 0;
+    for( flat_map_type::const_iterator it = f.begin(); it != f.end(); ++it ) { count += it->second; }
+    EXPECT_EQ( 100000u, count );
+}
+
+TEST( voxel_map, flat_references_remain_valid )
+{
+    flat_map_type m( flat_map_type::point_type( 1, 1, 1 ) );
+    int* first = &m.touch_at( flat_map_type::point_type( 0, 0, 0 ) )->second;
+    *first = 42;
+    for( int i = 1; i < 10000; ++i ) { m.touch_at( flat_map_type::point_type( i, -i, i % 7 ) ); } // table gets rebuilt several times
+    EXPECT_EQ( 10000u, m.size() );
+    EXPECT_EQ( first, &m.find( flat_map_type::point_type( 0, 0, 0 ) )->second );
+    EXPECT_EQ( 42, *first );
+    EXPECT_TRUE( m.begin()->second == 42 ); // voxels are iterated in the order of insertion
+}
+
+TEST( voxel_map, flat_large_coordinates )
+{
+    flat_map_type m( flat_map_type::point_type( 0.25, 0.25, 0.25 ) ); // e.g. utm coordinates with default origin: indices far beyond 2^20
+    for( int i = 0; i < 1000; ++i ) { m.touch_at( flat_map_type::point_type( 6e6 + i * 0.25, -3e5 - i * 0.25, 1e4 ) )->second = i; }
+    EXPECT_EQ( 1000u, m.size() );
+    for( int i = 0; i < 1000; ++i ) { EXPECT_EQ( i, m.find( flat_map_type::point_type( 6e6 + i * 0.25 + 0.125, -3e5 - i * 0.25 + 0.125, 1e4 + 0.125 ) )->second ); }
+    EXPECT_TRUE( m.find( flat_map_type::point_type( 0.125, 0.125, 0.125 ) ) == m.end() );
+}
+
+TEST( voxel_map, flat_2d )
+{
+    typedef voxel_map< int, 2, Eigen::Matrix< double, 2, 1 >, voxel_storage::flat > map_2d;
+    map_2d m( map_2d::point_type( 0.5, 0.5 ) );
+    m.touch_at( map_2d::point_type( -1e8, 1e8 ) )->second = 1; // 31 bits per dimension in 2d
+    m.touch_at( map_2d::point_type( 1e8, -1e8 ) )->second = 2;
+    EXPECT_EQ( 2u, m.size() );
+    EXPECT_EQ( 1, m.find( map_2d::point_type( -1e8, 1e8 ) )->second );
+    EXPECT_EQ( 2, m.find( map_2d::point_type( 1e8, -1e8 ) )->second );
+}
+
 } }
 
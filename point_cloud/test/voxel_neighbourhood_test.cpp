@@ -0,0 +1,125 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdlib>
+#include <map>
+#include <gtest/gtest.h>
+#include <comma/base/exception.h>
+#include <snark/point_cloud/voxel_neighbourhood.h>
+
+namespace snark {
+
+typedef voxel_neighbourhood< comma::uint64 > neighbourhood_type;
+typedef neighbourhood_type::index_type index_type;
+
+static comma::uint64 brute_force( const std::map< index_type, comma::uint64 >& voxels, const index_type& index, int radius )
+{
+    comma::uint64 sum = 0;
+    for( std::map< index_type, comma::uint64 >::const_iterator it = voxels.begin(); it != voxels.end(); ++it )
+    {
+        if(    std::abs( it->first[0] - index[0] ) <= radius
+            && std::abs( it->first[1] - index[1] ) <= radius
+            && std::abs( it->first[2] - index[2] ) <= radius ) { sum += it->second; }
+    }
+    return sum;
+}
+
+TEST( voxel_neighbourhood, single )
+{
+    neighbourhood_type n( 1 );
+    index_type i = {{ 0, 0, 0 }};
+    n.add( i, 5 );
+    n.add( i, 2 );
+    n.build();
+    EXPECT_EQ( 7u, n.sum( i ) );
+    index_type j = {{ -1, 1, 1 }};
+    EXPECT_EQ( 7u, n.sum( j ) );
+    index_type k = {{ -2, 0, 0 }};
+    EXPECT_EQ( 0u, n.sum( k ) );
+    EXPECT_EQ( 1u, n.bricks() );
+}
+
+TEST( voxel_neighbourhood, brick_boundaries )
+{
+    neighbourhood_type n( 1, 3 );
+    std::map< index_type, comma::uint64 > voxels;
+    for( int x = -4; x < 4; ++x ) { for( int y = -4; y < 4; ++y ) { for( int z = -4; z < 4; ++z ) { index_type i = {{ x, y, z }}; n.add( i, 1 ); voxels[i] = 1; } } }
+    n.build();
+    for( int x = -6; x < 6; ++x ) { for( int y = -6; y < 6; ++y ) { for( int z = -6; z < 6; ++z ) { index_type i = {{ x, y, z }}; EXPECT_EQ( brute_force( voxels, i, 1 ), n.sum( i ) ); } } }
+}
+
+TEST( voxel_neighbourhood, radius_greater_than_brick )
+{
+    neighbourhood_type n( 3, 2 );
+    std::map< index_type, comma::uint64 > voxels;
+    ::srand( 1 );
+    for( unsigned int i = 0; i < 200; ++i )
+    {
+        index_type index = {{ ::rand() % 20 - 10, ::rand() % 20 - 10, ::rand() % 6 - 3 }};
+        n.add( index, 1 );
+        voxels[index] += 1;
+    }
+    n.build();
+    for( int x = -12; x < 12; ++x ) { for( int y = -12; y < 12; ++y ) { for( int z = -5; z < 5; ++z ) { index_type i = {{ x, y, z }}; EXPECT_EQ( brute_force( voxels, i, 3 ), n.sum( i ) ); } } }
+    EXPECT_EQ( 2u, n.brick() );
+}
+
+TEST( voxel_neighbourhood, same_as_brute_force )
+{
+    for( unsigned int radius = 0; radius < 6; ++radius )
+    {
+        neighbourhood_type n( radius );
+        std::map< index_type, comma::uint64 > voxels;
+        ::srand( 1 + radius );
+        for( unsigned int i = 0; i < 300; ++i )
+        {
+            index_type index = {{ ::rand() % 40 - 20, ::rand() % 40 - 20, ::rand() % 10 - 5 }};
+            comma::uint64 w = ::rand() % 10 + 1;
+            n.add( index, w );
+            voxels[index] += w;
+        }
+        n.build();
+        for( std::map< index_type, comma::uint64 >::const_iterator it = voxels.begin(); it != voxels.end(); ++it ) { EXPECT_EQ( brute_force( voxels, it->first, radius ), n.sum( it->first ) ); }
+    }
+}
+
+TEST( voxel_neighbourhood, usage )
+{
+    EXPECT_EQ( 8u, neighbourhood_type( 1 ).brick() );
+    EXPECT_EQ( 13u, neighbourhood_type( 6 ).brick() );
+    EXPECT_EQ( 16u, neighbourhood_type( 20 ).brick() );
+    neighbourhood_type n( 2 );
+    index_type i = {{ 0, 0, 0 }};
+    EXPECT_THROW( n.sum( i ), comma::exception );
+    n.build();
+    EXPECT_THROW( n.add( i, 1 ), comma::exception );
+}
+
+} // namespace snark {
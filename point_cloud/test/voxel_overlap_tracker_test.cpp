@@ -0,0 +1,110 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+#include <snark/point_cloud/voxel_overlap_tracker.h>
+
+namespace snark {
+
+static void add_box( voxel_overlap_tracker& tracker, std::vector< comma::uint32 >& partitions, comma::uint32 id, double x, double y, unsigned int size )
+{
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        for( unsigned int j = 0; j < size; ++j ) { partitions.push_back( tracker.add( Eigen::Vector3d( x + 0.1 + i, y + 0.1 + j, 0.1 ), id ) ); }
+    }
+}
+
+TEST( voxel_overlap_tracker, first_block )
+{
+    voxel_overlap_tracker tracker( Eigen::Vector3d::Zero(), Eigen::Vector3d( 1, 1, 1 ) );
+    std::vector< comma::uint32 > partitions;
+    add_box( tracker, partitions, 5, 0, 0, 2 );
+    add_box( tracker, partitions, 3, 10, 0, 2 );
+    tracker.track();
+    EXPECT_EQ( tracker.size(), 2u );
+    EXPECT_EQ( tracker.id( partitions[0] ), 5u );
+    EXPECT_EQ( tracker.id( partitions[4] ), 3u );
+}
+
+TEST( voxel_overlap_tracker, track )
+{
+    voxel_overlap_tracker tracker( Eigen::Vector3d::Zero(), Eigen::Vector3d( 1, 1, 1 ) );
+    std::vector< comma::uint32 > partitions;
+    add_box( tracker, partitions, 0, 0, 0, 3 );
+    add_box( tracker, partitions, 1, 10, 0, 3 );
+    add_box( tracker, partitions, 2, 20, 0, 3 );
+    tracker.track();
+    partitions.clear();
+    add_box( tracker, partitions, 7, 11, 0, 3 ); // moved partition 1
+    add_box( tracker, partitions, 8, 0, 0, 3 ); // partition 0
+    add_box( tracker, partitions, 9, 30, 0, 3 ); // new partition
+    tracker.track();
+    EXPECT_EQ( tracker.id( partitions[0] ), 1u );
+    EXPECT_EQ( tracker.id( partitions[9] ), 0u );
+    EXPECT_EQ( tracker.id( partitions[18] ), 3u );
+    for( unsigned int i = 0; i < partitions.size(); ++i ) { EXPECT_EQ( tracker.id( partitions[i] ), tracker.id( partitions[ i / 9 * 9 ] ) ); }
+    partitions.clear();
+    add_box( tracker, partitions, 0, 30, 0, 3 );
+    add_box( tracker, partitions, 1, 20, 0, 3 ); // partition 2 was not in the previous block
+    tracker.track();
+    EXPECT_EQ( tracker.id( partitions[0] ), 3u );
+    EXPECT_EQ( tracker.id( partitions[9] ), 4u );
+}
+
+TEST( voxel_overlap_tracker, split )
+{
+    voxel_overlap_tracker tracker( Eigen::Vector3d::Zero(), Eigen::Vector3d( 1, 1, 1 ) );
+    std::vector< comma::uint32 > partitions;
+    add_box( tracker, partitions, 0, 0, 0, 4 );
+    tracker.track();
+    partitions.clear();
+    add_box( tracker, partitions, 1, 0, 0, 1 );
+    add_box( tracker, partitions, 2, 2, 2, 2 ); // larger overlap keeps the id
+    tracker.track();
+    EXPECT_EQ( tracker.id( partitions[0] ), 1u );
+    EXPECT_EQ( tracker.id( partitions[1] ), 0u );
+}
+
+TEST( voxel_overlap_tracker, tie )
+{
+    voxel_overlap_tracker tracker( Eigen::Vector3d::Zero(), Eigen::Vector3d( 1, 1, 1 ) );
+    std::vector< comma::uint32 > partitions;
+    add_box( tracker, partitions, 0, 0, 0, 2 );
+    tracker.track();
+    partitions.clear();
+    tracker.add( Eigen::Vector3d( 0.5, 0.5, 0.5 ), 4 );
+    tracker.add( Eigen::Vector3d( 1.5, 0.5, 0.5 ), 3 );
+    tracker.add( Eigen::Vector3d( 1.5, 0.5, 0.5 ), 4 ); // voxels shared by partitions are counted for each of them
+    tracker.track();
+    EXPECT_EQ( tracker.id( 0 ), 0u ); // same overlap: larger partition wins
+    EXPECT_EQ( tracker.id( 1 ), 1u );
+}
+
+} // namespace snark {
@@ -37,23 +37,43 @@
 #include <Eigen/Core>
 #include <boost/optional.hpp>
 #include <snark/math/interval.h>
+#include <snark/point_cloud/impl/brick_pin_screen.h>
 #include <snark/point_cloud/impl/pin_screen.h>
 
 namespace snark {
 
+/// storage policies for voxel_grid
+namespace voxel_grid_storage {
+
+/// pin_screen: dense 2D array of std::map columns; memory grows with 2D extents
+struct columns
+{
+    template < typename V > struct screen { typedef pin_screen< V > type; };
+};
+
+/// brick_pin_screen: hashed 8x8x8 bricks; memory grows with occupied volume; column( point ) not supported
+struct bricks
+{
+    template < typename V > struct screen { typedef brick_pin_screen< V > type; };
+};
+
+} // namespace voxel_grid_storage {
+
 /// voxel grid
 /// @todo this class is mostly copy-pasted
 ///       just to allow refactoring elsewhere
 ///       refactor this class further, if needed
-template < typename V = boost::none_t, typename P = Eigen::Vector3d >
-class voxel_grid : public pin_screen< V >
+/// @param S storage policy, see voxel_grid_storage
+template < typename V = boost::none_t, typename P = Eigen::Vector3d, typename S = voxel_grid_storage::columns >
+class voxel_grid : public S::template screen< V >::type
 {
     public:
         typedef V voxel_type;
         typedef P point_type;
-        typedef typename pin_screen< V >::index_type index_type;
-        typedef typename pin_screen< V >::size_type size_type;
-        typedef typename pin_screen< V >::column_type column_type;
+        typedef typename S::template screen< V >::type base_type;
+        typedef typename base_type::index_type index_type;
+        typedef typename base_type::size_type size_type;
+        typedef typename base_type::column_type column_type;
         typedef snark::math::closed_interval< typename P::Scalar, P::RowsAtCompileTime > interval_type;
         
         /// constructor
@@ -64,6 +84,9 @@ class voxel_grid : public pin_screen< V >
                   , const point_type& resolution
                   , bool adjusted = false );
 
+        /// clear and set new extents, keeping resolution; with brick storage, keeps allocated memory for reuse
+        void reset( const interval_type& extents, bool adjusted = false );
+
         /// return extents
         const interval_type& extents() const;
 
@@ -92,10 +115,10 @@ class voxel_grid : public pin_screen< V >
         const column_type* column( const point_type& p ) const;
         //column_type* column( const point_type& p ); // no non-const class in pin_screen for now
 
-        using typename pin_screen< voxel_type >::iterator;
-        using typename pin_screen< voxel_type >::const_iterator;
-        using typename pin_screen< voxel_type >::neighbourhood_iterator;
-        using pin_screen< voxel_type >::column;
+        using typename base_type::iterator;
+        using typename base_type::const_iterator;
+        using typename base_type::neighbourhood_iterator;
+        using base_type::column;
 
     private:
         interval_type extents_;
@@ -120,74 +143,81 @@ inline static Eigen::Matrix< std::size_t, 1, 2 > size( const math::closed_interv
 
 } // namespace detail {
 
-template < typename V, typename P >
-inline voxel_grid< V, P >::voxel_grid( const typename voxel_grid< V, P >::interval_type& extents
-                                , const typename voxel_grid< V, P >::point_type& resolution
+template < typename V, typename P, typename S >
+inline voxel_grid< V, P, S >::voxel_grid( const typename voxel_grid< V, P, S >::interval_type& extents
+                                   , const typename voxel_grid< V, P, S >::point_type& resolution
                                 , bool adjusted )
-    : pin_screen< V >( detail::size( extents, resolution, adjusted ) )
+    : base_type( detail::size( extents, resolution, adjusted ) )
     , extents_( detail::extents( extents, resolution, adjusted ) )
     , resolution_( resolution )
 {
 }
 
-template < typename V, typename P >
-inline const typename voxel_grid< V, P >::interval_type& voxel_grid< V, P >::extents() const { return extents_; }
+template < typename V, typename P, typename S >
+inline void voxel_grid< V, P, S >::reset( const typename voxel_grid< V, P, S >::interval_type& extents, bool adjusted )
+{
+    base_type::resize( detail::size( extents, resolution_, adjusted ) );
+    extents_ = detail::extents( extents, resolution_, adjusted );
+}
+
+template < typename V, typename P, typename S >
+inline const typename voxel_grid< V, P, S >::interval_type& voxel_grid< V, P, S >::extents() const { return extents_; }
 
-template < typename V, typename P >
-inline const P& voxel_grid< V, P >::resolution() const { return resolution_; }
+template < typename V, typename P, typename S >
+inline const P& voxel_grid< V, P, S >::resolution() const { return resolution_; }
 
-template < typename V, typename P >
-inline typename voxel_grid< V, P >::index_type voxel_grid< V, P >::index_of( const P& p ) const
+template < typename V, typename P, typename S >
+inline typename voxel_grid< V, P, S >::index_type voxel_grid< V, P, S >::index_of( const P& p ) const
 {
     return index_type( std::floor( ( p.x() - extents_.min().x() ) / resolution_.x() )
                      , std::floor( ( p.y() - extents_.min().y() ) / resolution_.y() )
                      , std::floor( ( p.z() - extents_.min().z() ) / resolution_.z() ) );
 }
 
-template < typename V, typename P >
-inline bool voxel_grid< V, P >::covers( const P& p ) const
+template < typename V, typename P, typename S >
+inline bool voxel_grid< V, P, S >::covers( const P& p ) const
 {
     return extents_.contains( p );
 }
 
-template < typename V, typename P >
-inline V* voxel_grid< V, P >::touch_at( const P& p )
+template < typename V, typename P, typename S >
+inline V* voxel_grid< V, P, S >::touch_at( const P& p )
 {
     if( !covers( p ) ) { return NULL; }
     const index_type& i = index_of( p );
-    return &pin_screen< V >::touch( i );
+    return &base_type::touch( i );
 }
 
-template < typename V, typename P >
-inline void voxel_grid< V, P >::erase_at( const P& point )
+template < typename V, typename P, typename S >
+inline void voxel_grid< V, P, S >::erase_at( const P& point )
 {
     if( !covers( point ) ) { return; }
-    pin_screen< V >::erase( index_of( point ) );
+    base_type::erase( index_of( point ) );
 }
 
-template < typename V, typename P >
-inline P voxel_grid< V, P >::origin( const index_type& i ) const
+template < typename V, typename P, typename S >
+inline P voxel_grid< V, P, S >::origin( const index_type& i ) const
 {
     P p( resolution_[0] * i[0], resolution_[1] * i[1], resolution_[2] * i[2] );
     return extents_.min() + p;
 }
 
-template < typename V, typename P >
-inline P voxel_grid< V, P >::origin_at( const point_type& p ) const
+template < typename V, typename P, typename S >
+inline P voxel_grid< V, P, S >::origin_at( const point_type& p ) const
 {
     return origin( index_of( p ) );
 }
 
-template < typename V, typename P >
-const typename voxel_grid< V, P >::column_type* voxel_grid< V, P >::column( const point_type& p ) const
+template < typename V, typename P, typename S >
+const typename voxel_grid< V, P, S >::column_type* voxel_grid< V, P, S >::column( const point_type& p ) const
 {
     if( !covers( p ) ) { return NULL; }
     index_type index = index_of( p );
-    return &this->pin_screen< V >::column( index.x(), index.y() );
+    return &this->base_type::column( index.x(), index.y() );
 }
 
-// template < typename V, typename P >
-// typename voxel_grid< V, P >::column_type* voxel_grid< V, P >::column( const point_type& p )
+// template < typename V, typename P, typename S >
+// typename voxel_grid< V, P, S >::column_type* voxel_grid< V, P, S >::column( const point_type& p )
 // {
 //     if( !covers( p ) ) { return NULL; }
 //     index i = index_of( p );
@@ -36,6 +36,7 @@
 #include <boost/unordered_map.hpp>
 #include <Eigen/Core>
 #include <comma/base/types.h>
+#include <snark/point_cloud/flat_voxel_map.h>
 
 namespace snark {
 
@@ -53,13 +54,33 @@ struct array_hash : public std::unary_function< Array, std::size_t >
     }
 };
 
+/// storage policies for voxel_map
+namespace voxel_storage {
+
+/// boost::unordered_map: one node per voxel, any index range, supports erase
+struct unordered
+{
+    template < typename V, unsigned int D > struct map { typedef boost::unordered_map< boost::array< comma::int32, D >, V, snark::array_hash< boost::array< comma::int32, D >, D > > type; };
+};
+
+/// flat_voxel_map: open addressing on contiguous arrays of indices, much faster
+/// and smaller for large maps; any index range; no erase
+struct flat
+{
+    template < typename V, unsigned int D > struct map { typedef flat_voxel_map< V, D > type; };
+};
+
+} // namespace voxel_storage {
+
 /// unordered voxel map
 ///
 /// it may be a much better choice than voxel grid, whenever
 /// operations on a voxel do not depend on its neighbours,
 /// and also when the grid extents are not known beforehand
-template < typename V, unsigned int D, typename P = Eigen::Matrix< double, D, 1 > >
-class voxel_map : public boost::unordered_map< boost::array< comma::int32, D >, V, snark::array_hash< boost::array< comma::int32, D >, D > >
+///
+/// @param S storage policy, see voxel_storage
+template < typename V, unsigned int D, typename P = Eigen::Matrix< double, D, 1 >, typename S = voxel_storage::unordered >
+class voxel_map : public S::template map< V, D >::type
 {
     public:
         /// number of dimensions
@@ -75,7 +96,7 @@ class voxel_map : public boost::unordered_map< boost::array< comma::int32, D >,
         typedef boost::array< comma::int32, D > index_type;
         
         /// base class type
-        typedef boost::unordered_map< index_type, voxel_type, snark::array_hash< index_type, D > > base_type;
+        typedef typename S::template map< V, D >::type base_type;
         
         /// iterator type (otherwise it does not build on windows...)
         typedef typename base_type::iterator iterator;
@@ -127,22 +148,22 @@ class voxel_map : public boost::unordered_map< boost::array< comma::int32, D >,
         point_type resolution_;
 };
 
-template < typename V, unsigned int D, typename P >
-inline voxel_map< V, D, P >::voxel_map( const typename voxel_map< V, D, P >::point_type& origin, const typename voxel_map< V, D, P >::point_type& resolution )
+template < typename V, unsigned int D, typename P, typename S >
+inline voxel_map< V, D, P, S >::voxel_map( const typename voxel_map< V, D, P, S >::point_type& origin, const typename voxel_map< V, D, P, S >::point_type& resolution )
     : origin_( origin )
     , resolution_( resolution )
 {
 }
 
-template < typename V, unsigned int D, typename P >
-inline voxel_map< V, D, P >::voxel_map( const typename voxel_map< V, D, P >::point_type& resolution )
+template < typename V, unsigned int D, typename P, typename S >
+inline voxel_map< V, D, P, S >::voxel_map( const typename voxel_map< V, D, P, S >::point_type& resolution )
     : origin_( point_type::Zero() ) // todo: use traits, if decoupling from eigen required
     , resolution_( resolution )
 {
 }
 
-template < typename V, unsigned int D, typename P >
-inline typename voxel_map< V, D, P >::iterator voxel_map< V, D, P >::touch_at( const typename voxel_map< V, D, P >::point_type& point )
+template < typename V, unsigned int D, typename P, typename S >
+inline typename voxel_map< V, D, P, S >::iterator voxel_map< V, D, P, S >::touch_at( const typename voxel_map< V, D, P, S >::point_type& point )
 {
     index_type index = index_of( point );
     iterator it = this->base_type::find( index );
@@ -150,8 +171,8 @@ inline typename voxel_map< V, D, P >::iterator voxel_map< V, D, P >::touch_at( c
     return this->base_type::insert( std::make_pair( index, voxel_type() ) ).first;
 }
 
-template < typename V, unsigned int D, typename P >
-inline std::pair< typename voxel_map< V, D, P >::iterator, bool > voxel_map< V, D, P >::insert( const typename voxel_map< V, D, P >::point_type& point, const typename voxel_map< V, D, P >::voxel_type& voxel )
+template < typename V, unsigned int D, typename P, typename S >
+inline std::pair< typename voxel_map< V, D, P, S >::iterator, bool > voxel_map< V, D, P, S >::insert( const typename voxel_map< V, D, P, S >::point_type& point, const typename voxel_map< V, D, P, S >::voxel_type& voxel )
 {
     return this->base_type::insert( std::make_pair( index_of( point ), voxel ) );
 }
@@ -163,8 +184,8 @@ static int positive_flooring_ = static_cast< int >( 1.5 ) == 1 ? 0 : static_cast
 
 } // namespace impl {
 
-template < typename V, unsigned int D, typename P >
-inline typename voxel_map< V, D, P >::index_type voxel_map< V, D, P >::index_of( const typename voxel_map< V, D, P >::point_type& point, const typename voxel_map< V, D, P >::point_type& origin, const typename voxel_map< V, D, P >::point_type& resolution )
+template < typename V, unsigned int D, typename P, typename S >
+inline typename voxel_map< V, D, P, S >::index_type voxel_map< V, D, P, S >::index_of( const typename voxel_map< V, D, P, S >::point_type& point, const typename voxel_map< V, D, P, S >::point_type& origin, const typename voxel_map< V, D, P, S >::point_type& resolution )
 {
     point_type diff = ( point - origin ).array() / resolution.array();
     index_type index;
@@ -178,49 +199,49 @@ inline typename voxel_map< V, D, P >::index_type voxel_map< V, D, P >::index_of(
     return index;
 }
 
-template < typename V, unsigned int D, typename P >
-inline typename voxel_map< V, D, P >::index_type voxel_map< V, D, P >::index_of( const typename voxel_map< V, D, P >::point_type& point, const typename voxel_map< V, D, P >::point_type& resolution )
+template < typename V, unsigned int D, typename P, typename S >
+inline typename voxel_map< V, D, P, S >::index_type voxel_map< V, D, P, S >::index_of( const typename voxel_map< V, D, P, S >::point_type& point, const typename voxel_map< V, D, P, S >::point_type& resolution )
 {
     return index_of( point, point_type::Zero(), resolution );
 }
 
-template < typename V, unsigned int D, typename P >
-inline typename voxel_map< V, D, P >::index_type voxel_map< V, D, P >::index_of( const typename voxel_map< V, D, P >::point_type& point ) const
+template < typename V, unsigned int D, typename P, typename S >
+inline typename voxel_map< V, D, P, S >::index_type voxel_map< V, D, P, S >::index_of( const typename voxel_map< V, D, P, S >::point_type& point ) const
 {
     return index_of( point, origin_, resolution_ );
 }
 
-template < typename V, unsigned int D, typename P >
-inline typename voxel_map< V, D, P >::iterator voxel_map< V, D, P >::find( const typename voxel_map< V, D, P >::point_type& point )
+template < typename V, unsigned int D, typename P, typename S >
+inline typename voxel_map< V, D, P, S >::iterator voxel_map< V, D, P, S >::find( const typename voxel_map< V, D, P, S >::point_type& point )
 {
     index_type i = index_of( point );
     return this->base_type::find( i );
 }
 
-template < typename V, unsigned int D, typename P >
-inline typename voxel_map< V, D, P >::const_iterator voxel_map< V, D, P >::find( const typename voxel_map< V, D, P >::point_type& point ) const
+template < typename V, unsigned int D, typename P, typename S >
+inline typename voxel_map< V, D, P, S >::const_iterator voxel_map< V, D, P, S >::find( const typename voxel_map< V, D, P, S >::point_type& point ) const
 {
     index_type i = index_of( point );
     return this->base_type::find( i );
 }
 
-template < typename V, unsigned int D, typename P >
-inline typename voxel_map< V, D, P >::iterator voxel_map< V, D, P >::find( const typename voxel_map< V, D, P >::index_type& index )
+template < typename V, unsigned int D, typename P, typename S >
+inline typename voxel_map< V, D, P, S >::iterator voxel_map< V, D, P, S >::find( const typename voxel_map< V, D, P, S >::index_type& index )
 {
     return this->base_type::find( index ); // otherwise strange things happen... debug, when we have time
 }
 
-template < typename V, unsigned int D, typename P >
-inline typename voxel_map< V, D, P >::const_iterator voxel_map< V, D, P >::find( const typename voxel_map< V, D, P >::index_type& index ) const
+template < typename V, unsigned int D, typename P, typename S >
+inline typename voxel_map< V, D, P, S >::const_iterator voxel_map< V, D, P, S >::find( const typename voxel_map< V, D, P, S >::index_type& index ) const
 {
     return this->base_type::find( index ); // otherwise strange things happen... debug, when we have time
 }
 
-template < typename V, unsigned int D, typename P >
-inline const typename voxel_map< V, D, P >::point_type& voxel_map< V, D, P >::origin() const { return origin_; }
+template < typename V, unsigned int D, typename P, typename S >
+inline const typename voxel_map< V, D, P, S >::point_type& voxel_map< V, D, P, S >::origin() const { return origin_; }
 
-template < typename V, unsigned int D, typename P >
-inline const typename voxel_map< V, D, P >::point_type& voxel_map< V, D, P >::resolution() const { return resolution_; }
+template < typename V, unsigned int D, typename P, typename S >
+inline const typename voxel_map< V, D, P, S >::point_type& voxel_map< V, D, P, S >::resolution() const { return resolution_; }
 
 } // namespace snark {
 
@@ -0,0 +1,188 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_VOXEL_NEIGHBOURHOOD_H
+#define SNARK_POINT_CLOUD_VOXEL_NEIGHBOURHOOD_H
+
+#include <algorithm>
+#include <vector>
+#include <boost/array.hpp>
+#include <comma/base/exception.h>
+#include <comma/base/types.h>
+#include <snark/point_cloud/flat_voxel_map.h>
+
+namespace snark {
+
+/// sums of voxel values over cubic neighbourhoods in a sparse 3d voxel set
+///
+/// the space is split into cubic bricks of bounded edge, by default 2 * radius + 1,
+/// but not less than 8 and not more than 16 voxels; each occupied brick holds a dense
+/// summed-volume table of its voxels, thus the sum over a neighbourhood takes one lookup
+/// for each brick the neighbourhood covers entirely and at most 8 lookups for each brick
+/// it covers partially
+///
+/// memory: edge^3 values per occupied brick, i.e. at most 16^3 by default, whatever the radius;
+/// a neighbourhood spans up to ( ( 2 * radius + 1 ) / edge + 1 )^3 bricks, thus for radii
+/// greater than the edge, query time grows with the radius; a greater brick edge trades
+/// memory for query time
+///
+/// the cost of build() is linear in the volume of occupied bricks, which
+/// for the typical point clouds is close to linear in the number of occupied voxels
+///
+/// W: value type; it should be default-constructible to zero and have += and -=;
+/// for example, number of points for weighted counts or 1 for counts of voxels
+///
+/// usage:
+///     voxel_neighbourhood< W > n( radius );
+///     for( ... ) { n.add( index, w ); }
+///     n.build();
+///     for( ... ) { W sum = n.sum( index ); }
+template < typename W >
+class voxel_neighbourhood
+{
+    public:
+        typedef boost::array< comma::int32, 3 > index_type;
+
+        /// constructor
+        /// @param radius neighbourhood radius in voxels: neighbourhood of a voxel is [index - radius, index + radius] along each axis
+        /// @param brick brick edge in voxels; default: 2 * radius + 1, but not less than 8 and not more than 16
+        voxel_neighbourhood( unsigned int radius, unsigned int brick = 0 );
+
+        /// add value to the voxel at given index; adding to the same voxel again accumulates
+        void add( const index_type& index, const W& w );
+
+        /// compute summed-volume tables; call once, after all values have been added
+        void build();
+
+        /// return sum of values in the neighbourhood of the given voxel
+        /// (the voxel itself does not have to be occupied)
+        W sum( const index_type& index ) const;
+
+        /// number of occupied bricks
+        std::size_t bricks() const { return bricks_.size(); }
+
+        unsigned int radius() const { return radius_; }
+
+        unsigned int brick() const { return edge_; }
+
+    private:
+        unsigned int radius_;
+        comma::int32 edge_;
+        flat_voxel_map< std::size_t, 3 > bricks_; // brick index -> offset of its table in values_
+        std::vector< W > values_;
+        bool built_;
+
+        comma::int32 brick_of_( comma::int32 i ) const { return i >= 0 ? i / edge_ : -( ( -i - 1 ) / edge_ ) - 1; }
+        std::size_t offset_( comma::int32 x, comma::int32 y, comma::int32 z ) const { return ( std::size_t( z ) * edge_ + y ) * edge_ + x; }
+};
+
+template < typename W >
+inline voxel_neighbourhood< W >::voxel_neighbourhood( unsigned int radius, unsigned int brick )
+    : radius_( radius )
+    , edge_( brick == 0 ? std::min( std::max( 2 * radius + 1, 8u ), 16u ) : brick )
+    , built_( false )
+{
+}
+
+template < typename W >
+inline void voxel_neighbourhood< W >::add( const typename voxel_neighbourhood< W >::index_type& index, const W& w )
+{
+    if( built_ ) { COMMA_THROW( comma::exception, "cannot add voxels after build()" ); }
+    index_type b = {{ brick_of_( index[0] ), brick_of_( index[1] ), brick_of_( index[2] ) }};
+    std::pair< flat_voxel_map< std::size_t, 3 >::iterator, bool > r = bricks_.insert( std::make_pair( b, values_.size() ) );
+    if( r.second ) { values_.resize( values_.size() + std::size_t( edge_ ) * edge_ * edge_ ); }
+    values_[ r.first->second + offset_( index[0] - b[0] * edge_, index[1] - b[1] * edge_, index[2] - b[2] * edge_ ) ] += w;
+}
+
+template < typename W >
+inline void voxel_neighbourhood< W >::build()
+{
+    if( built_ ) { return; }
+    for( flat_voxel_map< std::size_t, 3 >::const_iterator it = bricks_.begin(); it != bricks_.end(); ++it ) // separable prefix sums along x, y, z
+    {
+        W* t = &values_[ it->second ];
+        for( comma::int32 z = 0; z < edge_; ++z ) { for( comma::int32 y = 0; y < edge_; ++y ) { for( comma::int32 x = 1; x < edge_; ++x ) { t[ offset_( x, y, z ) ] += t[ offset_( x - 1, y, z ) ]; } } }
+        for( comma::int32 z = 0; z < edge_; ++z ) { for( comma::int32 y = 1; y < edge_; ++y ) { for( comma::int32 x = 0; x < edge_; ++x ) { t[ offset_( x, y, z ) ] += t[ offset_( x, y - 1, z ) ]; } } }
+        for( comma::int32 z = 1; z < edge_; ++z ) { for( comma::int32 y = 0; y < edge_; ++y ) { for( comma::int32 x = 0; x < edge_; ++x ) { t[ offset_( x, y, z ) ] += t[ offset_( x, y, z - 1 ) ]; } } }
+    }
+    built_ = true;
+}
+
+template < typename W >
+inline W voxel_neighbourhood< W >::sum( const typename voxel_neighbourhood< W >::index_type& index ) const
+{
+    if( !built_ ) { COMMA_THROW( comma::exception, "call build() first" ); }
+    index_type lo, hi, blo, bhi;
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        lo[i] = index[i] - comma::int32( radius_ );
+        hi[i] = index[i] + comma::int32( radius_ );
+        blo[i] = brick_of_( lo[i] );
+        bhi[i] = brick_of_( hi[i] );
+    }
+    W s = W();
+    index_type b;
+    for( b[2] = blo[2]; b[2] <= bhi[2]; ++b[2] )
+    {
+        for( b[1] = blo[1]; b[1] <= bhi[1]; ++b[1] )
+        {
+            for( b[0] = blo[0]; b[0] <= bhi[0]; ++b[0] )
+            {
+                flat_voxel_map< std::size_t, 3 >::const_iterator it = bricks_.find( b );
+                if( it == bricks_.end() ) { continue; }
+                const W* t = &values_[ it->second ];
+                comma::int32 l[3], h[3]; // box in brick coordinates; l is exclusive, i.e. -1 means from the brick boundary
+                for( unsigned int i = 0; i < 3; ++i )
+                {
+                    comma::int32 begin = b[i] * edge_;
+                    l[i] = lo[i] > begin ? lo[i] - begin - 1 : -1;
+                    h[i] = hi[i] < begin + edge_ - 1 ? hi[i] - begin : edge_ - 1;
+                }
+                for( unsigned int corner = 0; corner < 8; ++corner ) // inclusion-exclusion over the corners of the box
+                {
+                    comma::int32 c[3];
+                    unsigned int lows = 0;
+                    bool empty = false;
+                    for( unsigned int i = 0; i < 3; ++i )
+                    {
+                        if( corner & ( 1 << i ) ) { c[i] = l[i]; ++lows; empty = empty || l[i] < 0; } else { c[i] = h[i]; }
+                    }
+                    if( empty ) { continue; }
+                    if( lows & 1 ) { s -= t[ offset_( c[0], c[1], c[2] ) ]; } else { s += t[ offset_( c[0], c[1], c[2] ) ]; }
+                }
+            }
+        }
+    }
+    return s;
+}
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_VOXEL_NEIGHBOURHOOD_H
@@ -0,0 +1,220 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_POINT_CLOUD_VOXEL_OVERLAP_TRACKER_H
+#define SNARK_POINT_CLOUD_VOXEL_OVERLAP_TRACKER_H
+
+#include <algorithm>
+#include <vector>
+#include <Eigen/Core>
+#include <comma/base/types.h>
+#include <snark/point_cloud/flat_voxel_map.h>
+#include <snark/point_cloud/voxel_map.h>
+
+namespace snark {
+
+/// keep partition ids consistent in subsequent partitioned blocks of points
+///
+/// each partition of a block has a signature: the set of voxels it occupies
+///
+/// while points of a new block are added, the overlaps between new partitions
+/// and partitions of the previous block, i.e. the numbers of voxels occupied
+/// by both, are counted in a hash of (previous partition, new partition) pairs
+///
+/// track() then assigns ids greedily: pairs with larger overlap go first;
+/// a new partition takes the id of the previous partition, unless either of
+/// them is already taken; new partitions that are left get vacant ids in
+/// the order of their first points; partitions of the first block keep their ids
+///
+/// ties are broken by the size of new partitions in voxels, then by the order
+/// of first points, thus the result depends only on input
+///
+/// only signatures of two blocks are kept; each block is tracked in linear time
+///
+/// usage:
+///     voxel_overlap_tracker tracker( origin, resolution );
+///     for( each block )
+///     {
+///         for( each point ) { partitions.push_back( tracker.add( point, id ) ); }
+///         tracker.track();
+///         for( each point ) { output( point, tracker.id( partitions[i] ) ); }
+///     }
+class voxel_overlap_tracker
+{
+    public:
+        typedef voxel_map< int, 3 >::index_type index_type;
+
+        /// constructor
+        voxel_overlap_tracker( const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution );
+
+        /// add point with given partition id to the current block
+        /// @return index of the partition in the current block
+        comma::uint32 add( const Eigen::Vector3d& point, comma::uint32 id );
+
+        /// assign ids to partitions of the current block; the next add() starts a new block
+        void track();
+
+        /// return id of partition by index returned by add(), valid after track()
+        comma::uint32 id( comma::uint32 partition ) const { return current_.ids[ partition ]; }
+
+        /// return number of partitions in the current block
+        std::size_t size() const { return current_.ids.size(); }
+
+    private:
+        struct block
+        {
+            flat_voxel_map< comma::uint32, 3 > voxels; // voxel index -> voxel position in the block
+            flat_voxel_map< comma::uint32, 1 > partitions; // partition id -> partition position in the block
+            std::vector< comma::uint32 > ids; // partition ids: input before track(), tracked after
+            std::vector< comma::uint32 > sizes; // partition sizes in voxels
+            std::vector< std::pair< comma::uint32, comma::uint32 > > signature; // sorted pairs of voxel and partition positions
+            std::vector< comma::uint32 > offsets; // offsets of voxels in signature
+            void clear();
+        };
+        struct overlap
+        {
+            comma::uint32 size;
+            comma::uint32 previous;
+            comma::uint32 current;
+            overlap( comma::uint32 size, comma::uint32 previous, comma::uint32 current ) : size( size ), previous( previous ), current( current ) {}
+        };
+        Eigen::Vector3d origin_;
+        Eigen::Vector3d resolution_;
+        block previous_;
+        block current_;
+        flat_voxel_map< char, 2 > pairs_; // (voxel, partition) pairs of the current block
+        flat_voxel_map< comma::uint32, 2 > overlaps_; // (previous partition, current partition) -> number of common voxels
+        std::vector< overlap > sorted_;
+        comma::uint32 vacant_;
+        bool tracked_;
+        bool first_;
+        struct greater
+        {
+            const std::vector< comma::uint32 >& sizes;
+            greater( const std::vector< comma::uint32 >& sizes ) : sizes( sizes ) {}
+            bool operator()( const overlap& lhs, const overlap& rhs ) const;
+        };
+};
+
+inline voxel_overlap_tracker::voxel_overlap_tracker( const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution )
+    : origin_( origin )
+    , resolution_( resolution )
+    , vacant_( 0 )
+    , tracked_( false )
+    , first_( true )
+{
+}
+
+inline void voxel_overlap_tracker::block::clear()
+{
+    voxels.clear();
+    partitions.clear();
+    ids.clear();
+    sizes.clear();
+    signature.clear();
+    offsets.clear();
+}
+
+inline comma::uint32 voxel_overlap_tracker::add( const Eigen::Vector3d& point, comma::uint32 id )
+{
+    if( tracked_ ) // quick and dirty: start new block; current block becomes previous
+    {
+        std::swap( previous_, current_ );
+        current_.clear();
+        pairs_.clear();
+        overlaps_.clear();
+        tracked_ = false;
+    }
+    flat_voxel_map< comma::uint32, 1 >::key_type partition_key = {{ comma::int32( id ) }};
+    comma::uint32 partition = current_.partitions.insert( std::make_pair( partition_key, comma::uint32( current_.ids.size() ) ) ).first->second;
+    if( partition == current_.ids.size() ) { current_.ids.push_back( id ); current_.sizes.push_back( 0 ); }
+    const index_type& index = voxel_map< int, 3 >::index_of( point, origin_, resolution_ );
+    comma::uint32 voxel = current_.voxels.insert( std::make_pair( index, comma::uint32( current_.voxels.size() ) ) ).first->second;
+    flat_voxel_map< char, 2 >::key_type pair_key = {{ comma::int32( voxel ), comma::int32( partition ) }};
+    if( !pairs_.insert( std::make_pair( pair_key, 0 ) ).second ) { return partition; }
+    ++current_.sizes[ partition ];
+    current_.signature.push_back( std::make_pair( voxel, partition ) );
+    flat_voxel_map< comma::uint32, 3 >::const_iterator it = previous_.voxels.find( index );
+    if( it == previous_.voxels.end() ) { return partition; }
+    for( comma::uint32 i = previous_.offsets[ it->second ]; i < previous_.offsets[ it->second + 1 ]; ++i )
+    {
+        flat_voxel_map< comma::uint32, 2 >::key_type key = {{ comma::int32( previous_.signature[i].second ), comma::int32( partition ) }};
+        ++overlaps_[ key ];
+    }
+    return partition;
+}
+
+inline bool voxel_overlap_tracker::greater::operator()( const overlap& lhs, const overlap& rhs ) const
+{
+    if( lhs.size != rhs.size ) { return lhs.size > rhs.size; }
+    if( sizes[ lhs.current ] != sizes[ rhs.current ] ) { return sizes[ lhs.current ] > sizes[ rhs.current ]; }
+    if( lhs.current != rhs.current ) { return lhs.current < rhs.current; }
+    return lhs.previous < rhs.previous;
+}
+
+inline void voxel_overlap_tracker::track()
+{
+    if( tracked_ ) { return; }
+    tracked_ = true;
+    if( first_ )
+    {
+        first_ = false;
+        for( std::size_t i = 0; i < current_.ids.size(); ++i ) { if( current_.ids[i] >= vacant_ ) { vacant_ = current_.ids[i] + 1; } }
+    }
+    else
+    {
+        sorted_.clear();
+        for( flat_voxel_map< comma::uint32, 2 >::const_iterator it = overlaps_.begin(); it != overlaps_.end(); ++it ) { sorted_.push_back( overlap( it->second, it->first[0], it->first[1] ) ); }
+        std::sort( sorted_.begin(), sorted_.end(), greater( current_.sizes ) );
+        static const comma::uint32 none = comma::uint32( -1 );
+        std::vector< comma::uint32 > ids( current_.ids.size(), none );
+        std::vector< bool > taken( previous_.ids.size(), false );
+        for( std::size_t i = 0; i < sorted_.size(); ++i )
+        {
+            const overlap& o = sorted_[i];
+            if( ids[ o.current ] != none || taken[ o.previous ] ) { continue; }
+            ids[ o.current ] = previous_.ids[ o.previous ];
+            taken[ o.previous ] = true;
+        }
+        for( std::size_t i = 0; i < ids.size(); ++i ) { if( ids[i] == none ) { ids[i] = vacant_++; } }
+        current_.ids.swap( ids );
+    }
+    current_.offsets.assign( current_.voxels.size() + 1, 0 ); // signature sorted by voxel, i.e. counting sort
+    for( std::size_t i = 0; i < current_.signature.size(); ++i ) { ++current_.offsets[ current_.signature[i].first + 1 ]; }
+    for( std::size_t i = 1; i < current_.offsets.size(); ++i ) { current_.offsets[i] += current_.offsets[ i - 1 ]; }
+    std::vector< std::pair< comma::uint32, comma::uint32 > > signature( current_.signature.size() );
+    std::vector< comma::uint32 > positions( current_.offsets.begin(), current_.offsets.end() - 1 );
+    for( std::size_t i = 0; i < current_.signature.size(); ++i ) { signature[ positions[ current_.signature[i].first ]++ ] = current_.signature[i]; }
+    current_.signature.swap( signature );
+}
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_VOXEL_OVERLAP_TRACKER_H
@@ -0,0 +1,113 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <comma/application/command_line_options.h>
+#include <comma/base/exception.h>
+#include <comma/csv/format.h>
+#include <comma/csv/names.h>
+#include <comma/csv/stream.h>
+#include <comma/string/string.h>
+#include <snark/sensors/velodyne/scan_index.h>
+#include <snark/sensors/velodyne/impl/proprietary_reader.h>
+#include <snark/sensors/velodyne/impl/stream_reader.h>
+#include <snark/sensors/velodyne/impl/thin_reader.h>
+#ifndef WIN32
+#include <snark/sensors/velodyne/impl/mmap_pcap_reader.h>
+#endif
+
+using namespace snark;
+
+static void usage()
+{
+    std::cerr << std::endl;
+    std::cerr << "index scan start offsets and timestamps in a velodyne log file" << std::endl;
+    std::cerr << "the index can be used by velodyne-to-csv --index to seek a scan or time range" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "usage: velodyne-index <log file> [<options>] > index.csv" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "options" << std::endl;
+    std::cerr << "    --pcap : log file is pcap" << std::endl;
+    std::cerr << "    --proprietary,-q : log file is in proprietary format" << std::endl;
+    std::cerr << "        <header, 16 bytes><timestamp, 12 bytes><packet, 1206 bytes><footer, 4 bytes>" << std::endl;
+    std::cerr << "    --thin : log file is output of velodyne-thin (velodyne-thin --index can write index on the fly)" << std::endl;
+    std::cerr << "    default format: <timestamp, 8 bytes><packet, 1206 bytes>" << std::endl;
+    std::cerr << "    --binary,-b: output index in binary" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "output fields: " << comma::join( comma::csv::names< velodyne::scan_index::entry >(), ',' ) << std::endl;
+    std::cerr << "    scan: scan number, as output by velodyne-to-csv" << std::endl;
+    std::cerr << "    offset: offset in bytes of the first packet of the scan in the log file" << std::endl;
+    std::cerr << "    t: timestamp of the first packet of the scan" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "examples" << std::endl;
+    std::cerr << "    velodyne-index velodyne.pcap --pcap > velodyne.pcap.index" << std::endl;
+    std::cerr << "    velodyne-to-csv --pcap-file velodyne.pcap --index velodyne.pcap.index --scans 1000:1010" << std::endl;
+    std::cerr << std::endl;
+    exit( -1 );
+}
+
+template < typename S >
+static void run( const std::string& filename, const comma::csv::options& csv )
+{
+    S reader( filename );
+    velodyne::scan_index index = velodyne::scan_index::make( reader );
+    comma::csv::output_stream< velodyne::scan_index::entry > ostream( std::cout, csv );
+    for( std::size_t i = 0; i < index.entries().size(); ++i ) { ostream.write( index.entries()[i] ); }
+    std::cerr << "velodyne-index: indexed " << index.entries().size() << " scan(s)" << std::endl;
+}
+
+int main( int ac, char** av )
+{
+    try
+    {
+        comma::command_line_options options( ac, av );
+        if( options.exists( "--help,-h" ) ) { usage(); }
+        std::vector< std::string > unnamed = options.unnamed( "--pcap,--proprietary,-q,--thin,--binary,-b", "" );
+        if( unnamed.size() != 1 ) { std::cerr << "velodyne-index: expected one log file name, got " << unnamed.size() << std::endl; return 1; }
+        options.assert_mutually_exclusive( "--pcap,--proprietary,-q,--thin" );
+        comma::csv::options csv;
+        csv.fields = "scan,offset,t";
+        if( options.exists( "--binary,-b" ) ) { csv.format( comma::csv::format::value< velodyne::scan_index::entry >() ); }
+        if( options.exists( "--pcap" ) )
+        {
+            #ifdef WIN32
+            std::cerr << "velodyne-index: pcap indexing not supported on windows" << std::endl; return 1;
+            #else
+            run< snark::mmap_pcap_reader >( unnamed[0], csv );
+            #endif
+        }
+        else if( options.exists( "--proprietary,-q" ) ) { run< snark::proprietary_reader >( unnamed[0], csv ); }
+        else if( options.exists( "--thin" ) ) { run< snark::thin_reader >( unnamed[0], csv ); }
+        else { run< snark::stream_reader >( unnamed[0], csv ); }
+        return 0;
+    }
+    catch( std::exception& ex ) { std::cerr << "velodyne-index: " << ex.what() << std::endl; }
+    catch( ... ) { std::cerr << "velodyne-index: unknown exception" << std::endl; }
+    return 1;
+}
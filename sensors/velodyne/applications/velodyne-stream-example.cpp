@@ -115,7 +115,7 @@ int main( int ac, char** av )
             const velodyne::laser_return* r = stream.read();
             if( r == NULL ) { break; }
             point p;
-            p.timestamp = r->timestamp;
+            p.timestamp = velodyne::to_ptime( r->timestamp );
             p.id = r->id;
             p.intensity = r->intensity;
             p.valid = true;
@@ -29,30 +29,34 @@
 
 
 #include <pcap.h>
+#include <fstream>
 #include <boost/array.hpp>
 #include <boost/asio/ip/udp.hpp>
 #include <boost/optional.hpp>
-#include <boost/random/mersenne_twister.hpp>
-#include <boost/random/uniform_real.hpp>
-#include <boost/random/variate_generator.hpp>
 #include <boost/shared_ptr.hpp>
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
 #include <comma/base/exception.h>
 #include <comma/base/types.h>
 #include <comma/csv/ascii.h>
+#include <comma/csv/stream.h>
 #include <comma/io/publisher.h>
 #include <comma/math/compare.h>
 #include <comma/name_value/parser.h>
 #include <comma/string/string.h>
 #include <snark/timing/time.h>
 #include <snark/sensors/velodyne/stream.h>
+#include <snark/sensors/velodyne/scan_index.h>
+#include <snark/sensors/velodyne/thin/bandwidth.h>
+#include <snark/sensors/velodyne/thin/focus_table.h>
 #include <snark/sensors/velodyne/thin/thin.h>
+#include <snark/sensors/velodyne/thin/v2.h>
 #include <snark/sensors/velodyne/impl/pcap_reader.h>
 #include <snark/sensors/velodyne/impl/proprietary_reader.h>
 #include <snark/sensors/velodyne/impl/stream_reader.h>
 #include <snark/sensors/velodyne/impl/stream_traits.h>
 #include <snark/sensors/velodyne/impl/udp_reader.h>
+#include <snark/sensors/velodyne/impl/batched_udp_reader.h>
 #include <snark/sensors/velodyne/thin/scan.h>
 #include <snark/visiting/traits.h>
 
@@ -77,18 +81,31 @@ static void usage()
     std::cerr << "        <header, 16 bytes><timestamp, 12 bytes><packet, 1206 bytes><footer, 4 bytes>" << std::endl;
     std::cerr << "    default input format: <timestamp, 8 bytes><packet, 1206 bytes>" << std::endl;
     std::cerr << "    --publish=<address>: if present, publish on given address (see io-publish -h for address syntax)" << std::endl;
+    std::cerr << "    --v2: output thin format v2: delta- and entropy-coded ranges, optionally with intensity" << std::endl;
+    std::cerr << "        --intensity-bits=<n>: keep <n> most significant bits of intensity, 0 to 8; default 0: drop intensity" << std::endl;
+    std::cerr << "    --index=<filename>: write scan index of thin output to file, same as output by velodyne-index" << std::endl;
+    std::cerr << "                        e.g. velodyne-to-csv --thin --file=thin.bin --index=thin.bin.index --scans=100:110" << std::endl;
     std::cerr << "    --verbose,-v" << std::endl;
     std::cerr << std::endl;
     std::cerr << "filtering options" << std::endl;
     std::cerr << "    --udp-port <port>: if present, read raw velodyne packets from udp and timestamp them" << std::endl;
+    std::cerr << "        on linux, packets are received in batches and stamped with kernel receive time" << std::endl;
+    std::cerr << "        --udp-batch=<n>: max number of packets received at once; default 64" << std::endl;
+    std::cerr << "        --udp-receive-buffer=<bytes>: socket receive buffer size; default: system default" << std::endl;
     std::cerr << "    --rate <rate>: thinning rate between 0 and 1" << std::endl;
     std::cerr << "                    default 1: send all valid datapoints" << std::endl;
     std::cerr << "    --scan-rate <rate>: scan thin rate between 0 and 1" << std::endl;
+    std::cerr << "    --target-bandwidth=<bytes/second>: adjust thinning rate on each scan to keep output under given bandwidth" << std::endl;
+    std::cerr << "                                       measured as bytes actually written to stdout, publisher or udp" << std::endl;
+    std::cerr << "                                       applied on top of --rate and --focus; not supported with --output-raw" << std::endl;
+    std::cerr << "        --bandwidth-gain=<gain>: controller gain in (0,1]; lower: slower, smoother; default: 0.5" << std::endl;
+    std::cerr << "        --bandwidth-headroom=<fraction>: fraction of target bandwidth kept in reserve; default: 0.05" << std::endl;
     std::cerr << "    --focus --region <options>: focus on particular region" << std::endl;
     std::cerr << "        <options>" << std::endl;
     std::cerr << "            sector: e.g: sector;range=10;bearing=0;ken=30" << std::endl;
     std::cerr << "                    default: bearing: 0, ken: 360" << std::endl;
     std::cerr << "            extents;<min>,<max>: e.g: extents;0,0,0,10,10,5" << std::endl;
+    std::cerr << "        --focus-bins=<n>: number of azimuth bins in focus lookup table; default: 720, i.e. 0.5 degree" << std::endl;
     std::cerr << "        examples" << std::endl;
     std::cerr << "            e.g. at choosen --rate in the direction of" << std::endl;
     std::cerr << "            0 degrees 30 degrees wide not farther than 10 metres" << std::endl;
@@ -105,8 +122,14 @@ static boost::optional< double > scan_rate;
 static boost::optional< double > angularSpeed_;
 static boost::optional< velodyne::db > db;
 static boost::scoped_ptr< velodyne::thin::focus > focus;
+static boost::scoped_ptr< velodyne::thin::focus_table > focus_table;
+static boost::scoped_ptr< velodyne::thin::bandwidth > bandwidth;
 static velodyne::thin::scan scan;
 static boost::scoped_ptr< comma::io::publisher > publisher;
+static bool v2 = false;
+static unsigned int intensity_bits = 0;
+static boost::scoped_ptr< std::ofstream > index_file;
+static boost::scoped_ptr< comma::csv::output_stream< velodyne::scan_index::entry > > index_stream;
 
 // todo: quick and dirty
 static boost::scoped_ptr< boost::asio::io_service > publisher_udp_service;
@@ -122,6 +145,19 @@ static double angularSpeed( const snark::velodyne::packet& packet )
     return da / dt;
 }
 
+static void output( const char* buf, std::size_t size )
+{
+    if( publisher ) { publisher->write( buf, size ); }
+    else if( publisher_udp_socket ) { publisher_udp_socket->send_to( boost::asio::buffer( buf, size ), udp_destination ); }
+    else { std::cout.write( buf, size ); }
+    if( bandwidth ) { bandwidth->add( size ); }
+}
+
+static void report_bandwidth()
+{
+    std::cerr << "velodyne-thin: scans: " << bandwidth->scans() << "; target bandwidth: " << bandwidth->target() << " bytes/s; achieved: " << bandwidth->achieved() << " bytes/s; last scan: " << bandwidth->last() << " bytes/s; rate: " << bandwidth->rate() << std::endl;
+}
+
 static velodyne::thin::focus* make_focus( const std::string& options, double rate ) // quick and dirty
 {
     std::string type = comma::name_value::map( options, "type" ).value< std::string >( "type" );
@@ -139,9 +175,7 @@ template < typename S >
 void run( S* stream )
 {
     static const unsigned int timeSize = 12;
-    boost::mt19937 generator;
-    boost::uniform_real< float > distribution( 0, 1 );
-    boost::variate_generator< boost::mt19937&, boost::uniform_real< float > > random( generator, distribution );
+    velodyne::thin::counter_random random;
     comma::uint64 count = 0;
     comma::uint64 dropped_count = 0;
     double compression = 0;
@@ -149,18 +183,30 @@ void run( S* stream )
     comma::signal_flag isShutdown;
     velodyne::scan_tick tick;
     comma::uint32 scan_id = 0;
+    comma::uint64 output_offset = 0;
+    comma::uint32 index_scan = 0;
+    boost::optional< comma::uint32 > last_written_scan;
     while( !isShutdown && std::cin.good() && !std::cin.eof() && std::cout.good() && !std::cout.eof() )
     {
         const char* p = velodyne::impl::stream_traits< S >::read( *stream, sizeof( velodyne::packet ) );
         if( p == NULL ) { break; }
         ::memcpy( &packet, p, velodyne::packet::size );
-        if( tick.is_new_scan( packet ) ) { ++scan_id; } // quick and dirty
         boost::posix_time::ptime timestamp = stream->timestamp();
+        if( tick.is_new_scan( packet ) ) // quick and dirty
+        {
+            ++scan_id;
+            if( bandwidth )
+            {
+                bandwidth->update( timestamp );
+                if( verbose && bandwidth->scans() > 0 && bandwidth->scans() % 100 == 0 ) { report_bandwidth(); }
+            }
+        }
         if( scan_rate ) { scan.thin( packet, *scan_rate, angularSpeed( packet ) ); }
         if( !scan_rate || !scan.empty() )
         {
-            if( focus ) { velodyne::thin::thin( packet, *focus, *db, angularSpeed( packet ), random ); }
+            if( focus_table ) { focus_table->thin( packet, random ); }
             if( rate ) { velodyne::thin::thin( packet, *rate, random ); }
+            if( bandwidth && bandwidth->rate() < 1 ) { velodyne::thin::thin( packet, bandwidth->rate(), random ); }
         }
         const boost::posix_time::ptime base( snark::timing::epoch );
         const boost::posix_time::time_duration d = timestamp - base;
@@ -176,26 +222,30 @@ void run( S* stream )
             ::memcpy( &buf[0] + 16, &seconds, 8 );
             ::memcpy( &buf[0] + 16 + 8, &nanoseconds, 4 );
             ::memcpy( &buf[0] + 16 + 8 + 4, &packet, velodyne::packet::size );
-            if( publisher ) { publisher->write( &buf[0], buf.size() ); }
-            else if( publisher_udp_socket ) { publisher_udp_socket->send_to( boost::asio::buffer( &buf[0], buf.size() ), udp_destination ); }
-            else { std::cout.write( &buf[0], buf.size() ); }
+            output( &buf[0], buf.size() );
         }
         else
         {
             // todo: certainly rewrite with the proper header using comma::packed
-            static char buf[ timeSize + sizeof( comma::uint16 ) + velodyne::thin::maxBufferSize ];
-            comma::uint16 size = velodyne::thin::serialize( packet, buf + timeSize + sizeof( comma::uint16 ), scan_id );
-            bool empty = size == ( sizeof( comma::uint32 ) + 1 ); // todo: atrocious... i.e. packet is not empty; refactor!!!
+            static char buf[ timeSize + sizeof( comma::uint16 ) + ( int( velodyne::thin::maxBufferSize ) > int( velodyne::thin::v2::maxBufferSize ) ? int( velodyne::thin::maxBufferSize ) : int( velodyne::thin::v2::maxBufferSize ) ) ];
+            comma::uint16 size = v2 ? velodyne::thin::v2::serialize( packet, buf + timeSize + sizeof( comma::uint16 ), scan_id, intensity_bits )
+                                    : velodyne::thin::serialize( packet, buf + timeSize + sizeof( comma::uint16 ), scan_id );
+            bool empty = size == ( v2 ? velodyne::thin::v2::empty_size : sizeof( comma::uint32 ) + 1 ); // todo: atrocious... i.e. packet is not empty; refactor!!!
             if( !empty )
             {
                 size += timeSize;
-                ::memcpy( buf, &size, sizeof( comma::uint16 ) );
+                comma::uint16 header = v2 ? size | velodyne::thin::v2::record_flag : size;
+                ::memcpy( buf, &header, sizeof( comma::uint16 ) );
                 size += sizeof( comma::uint16 );
                 ::memcpy( buf + sizeof( comma::uint16 ), &seconds, sizeof( comma::int64 ) );
                 ::memcpy( buf + sizeof( comma::uint16 ) + sizeof( comma::int64 ), &nanoseconds, sizeof( comma::int32 ) );
-                if( publisher ) { publisher->write( buf, size ); }
-                else if( publisher_udp_socket ) { publisher_udp_socket->send_to( boost::asio::buffer( buf, size ), udp_destination ); }
-                else { std::cout.write( buf, size ); }
+                if( index_stream && ( !last_written_scan || *last_written_scan != scan_id ) )
+                {
+                    index_stream->write( velodyne::scan_index::entry( ++index_scan, output_offset, timestamp ) );
+                    last_written_scan = scan_id;
+                }
+                output_offset += size;
+                output( buf, size );
             }
             else
             {
@@ -210,6 +260,7 @@ void run( S* stream )
         }
     }
     if( publisher ) { publisher->close(); }
+    if( bandwidth ) { report_bandwidth(); }
     std::cerr << "velodyne-thin: " << ( isShutdown ? "signal received" : "no more data" ) << "; shutdown" << std::endl;
 }
 
@@ -253,15 +304,46 @@ int main( int ac, char** av )
         {
             focus.reset( make_focus( options.value< std::string >( "--focus,--region" ), rate ? *rate : 1.0 ) );
             std::cerr << "velodyne-thin: rate in focus: " << focus->rate_in_focus() << "; rate out of focus: " << focus->rate_out_of_focus() << "; coverage: " << focus->coverage() << std::endl;
+            focus_table.reset( new velodyne::thin::focus_table( *db, options.value( "--focus-bins", 720u ) ) );
+            focus_table->update( *focus );
+        }
+        if( options.exists( "--target-bandwidth" ) )
+        {
+            if( outputRaw ) { std::cerr << "velodyne-thin: --target-bandwidth not supported with --output-raw" << std::endl; return 1; }
+            velodyne::thin::bandwidth::config config( options.value< double >( "--target-bandwidth" ) );
+            config.gain = options.value( "--bandwidth-gain", config.gain );
+            config.headroom = options.value( "--bandwidth-headroom", config.headroom );
+            bandwidth.reset( new velodyne::thin::bandwidth( config ) );
         }
         verbose = options.exists( "--verbose,-v" );
+        v2 = options.exists( "--v2" );
+        intensity_bits = options.value( "--intensity-bits", 0u );
+        if( intensity_bits > velodyne::thin::v2::max_intensity_bits ) { std::cerr << "velodyne-thin: expected --intensity-bits not greater than " << velodyne::thin::v2::max_intensity_bits << ", got " << intensity_bits << std::endl; return 1; }
+        if( options.exists( "--index" ) )
+        {
+            if( outputRaw ) { std::cerr << "velodyne-thin: --index not supported with --output-raw" << std::endl; return 1; }
+            index_file.reset( new std::ofstream( options.value< std::string >( "--index" ).c_str() ) );
+            if( !index_file->is_open() ) { std::cerr << "velodyne-thin: failed to open \"" << options.value< std::string >( "--index" ) << "\"" << std::endl; return 1; }
+            comma::csv::options csv;
+            csv.fields = "scan,offset,t";
+            index_stream.reset( new comma::csv::output_stream< velodyne::scan_index::entry >( *index_file, csv ) );
+        }
         #ifdef WIN32
         _setmode( _fileno( stdin ), _O_BINARY );
         _setmode( _fileno( stdout ), _O_BINARY );
         #endif
         options.assert_mutually_exclusive( "--pcap,--udp-port,--proprietary,-q" );
         boost::optional< unsigned short > port = options.optional< unsigned short >( "--udp-port" );
-        if( port ) { run( new snark::udp_reader( *port ) ); }
+        if( port )
+        {
+            #ifdef __linux__
+            snark::batched_udp_reader* reader = new snark::batched_udp_reader( snark::batched_udp_reader::config( *port, options.value( "--udp-batch", 64u ), options.value( "--udp-receive-buffer", 0u ) ) );
+            run( reader );
+            std::cerr << "velodyne-thin: received " << reader->received() << " packets; dropped by kernel: " << reader->dropped() << "; missing in sequence: " << reader->gaps() << std::endl;
+            #else
+            run( new snark::udp_reader( *port ) );
+            #endif
+        }
         else if( options.exists( "--pcap" ) ) { run( new snark::pcap_reader ); }
         else if( options.exists( "--proprietary,-q" ) )
         {
@@ -28,30 +28,76 @@
 // IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <vector>
+#include <tbb/concurrent_queue.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_scheduler_init.h>
+#include <boost/array.hpp>
+#include <boost/bind.hpp>
 #include <boost/optional.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/lexical_cast.hpp>
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
 #include <comma/base/exception.h>
 #include <comma/base/types.h>
+#include <comma/csv/ascii.h>
 #include <comma/csv/format.h>
 #include <comma/csv/names.h>
 #include <comma/csv/stream.h>
+#include <comma/io/stream.h>
+#include <comma/name_value/parser.h>
 #include <comma/string/string.h>
 #include <comma/visiting/traits.h>
 #include <snark/sensors/velodyne/impl/pcap_reader.h>
+#ifndef WIN32
+#include <snark/sensors/velodyne/impl/mmap_pcap_reader.h>
+#endif
 #include <snark/sensors/velodyne/impl/proprietary_reader.h>
 #include <snark/sensors/velodyne/impl/thin_reader.h>
 #include <snark/sensors/velodyne/impl/udp_reader.h>
+#include <snark/sensors/velodyne/impl/batched_udp_reader.h>
 #include <snark/sensors/velodyne/impl/stream_reader.h>
 #include <snark/sensors/velodyne/impl/velodyne_stream.h>
+#include <snark/sensors/velodyne/merge.h>
+#include <snark/sensors/velodyne/nav_frame.h>
+#include <snark/sensors/velodyne/scan_index.h>
 
 //#include <google/profiler.h>
 
 using namespace snark;
 
+/// velodyne point tagged with the sensor it came from, output when merging several sources
+struct sourced_point : public velodyne_point
+{
+    comma::uint32 sensor;
+    sourced_point() : sensor( 0 ) {}
+};
+
+namespace comma { namespace visiting {
+
+template <> struct traits< sourced_point >
+{
+    template < typename K, typename V > static void visit( const K& k, sourced_point& p, V& v )
+    {
+        traits< velodyne_point >::visit( k, static_cast< velodyne_point& >( p ), v );
+        v.apply( "sensor", p.sensor );
+    }
+
+    template < typename K, typename V > static void visit( const K& k, const sourced_point& p, V& v )
+    {
+        traits< velodyne_point >::visit( k, static_cast< const velodyne_point& >( p ), v );
+        v.apply( "sensor", p.sensor );
+    }
+};
+
+} } // namespace comma { namespace visiting {
+
 static void usage()
 {
     std::cerr << std::endl;
@@ -64,11 +110,30 @@ static void usage()
     std::cerr << "              <packet>: regular velodyne 1206-byte packet" << std::endl;
     std::cerr << "    --db <db.xml file> ; default /usr/local/etc/db.xml" << std::endl;
     std::cerr << "    --pcap : if present, velodyne data is read from pcap packets" << std::endl;
+    std::cerr << "    --pcap-file=<filename> : read pcap packets from memory-mapped file, faster than --pcap on stdin" << std::endl;
     std::cerr << "    --thin : if present, velodyne data is thinned (e.g. by velodyne-thin)" << std::endl;
     std::cerr << "    --udp-port <port> : read velodyne data directly from udp port" << std::endl;
+    std::cerr << "        on linux, packets are received in batches and stamped with kernel receive time" << std::endl;
+    std::cerr << "        --udp-batch=<n>: max number of packets received at once; default 64" << std::endl;
+    std::cerr << "        --udp-receive-buffer=<bytes>: socket receive buffer size; default: system default" << std::endl;
     std::cerr << "    --proprietary,-q : read velodyne data directly from stdin using the proprietary protocol" << std::endl;
     std::cerr << "        <header, 16 bytes><timestamp, 12 bytes><packet, 1206 bytes><footer, 4 bytes>" << std::endl;
     std::cerr << "    default input format: <timestamp, 8 bytes><packet, 1206 bytes>" << std::endl;
+    std::cerr << "    --file=<filename> : read default, --proprietary or --thin input from file rather than stdin" << std::endl;
+    std::cerr << "    --source=<address>[;type=<type>][;db=<db.xml>][;id=<id>]: velodyne source; if given several times," << std::endl;
+    std::cerr << "                       sources are decoded concurrently and their points merged in the order of timestamps" << std::endl;
+    std::cerr << "                       and tagged with field sensor" << std::endl;
+    std::cerr << "        <address>: filename or, for udp, port" << std::endl;
+    std::cerr << "        <type>: raw (default input format), proprietary, thin, pcap, udp; default: raw" << std::endl;
+    std::cerr << "        <db.xml>: calibration of this velodyne; default: --db" << std::endl;
+    std::cerr << "        <id>: sensor id to output; default: number of --source option, starting from 0" << std::endl;
+    std::cerr << "        e.g: --source=\"2368;type=udp;db=front.xml\" --source=\"2369;type=udp;db=rear.xml\"" << std::endl;
+    std::cerr << "        --merge-lookahead=<packets>: max number of decoded packets per source waiting to be merged; default 16" << std::endl;
+    std::cerr << "        --merge-timeout=<seconds>: how long to wait for a udp source without data before merging without it; default 0.1" << std::endl;
+    std::cerr << "                                   its late points are still output, i.e. output may go out of order" << std::endl;
+    std::cerr << "        not supported: --nav, --index, --threads (each source is decoded on its own thread)" << std::endl;
+    std::cerr << "    --index=<filename> : scan index of --file or --pcap-file input, as output by velodyne-index or velodyne-thin --index" << std::endl;
+    std::cerr << "                         if present, --scans and --time seek straight to the first scan requested" << std::endl;
     std::cerr << std::endl;
     std::cerr << "output options:" << std::endl;
     std::cerr << "    --binary,-b[=<format>]: if present, output in binary equivalent of csv" << std::endl;
@@ -76,12 +141,32 @@ static void usage()
     std::cerr << "    --format: output full binary format and exit (see examples)" << std::endl;
     std::cerr << "    --min-range=<value>: do not output points closer than <value>; default 0" << std::endl;
     std::cerr << "    --output-invalid-points: output also invalid laser returns" << std::endl;
+    std::cerr << "    --lasers=<ids>: output only returns of given lasers, e.g. 0,1,5-10" << std::endl;
+    std::cerr << "    --azimuth=<from>,<to>: output only returns with azimuth in [from,to) degrees, e.g. 350,10" << std::endl;
+    std::cerr << "                           approximate: compared before per-laser rotational correction" << std::endl;
+    std::cerr << "    --range=[<min>],[<max>]: output only returns with range in [min,max] metres" << std::endl;
+    std::cerr << "                             approximate: compared before per-laser distance correction" << std::endl;
+    std::cerr << "        --lasers, --azimuth and --range are applied to raw packet data, before any point conversion" << std::endl;
     std::cerr << "    --scans [<from>]:[<to>] : output only scans in given range" << std::endl;
     std::cerr << "                               e.g. 1:3 for scans 1, 2, 3" << std::endl;
     std::cerr << "                                    5: for scans 5, 6, ..." << std::endl;
     std::cerr << "                                    :3 for scans 0, 1, 2, 3" << std::endl;
+    std::cerr << "    --time=[<from>],[<to>] : output only scans started in given time range, e.g. 20140101T120000,20140101T120100" << std::endl;
+    std::cerr << "                             requires --index" << std::endl;
+    std::cerr << "    --threads=<n>: decode packets on <n> threads, output is the same as single-threaded; default 1" << std::endl;
+    std::cerr << "                   with --index, the log is split into scan-aligned shards decoded on separate threads" << std::endl;
+    std::cerr << "    --shard-size=<n>: number of scans per shard with --index and --threads; default 10" << std::endl;
+    std::cerr << "    --nav=<filename>[;<csv options>]: output points in world frame, using sensor poses from timestamped nav" << std::endl;
+    std::cerr << "                                      same as piping to points-frame --from, but pose is interpolated" << std::endl;
+    std::cerr << "                                      once per firing block and points are not parsed twice" << std::endl;
+    std::cerr << "                                      nav fields default: t,x,y,z,roll,pitch,yaw; points without nav are dropped" << std::endl;
+    std::cerr << "                                      e.g. --nav=\"nav.bin;fields=t,x,y,z,roll,pitch,yaw;binary=t,6d\"" << std::endl;
+    std::cerr << "        --nav-max-gap=<seconds>: drop points between nav records further apart than given" << std::endl;
+    std::cerr << "        --nav-nearest: take nearest nav record rather than interpolate" << std::endl;
+    std::cerr << "        --sensor=<x>,<y>,<z>,<roll>,<pitch>,<yaw>: velodyne pose in the nav body frame; default: 0,0,0,0,0,0" << std::endl;
     std::cerr << "    default output columns: " << comma::join( comma::csv::names< velodyne_point >(), ',' ) << std::endl;
     std::cerr << "    default binary format: " << comma::csv::format::value< velodyne_point >() << std::endl;
+    std::cerr << "    default output columns with --source: " << comma::join( comma::csv::names< sourced_point >(), ',' ) << std::endl;
     std::cerr << std::endl;
     std::cerr << "examples:" << std::endl;
     std::cerr << "    output csv points to file:" << std::endl;
@@ -105,18 +190,500 @@ static void usage()
     exit( -1 );
 }
 
+template < typename S >
+static void write_points_( velodyne_stream< S >& v, comma::csv::output_stream< velodyne_point >& ostream, double min_range, comma::signal_flag& is_shutdown )
+{
+    velodyne_point point;
+    while( !is_shutdown )
+    {
+        const velodyne::decoded_packet* p = v.read_packet();
+        if( p == NULL ) { break; }
+        for( std::size_t i = 0; i < p->size; ++i )
+        {
+            if( p->range[i] <= min_range ) { continue; }
+            to_velodyne_point( *p, i, point );
+            ostream.write( point );
+        }
+    }
+}
+
 template < typename S >
 inline static void run( velodyne_stream< S >& v, const comma::csv::options& csv, double min_range )
 {
     comma::signal_flag isShutdown;
     comma::csv::output_stream< velodyne_point > ostream( std::cout, csv );
     //Profilerstart( "velodyne-to-csv.prof" );{
-    while( !isShutdown && v.read() ) { if( v.point().range > min_range ) { ostream.write( v.point() ); } }
+    write_points_( v, ostream, min_range, isShutdown );
     //Profilerstop(); }
     if( isShutdown ) { std::cerr << "velodyne-to-csv: interrupted by signal" << std::endl; }
     else { std::cerr << "velodyne-to-csv: done, no more data" << std::endl; }
 }
 
+struct packet_t // quick and dirty
+{
+    velodyne::packet packet;
+    comma::int64 timestamp; // nanoseconds from epoch
+    double angular_speed;
+    comma::uint32 scan;
+    boost::array< velodyne::nav_frame::transform, 6 > poses; // pose per pair of upper and lower blocks fired at the same time
+    comma::uint32 posed; // bit mask of pairs with pose
+};
+
+static boost::scoped_ptr< comma::io::istream > nav_istream;
+static boost::scoped_ptr< velodyne::nav_frame > nav;
+static comma::uint64 blocks_without_pose = 0;
+
+static void set_poses_( packet_t& p ) // serial, since nav is read forward
+{
+    p.posed = 0;
+    for( unsigned int k = 0; k < p.poses.size(); ++k )
+    {
+        if( nav->at( velodyne::to_ptime( p.timestamp + velodyne::impl::time_offset_nanoseconds( k * 2, 16 ) ), p.poses[k] ) ) { p.posed |= 1 << k; }
+        else { ++blocks_without_pose; }
+    }
+}
+
+struct batch_t
+{
+    enum { capacity = 256 };
+    std::vector< packet_t > packets;
+    std::vector< velodyne_point > points;
+};
+
+static void write_( comma::csv::output_stream< velodyne_point >& ostream, batch_t* batch )
+{
+    for( std::size_t i = 0; i < batch->points.size(); ++i ) { ostream.write( batch->points[i] ); }
+    delete batch;
+}
+
+static velodyne::return_filter raw_filter;
+
+template < typename S >
+class decode_pipeline // quick and dirty
+{
+    public:
+        decode_pipeline( velodyne_stream< S >& v, bool output_invalid, double min_range, comma::signal_flag& is_shutdown )
+            : stream_( v ), output_invalid_( output_invalid ), min_range_( min_range ), is_shutdown_( is_shutdown ), is_shutdown_nav_( false ) {}
+
+        batch_t* read( ::tbb::flow_control& flow )
+        {
+            if( is_shutdown_ || is_shutdown_nav_ ) { flow.stop(); return NULL; }
+            batch_t* batch = new batch_t;
+            batch->packets.reserve( batch_t::capacity );
+            while( batch->packets.size() < batch_t::capacity && !is_shutdown_ )
+            {
+                const velodyne::packet* p = stream_.read_raw_packet();
+                if( p == NULL ) { break; }
+                batch->packets.push_back( packet_t() );
+                packet_t& t = batch->packets.back();
+                ::memcpy( &t.packet, p, velodyne::packet::size );
+                t.timestamp = stream_.nanoseconds();
+                t.angular_speed = stream_.angular_speed();
+                t.scan = stream_.scan();
+                if( nav )
+                {
+                    set_poses_( t );
+                    if( t.posed == 0 && nav->eof() ) { batch->packets.pop_back(); is_shutdown_nav_ = true; break; }
+                }
+            }
+            if( batch->packets.empty() ) { delete batch; flow.stop(); return NULL; }
+            return batch;
+        }
+
+        batch_t* decode( batch_t* batch ) const // same order of laser returns as in velodyne::stream::read()
+        {
+            velodyne::packet_decoder decoder( stream_.db() ); // decoder per batch, since batches are decoded in parallel
+            velodyne::decoded_packet decoded;
+            batch->points.reserve( batch->packets.size() * 12 * 32 );
+            velodyne_point point;
+            for( std::size_t i = 0; i < batch->packets.size(); ++i )
+            {
+                const packet_t& p = batch->packets[i];
+                decoder.decode( p.packet, p.timestamp, p.angular_speed, output_invalid_, decoded, &stream_.filter() );
+                decoded.scan = p.scan;
+                for( std::size_t j = 0; j < decoded.size; ++j )
+                {
+                    unsigned int k = decoded.block[j] >> 1; // upper and lower blocks fired at the same time share the pose
+                    if( nav && !( p.posed & ( 1 << k ) ) ) { continue; }
+                    if( decoded.range[j] <= min_range_ ) { continue; }
+                    to_velodyne_point( decoded, j, point );
+                    if( nav )
+                    {
+                        point.ray.first = p.poses[k] * point.ray.first;
+                        point.ray.second = p.poses[k] * point.ray.second;
+                    }
+                    batch->points.push_back( point );
+                }
+            }
+            batch->packets.clear();
+            return batch;
+        }
+
+    private:
+        velodyne_stream< S >& stream_;
+        bool output_invalid_;
+        double min_range_;
+        comma::signal_flag& is_shutdown_;
+        bool is_shutdown_nav_; // nav ended
+};
+
+template < typename S >
+inline static void run( velodyne_stream< S >& v, const comma::csv::options& csv, double min_range, bool output_invalid, unsigned int threads )
+{
+    v.filter( raw_filter );
+    if( threads < 2 && !nav ) { run( v, csv, min_range ); return; }
+    if( threads < 1 ) { threads = 1; }
+    comma::signal_flag isShutdown;
+    comma::csv::output_stream< velodyne_point > ostream( std::cout, csv );
+    decode_pipeline< S > p( v, output_invalid, min_range, isShutdown );
+    ::tbb::task_scheduler_init init( threads );
+    ::tbb::filter_t< void, batch_t* > read_filter( ::tbb::filter::serial_in_order, boost::bind( &decode_pipeline< S >::read, &p, _1 ) );
+    ::tbb::filter_t< batch_t*, batch_t* > decode_filter( ::tbb::filter::parallel, boost::bind( &decode_pipeline< S >::decode, &p, _1 ) );
+    ::tbb::filter_t< batch_t*, void > write_filter( ::tbb::filter::serial_in_order, boost::bind( &write_, boost::ref( ostream ), _1 ) );
+    ::tbb::parallel_pipeline( threads * 2, read_filter & decode_filter & write_filter );
+    if( nav ) { std::cerr << "velodyne-to-csv: dropped " << blocks_without_pose << " firing block(s) without nav" << ( nav->eof() ? "; nav ended" : "" ) << std::endl; }
+    if( isShutdown ) { std::cerr << "velodyne-to-csv: interrupted by signal" << std::endl; }
+    else { std::cerr << "velodyne-to-csv: done, no more data" << std::endl; }
+}
+
+static boost::optional< velodyne::scan_index > log_index;
+static unsigned int shard_size;
+
+struct shard_t
+{
+    comma::uint32 from;
+    comma::uint32 to;
+    std::string output;
+};
+
+template < typename S >
+class shard_pipeline // quick and dirty
+{
+    public:
+        shard_pipeline( const std::string& filename
+                      , const velodyne::db& db
+                      , const comma::csv::options& csv
+                      , bool output_invalid
+                      , double min_range
+                      , comma::uint32 from
+                      , comma::uint32 to
+                      , comma::signal_flag& is_shutdown )
+            : filename_( filename ), db_( db ), csv_( csv ), output_invalid_( output_invalid ), min_range_( min_range ), next_( from ), to_( to ), is_shutdown_( is_shutdown ) {}
+
+        shard_t* read( ::tbb::flow_control& flow )
+        {
+            if( is_shutdown_ || next_ > to_ ) { flow.stop(); return NULL; }
+            shard_t* shard = new shard_t;
+            shard->from = next_;
+            shard->to = to_ - next_ < shard_size ? to_ : next_ + shard_size - 1;
+            next_ = shard->to + 1;
+            return shard;
+        }
+
+        shard_t* decode( shard_t* shard ) const
+        {
+            const velodyne::scan_index::entry* e = log_index->lower_bound( shard->from );
+            if( e == NULL || e->scan > shard->to ) { return shard; }
+            velodyne_stream< S > v( filename_, db_, output_invalid_, boost::optional< std::size_t >(), boost::optional< std::size_t >( shard->to ) );
+            v.seek( *e );
+            v.filter( raw_filter );
+            std::ostringstream oss;
+            {
+                comma::csv::output_stream< velodyne_point > ostream( oss, csv_ );
+                write_points_( v, ostream, min_range_, is_shutdown_ );
+            }
+            shard->output = oss.str();
+            return shard;
+        }
+
+        static void write( shard_t* shard )
+        {
+            std::cout.write( &shard->output[0], shard->output.size() );
+            delete shard;
+        }
+
+    private:
+        std::string filename_;
+        const velodyne::db& db_;
+        const comma::csv::options& csv_;
+        bool output_invalid_;
+        double min_range_;
+        comma::uint32 next_;
+        comma::uint32 to_;
+        comma::signal_flag& is_shutdown_;
+};
+
+template < typename S >
+static void run( const std::string& filename, const velodyne::db& db, const comma::csv::options& csv, double min_range, bool output_invalid, unsigned int threads, boost::optional< std::size_t > from, boost::optional< std::size_t > to )
+{
+    if( !log_index )
+    {
+        velodyne_stream< S > v( filename, db, output_invalid, from, to );
+        run( v, csv, min_range, output_invalid, threads );
+        return;
+    }
+    if( log_index->entries().empty() ) { std::cerr << "velodyne-to-csv: index is empty" << std::endl; return; }
+    comma::uint32 first = from ? *from : 0;
+    comma::uint32 last = to && *to < log_index->entries().back().scan ? *to : log_index->entries().back().scan;
+    if( threads < 2 || nav ) // nav is read forward only, thus no shards
+    {
+        velodyne_stream< S > v( filename, db, output_invalid, boost::optional< std::size_t >(), to );
+        const velodyne::scan_index::entry* e = log_index->lower_bound( first );
+        if( e == NULL ) { std::cerr << "velodyne-to-csv: done, no scans from " << first << " in the index" << std::endl; return; }
+        v.seek( *e );
+        run( v, csv, min_range, output_invalid, threads );
+        return;
+    }
+    comma::signal_flag isShutdown;
+    shard_pipeline< S > p( filename, db, csv, output_invalid, min_range, first, last, isShutdown );
+    ::tbb::task_scheduler_init init( threads );
+    ::tbb::filter_t< void, shard_t* > read_filter( ::tbb::filter::serial_in_order, boost::bind( &shard_pipeline< S >::read, &p, _1 ) );
+    ::tbb::filter_t< shard_t*, shard_t* > decode_filter( ::tbb::filter::parallel, boost::bind( &shard_pipeline< S >::decode, &p, _1 ) );
+    ::tbb::filter_t< shard_t*, void > write_filter( ::tbb::filter::serial_in_order, &shard_pipeline< S >::write );
+    ::tbb::parallel_pipeline( threads * 2, read_filter & decode_filter & write_filter );
+    if( isShutdown ) { std::cerr << "velodyne-to-csv: interrupted by signal" << std::endl; }
+    else { std::cerr << "velodyne-to-csv: done, no more data" << std::endl; }
+}
+
+struct points_packet // quick and dirty: points of one packet of a source, ready to merge
+{
+    std::size_t size;
+    boost::array< comma::int64, velodyne::decoded_packet::capacity > t; // timestamps, contiguous for merge
+    boost::array< sourced_point, velodyne::decoded_packet::capacity > points;
+    points_packet() : size( 0 ) {}
+};
+
+static boost::mutex ready_mutex; // quick and dirty: sources notify the merge on any packet ready, so that it waits rather than polls
+static boost::condition_variable ready_condition;
+
+class source // decodes packets of one velodyne on its own thread into a fixed pool of packets
+{
+    public:
+        source( comma::uint32 id, bool live, unsigned int capacity ) : id_( id ), live_( live ), pool_( capacity ), stop_( false )
+        {
+            ready.set_capacity( capacity + 1 ); // all the packets plus end of stream
+            for( std::size_t i = 0; i < pool_.size(); ++i ) { free.push( &pool_[i] ); }
+        }
+
+        virtual ~source() {}
+
+        void start() { thread_.reset( new boost::thread( boost::bind( &source::run_, this ) ) ); }
+
+        /// stop thread, even if it is blocked waiting for a free packet or on udp receive
+        void stop() { stop_ = true; free.push( NULL ); interrupt_(); }
+
+        void join() { if( thread_ ) { thread_->join(); } }
+
+        bool live() const { return live_; }
+
+        /// decoded packets; NULL marks end of source; ready_condition gets notified on push
+        ::tbb::concurrent_bounded_queue< points_packet* > ready;
+
+        /// packets to decode into; blocks the source, if all of them wait to be merged
+        ::tbb::concurrent_bounded_queue< points_packet* > free;
+
+    protected:
+        comma::uint32 id_;
+
+        /// decode next packet with at least one point into given packet, return false on end of stream
+        virtual bool read_( points_packet& p ) = 0;
+
+        /// unblock read_(), if it waits for data
+        virtual void interrupt_() {}
+
+    private:
+        bool live_;
+        std::vector< points_packet > pool_;
+        volatile bool stop_;
+        boost::scoped_ptr< boost::thread > thread_;
+
+        void push_ready_( points_packet* p )
+        {
+            ready.push( p );
+            { boost::lock_guard< boost::mutex > lock( ready_mutex ); } // merge either has not checked the queue yet or already waits
+            ready_condition.notify_all();
+        }
+
+        void run_()
+        {
+            try
+            {
+                while( !stop_ )
+                {
+                    points_packet* p;
+                    free.pop( p );
+                    if( p == NULL ) { break; }
+                    if( !read_( *p ) ) { free.push( p ); break; }
+                    push_ready_( p );
+                }
+            }
+            catch( std::exception& ex ) { std::cerr << "velodyne-to-csv: sensor " << id_ << ": " << ex.what() << std::endl; }
+            catch( ... ) { std::cerr << "velodyne-to-csv: sensor " << id_ << ": unknown exception" << std::endl; }
+            push_ready_( NULL );
+        }
+};
+
+template < typename S > static void interrupt_reader_( S& ) {} // file readers do not block for long
+
+#ifdef __linux__
+static void interrupt_reader_( snark::batched_udp_reader& reader ) { reader.shutdown(); }
+#else
+static void interrupt_reader_( snark::udp_reader& reader ) { reader.shutdown(); }
+#endif
+
+template < typename S >
+class stream_source : public source
+{
+    public:
+        template < typename P >
+        stream_source( const P& p, const velodyne::db& db, comma::uint32 id, bool live, unsigned int capacity, bool output_invalid, double min_range, boost::optional< std::size_t > from, boost::optional< std::size_t > to )
+            : source( id, live, capacity )
+            , stream_( p, db, output_invalid, from, to ) // stream keeps its own copy of db and decoder, thus sensors do not share calibration tables
+            , min_range_( min_range )
+        {
+            stream_.filter( raw_filter );
+        }
+
+        S& reader() { return stream_.reader(); }
+
+    private:
+        velodyne_stream< S > stream_;
+        double min_range_;
+
+        void interrupt_() { interrupt_reader_( stream_.reader() ); }
+
+        bool read_( points_packet& p ) // same order of laser returns as in velodyne::stream::read()
+        {
+            for( p.size = 0; p.size == 0; )
+            {
+                const velodyne::decoded_packet* decoded = stream_.read_packet();
+                if( decoded == NULL ) { return false; }
+                for( std::size_t i = 0; i < decoded->size; ++i )
+                {
+                    if( decoded->range[i] <= min_range_ ) { continue; }
+                    sourced_point& point = p.points[ p.size ];
+                    to_velodyne_point( *decoded, i, point );
+                    point.sensor = id_;
+                    p.t[ p.size++ ] = point.timestamp;
+                }
+            }
+            return true;
+        }
+};
+
+static source* make_source_( const std::string& spec, unsigned int index, const std::string& default_db, unsigned int capacity, bool output_invalid, double min_range, boost::optional< std::size_t > from, boost::optional< std::size_t > to )
+{
+    std::vector< std::string > v = comma::split( spec, ';' );
+    const std::string& address = v[0];
+    if( address.empty() ) { COMMA_THROW( comma::exception, "expected source address, got: \"" << spec << "\"" ); }
+    std::string type = "raw";
+    std::string db_filename = default_db;
+    comma::uint32 id = index;
+    for( std::size_t i = 1; i < v.size(); ++i )
+    {
+        std::vector< std::string > kv = comma::split( v[i], '=' );
+        if( kv.size() != 2 ) { COMMA_THROW( comma::exception, "expected <name>=<value> in source, got: \"" << v[i] << "\" in \"" << spec << "\"" ); }
+        if( kv[0] == "type" ) { type = kv[1]; }
+        else if( kv[0] == "db" ) { db_filename = kv[1]; }
+        else if( kv[0] == "id" ) { id = boost::lexical_cast< comma::uint32 >( kv[1] ); }
+        else { COMMA_THROW( comma::exception, "expected type, db, or id in source, got: \"" << kv[0] << "\" in \"" << spec << "\"" ); }
+    }
+    velodyne::db db( db_filename );
+    if( type == "raw" ) { return new stream_source< snark::stream_reader >( address, db, id, false, capacity, output_invalid, min_range, from, to ); }
+    if( type == "proprietary" ) { return new stream_source< snark::proprietary_reader >( address, db, id, false, capacity, output_invalid, min_range, from, to ); }
+    if( type == "thin" ) { return new stream_source< snark::thin_reader >( address, db, id, false, capacity, output_invalid, min_range, from, to ); }
+    #ifdef WIN32
+    if( type == "pcap" ) { return new stream_source< snark::pcap_reader >( address, db, id, false, capacity, output_invalid, min_range, from, to ); }
+    #else
+    if( type == "pcap" ) { return new stream_source< snark::mmap_pcap_reader >( address, db, id, false, capacity, output_invalid, min_range, from, to ); }
+    #endif
+    #ifdef __linux__
+    if( type == "udp" ) { return new stream_source< snark::batched_udp_reader >( snark::batched_udp_reader::config( boost::lexical_cast< unsigned short >( address ) ), db, id, true, capacity, output_invalid, min_range, from, to ); }
+    #else
+    if( type == "udp" ) { return new stream_source< snark::udp_reader >( boost::lexical_cast< unsigned short >( address ), db, id, true, capacity, output_invalid, min_range, from, to ); }
+    #endif
+    COMMA_THROW( comma::exception, "expected source type raw, proprietary, thin, pcap, or udp, got: \"" << type << "\" in \"" << spec << "\"" );
+}
+
+/// merge points of all the sources in the order of timestamps; each source holds a fixed number of packets,
+/// and the merge looks only at the current packet of each source, thus memory use does not grow
+static void run_merge( const std::vector< source* >& sources, const comma::csv::options& csv, double timeout )
+{
+    boost::posix_time::time_duration wait = boost::posix_time::microseconds( static_cast< long >( timeout * 1000000 ) );
+    comma::signal_flag isShutdown;
+    comma::csv::output_stream< sourced_point > ostream( std::cout, csv );
+    velodyne::merge merge( sources.size() );
+    std::vector< points_packet* > current( sources.size(), NULL );
+    std::vector< bool > stalled( sources.size(), false ); // live source timed out; merging without it until it comes back
+    unsigned int remaining = sources.size();
+    comma::int64 last = std::numeric_limits< comma::int64 >::min();
+    comma::uint64 late = 0;
+    comma::uint64 stalls = 0;
+    for( std::size_t i = 0; i < sources.size(); ++i ) { sources[i]->start(); }
+    while( !isShutdown )
+    {
+        bool polled = false;
+        while( boost::optional< unsigned int > w = merge.waiting() )
+        {
+            unsigned int i = *w;
+            if( current[i] ) { sources[i]->free.push( current[i] ); current[i] = NULL; }
+            points_packet* p;
+            if( !sources[i]->ready.try_pop( p ) )
+            {
+                if( sources[i]->live() )
+                {
+                    boost::system_time deadline = boost::get_system_time() + wait;
+                    bool got = false;
+                    {
+                        boost::unique_lock< boost::mutex > lock( ready_mutex );
+                        while( !( got = sources[i]->ready.try_pop( p ) ) && ready_condition.timed_wait( lock, deadline ) );
+                    }
+                    if( !got ) { merge.close( i ); stalled[i] = true; ++stalls; continue; }
+                }
+                else
+                {
+                    sources[i]->ready.pop( p ); // file sources always deliver a packet or the end
+                }
+            }
+            polled = true;
+            if( p == NULL ) { merge.close( i ); --remaining; continue; }
+            current[i] = p;
+            merge.push( i, &p->t[0], p->size );
+        }
+        if( polled || merge.empty() ) // check stalled sources once per packet rather than once per point
+        {
+            for( std::size_t i = 0; i < sources.size(); ++i )
+            {
+                points_packet* p;
+                if( !stalled[i] || !sources[i]->ready.try_pop( p ) ) { continue; }
+                stalled[i] = false;
+                if( p == NULL ) { --remaining; continue; }
+                current[i] = p;
+                merge.push( i, &p->t[0], p->size );
+            }
+        }
+        if( merge.empty() )
+        {
+            if( remaining == 0 ) { break; }
+            boost::unique_lock< boost::mutex > lock( ready_mutex ); // all remaining sources are live and stalled: wait for any of them, checking for signals once in a while
+            bool any = false;
+            for( std::size_t i = 0; i < sources.size() && !any; ++i ) { any = stalled[i] && !sources[i]->ready.empty(); }
+            if( !any ) { ready_condition.timed_wait( lock, boost::get_system_time() + boost::posix_time::milliseconds( 100 ) ); }
+            continue;
+        }
+        const velodyne::merge::entry& e = merge.top();
+        const sourced_point& point = current[ e.source ]->points[ e.index ];
+        if( point.timestamp < last ) { ++late; } else { last = point.timestamp; }
+        ostream.write( point );
+        merge.pop();
+    }
+    for( std::size_t i = 0; i < sources.size(); ++i ) { sources[i]->stop(); }
+    for( std::size_t i = 0; i < sources.size(); ++i ) { sources[i]->join(); delete sources[i]; }
+    if( stalls > 0 || late > 0 ) { std::cerr << "velodyne-to-csv: sources stalled " << stalls << " time(s); " << late << " point(s) output out of order" << std::endl; }
+    if( isShutdown ) { std::cerr << "velodyne-to-csv: interrupted by signal" << std::endl; }
+    else { std::cerr << "velodyne-to-csv: done, no more data" << std::endl; }
+}
+
 static std::string fields_( const std::string& s ) // parsing fields, quick and dirty
 {
     if( s == "" ) { return s; }
@@ -133,10 +700,10 @@ static std::string fields_( const std::string& s ) // parsing fields, quick and
     return comma::join( v, ',' );
 }
 
-static comma::csv::format format_( const std::string& s, const std::string& fields )
+static comma::csv::format format_( const std::string& s, const std::string& fields, bool sourced )
 {
     if( !s.empty() ) { try { return comma::csv::format( s ); } catch( ... ) {} }
-    if( fields.empty() ) { return comma::csv::format::value< velodyne_point >(); }
+    if( fields.empty() ) { return sourced ? comma::csv::format::value< sourced_point >() : comma::csv::format::value< velodyne_point >(); }
     std::vector< std::string > v = comma::split( fields, ',' );
     comma::csv::format format;
     for( std::size_t i = 0; i < v.size(); ++i )
@@ -146,6 +713,7 @@ static comma::csv::format format_( const std::string& s, const std::string& fiel
         else if( v[i] == "intensity" ) { format += "ui"; }
         else if( v[i] == "valid" ) { format += "b"; }
         else if( v[i] == "scan" ) { format += "ui"; }
+        else if( v[i] == "sensor" ) { format += "ui"; }
         else if( v[i] == "ray" ) { format += "6d"; }
         else if( v[i] == "ray/first" ) { format += "3d"; }
         else if( v[i] == "ray/second" ) { format += "3d"; }
@@ -161,9 +729,9 @@ int main( int ac, char** av )
         comma::command_line_options options( ac, av );
         if( options.exists( "--help" ) || options.exists( "-h" ) ) { usage(); }
         std::string fields = fields_( options.value< std::string >( "--fields", "" ) );
-        comma::csv::format format = format_( options.value< std::string >( "--binary,-b", "" ), fields );
+        comma::csv::format format = format_( options.value< std::string >( "--binary,-b", "" ), fields, options.exists( "--source" ) );
         if( options.exists( "--format" ) ) { std::cout << format.string(); exit( 0 ); }
-        velodyne::db db( options.value< std::string >( "--db", "/usr/local/etc/db.xml" ) );
+        std::string db_filename = options.value< std::string >( "--db", "/usr/local/etc/db.xml" );
         bool outputInvalidpoints = options.exists( "--output-invalid-points" );
         boost::optional< std::size_t > from;
         boost::optional< std::size_t > to;
@@ -176,36 +744,141 @@ int main( int ac, char** av )
             if( v[1] != "" ) { to = boost::lexical_cast< std::size_t >( v[1] ); }
             if( from && to && *from > *to ) { COMMA_THROW( comma::exception, "expected <from> not greater than <to> in the range, got: \"" << range << "\"" ); }
         }
+        if( options.exists( "--index" ) )
+        {
+            log_index = velodyne::scan_index();
+            std::ifstream ifs( options.value< std::string >( "--index" ).c_str() );
+            if( !ifs.is_open() ) { COMMA_THROW( comma::exception, "failed to open index \"" << options.value< std::string >( "--index" ) << "\"" ); }
+            comma::csv::options index_csv;
+            index_csv.fields = "scan,offset,t";
+            comma::csv::input_stream< velodyne::scan_index::entry > istream( ifs, index_csv );
+            while( ifs.good() && !ifs.eof() )
+            {
+                const velodyne::scan_index::entry* e = istream.read();
+                if( !e ) { break; }
+                log_index->push_back( *e );
+            }
+        }
+        if( options.exists( "--time" ) )
+        {
+            if( !log_index ) { COMMA_THROW( comma::exception, "--time requires --index" ); }
+            std::vector< std::string > v = comma::split( options.value< std::string >( "--time" ), ',' );
+            if( v.size() != 2 ) { COMMA_THROW( comma::exception, "expected time range in format [<from>],[<to>], got: \"" << options.value< std::string >( "--time" ) << "\"" ); }
+            boost::posix_time::ptime t0 = v[0].empty() ? boost::posix_time::ptime() : boost::posix_time::from_iso_string( v[0] );
+            boost::posix_time::ptime t1 = v[1].empty() ? boost::posix_time::ptime() : boost::posix_time::from_iso_string( v[1] );
+            comma::uint32 first;
+            comma::uint32 last;
+            if( !log_index->scans( t0, t1, first, last ) ) { std::cerr << "velodyne-to-csv: no scans in the given time range" << std::endl; return 0; }
+            from = from && *from > first ? *from : first;
+            to = to && *to < last ? *to : last;
+            if( *from > *to ) { std::cerr << "velodyne-to-csv: no scans in the given scan and time ranges" << std::endl; return 0; }
+        }
+        if( options.exists( "--lasers" ) )
+        {
+            std::vector< unsigned int > ids;
+            std::vector< std::string > v = comma::split( options.value< std::string >( "--lasers" ), ',' );
+            for( std::size_t i = 0; i < v.size(); ++i )
+            {
+                std::vector< std::string > r = comma::split( v[i], '-' );
+                if( r.size() > 2 ) { COMMA_THROW( comma::exception, "expected laser id or range of ids, e.g. 5-10, got: \"" << v[i] << "\"" ); }
+                unsigned int first = boost::lexical_cast< unsigned int >( r[0] );
+                unsigned int last = boost::lexical_cast< unsigned int >( r.back() );
+                for( unsigned int id = first; id <= last; ++id ) { ids.push_back( id ); }
+            }
+            raw_filter.lasers( ids );
+        }
+        if( options.exists( "--azimuth" ) )
+        {
+            std::vector< std::string > v = comma::split( options.value< std::string >( "--azimuth" ), ',' );
+            if( v.size() != 2 ) { COMMA_THROW( comma::exception, "expected azimuth in format <from>,<to>, got: \"" << options.value< std::string >( "--azimuth" ) << "\"" ); }
+            raw_filter.azimuth( boost::lexical_cast< double >( v[0] ), boost::lexical_cast< double >( v[1] ) );
+        }
+        if( options.exists( "--range" ) )
+        {
+            std::vector< std::string > v = comma::split( options.value< std::string >( "--range" ), ',' );
+            if( v.size() != 2 ) { COMMA_THROW( comma::exception, "expected range in format [<min>],[<max>], got: \"" << options.value< std::string >( "--range" ) << "\"" ); }
+            raw_filter.range( v[0].empty() ? 0 : boost::lexical_cast< double >( v[0] ), v[1].empty() ? std::numeric_limits< double >::max() : boost::lexical_cast< double >( v[1] ) );
+        }
+        shard_size = options.value( "--shard-size", 10u );
+        if( shard_size == 0 ) { COMMA_THROW( comma::exception, "expected positive --shard-size" ); }
         comma::csv::options csv;
         csv.fields = fields;
         csv.full_xpath = true;
         if( options.exists( "--binary,-b" ) ) { csv.format( format ); }
-        options.assert_mutually_exclusive( "--pcap,--thin,--udp-port,--proprietary,-q" );
+        options.assert_mutually_exclusive( "--pcap,--pcap-file,--thin,--udp-port,--proprietary,-q" );
+        options.assert_mutually_exclusive( "--pcap,--pcap-file,--udp-port,--file" );
+        if( log_index && !options.exists( "--pcap-file,--file" ) ) { COMMA_THROW( comma::exception, "--index requires --file or --pcap-file" ); }
         double min_range = options.value( "--min-range", 0.0 );
+        if( options.exists( "--source" ) )
+        {
+            if( options.exists( "--pcap,--pcap-file,--thin,--udp-port,--proprietary,-q,--file" ) ) { COMMA_THROW( comma::exception, "--source: input options are given per source, e.g. --source=\"log.bin;type=proprietary\"" ); }
+            if( options.exists( "--nav,--index,--time" ) ) { COMMA_THROW( comma::exception, "--source: --nav, --index, and --time not supported" ); }
+            unsigned int capacity = options.value( "--merge-lookahead", 16u );
+            if( capacity == 0 ) { COMMA_THROW( comma::exception, "expected positive --merge-lookahead" ); }
+            std::vector< std::string > specs = options.values< std::string >( "--source" );
+            std::vector< source* > sources;
+            for( unsigned int i = 0; i < specs.size(); ++i ) { sources.push_back( make_source_( specs[i], i, db_filename, capacity, outputInvalidpoints, min_range, from, to ) ); }
+            run_merge( sources, csv, options.value( "--merge-timeout", 0.1 ) );
+            return 0;
+        }
+        velodyne::db db( db_filename );
+        if( options.exists( "--nav" ) )
+        {
+            std::string s = options.value< std::string >( "--nav" );
+            comma::csv::options nav_csv = comma::name_value::parser( "filename" ).get< comma::csv::options >( s );
+            nav_istream.reset( new comma::io::istream( nav_csv.filename, nav_csv.binary() ? comma::io::mode::binary : comma::io::mode::ascii, comma::io::mode::blocking ) );
+            boost::optional< boost::posix_time::time_duration > max_gap;
+            if( options.exists( "--nav-max-gap" ) ) { max_gap = boost::posix_time::microseconds( static_cast< long >( options.value< double >( "--nav-max-gap" ) * 1000000 ) ); }
+            nav.reset( new velodyne::nav_frame( *( *nav_istream )(), nav_csv, !options.exists( "--nav-nearest" ), max_gap ) );
+            if( options.exists( "--sensor" ) ) { nav->sensor( comma::csv::ascii< velodyne::nav_frame::pose >().get( options.value< std::string >( "--sensor" ) ) ); }
+        }
+        unsigned int threads = options.value( "--threads", 1u );
         if( options.exists( "--pcap" ) )
         {
             velodyne_stream< snark::pcap_reader > v( db, outputInvalidpoints, from, to );
-            run( v, csv, min_range );
+            run( v, csv, min_range, outputInvalidpoints, threads );
+        }
+        else if( options.exists( "--pcap-file" ) )
+        {
+            #ifdef WIN32
+            COMMA_THROW( comma::exception, "--pcap-file not supported on windows, use --pcap" );
+            #else
+            run< snark::mmap_pcap_reader >( options.value< std::string >( "--pcap-file" ), db, csv, min_range, outputInvalidpoints, threads, from, to );
+            #endif
+        }
+        else if( options.exists( "--thin" ) && options.exists( "--file" ) )
+        {
+            run< snark::thin_reader >( options.value< std::string >( "--file" ), db, csv, min_range, outputInvalidpoints, threads, from, to );
         }
         else if( options.exists( "--thin" ) )
         {
             velodyne_stream< snark::thin_reader > v( db, outputInvalidpoints, from, to );
-            run( v, csv, min_range );
+            run( v, csv, min_range, outputInvalidpoints, threads );
         }
         else if( options.exists( "--udp-port" ) )
         {
+            #ifdef __linux__
+            snark::batched_udp_reader::config config( options.value< unsigned short >( "--udp-port" ), options.value( "--udp-batch", 64u ), options.value( "--udp-receive-buffer", 0u ) );
+            velodyne_stream< snark::batched_udp_reader > v( config, db, outputInvalidpoints, from, to );
+            run( v, csv, min_range, outputInvalidpoints, threads );
+            std::cerr << "velodyne-to-csv: received " << v.reader().received() << " packets; dropped by kernel: " << v.reader().dropped() << "; missing in sequence: " << v.reader().gaps() << "; shorter than packet, skipped: " << v.reader().truncated() << std::endl;
+            #else
             velodyne_stream< snark::udp_reader > v( options.value< unsigned short >( "--udp-port" ), db, outputInvalidpoints, from, to );
-            run( v, csv, min_range );
+            run( v, csv, min_range, outputInvalidpoints, threads );
+            #endif
         }
         else if( options.exists( "--proprietary,-q" ) )
         {
-            velodyne_stream< snark::proprietary_reader > v( db, outputInvalidpoints, from, to );
-            run( v, csv, min_range );
+            run< snark::proprietary_reader >( options.value< std::string >( "--file", "-" ), db, csv, min_range, outputInvalidpoints, threads, from, to );
+        }
+        else if( options.exists( "--file" ) )
+        {
+            run< snark::stream_reader >( options.value< std::string >( "--file" ), db, csv, min_range, outputInvalidpoints, threads, from, to );
         }
         else
         {
             velodyne_stream< snark::stream_reader > v( db, outputInvalidpoints, from, to );
-            run( v, csv, min_range );
+            run( v, csv, min_range, outputInvalidpoints, threads );
         }
         return 0;
     }
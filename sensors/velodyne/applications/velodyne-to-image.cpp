@@ -0,0 +1,169 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifdef WIN32
+#include <stdio.h>
+#include <fcntl.h>
+#include <io.h>
+#endif
+#include <boost/scoped_ptr.hpp>
+#include <opencv2/core/core.hpp>
+#include <comma/application/command_line_options.h>
+#include <comma/application/signal_flag.h>
+#include <comma/base/exception.h>
+#include <comma/csv/binary.h>
+#include <comma/csv/format.h>
+#include <comma/csv/names.h>
+#include <comma/string/string.h>
+#include <snark/imaging/cv_mat/serialization.h>
+#include <snark/sensors/velodyne/scan_image.h>
+#include <snark/sensors/velodyne/impl/pcap_reader.h>
+#include <snark/sensors/velodyne/impl/proprietary_reader.h>
+#include <snark/sensors/velodyne/impl/stream_reader.h>
+#include <snark/sensors/velodyne/impl/thin_reader.h>
+#include <snark/sensors/velodyne/impl/velodyne_stream.h>
+
+using namespace snark;
+
+static std::string scan_image_fields() { return "range,intensity,x,y,z,t"; }
+
+static void usage()
+{
+    std::cerr << std::endl;
+    std::cerr << "assemble velodyne revolutions into range images: rows are lasers ordered by elevation, columns are azimuth bins" << std::endl;
+    std::cerr << "each image cell contains " << scan_image_fields() << " as floats" << std::endl;
+    std::cerr << "    range: metres, 0 if no return; if several returns fall into the same cell, the nearest is kept" << std::endl;
+    std::cerr << "    x,y,z: coordinates relative to velodyne base" << std::endl;
+    std::cerr << "    t: seconds since image timestamp, i.e. time of the first return of the scan" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "usage: cat velodyne*.bin | velodyne-to-image [<options>]" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "input options" << std::endl;
+    std::cerr << "    --db=<db.xml file> ; default /usr/local/etc/db.xml" << std::endl;
+    std::cerr << "    --pcap : read pcap from stdin" << std::endl;
+    std::cerr << "    --thin : read thinned packets from stdin" << std::endl;
+    std::cerr << "    --proprietary,-q : read velodyne data directly from stdin using the proprietary protocol" << std::endl;
+    std::cerr << "    default input format: <timestamp, 8 bytes><packet, 1206 bytes>" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "output options" << std::endl;
+    std::cerr << "    --bins=<n>: number of azimuth bins per revolution; default 2000" << std::endl;
+    std::cerr << "    --binary-block: output <header><cells> per scan instead of cv::Mat stream" << std::endl;
+    std::cerr << "        header fields: " << comma::join( comma::csv::names< velodyne::scan_image::header >(), ',' ) << std::endl;
+    std::cerr << "        header format: " << comma::csv::format::value< velodyne::scan_image::header >() << std::endl;
+    std::cerr << "    default: cv::Mat stream of type CV_32FC" << velodyne::scan_image::channels << " with header t,rows,cols,type, as read by cv-cat" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "examples" << std::endl;
+    std::cerr << "    cat velodyne.bin | velodyne-to-image --db=db.xml | cv-cat \"split;view\"" << std::endl;
+    std::cerr << std::endl;
+    exit( -1 );
+}
+
+static bool binary_block;
+static boost::scoped_ptr< cv_mat::serialization > serialization;
+static boost::scoped_ptr< comma::csv::binary< velodyne::scan_image::header > > header_binary;
+
+static void write( const velodyne::scan_image& image )
+{
+    const velodyne::scan_image::header& h = image.get_header();
+    if( binary_block )
+    {
+        std::vector< char > buf( header_binary->format().size() );
+        header_binary->put( h, &buf[0] );
+        std::cout.write( &buf[0], buf.size() );
+        std::cout.write( reinterpret_cast< const char* >( &image.cells()[0] ), image.cells().size() * sizeof( velodyne::scan_image::cell ) );
+    }
+    else
+    {
+        cv::Mat m( h.rows, h.cols, CV_32FC( velodyne::scan_image::channels ), const_cast< velodyne::scan_image::cell* >( &image.cells()[0] ) );
+        serialization->write( std::cout, std::make_pair( h.t, m ) );
+    }
+    std::cout.flush();
+}
+
+template < typename S >
+static void run( velodyne_stream< S >& v, unsigned int bins )
+{
+    comma::signal_flag is_shutdown;
+    velodyne::scan_assembler assembler( v.db(), bins );
+    while( !is_shutdown && std::cout.good() )
+    {
+        const velodyne::decoded_packet* p = v.read_packet();
+        if( p == NULL ) { break; }
+        const velodyne::scan_image* image = assembler.push( *p );
+        if( image ) { write( *image ); }
+    }
+    if( is_shutdown ) { std::cerr << "velodyne-to-image: interrupted by signal" << std::endl; return; }
+    const velodyne::scan_image* image = assembler.flush();
+    if( image ) { write( *image ); }
+    std::cerr << "velodyne-to-image: done, no more data" << std::endl;
+}
+
+int main( int ac, char** av )
+{
+    try
+    {
+        comma::command_line_options options( ac, av );
+        if( options.exists( "--help,-h" ) ) { usage(); }
+        #ifdef WIN32
+        _setmode( _fileno( stdin ), _O_BINARY );
+        _setmode( _fileno( stdout ), _O_BINARY );
+        #endif
+        velodyne::db db( options.value< std::string >( "--db", "/usr/local/etc/db.xml" ) );
+        unsigned int bins = options.value( "--bins", 2000u );
+        binary_block = options.exists( "--binary-block" );
+        if( binary_block ) { header_binary.reset( new comma::csv::binary< velodyne::scan_image::header >() ); }
+        else { serialization.reset( new cv_mat::serialization( cv_mat::serialization::options() ) ); } // same header as cv-cat default
+        options.assert_mutually_exclusive( "--pcap,--thin,--proprietary,-q" );
+        if( options.exists( "--pcap" ) )
+        {
+            velodyne_stream< snark::pcap_reader > v( db, false );
+            run( v, bins );
+        }
+        else if( options.exists( "--thin" ) )
+        {
+            velodyne_stream< snark::thin_reader > v( db, false );
+            run( v, bins );
+        }
+        else if( options.exists( "--proprietary,-q" ) )
+        {
+            velodyne_stream< snark::proprietary_reader > v( db, false );
+            run( v, bins );
+        }
+        else
+        {
+            velodyne_stream< snark::stream_reader > v( db, false );
+            run( v, bins );
+        }
+        return 0;
+    }
+    catch( std::exception& ex ) { std::cerr << "velodyne-to-image: " << ex.what() << std::endl; }
+    catch( ... ) { std::cerr << "velodyne-to-image: unknown exception" << std::endl; }
+    return 1;
+}
@@ -0,0 +1,183 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <comma/base/exception.h>
+#include <snark/timing/time.h>
+#include "../packet.h"
+#include "./batched_udp_reader.h"
+
+namespace snark {
+
+static const std::size_t max_packet_size = 2000; // way greater than velodyne packet
+
+static const std::size_t control_size = CMSG_SPACE( sizeof( ::timespec ) ) + CMSG_SPACE( sizeof( comma::uint32 ) );
+
+batched_udp_reader::batched_udp_reader( unsigned short port ) { init_( config( port ) ); }
+
+batched_udp_reader::batched_udp_reader( const config& c ) { init_( c ); }
+
+batched_udp_reader::~batched_udp_reader() { close(); }
+
+void batched_udp_reader::init_( const config& c )
+{
+    if( c.batch == 0 ) { COMMA_THROW( comma::exception, "expected positive batch size" ); }
+    current_ = 0;
+    count_ = 0;
+    received_ = 0;
+    dropped_ = 0;
+    truncated_ = 0;
+    kernel_dropped_ = 0;
+    gaps_ = 0;
+    previous_rotation_ = -1;
+    shutdown_ = false;
+    socket_ = ::socket( AF_INET, SOCK_DGRAM, 0 );
+    if( socket_ < 0 ) { COMMA_THROW( comma::exception, "failed to open udp socket: " << ::strerror( errno ) ); }
+    int on = 1;
+    if( ::setsockopt( socket_, SOL_SOCKET, SO_BROADCAST, &on, sizeof( on ) ) != 0 ) { close(); COMMA_THROW( comma::exception, "failed to set broadcast option on port " << c.port ); }
+    if( ::setsockopt( socket_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof( on ) ) != 0 ) { close(); COMMA_THROW( comma::exception, "failed to set reuse address option on port " << c.port ); }
+    if( ::setsockopt( socket_, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof( on ) ) != 0 ) { close(); COMMA_THROW( comma::exception, "failed to set kernel timestamp option on port " << c.port ); }
+    if( ::setsockopt( socket_, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof( on ) ) != 0 ) { close(); COMMA_THROW( comma::exception, "failed to set drop count option on port " << c.port ); }
+    if( c.receive_buffer_size > 0 )
+    {
+        int size = c.receive_buffer_size;
+        if( ::setsockopt( socket_, SOL_SOCKET, SO_RCVBUF, &size, sizeof( size ) ) != 0 ) { close(); COMMA_THROW( comma::exception, "failed to set receive buffer size " << c.receive_buffer_size << " on port " << c.port ); }
+    }
+    ::sockaddr_in address;
+    ::memset( &address, 0, sizeof( address ) );
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl( INADDR_ANY );
+    address.sin_port = htons( c.port );
+    if( ::bind( socket_, reinterpret_cast< ::sockaddr* >( &address ), sizeof( address ) ) != 0 ) { close(); COMMA_THROW( comma::exception, "failed to bind port " << c.port << ": " << ::strerror( errno ) ); }
+    ::socklen_t length = sizeof( address );
+    if( ::getsockname( socket_, reinterpret_cast< ::sockaddr* >( &address ), &length ) != 0 ) { close(); COMMA_THROW( comma::exception, "failed to get socket name for port " << c.port ); }
+    port_ = ntohs( address.sin_port );
+    buffer_.resize( c.batch * max_packet_size );
+    control_.resize( c.batch * control_size );
+    headers_.resize( c.batch );
+    iovecs_.resize( c.batch );
+    sizes_.resize( c.batch, 0 );
+    nanoseconds_.resize( c.batch, 0 );
+}
+
+bool batched_udp_reader::receive_()
+{
+    for( unsigned int i = 0; i < headers_.size(); ++i ) // recvmmsg overwrites lengths, reset them all
+    {
+        iovecs_[i].iov_base = &buffer_[ i * max_packet_size ];
+        iovecs_[i].iov_len = max_packet_size;
+        ::memset( &headers_[i], 0, sizeof( ::mmsghdr ) );
+        headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+        headers_[i].msg_hdr.msg_iovlen = 1;
+        headers_[i].msg_hdr.msg_control = &control_[ i * control_size ];
+        headers_[i].msg_hdr.msg_controllen = control_size;
+    }
+    int count;
+    do { count = ::recvmmsg( socket_, &headers_[0], headers_.size(), MSG_WAITFORONE, NULL ); } while( count < 0 && errno == EINTR ); // interrupted by signal before receiving anything: retry
+    if( count <= 0 || shutdown_ ) { return false; } // after shutdown, recvmmsg returns empty datagrams rather than an error
+    boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+    comma::int64 now_nanoseconds = ( now - boost::posix_time::ptime( snark::timing::epoch ) ).total_microseconds() * 1000;
+    for( int i = 0; i < count; ++i )
+    {
+        sizes_[i] = headers_[i].msg_len;
+        if( sizes_[i] < velodyne::packet::size ) { ++truncated_; }
+        nanoseconds_[i] = now_nanoseconds; // in case kernel timestamp is missing
+        for( ::cmsghdr* c = CMSG_FIRSTHDR( &headers_[i].msg_hdr ); c != NULL; c = CMSG_NXTHDR( &headers_[i].msg_hdr, c ) )
+        {
+            if( c->cmsg_level != SOL_SOCKET ) { continue; }
+            if( c->cmsg_type == SCM_TIMESTAMPNS )
+            {
+                ::timespec t;
+                ::memcpy( &t, CMSG_DATA( c ), sizeof( ::timespec ) );
+                nanoseconds_[i] = comma::int64( t.tv_sec ) * 1000000000 + t.tv_nsec;
+            }
+            else if( c->cmsg_type == SO_RXQ_OVFL ) // cumulative count of drops on the socket since it was opened
+            {
+                comma::uint32 d;
+                ::memcpy( &d, CMSG_DATA( c ), sizeof( comma::uint32 ) );
+                dropped_ += d - kernel_dropped_; // unsigned arithmetic takes care of wrap around
+                kernel_dropped_ = d;
+            }
+        }
+        update_gaps_( &buffer_[ i * max_packet_size ], sizes_[i] );
+    }
+    received_ += count;
+    count_ = count;
+    return true;
+}
+
+void batched_udp_reader::update_gaps_( const char* data, std::size_t size )
+{
+    if( size != velodyne::packet::size ) { return; }
+    const velodyne::packet& p = *reinterpret_cast< const velodyne::packet* >( data );
+    int rotation = p.blocks[0].rotation();
+    int previous = previous_rotation_;
+    previous_rotation_ = rotation;
+    if( previous < 0 ) { return; }
+    int step = ( int( p.blocks[10].rotation() ) - rotation + 36000 ) % 36000; // 5 firings of upper and lower block pairs
+    if( step == 0 ) { return; }
+    int expected = step * 6 / 5; // 6 firings per packet
+    int delta = ( rotation - previous + 36000 ) % 36000;
+    if( delta * 2 > expected * 3 ) { gaps_ += ( delta + expected / 2 ) / expected - 1; }
+}
+
+const char* batched_udp_reader::read()
+{
+    if( socket_ < 0 || shutdown_ ) { return NULL; }
+    if( current_ + 1 < count_ ) { ++current_; }
+    else if( receive_() ) { current_ = 0; }
+    else { return NULL; }
+    const comma::int64& t = nanoseconds_[ current_ ];
+    timestamp_ = boost::posix_time::ptime( snark::timing::epoch, boost::posix_time::seconds( t / 1000000000 ) + boost::posix_time::microseconds( ( t % 1000000000 ) / 1000 ) );
+    return &buffer_[ current_ * max_packet_size ];
+}
+
+void batched_udp_reader::shutdown()
+{
+    if( socket_ < 0 ) { return; }
+    shutdown_ = true;
+    ::shutdown( socket_, SHUT_RDWR ); // fails with ENOTCONN on unconnected udp socket, but still wakes up blocked receive on linux
+}
+
+void batched_udp_reader::close()
+{
+    if( socket_ < 0 ) { return; }
+    ::close( socket_ );
+    socket_ = -1;
+}
+
+} // namespace snark {
+
+#endif // #ifdef __linux__
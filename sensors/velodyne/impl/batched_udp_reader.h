@@ -0,0 +1,138 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_BATCHED_UDP_READER_H_
+#define SNARK_SENSORS_VELODYNE_BATCHED_UDP_READER_H_
+
+#ifdef __linux__
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
+#include <comma/base/types.h>
+
+namespace snark {
+
+/// udp reader receiving many datagrams per system call with recvmmsg into a preallocated ring
+/// packets are stamped with kernel receive time (SO_TIMESTAMPNS)
+/// keeps count of packets dropped by kernel (SO_RXQ_OVFL) and of gaps in velodyne packet sequence
+/// @note linux only
+class batched_udp_reader : public boost::noncopyable
+{
+    public:
+        struct config
+        {
+            /// port to bind to; 0: any free port, see port()
+            unsigned short port;
+
+            /// max number of datagrams received in one system call
+            unsigned int batch;
+
+            /// socket receive buffer size in bytes; 0: system default
+            unsigned int receive_buffer_size;
+
+            config( unsigned short port = 0, unsigned int batch = 64, unsigned int receive_buffer_size = 0 ) : port( port ), batch( batch ), receive_buffer_size( receive_buffer_size ) {}
+        };
+
+        /// constructor
+        batched_udp_reader( unsigned short port );
+
+        /// constructor
+        batched_udp_reader( const config& c );
+
+        /// destructor
+        ~batched_udp_reader();
+
+        /// read and return pointer to the current packet; NULL, if socket closed or on error
+        const char* read();
+
+        /// return size of the current packet
+        std::size_t size() const { return sizes_[ current_ ]; }
+
+        /// close
+        void close();
+
+        /// unblock read() waiting in another thread, after which read() returns NULL
+        /// the socket stays open, close it once the reading thread is done
+        void shutdown();
+
+        /// return kernel receive timestamp of the current packet
+        const boost::posix_time::ptime& timestamp() const { return timestamp_; }
+
+        /// return kernel receive timestamp of the current packet, nanoseconds from epoch
+        comma::int64 nanoseconds() const { return nanoseconds_[ current_ ]; }
+
+        /// return bound port
+        unsigned short port() const { return port_; }
+
+        /// return number of packets received
+        comma::uint64 received() const { return received_; }
+
+        /// return number of datagrams shorter than velodyne packet, e.g. of other traffic on the port
+        comma::uint64 truncated() const { return truncated_; }
+
+        /// return number of packets dropped by kernel because receive buffer was full
+        comma::uint64 dropped() const { return dropped_; }
+
+        /// return estimated number of velodyne packets missing in the sequence
+        /// judging by jumps in block rotation; counts packets lost anywhere on the way, not only in the kernel
+        comma::uint64 gaps() const { return gaps_; }
+
+    private:
+        int socket_;
+        unsigned short port_;
+        std::vector< char > buffer_;
+        std::vector< char > control_;
+        std::vector< ::mmsghdr > headers_;
+        std::vector< ::iovec > iovecs_;
+        std::vector< std::size_t > sizes_;
+        std::vector< comma::int64 > nanoseconds_;
+        unsigned int current_;
+        unsigned int count_;
+        boost::posix_time::ptime timestamp_;
+        comma::uint64 received_;
+        comma::uint64 dropped_;
+        comma::uint64 truncated_;
+        comma::uint32 kernel_dropped_;
+        comma::uint64 gaps_;
+        int previous_rotation_;
+        volatile bool shutdown_;
+        void init_( const config& c );
+        bool receive_();
+        void update_gaps_( const char* data, std::size_t size );
+};
+
+} // namespace snark {
+
+#endif // #ifdef __linux__
+
+#endif // SNARK_SENSORS_VELODYNE_BATCHED_UDP_READER_H_
@@ -32,6 +32,7 @@
 #include <comma/math/compare.h>
 #include <snark/sensors/velodyne/impl/angle.h>
 #include <snark/sensors/velodyne/impl/get_laser_return.h>
+#include <snark/sensors/velodyne/time.h>
 
 namespace snark {  namespace velodyne { namespace impl {
 
@@ -102,6 +103,24 @@ boost::posix_time::time_duration time_offset( unsigned int block, unsigned int l
     return boost::posix_time::microseconds( offset * 1000000 );
 }
 
+double firing_step() { return timestamps::step; }
+
+namespace {
+
+struct time_offsets // quick and dirty: kept at microsecond resolution to produce exactly the same timestamps as time_offset()
+{
+    comma::int64 values[12][32];
+    time_offsets() { for( unsigned int b = 0; b < 12; ++b ) { for( unsigned int l = 0; l < 32; ++l ) { values[b][l] = time_offset( b, l ).total_microseconds() * 1000; } } }
+};
+
+} // namespace {
+
+comma::int64 time_offset_nanoseconds( unsigned int block, unsigned int laser )
+{
+    static const time_offsets offsets;
+    return offsets.values[block][laser];
+}
+
 double azimuth( double rotation, unsigned int laser, double angularSpeed )
 {
     double a = rotation + angularSpeed * timestamps::step * laser + 90; // add 90 degrees for our system of coordinates (although this value is only output for later processing - can keep its own)
@@ -120,7 +139,7 @@ static bool is_upper( unsigned int block ) { return ( block & 0x1 ) == 0; }
 laser_return get_laser_return( const packet& packet
                              , unsigned int block
                              , unsigned int laser
-                             , const boost::posix_time::ptime& timestamp
+                             , comma::int64 timestamp
                              , double angularSpeed
                              , bool raw )
 {
@@ -135,10 +154,20 @@ laser_return get_laser_return( const packet& packet
     }
     else
     {
-        r.timestamp = timestamp + time_offset( block, laser );
+        r.timestamp = timestamp == invalid_time ? invalid_time : timestamp + time_offset_nanoseconds( block, laser );
         r.azimuth = azimuth( packet, block, laser, angularSpeed );
     }
     return r;
 }
 
+laser_return get_laser_return( const packet& packet
+                             , unsigned int block
+                             , unsigned int laser
+                             , const boost::posix_time::ptime& timestamp
+                             , double angularSpeed
+                             , bool raw )
+{
+    return get_laser_return( packet, block, laser, to_nanoseconds( timestamp ), angularSpeed, raw );
+}
+
 } } } // namespace snark {  namespace velodyne { namespace impl {
@@ -32,12 +32,22 @@
 #define SNARK_SENSORS_VELODYNE_IMPL_GETLASERRETURN_H_
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <comma/base/types.h>
 #include <snark/sensors/velodyne/db.h>
 #include <snark/sensors/velodyne/laser_return.h>
 #include <snark/sensors/velodyne/packet.h>
 
 namespace snark {  namespace velodyne { namespace impl {
 
+/// @param timestamp packet timestamp in nanoseconds from epoch, see time.h
+laser_return get_laser_return( const packet& packet
+                             , unsigned int block
+                             , unsigned int laser
+                             , comma::int64 timestamp
+                             , double angularSpeed
+                             , bool raw = false );
+
+/// convenience overload, converts timestamp to nanoseconds
 laser_return get_laser_return( const packet& packet
                              , unsigned int block
                              , unsigned int laser
@@ -47,6 +57,12 @@ laser_return get_laser_return( const packet& packet
 
 boost::posix_time::time_duration time_offset( unsigned int block, unsigned int laser );
 
+/// same as time_offset(), but in nanoseconds, looked up in a precomputed table
+comma::int64 time_offset_nanoseconds( unsigned int block, unsigned int laser );
+
+/// time between firings of two consecutive lasers in a block, in seconds
+double firing_step();
+
 double azimuth( const packet& packet, unsigned int block, unsigned int laser, double angularSpeed );
 
 double azimuth( double rotation, unsigned int laser, double angularSpeed );
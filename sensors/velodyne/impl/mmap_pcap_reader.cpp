@@ -0,0 +1,159 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef WIN32
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <comma/base/exception.h>
+#include <snark/timing/time.h>
+#include "./mmap_pcap_reader.h"
+
+namespace snark {
+
+namespace pcap_format {
+
+static const comma::uint32 magic = 0xa1b2c3d4;
+static const comma::uint32 magic_swapped = 0xd4c3b2a1;
+static const comma::uint32 nanosecond_magic = 0xa1b23c4d;
+static const comma::uint32 nanosecond_magic_swapped = 0x4d3cb2a1;
+enum { header_size = 24, record_header_size = 16 };
+
+} // namespace pcap_format {
+
+static comma::uint32 swap_( comma::uint32 v ) { return ( v >> 24 ) | ( ( v >> 8 ) & 0xff00 ) | ( ( v << 8 ) & 0xff0000 ) | ( v << 24 ); }
+
+mmap_pcap_reader::mmap_pcap_reader( const std::string& filename )
+    : fd_( -1 )
+    , data_( NULL )
+    , mapped_size_( 0 )
+    , offset_( pcap_format::header_size )
+    , position_( pcap_format::header_size )
+    , swapped_( false )
+    , nanosecond_resolution_( false )
+    , seconds_( 0 )
+    , fraction_( 0 )
+    , size_( 0 )
+{
+    if( filename == "-" ) { COMMA_THROW( comma::exception, "cannot memory-map stdin, please specify pcap file name" ); }
+    fd_ = ::open( filename.c_str(), O_RDONLY );
+    if( fd_ < 0 ) { COMMA_THROW( comma::exception, "failed to open pcap file " << filename ); }
+    struct stat s;
+    if( ::fstat( fd_, &s ) != 0 ) { close(); COMMA_THROW( comma::exception, "failed to stat pcap file " << filename ); }
+    if( s.st_size < pcap_format::header_size ) { close(); COMMA_THROW( comma::exception, "expected pcap file, got file of " << s.st_size << " byte(s): " << filename ); }
+    mapped_size_ = s.st_size;
+    void* p = ::mmap( NULL, mapped_size_, PROT_READ, MAP_PRIVATE, fd_, 0 );
+    if( p == MAP_FAILED ) { data_ = NULL; close(); COMMA_THROW( comma::exception, "failed to memory-map pcap file " << filename ); }
+    data_ = reinterpret_cast< char* >( p );
+    ::madvise( data_, mapped_size_, MADV_SEQUENTIAL );
+    comma::uint32 magic;
+    ::memcpy( &magic, data_, sizeof( comma::uint32 ) );
+    switch( magic )
+    {
+        case pcap_format::magic: break;
+        case pcap_format::magic_swapped: swapped_ = true; break;
+        case pcap_format::nanosecond_magic: nanosecond_resolution_ = true; break;
+        case pcap_format::nanosecond_magic_swapped: swapped_ = true; nanosecond_resolution_ = true; break;
+        default: close(); COMMA_THROW( comma::exception, "expected pcap file, got unknown magic number 0x" << std::hex << magic << " in " << filename );
+    }
+}
+
+mmap_pcap_reader::~mmap_pcap_reader() { close(); }
+
+comma::uint32 mmap_pcap_reader::uint32_( comma::uint64 offset ) const
+{
+    comma::uint32 v;
+    ::memcpy( &v, data_ + offset, sizeof( comma::uint32 ) );
+    return swapped_ ? swap_( v ) : v;
+}
+
+const char* mmap_pcap_reader::read()
+{
+    if( data_ == NULL || offset_ + pcap_format::record_header_size > mapped_size_ ) { return NULL; }
+    comma::uint32 size = uint32_( offset_ + 8 );
+    comma::uint64 begin = offset_ + pcap_format::record_header_size;
+    if( begin + size > mapped_size_ ) { offset_ = mapped_size_; return NULL; } // truncated record
+    seconds_ = uint32_( offset_ );
+    fraction_ = uint32_( offset_ + 4 );
+    size_ = size;
+    position_ = offset_;
+    offset_ = begin + size;
+    return data_ + begin;
+}
+
+bool mmap_pcap_reader::eof() const { return data_ == NULL || offset_ + pcap_format::record_header_size > mapped_size_; }
+
+comma::int64 mmap_pcap_reader::nanoseconds() const
+{
+    return comma::int64( seconds_ ) * 1000000000 + ( nanosecond_resolution_ ? fraction_ : comma::int64( fraction_ ) * 1000 );
+}
+
+boost::posix_time::ptime mmap_pcap_reader::timestamp() const
+{
+    return boost::posix_time::ptime( snark::timing::epoch, boost::posix_time::seconds( seconds_ ) + boost::posix_time::microseconds( nanosecond_resolution_ ? fraction_ / 1000 : fraction_ ) );
+}
+
+void mmap_pcap_reader::seek_offset( comma::uint64 offset )
+{
+    if( offset < pcap_format::header_size || offset > mapped_size_ ) { COMMA_THROW( comma::exception, "expected offset between " << pcap_format::header_size << " and " << mapped_size_ << ", got " << offset ); }
+    offset_ = offset;
+}
+
+std::size_t mmap_pcap_reader::build_index()
+{
+    index_.clear();
+    for( comma::uint64 offset = pcap_format::header_size; offset + pcap_format::record_header_size <= mapped_size_; )
+    {
+        comma::uint64 next = offset + pcap_format::record_header_size + uint32_( offset + 8 );
+        if( next > mapped_size_ ) { break; } // truncated record
+        index_.push_back( offset );
+        offset = next;
+    }
+    return index_.size();
+}
+
+void mmap_pcap_reader::seek( std::size_t n )
+{
+    if( n > index_.size() ) { COMMA_THROW( comma::exception, "asked to seek packet " << n << ", but index has only " << index_.size() << " packet(s); forgot to call build_index()?" ); }
+    offset_ = n == index_.size() ? mapped_size_ : index_[n];
+}
+
+void mmap_pcap_reader::close()
+{
+    if( data_ ) { ::munmap( data_, mapped_size_ ); data_ = NULL; }
+    if( fd_ >= 0 ) { ::close( fd_ ); fd_ = -1; }
+}
+
+} // namespace snark {
+
+#endif // #ifndef WIN32
@@ -0,0 +1,115 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_MMAP_PCAP_READER_H_
+#define SNARK_SENSORS_VELODYNE_MMAP_PCAP_READER_H_
+
+#ifndef WIN32
+#include <stdlib.h>
+#endif
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
+#include <comma/base/types.h>
+
+namespace snark {
+
+/// pcap reader parsing record headers directly from memory-mapped file
+/// supports classic (microsecond) and nanosecond pcap in either byte order
+/// returned packet pointers point into the mapped file and are valid until close()
+/// @note not available on windows
+class mmap_pcap_reader : public boost::noncopyable
+{
+    public:
+        /// constructor, map pcap file
+        mmap_pcap_reader( const std::string& filename );
+
+        /// destructor, unmap file
+        ~mmap_pcap_reader();
+
+        /// read and return pointer to the current packet; NULL, if end of file
+        const char* read();
+
+        /// return captured size of the current packet
+        std::size_t size() const { return size_; }
+
+        /// close
+        void close();
+
+        /// return true, if end of file
+        bool eof() const;
+
+        /// return current timestamp
+        boost::posix_time::ptime timestamp() const;
+
+        /// return current timestamp, nanoseconds from epoch
+        comma::int64 nanoseconds() const;
+
+        /// return true, if file has nanosecond timestamps
+        bool nanosecond_resolution() const { return nanosecond_resolution_; }
+
+        /// return offset of the next record in the file
+        comma::uint64 offset() const { return offset_; }
+
+        /// return offset of the current packet record in the file
+        comma::uint64 position() const { return position_; }
+
+        /// position reader at the record at given offset, e.g. an offset from index()
+        void seek_offset( comma::uint64 offset );
+
+        /// build index of record offsets without touching packet payloads
+        /// @return number of packets
+        std::size_t build_index();
+
+        /// return offsets of all records in the file; empty until build_index() is called
+        const std::vector< comma::uint64 >& index() const { return index_; }
+
+        /// position reader so that next read() returns n-th packet; build_index() must have been called
+        void seek( std::size_t n );
+
+    private:
+        int fd_;
+        char* data_;
+        comma::uint64 mapped_size_;
+        comma::uint64 offset_;
+        comma::uint64 position_;
+        bool swapped_;
+        bool nanosecond_resolution_;
+        comma::uint32 seconds_;
+        comma::uint32 fraction_;
+        std::size_t size_;
+        std::vector< comma::uint64 > index_;
+        comma::uint32 uint32_( comma::uint64 offset ) const;
+};
+
+} // namespace snark {
+
+#endif // SNARK_SENSORS_VELODYNE_MMAP_PCAP_READER_H_
@@ -37,6 +37,7 @@
 #include <pcap.h>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/noncopyable.hpp>
+#include <comma/base/types.h>
 
 namespace snark {
 
@@ -63,6 +64,9 @@ class pcap_reader : public boost::noncopyable
         /// return current timestamp
         boost::posix_time::ptime timestamp() const;
 
+        /// return current timestamp, nanoseconds from epoch
+        comma::int64 nanoseconds() const { return comma::int64( m_header.ts.tv_sec ) * 1000000000 + comma::int64( m_header.ts.tv_usec ) * 1000; }
+
     private:
         char m_error[1024];
         ::pcap_t* m_handle;
@@ -30,7 +30,7 @@
 
 #include <comma/base/exception.h>
 #include <comma/base/types.h>
-#include <snark/timing/time.h>
+#include <snark/sensors/velodyne/time.h>
 #include "./proprietary_reader.h"
 
 #ifdef WIN32
@@ -43,6 +43,9 @@ namespace snark {
 proprietary_reader::proprietary_reader( const std::string& filename )
     : m_offset( 0 )
     , m_end( 0 )
+    , m_nanoseconds( 0 )
+    , m_buffer_position( 0 )
+    , m_position( 0 )
 {
     if( filename == "-" )
     {
@@ -59,6 +62,16 @@ proprietary_reader::proprietary_reader( const std::string& filename )
     }
 }
 
+proprietary_reader::proprietary_reader( std::istream& is )
+    : m_offset( 0 )
+    , m_end( 0 )
+    , m_nanoseconds( 0 )
+    , m_istream( &is )
+    , m_buffer_position( 0 )
+    , m_position( 0 )
+{
+}
+
 proprietary_reader::~proprietary_reader() { close(); }
 
 const char* proprietary_reader::read() // quick and dirty
@@ -72,6 +85,7 @@ const char* proprietary_reader::read() // quick and dirty
         if( m_offset + packetSize > m_end )
         {
             if( m_istream->bad() || m_istream->eof() ) { return NULL; }
+            m_buffer_position += m_offset < m_end ? m_offset : m_end;
             std::size_t size = m_buffer.size();
             std::size_t len = 0;
             if( m_offset < m_end )
@@ -96,12 +110,24 @@ const char* proprietary_reader::read() // quick and dirty
     comma::uint32 nanoseconds;
     ::memcpy( &seconds, t, 8 );
     ::memcpy( &nanoseconds, t + 8, 4 );
-    m_timestamp = boost::posix_time::ptime( snark::timing::epoch, boost::posix_time::seconds( seconds ) + boost::posix_time::microseconds( nanoseconds / 1000 ) );
+    m_nanoseconds = velodyne::to_nanoseconds( seconds, nanoseconds );
+    m_position = m_buffer_position + m_offset;
     m_offset += packetSize;
     return t + timestampSize;
 }
 
-boost::posix_time::ptime proprietary_reader::timestamp() const { return m_timestamp; }
+void proprietary_reader::seek_offset( comma::uint64 offset )
+{
+    if( !m_ifstream ) { COMMA_THROW( comma::exception, "cannot seek on stdin or other stream" ); }
+    m_ifstream->clear();
+    m_ifstream->seekg( offset );
+    if( !m_ifstream->good() ) { COMMA_THROW( comma::exception, "failed to seek offset " << offset ); }
+    m_buffer_position = offset;
+    m_offset = 0;
+    m_end = 0;
+}
+
+boost::posix_time::ptime proprietary_reader::timestamp() const { return velodyne::to_ptime( m_nanoseconds ); }
 
 void proprietary_reader::close() { if( m_ifstream ) { m_ifstream->close(); } }
 
@@ -40,6 +40,7 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <comma/base/types.h>
 
 namespace snark {
 
@@ -50,6 +51,9 @@ class proprietary_reader : public boost::noncopyable
     public:
         /// constructor, open a file, default stdin
         proprietary_reader( const std::string& filename = "-" );
+
+        /// constructor, read from given stream, e.g. from memory
+        proprietary_reader( std::istream& is );
     
         /// destructor, close file
         ~proprietary_reader();
@@ -62,6 +66,15 @@ class proprietary_reader : public boost::noncopyable
     
         /// return current timestamp
         boost::posix_time::ptime timestamp() const;
+
+        /// return current timestamp, nanoseconds from epoch
+        comma::int64 nanoseconds() const { return m_nanoseconds; }
+
+        /// return offset of the current packet record in the stream
+        comma::uint64 position() const { return m_position; }
+
+        /// position reader at the record at given offset; only for files
+        void seek_offset( comma::uint64 offset );
     
     private:
         enum
@@ -76,9 +89,11 @@ class proprietary_reader : public boost::noncopyable
         boost::array< char, packetSize * packetNum > m_buffer;
         std::size_t m_offset;
         std::size_t m_end;
-        boost::posix_time::ptime m_timestamp;
+        comma::int64 m_nanoseconds;
         boost::scoped_ptr< std::ifstream > m_ifstream;
         std::istream* m_istream;
+        comma::uint64 m_buffer_position; // offset of the buffer start in the stream
+        comma::uint64 m_position;
 };
 
 } 
@@ -30,7 +30,7 @@
 
 #include <comma/base/exception.h>
 #include "./stream_reader.h"
-#include <snark/timing/time.h>
+#include <snark/sensors/velodyne/time.h>
 #ifdef WIN32
 #include <fcntl.h>
 #include <io.h>
@@ -38,7 +38,7 @@
 
 namespace snark {
 
-stream_reader::stream_reader( std::istream& is ) : istream_( is ), m_epoch( timing::epoch )
+stream_reader::stream_reader( std::istream& is ) : istream_( is ), m_microseconds( 0 ), m_position( 0 ), m_next( 0 )
 {
     #ifdef WIN32
     if( is == std::cin ) { _setmode( _fileno( stdin ), _O_BINARY ); }
@@ -48,7 +48,9 @@ stream_reader::stream_reader( std::istream& is ) : istream_( is ), m_epoch( timi
 stream_reader::stream_reader( const std::string& filename )
     : ifstream_( new std::ifstream( &filename[0], std::ios::binary ) )
     , istream_( *ifstream_ )
-    , m_epoch( timing::epoch )
+    , m_microseconds( 0 )
+    , m_position( 0 )
+    , m_next( 0 )
 {
 }
 
@@ -59,16 +61,20 @@ const char* stream_reader::read()
     istream_.read( reinterpret_cast< char* >( &m_microseconds ), sizeof( m_microseconds ) );
     istream_.read( m_packet.data(), payload_size );
     if( istream_.bad() || istream_.eof() ) { return NULL; }
-    comma::uint64 seconds = m_microseconds / 1000000; //to avoid time overflow on 32bit systems with boost::posix_time::microseconds( m_microseconds ), apparently due to a bug in boost
-    comma::uint64 microseconds = m_microseconds % 1000000;
-    m_timestamp = m_epoch + boost::posix_time::seconds( seconds ) + boost::posix_time::microseconds( microseconds );
+    m_position = m_next;
+    m_next += sizeof( m_microseconds ) + payload_size;
     return &m_packet[0];
 }
 
-const boost::posix_time::ptime& stream_reader::timestamp() const
+void stream_reader::seek_offset( comma::uint64 offset )
 {
-    return m_timestamp;
+    istream_.clear();
+    istream_.seekg( offset );
+    if( !istream_.good() ) { COMMA_THROW( comma::exception, "failed to seek offset " << offset << "; stream not seekable?" ); }
+    m_next = offset;
 }
 
+boost::posix_time::ptime stream_reader::timestamp() const { return velodyne::to_ptime( nanoseconds() ); }
+
 } // namespace snark {
 
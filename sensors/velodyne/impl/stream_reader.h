@@ -60,7 +60,16 @@ class stream_reader
         const char* read();
 
         /// return current timestamp
-        const boost::posix_time::ptime& timestamp() const;
+        boost::posix_time::ptime timestamp() const;
+
+        /// return current timestamp, nanoseconds from epoch
+        comma::int64 nanoseconds() const { return comma::int64( m_microseconds ) * 1000; }
+
+        /// return offset of the current packet record in the stream
+        comma::uint64 position() const { return m_position; }
+
+        /// position stream at the record at given offset; only for seekable streams, e.g. files
+        void seek_offset( comma::uint64 offset );
 
     private:
         boost::scoped_ptr< std::ifstream > ifstream_;
@@ -68,8 +77,8 @@ class stream_reader
         enum{ payload_size = 1206 };
         comma::uint64 m_microseconds;
         boost::array< char, payload_size > m_packet;
-        boost::posix_time::ptime m_timestamp;
-        boost::posix_time::ptime m_epoch;
+        comma::uint64 m_position;
+        comma::uint64 m_next;
 };
 
 } // namespace snark {
@@ -33,10 +33,17 @@
 
 #include <boost/optional.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <comma/base/types.h>
 #include "snark/sensors/velodyne/scan_tick.h"
 #include "./pcap_reader.h"
+#ifndef WIN32
+#include "./mmap_pcap_reader.h"
+#endif
 #include "./proprietary_reader.h"
 #include "./thin_reader.h"
+#ifdef __linux__
+#include "./batched_udp_reader.h"
+#endif
 
 namespace snark {  namespace velodyne { namespace impl {
 
@@ -49,6 +56,8 @@ struct stream_traits
     //static boost::posix_time::ptime timestamp( const S& ) { return boost::posix_time::microsec_clock::local_time(); }
     static boost::posix_time::ptime timestamp( const S& s ) { return s.timestamp(); }
 
+    static comma::int64 nanoseconds( const S& s ) { return s.nanoseconds(); }
+
     static void close( S& s ) { s.close(); }
 
     static bool is_new_scan( scan_tick& tick, const S&, const packet& p ) { return tick.is_new_scan( p ); }
@@ -61,6 +70,8 @@ struct stream_traits< proprietary_reader >
 
     static boost::posix_time::ptime timestamp( const proprietary_reader& s ) { return s.timestamp(); }
 
+    static comma::int64 nanoseconds( const proprietary_reader& s ) { return s.nanoseconds(); }
+
     static void close( proprietary_reader& s ) { s.close(); }
 
     static bool is_new_scan( scan_tick& tick, const proprietary_reader&, const packet& p ) { return tick.is_new_scan( p ); }
@@ -78,11 +89,63 @@ struct stream_traits< pcap_reader >
 
     static boost::posix_time::ptime timestamp( const pcap_reader& s ) { return s.timestamp(); }
 
+    static comma::int64 nanoseconds( const pcap_reader& s ) { return s.nanoseconds(); }
+
     static void close( pcap_reader& s ) { s.close(); }
 
     static bool is_new_scan( scan_tick& tick, const pcap_reader&, const packet& p ) { return tick.is_new_scan( p ); }
 };
 
+#ifndef WIN32
+template <>
+struct stream_traits< mmap_pcap_reader >
+{
+    /// skip records shorter than UDP header and packet, e.g. of other traffic, since packet would be read past their end
+    static const char* read( mmap_pcap_reader& s, std::size_t size )
+    {
+        while( true )
+        {
+            const char* r = s.read();
+            if( r == NULL ) { return NULL; }
+            if( s.size() >= 42 + size ) { return r + 42; } // skip UDP header
+        }
+    }
+
+    static boost::posix_time::ptime timestamp( const mmap_pcap_reader& s ) { return s.timestamp(); }
+
+    static comma::int64 nanoseconds( const mmap_pcap_reader& s ) { return s.nanoseconds(); }
+
+    static void close( mmap_pcap_reader& s ) { s.close(); }
+
+    static bool is_new_scan( scan_tick& tick, const mmap_pcap_reader&, const packet& p ) { return tick.is_new_scan( p ); }
+};
+#endif
+
+#ifdef __linux__
+template <>
+struct stream_traits< batched_udp_reader >
+{
+    /// skip datagrams shorter than packet, e.g. of other traffic, since packet would be read past their end; see batched_udp_reader::truncated()
+    static const char* read( batched_udp_reader& s, std::size_t size )
+    {
+        while( true )
+        {
+            const char* r = s.read();
+            if( r == NULL ) { return NULL; }
+            if( s.size() >= size ) { return r; }
+        }
+    }
+
+    static boost::posix_time::ptime timestamp( const batched_udp_reader& s ) { return s.timestamp(); }
+
+    static comma::int64 nanoseconds( const batched_udp_reader& s ) { return s.nanoseconds(); }
+
+    static void close( batched_udp_reader& s ) { s.close(); }
+
+    static bool is_new_scan( scan_tick& tick, const batched_udp_reader&, const packet& p ) { return tick.is_new_scan( p ); }
+};
+#endif
+
 template <> struct stream_traits< thin_reader >
 {
     //static const char* read( S& s, std::size_t size ) { return s.read( size ); }
@@ -91,6 +154,8 @@ template <> struct stream_traits< thin_reader >
     //static boost::posix_time::ptime timestamp( const S& ) { return boost::posix_time::microsec_clock::local_time(); }
     static boost::posix_time::ptime timestamp( const thin_reader& s ) { return s.timestamp(); }
 
+    static comma::int64 nanoseconds( const thin_reader& s ) { return s.nanoseconds(); }
+
     static void close( thin_reader& s ) { s.close(); }
 
     static bool is_new_scan( const scan_tick&, thin_reader& r, const packet& ) { return r.is_new_scan(); }
@@ -31,31 +31,51 @@
 #include <fcntl.h>
 #include <io.h>
 #endif
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/time.h>
 #include <snark/sensors/velodyne/impl/thin_reader.h>
 
 namespace snark {
 
-snark::thin_reader::thin_reader() : is_new_scan_( true )
+snark::thin_reader::thin_reader() : m_istream( std::cin ), m_nanoseconds( 0 ), is_new_scan_( true ), m_position( 0 ), m_next( 0 )
 {
     #ifdef WIN32
     _setmode( _fileno( stdin ), _O_BINARY );
     #endif
 }
 
+snark::thin_reader::thin_reader( const std::string& filename )
+    : m_ifstream( new std::ifstream( &filename[0], std::ios::binary ) )
+    , m_istream( *m_ifstream )
+    , m_nanoseconds( 0 )
+    , is_new_scan_( true )
+    , m_position( 0 )
+    , m_next( 0 )
+{
+    if( !m_ifstream->is_open() ) { COMMA_THROW( comma::exception, "failed to open \"" << filename << "\"" ); }
+}
+
+snark::thin_reader::thin_reader( std::istream& is ) : m_istream( is ), m_nanoseconds( 0 ), is_new_scan_( true ), m_position( 0 ), m_next( 0 ) {}
+
 const char* thin_reader::read()
 {
-    if( !std::cin.good() || std::cin.eof() ) { return NULL; }
+    if( !m_istream.good() || m_istream.eof() ) { return NULL; }
     comma::uint16 size;
-    std::cin.read( reinterpret_cast< char* >( &size ), 2 );
-    if( std::cin.gcount() < 2 ) { return NULL; }
-    std::cin.read( m_buf, size );
-    if( std::cin.gcount() < size ) { return NULL; }
+    m_istream.read( reinterpret_cast< char* >( &size ), 2 );
+    if( m_istream.gcount() < 2 ) { return NULL; }
+    bool v2 = size & velodyne::thin::v2::record_flag;
+    size &= ~comma::uint16( velodyne::thin::v2::record_flag );
+    if( size > bufferSize ) { COMMA_THROW( comma::exception, "expected thin record size not greater than " << bufferSize << ", got " << size ); }
+    m_istream.read( m_buf, size );
+    if( m_istream.gcount() < size ) { return NULL; }
+    m_position = m_next;
+    m_next += 2 + size;
     comma::int64 seconds;
     comma::int32 nanoseconds;
     ::memcpy( &seconds, m_buf, sizeof( comma::int64 ) );
     ::memcpy( &nanoseconds, m_buf + sizeof( comma::int64 ), sizeof( comma::int32 ) );
-    m_timestamp = boost::posix_time::ptime( snark::timing::epoch, boost::posix_time::seconds( static_cast< long >( seconds ) ) + boost::posix_time::microseconds( nanoseconds / 1000 ) );
-    comma::uint32 scan = velodyne::thin::deserialize( m_packet, m_buf + timeSize );
+    m_nanoseconds = velodyne::to_nanoseconds( seconds, nanoseconds );
+    comma::uint32 scan = v2 ? velodyne::thin::v2::deserialize( m_packet, m_buf + timeSize ) : velodyne::thin::deserialize( m_packet, m_buf + timeSize );
     is_new_scan_ = is_new_scan_ || !last_scan_ || *last_scan_ != scan; // quick and dirty; keep it set until we clear it in is_new_scan()
     last_scan_ = scan;
     return reinterpret_cast< char* >( &m_packet );
@@ -63,7 +83,17 @@ const char* thin_reader::read()
 
 void thin_reader::close() {}
 
-boost::posix_time::ptime thin_reader::timestamp() const { return m_timestamp; }
+void thin_reader::seek_offset( comma::uint64 offset )
+{
+    m_istream.clear();
+    m_istream.seekg( offset );
+    if( !m_istream.good() ) { COMMA_THROW( comma::exception, "failed to seek offset " << offset << "; stream not seekable?" ); }
+    m_next = offset;
+    last_scan_.reset();
+    is_new_scan_ = true;
+}
+
+boost::posix_time::ptime thin_reader::timestamp() const { return velodyne::to_ptime( m_nanoseconds ); }
 
 bool thin_reader::is_new_scan()
 {
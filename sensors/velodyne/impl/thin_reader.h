@@ -34,34 +34,59 @@
 #ifndef WIN32
 #include <stdlib.h>
 #endif
+#include <fstream>
+#include <iostream>
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <snark/sensors/velodyne/thin/thin.h>
+#include <snark/sensors/velodyne/thin/v2.h>
 #include <snark/timing/time.h>
 
 namespace snark {
 
-/// reader for thinned velodyne data
+/// reader for thinned velodyne data, v1 and v2 records can be mixed in the same stream
 class thin_reader : public boost::noncopyable
 {
     public:
+        /// constructor, read from stdin
         thin_reader();
 
+        /// constructor, read from file
+        thin_reader( const std::string& filename );
+
+        /// constructor, read from given stream, e.g. from memory
+        thin_reader( std::istream& is );
+
         const char* read();
 
         void close();
 
         boost::posix_time::ptime timestamp() const;
 
+        /// return current timestamp, nanoseconds from epoch
+        comma::int64 nanoseconds() const { return m_nanoseconds; }
+
         bool is_new_scan(); // quick and dirty
 
+        /// return offset of the current record in the stream
+        comma::uint64 position() const { return m_position; }
+
+        /// position stream at the record at given offset; only for seekable streams, e.g. files
+        void seek_offset( comma::uint64 offset );
+
     private:
         enum { timeSize = 12 };
-        char m_buf[ velodyne::thin::maxBufferSize + timeSize ];
+        enum { bufferSize = ( int( velodyne::thin::maxBufferSize ) > int( velodyne::thin::v2::maxBufferSize ) ? int( velodyne::thin::maxBufferSize ) : int( velodyne::thin::v2::maxBufferSize ) ) + timeSize };
+        boost::scoped_ptr< std::ifstream > m_ifstream;
+        std::istream& m_istream;
+        char m_buf[ bufferSize ];
         velodyne::packet m_packet;
-        boost::posix_time::ptime m_timestamp;
+        comma::int64 m_nanoseconds;
         boost::optional< comma::uint32 > last_scan_;
         bool is_new_scan_;
+        comma::uint64 m_position;
+        comma::uint64 m_next;
 };
 
 }
@@ -29,12 +29,14 @@
 
 
 #include <comma/base/exception.h>
+#include <snark/sensors/velodyne/time.h>
 #include "./udp_reader.h"
 
 namespace snark { 
 
 udp_reader::udp_reader( unsigned short port )
     : socket_( service_ )
+    , nanoseconds_( 0 )
 {
     socket_.open( boost::asio::ip::udp::v4() );
     boost::system::error_code error;
@@ -53,11 +55,14 @@ const char* udp_reader::read()
     std::size_t size = socket_.receive( boost::asio::buffer( packet_ ), 0, error );
     if( error || size == 0 ) { return NULL; }
     timestamp_ = boost::posix_time::microsec_clock::universal_time();
+    nanoseconds_ = velodyne::to_nanoseconds( timestamp_ );
     return &packet_[0];
 }
 
 void udp_reader::close() { socket_.close(); }
 
+void udp_reader::shutdown() { boost::system::error_code error; socket_.shutdown( boost::asio::ip::udp::socket::shutdown_both, error ); } // error on unconnected udp socket is expected
+
 const boost::posix_time::ptime& udp_reader::timestamp() const { return timestamp_; }
 
 } // namespace snark {
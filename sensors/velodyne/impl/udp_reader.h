@@ -38,6 +38,7 @@
 #include <boost/asio/ip/udp.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/noncopyable.hpp>
+#include <comma/base/types.h>
 
 namespace snark { 
 
@@ -54,14 +55,22 @@ class udp_reader : public boost::noncopyable
         /// close
         void close();
 
+        /// unblock read() waiting in another thread, after which read() returns NULL
+        /// the socket stays open, close it once the reading thread is done
+        void shutdown();
+
         /// return current timestamp
         const boost::posix_time::ptime& timestamp() const;
 
+        /// return current timestamp, nanoseconds from epoch
+        comma::int64 nanoseconds() const { return nanoseconds_; }
+
     private:
         boost::asio::io_service service_;
         boost::asio::ip::udp::socket socket_;
         boost::array< char, 2000 > packet_; // way greater than velodyne packet
         boost::posix_time::ptime timestamp_;
+        comma::int64 nanoseconds_;
 };
 
 } // namespace snark {
@@ -34,6 +34,9 @@
 #ifndef WIN32
 #include <stdlib.h>
 #endif
+#include <boost/scoped_ptr.hpp>
+#include <snark/sensors/velodyne/packet_decoder.h>
+#include <snark/sensors/velodyne/scan_index.h>
 #include <snark/sensors/velodyne/stream.h>
 #include <snark/visiting/eigen.h>
 
@@ -42,7 +45,7 @@ namespace snark {
 /// processed velodyne point    
 struct velodyne_point
 {
-    boost::posix_time::ptime timestamp;
+    comma::int64 timestamp; // nanoseconds from epoch, visited as ptime
     comma::uint32 id;
     comma::uint32 intensity;
     std::pair< ::Eigen::Vector3d, ::Eigen::Vector3d > ray;
@@ -52,6 +55,33 @@ struct velodyne_point
     comma::uint32 scan;
 };
 
+/// convert laser return into velodyne point
+inline void to_velodyne_point( const velodyne::db& db, const velodyne::laser_return& r, comma::uint32 scan, velodyne_point& point )
+{
+    point.timestamp = r.timestamp;
+    point.id = r.id;
+    point.intensity = r.intensity;
+    point.valid = !comma::math::equal( r.range, 0 ); // quick and dirty
+    point.ray = db.lasers[ point.id ].ray( r.range, r.azimuth );
+    point.range = db.lasers[ point.id ].range( r.range );
+    point.scan = scan;
+    point.azimuth = db.lasers[ point.id ].azimuth( r.azimuth );
+}
+
+/// convert return of decoded packet into velodyne point
+inline void to_velodyne_point( const velodyne::decoded_packet& p, std::size_t i, velodyne_point& point )
+{
+    point.timestamp = p.t[i];
+    point.id = p.id[i];
+    point.intensity = p.intensity[i];
+    point.valid = p.valid[i];
+    point.ray.first = ::Eigen::Vector3d( p.origin_x[i], p.origin_y[i], p.origin_z[i] );
+    point.ray.second = ::Eigen::Vector3d( p.x[i], p.y[i], p.z[i] );
+    point.range = p.range[i];
+    point.scan = p.scan;
+    point.azimuth = p.azimuth[i];
+}
+
 /// convert stream of raw velodyne data into velodyne points
 template < typename S >
 class velodyne_stream
@@ -70,11 +100,50 @@ public:
     bool read();
     const velodyne_point& point() const { return m_point; }
 
+    /// read and decode whole packet at once; do not mix with read()
+    /// the decoder and its buffer are created on the first call
+    const velodyne::decoded_packet* read_packet();
+
+    /// read raw packet within the scan range, e.g. to decode it elsewhere; do not mix with read()
+    /// @return NULL if end of stream is reached
+    const velodyne::packet* read_raw_packet();
+
+    /// return timestamp of the current packet
+    boost::posix_time::ptime timestamp() const { return m_stream.timestamp(); }
+
+    /// return timestamp of the current packet, nanoseconds from epoch
+    comma::int64 nanoseconds() const { return m_stream.nanoseconds(); }
+
+    /// return angular speed for the current packet
+    double angular_speed() { return m_stream.angular_speed(); }
+
+    /// return current scan number
+    unsigned int scan() const { return m_stream.scan(); }
+
+    /// return velodyne calibration
+    const velodyne::db& db() const { return m_db; }
+
+    /// return underlying reader, e.g. to get its statistics
+    S& reader() { return m_stream.reader(); }
+
+    /// set filter on raw fields of laser returns, applied before conversion
+    void filter( const velodyne::return_filter& f ) { m_stream.filter( f ); }
+
+    /// return filter
+    const velodyne::return_filter& filter() const { return m_stream.filter(); }
+
+    /// position stream at the first packet of the scan, e.g. from scan index
+    /// reader S must support seek_offset()
+    void seek( const velodyne::scan_index::entry& e ) { m_stream.reader().seek_offset( e.offset ); m_stream.reset_scan( e.scan ); }
+
 private:
     velodyne::stream< S > m_stream;
     velodyne::db m_db;
     velodyne_point m_point;
     boost::optional< std::size_t > m_to;
+    bool m_output_invalid;
+    boost::scoped_ptr< velodyne::packet_decoder > m_decoder;
+    boost::scoped_ptr< velodyne::decoded_packet > m_packet;
 };
 
 template < typename S >
@@ -83,7 +152,8 @@ velodyne_stream< S >::velodyne_stream ( const velodyne::db& db, bool outputInval
                     , boost::optional< std::size_t > to ):
     m_stream( new S, outputInvalidpoints ),
     m_db( db ),
-    m_to( to )
+    m_to( to ),
+    m_output_invalid( outputInvalidpoints )
 {
     if( from ) { while( m_stream.scan() < *from ) { m_stream.skip_scan(); } }
 }
@@ -95,7 +165,8 @@ velodyne_stream< S >::velodyne_stream ( const P& p, const velodyne::db& db, bool
                     , boost::optional< std::size_t > to ):
     m_stream( new S( p ), outputInvalidpoints ),
     m_db( db ),
-    m_to( to )
+    m_to( to ),
+    m_output_invalid( outputInvalidpoints )
 {
     if( from ) { while( m_stream.scan() < *from ) { m_stream.skip_scan(); } }
 }
@@ -107,18 +178,34 @@ bool velodyne_stream< S >::read()
 {
     if( m_to && m_stream.scan() > *m_to ) { return false; }
     const velodyne::laser_return* r = m_stream.read();
-    if( r == NULL ) { return false; }
-    m_point.timestamp = r->timestamp;
-    m_point.id = r->id;
-    m_point.intensity = r->intensity;
-    m_point.valid = !comma::math::equal( r->range, 0 ); // quick and dirty
-    m_point.ray = m_db.lasers[ m_point.id ].ray( r->range, r->azimuth );
-    m_point.range = m_db.lasers[ m_point.id ].range( r->range );
-    m_point.scan = m_stream.scan();
-    m_point.azimuth = m_db.lasers[ m_point.id ].azimuth( r->azimuth );
+    if( r == NULL || ( m_to && m_stream.scan() > *m_to ) ) { return false; }
+    to_velodyne_point( m_db, *r, m_stream.scan(), m_point );
     return true;
 }
 
+/// read next raw packet in the scan range
+/// @return NULL if end of stream is reached
+template < typename S >
+const velodyne::packet* velodyne_stream< S >::read_raw_packet()
+{
+    if( m_to && m_stream.scan() > *m_to ) { return NULL; }
+    const velodyne::packet* p = m_stream.read_packet();
+    return p == NULL || ( m_to && m_stream.scan() > *m_to ) ? NULL : p;
+}
+
+/// read and convert all returns of the next packet
+/// @return NULL if end of stream is reached
+template < typename S >
+const velodyne::decoded_packet* velodyne_stream< S >::read_packet()
+{
+    const velodyne::packet* p = read_raw_packet();
+    if( p == NULL ) { return NULL; }
+    if( !m_decoder ) { m_decoder.reset( new velodyne::packet_decoder( m_db ) ); m_packet.reset( new velodyne::decoded_packet ); }
+    m_decoder->decode( *p, m_stream.nanoseconds(), m_stream.angular_speed(), m_output_invalid, *m_packet, &m_stream.filter() );
+    m_packet->scan = m_stream.scan();
+    return m_packet.get();
+}
+
 /// specialisation for csv input stream: in this case nothing to convert
 template <>
 class velodyne_stream< comma::csv::input_stream< velodyne_point> >
@@ -158,7 +245,9 @@ template <> struct traits< snark::velodyne_point >
 {    
     template < typename K, typename V > static void visit( const K&, snark::velodyne_point& p, V& v )
     {
-        v.apply( "t", p.timestamp );
+        boost::posix_time::ptime timestamp = snark::velodyne::to_ptime( p.timestamp );
+        v.apply( "t", timestamp );
+        p.timestamp = snark::velodyne::to_nanoseconds( timestamp );
         v.apply( "id", p.id );
         v.apply( "intensity", p.intensity );
         v.apply( "ray", p.ray );
@@ -170,7 +259,7 @@ template <> struct traits< snark::velodyne_point >
     
     template < typename K, typename V > static void visit( const K&, const snark::velodyne_point& p, V& v )
     {
-        v.apply( "t", p.timestamp );
+        v.apply( "t", snark::velodyne::to_ptime( p.timestamp ) );
         v.apply( "id", p.id );
         v.apply( "intensity", p.intensity );
         v.apply( "ray", p.ray );
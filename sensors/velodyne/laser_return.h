@@ -34,14 +34,15 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <comma/base/types.h>
 #include <comma/visiting/traits.h>
+#include <snark/sensors/velodyne/time.h>
 
 namespace snark { namespace velodyne {
 
 /// velodyne point corresponding to a single laser return
 struct laser_return
 {
-    /// timestamp
-    boost::posix_time::ptime timestamp;
+    /// timestamp, nanoseconds from epoch (see time.h); visited as ptime
+    comma::int64 timestamp;
     
     /// laser id
     comma::uint32 id;
@@ -65,7 +66,9 @@ template <> struct traits< snark::velodyne::laser_return >
     template < typename Key, class Visitor >
     static void visit( Key k, snark::velodyne::laser_return& t, Visitor& v )
     {
-        v.apply( "t", t.timestamp );
+        boost::posix_time::ptime timestamp = snark::velodyne::to_ptime( t.timestamp );
+        v.apply( "t", timestamp );
+        t.timestamp = snark::velodyne::to_nanoseconds( timestamp );
         v.apply( "id", t.id );
         v.apply( "intensity", t.intensity );
         v.apply( "range", t.range );
@@ -75,7 +78,7 @@ template <> struct traits< snark::velodyne::laser_return >
     template < typename Key, class Visitor >
     static void visit( Key k, const snark::velodyne::laser_return& t, Visitor& v )
     {
-        v.apply( "t", t.timestamp );
+        v.apply( "t", snark::velodyne::to_ptime( t.timestamp ) );
         v.apply( "id", t.id );
         v.apply( "intensity", t.intensity );
         v.apply( "range", t.range );
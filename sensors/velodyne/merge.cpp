@@ -0,0 +1,116 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/merge.h>
+
+namespace snark {  namespace velodyne {
+
+merge::merge( unsigned int size ) : sources_( size )
+{
+    heap_.reserve( size );
+    waiting_.reserve( size );
+    for( unsigned int i = 0; i < size; ++i ) { waiting_.push_back( i ); }
+}
+
+boost::optional< unsigned int > merge::waiting() const { return waiting_.empty() ? boost::optional< unsigned int >() : boost::optional< unsigned int >( waiting_.back() ); }
+
+void merge::push( unsigned int source, const comma::int64* timestamps, std::size_t size )
+{
+    if( source >= sources_.size() ) { COMMA_THROW( comma::exception, "expected source less than " << sources_.size() << "; got " << source ); }
+    if( !sources_[source].waiting ) { COMMA_THROW( comma::exception, "source " << source << " still has points to merge" ); }
+    if( size == 0 ) { return; }
+    sources_[source].timestamps = timestamps;
+    sources_[source].size = size;
+    sources_[source].waiting = false;
+    std::vector< unsigned int >::iterator it = std::find( waiting_.begin(), waiting_.end(), source );
+    if( it != waiting_.end() ) { waiting_.erase( it ); }
+    entry e;
+    e.t = timestamps[0];
+    e.source = source;
+    e.index = 0;
+    heap_.push_back( e );
+    sift_up_( heap_.size() - 1 );
+}
+
+void merge::close( unsigned int source )
+{
+    std::vector< unsigned int >::iterator it = std::find( waiting_.begin(), waiting_.end(), source );
+    if( it != waiting_.end() ) { waiting_.erase( it ); }
+}
+
+void merge::pop()
+{
+    entry& e = heap_[0];
+    const source& s = sources_[ e.source ];
+    if( ++e.index < s.size ) // fast path: same packet, replace top and sift it down
+    {
+        e.t = s.timestamps[ e.index ];
+        sift_down_( 0 );
+        return;
+    }
+    sources_[ e.source ].waiting = true;
+    waiting_.push_back( e.source );
+    heap_[0] = heap_.back();
+    heap_.pop_back();
+    if( !heap_.empty() ) { sift_down_( 0 ); }
+}
+
+void merge::sift_up_( std::size_t i )
+{
+    entry e = heap_[i];
+    while( i > 0 )
+    {
+        std::size_t parent = ( i - 1 ) / 2;
+        if( !less_( e, heap_[parent] ) ) { break; }
+        heap_[i] = heap_[parent];
+        i = parent;
+    }
+    heap_[i] = e;
+}
+
+void merge::sift_down_( std::size_t i )
+{
+    entry e = heap_[i];
+    std::size_t size = heap_.size();
+    while( true )
+    {
+        std::size_t child = i * 2 + 1;
+        if( child >= size ) { break; }
+        if( child + 1 < size && less_( heap_[ child + 1 ], heap_[child] ) ) { ++child; }
+        if( !less_( heap_[child], e ) ) { break; }
+        heap_[i] = heap_[child];
+        i = child;
+    }
+    heap_[i] = e;
+}
+
+} } // namespace snark {  namespace velodyne {
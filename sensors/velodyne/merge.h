@@ -0,0 +1,114 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_MERGE_H_
+#define SNARK_SENSORS_VELODYNE_MERGE_H_
+
+#include <cstddef>
+#include <vector>
+#include <boost/optional.hpp>
+#include <comma/base/types.h>
+
+namespace snark {  namespace velodyne {
+
+/// k-way merge of several time-ordered sources delivered in packets, e.g. points of several velodynes
+///
+/// the merge holds at most one packet per source: it only looks at the timestamps
+/// of the current packets and keeps a heap of one entry per source, thus its memory
+/// is fixed; the caller owns the packets and decides how long to wait for a source
+///
+/// usage:
+///     while( true )
+///     {
+///         while( merge.waiting() ) { get next packet of source *merge.waiting(); push() it or close() the source }
+///         if( merge.empty() ) { break; }
+///         output point merge.top().index of packet of source merge.top().source
+///         merge.pop();
+///     }
+class merge
+{
+    public:
+        /// current point of a source
+        struct entry
+        {
+            comma::int64 t;
+            unsigned int source;
+            std::size_t index;
+        };
+
+        /// constructor
+        /// @param size number of sources
+        merge( unsigned int size );
+
+        /// set next packet of a source, which must be waiting, as returned by waiting()
+        /// a closed source can be pushed again, e.g. if it was stalled
+        /// @param timestamps timestamps of the packet points, must remain valid until the source is waiting again
+        /// @param size number of points in packet; pushing an empty packet leaves the source waiting
+        void push( unsigned int source, const comma::int64* timestamps, std::size_t size );
+
+        /// do not wait for source any longer, e.g. if it has ended
+        void close( unsigned int source );
+
+        /// return source, the next packet of which is needed before merge can proceed
+        /// once the last point of a packet has been popped, its source is waiting,
+        /// and the caller can reuse the packet
+        boost::optional< unsigned int > waiting() const;
+
+        /// return true, if all packets pushed so far have been merged
+        bool empty() const { return heap_.empty(); }
+
+        /// return earliest point
+        const entry& top() const { return heap_[0]; }
+
+        /// remove earliest point
+        void pop();
+
+        /// return number of sources
+        unsigned int size() const { return sources_.size(); }
+
+    private:
+        struct source
+        {
+            const comma::int64* timestamps;
+            std::size_t size;
+            bool waiting;
+            source() : timestamps( NULL ), size( 0 ), waiting( true ) {}
+        };
+        std::vector< source > sources_;
+        std::vector< entry > heap_;
+        std::vector< unsigned int > waiting_;
+        void sift_up_( std::size_t i );
+        void sift_down_( std::size_t i );
+        static bool less_( const entry& lhs, const entry& rhs ) { return lhs.t < rhs.t || ( lhs.t == rhs.t && lhs.source < rhs.source ); }
+};
+
+} } // namespace snark {  namespace velodyne {
+
+#endif // SNARK_SENSORS_VELODYNE_MERGE_H_
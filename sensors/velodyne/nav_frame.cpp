@@ -0,0 +1,118 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <comma/base/exception.h>
+#include <snark/math/rotation_matrix.h>
+#include "./nav_frame.h"
+
+namespace snark {  namespace velodyne {
+
+nav_frame::transform::transform( const pose& p )
+    : rotation( rotation_matrix::rotation( p.orientation ) )
+    , translation( p.coordinates )
+{
+}
+
+nav_frame::transform nav_frame::transform::operator*( const transform& rhs ) const
+{
+    transform t;
+    t.rotation = rotation * rhs.rotation;
+    t.translation = rotation * rhs.translation + translation;
+    return t;
+}
+
+static comma::csv::options nav_csv( const comma::csv::options& csv )
+{
+    comma::csv::options c = csv;
+    if( c.fields.empty() )
+    {
+        c.fields = "t,x,y,z,roll,pitch,yaw";
+        if( c.binary() ) { c.format( "t,6d" ); }
+    }
+    c.full_xpath = false;
+    return c;
+}
+
+nav_frame::nav_frame( std::istream& is, const comma::csv::options& csv, bool interpolate, boost::optional< boost::posix_time::time_duration > max_gap )
+    : istream_( new comma::csv::input_stream< nav_type >( is, nav_csv( csv ) ) )
+    , interpolate_( interpolate )
+    , max_gap_( max_gap )
+    , eof_( false )
+{
+    if( !read_() ) { COMMA_THROW( comma::exception, "failed to read nav" ); }
+    first_ = second_;
+    read_();
+}
+
+bool nav_frame::read_()
+{
+    const nav_type* p = istream_->read();
+    if( p == NULL ) { eof_ = true; return false; }
+    if( !second_.t.is_not_a_date_time() && p->t < second_.t ) { COMMA_THROW( comma::exception, "expected nav timestamps in ascending order, got " << boost::posix_time::to_iso_string( p->t ) << " after " << boost::posix_time::to_iso_string( second_.t ) ); }
+    second_ = *p;
+    return true;
+}
+
+static double angle_difference( double a, double b ) // quick and dirty: shortest way from a to b, so that yaw interpolates correctly across +-pi
+{
+    double d = std::fmod( b - a, 2 * M_PI );
+    if( d > M_PI ) { d -= 2 * M_PI; } else if( d < -M_PI ) { d += 2 * M_PI; }
+    return d;
+}
+
+bool nav_frame::at( const boost::posix_time::ptime& t, transform& tr )
+{
+    if( t.is_special() || t < first_.t ) { return false; }
+    while( t > second_.t )
+    {
+        if( eof_ ) { return false; }
+        first_ = second_;
+        if( !read_() ) { return false; }
+    }
+    boost::posix_time::time_duration span = second_.t - first_.t;
+    if( max_gap_ && span > *max_gap_ ) { return false; }
+    pose p;
+    if( span.total_microseconds() == 0 ) { p = second_.value; }
+    else
+    {
+        double factor = double( ( t - first_.t ).total_microseconds() ) / span.total_microseconds();
+        if( !interpolate_ ) { p = factor < 0.5 ? first_.value : second_.value; }
+        else
+        {
+            p.coordinates = first_.value.coordinates * ( 1 - factor ) + second_.value.coordinates * factor;
+            for( unsigned int i = 0; i < 3; ++i ) { p.orientation[i] = first_.value.orientation[i] + angle_difference( first_.value.orientation[i], second_.value.orientation[i] ) * factor; }
+        }
+    }
+    tr = transform( p ) * sensor_;
+    return true;
+}
+
+} } // namespace snark {  namespace velodyne {
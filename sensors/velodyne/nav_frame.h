@@ -0,0 +1,158 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_NAV_FRAME_H_
+#define SNARK_SENSORS_VELODYNE_NAV_FRAME_H_
+
+#include <iostream>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <Eigen/Core>
+#include <comma/csv/options.h>
+#include <comma/csv/stream.h>
+#include <comma/visiting/traits.h>
+
+namespace snark {  namespace velodyne {
+
+/// sensor poses in the world frame from a timestamped nav stream, e.g. as used by points-frame --from
+///
+/// nav is read forward only, thus queries must come in non-decreasing time order;
+/// a velodyne packet needs a pose per firing block rather than per return (6 per packet),
+/// so interpolating once per block is enough to de-skew a scan at full rate
+class nav_frame
+{
+    public:
+        /// pose as coordinates and orientation as roll, pitch, yaw; csv fields: x,y,z,roll,pitch,yaw
+        struct pose
+        {
+            Eigen::Vector3d coordinates;
+            Eigen::Vector3d orientation;
+
+            pose() : coordinates( Eigen::Vector3d::Zero() ), orientation( Eigen::Vector3d::Zero() ) {}
+            pose( const Eigen::Vector3d& c, const Eigen::Vector3d& o = Eigen::Vector3d::Zero() ) : coordinates( c ), orientation( o ) {}
+        };
+
+        /// nav record; csv fields: t,x,y,z,roll,pitch,yaw
+        struct nav_type
+        {
+            boost::posix_time::ptime t;
+            pose value;
+        };
+
+        /// rigid transform as rotation and translation
+        /// (not Eigen::Affine3d to keep it free of alignment requirements in std containers)
+        struct transform
+        {
+            Eigen::Matrix3d rotation;
+            Eigen::Vector3d translation;
+
+            transform() : rotation( Eigen::Matrix3d::Identity() ), translation( Eigen::Vector3d::Zero() ) {}
+            transform( const pose& p );
+
+            Eigen::Vector3d operator*( const Eigen::Vector3d& v ) const { return rotation * v + translation; }
+            transform operator*( const transform& rhs ) const;
+        };
+
+        /// @param csv nav stream options, fields default to t,x,y,z,roll,pitch,yaw
+        /// @param interpolate if false, take nearest nav record
+        /// @param max_gap do not interpolate between nav records further apart
+        nav_frame( std::istream& is
+                 , const comma::csv::options& csv
+                 , bool interpolate = true
+                 , boost::optional< boost::posix_time::time_duration > max_gap = boost::optional< boost::posix_time::time_duration >() );
+
+        /// set sensor pose in the nav body frame; default: identity
+        void sensor( const pose& p ) { sensor_ = transform( p ); }
+
+        /// get transform from sensor frame to world frame at given time
+        /// @return false, if no pose for given time: before the first nav record,
+        ///         after the last one, across a gap longer than max_gap, or earlier than already passed nav records
+        bool at( const boost::posix_time::ptime& t, transform& tr );
+
+        /// true if nav stream has ended
+        bool eof() const { return eof_; }
+
+    private:
+        boost::scoped_ptr< comma::csv::input_stream< nav_type > > istream_;
+        bool interpolate_;
+        boost::optional< boost::posix_time::time_duration > max_gap_;
+        transform sensor_;
+        nav_type first_;
+        nav_type second_;
+        bool eof_;
+        bool read_();
+};
+
+} } // namespace snark {  namespace velodyne {
+
+namespace comma { namespace visiting {
+
+template <> struct traits< snark::velodyne::nav_frame::pose >
+{
+    template < typename Key, class Visitor > static void visit( const Key&, snark::velodyne::nav_frame::pose& p, Visitor& v )
+    {
+        v.apply( "x", p.coordinates.x() );
+        v.apply( "y", p.coordinates.y() );
+        v.apply( "z", p.coordinates.z() );
+        v.apply( "roll", p.orientation.x() );
+        v.apply( "pitch", p.orientation.y() );
+        v.apply( "yaw", p.orientation.z() );
+    }
+
+    template < typename Key, class Visitor > static void visit( const Key&, const snark::velodyne::nav_frame::pose& p, Visitor& v )
+    {
+        v.apply( "x", p.coordinates.x() );
+        v.apply( "y", p.coordinates.y() );
+        v.apply( "z", p.coordinates.z() );
+        v.apply( "roll", p.orientation.x() );
+        v.apply( "pitch", p.orientation.y() );
+        v.apply( "yaw", p.orientation.z() );
+    }
+};
+
+template <> struct traits< snark::velodyne::nav_frame::nav_type >
+{
+    template < typename Key, class Visitor > static void visit( const Key&, snark::velodyne::nav_frame::nav_type& p, Visitor& v )
+    {
+        v.apply( "t", p.t );
+        v.apply( "value", p.value );
+    }
+
+    template < typename Key, class Visitor > static void visit( const Key&, const snark::velodyne::nav_frame::nav_type& p, Visitor& v )
+    {
+        v.apply( "t", p.t );
+        v.apply( "value", p.value );
+    }
+};
+
+} } // namespace comma { namespace visiting {
+
+#endif // SNARK_SENSORS_VELODYNE_NAV_FRAME_H_
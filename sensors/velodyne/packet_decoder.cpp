@@ -0,0 +1,165 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <comma/math/compare.h>
+#include <snark/sensors/velodyne/packet_decoder.h>
+#include <snark/sensors/velodyne/impl/angle.h>
+#include <snark/sensors/velodyne/impl/get_laser_return.h>
+#include <snark/sensors/velodyne/time.h>
+
+namespace snark {  namespace velodyne {
+
+packet_decoder::packet_decoder( const db& db ) : angular_speed_( 0 )
+{
+    for( unsigned int i = 0; i < 64; ++i )
+    {
+        const db::laser_data& laser = db.lasers[i];
+        lasers_.rotational[i] = laser.correction_angles.rotational.value;
+        lasers_.horizontal_offset[i] = laser.horizontal_offset;
+        lasers_.vertical_offset_xy[i] = laser.vertical_offset * laser.correction_angles.vertical.sin;
+        lasers_.vertical_offset_z[i] = laser.vertical_offset * laser.correction_angles.vertical.cos;
+        lasers_.distance_correction[i] = laser.distance_correction;
+        lasers_.vertical_sin[i] = laser.correction_angles.vertical.sin;
+        lasers_.vertical_cos[i] = laser.correction_angles.vertical.cos;
+    }
+    for( unsigned int block = 0; block < 12; ++block )
+    {
+        for( unsigned int laser = 0; laser < 32; ++laser )
+        {
+            time_offsets_[ block * 32 + laser ] = impl::time_offset_nanoseconds( block, laser );
+        }
+    }
+    update_( 0 );
+}
+
+void packet_decoder::update_( double angular_speed )
+{
+    angular_speed_ = angular_speed;
+    double step = impl::firing_step();
+    for( unsigned int laser = 0; laser < 32; ++laser ) { azimuth_offsets_[laser] = angular_speed * step * laser; }
+    for( unsigned int i = 0; i < 64; ++i )
+    {
+        double a = ( azimuth_offsets_[ i % 32 ] + lasers_.rotational[i] ) * M_PI / 180;
+        sin_[i] = std::sin( a );
+        cos_[i] = std::cos( a );
+    }
+}
+
+std::size_t packet_decoder::decode( const packet& packet
+                                  , const boost::posix_time::ptime& timestamp
+                                  , double angular_speed
+                                  , bool output_invalid
+                                  , decoded_packet& decoded
+                                  , const return_filter* filter )
+{
+    return decode( packet, to_nanoseconds( timestamp ), angular_speed, output_invalid, decoded, filter );
+}
+
+std::size_t packet_decoder::decode( const packet& packet
+                                  , comma::int64 t
+                                  , double angular_speed
+                                  , bool output_invalid
+                                  , decoded_packet& decoded
+                                  , const return_filter* filter )
+{
+    if( filter && filter->all() ) { filter = NULL; }
+    bool compact = filter || !output_invalid;
+    if( !comma::math::equal( angular_speed, angular_speed_ ) ) { update_( angular_speed ); } // with fixed rpm, tables get computed once
+    for( unsigned int block = 0; block < 12; ++block )
+    {
+        const packet::laser_block& b = packet.blocks[block];
+        unsigned int rotation = b.rotation();
+        double degrees = double( rotation ) / 100;
+        double sin_rotation = impl::angle::sin( rotation + 9000 ); // add 90 degrees for our system of coordinates
+        double cos_rotation = impl::angle::cos( rotation + 9000 );
+        unsigned int lower = block & 0x1;
+        unsigned int first_id = lower ? 32 : 0;
+        std::size_t index = ( block >> 1 ) * 64 + lower; // upper and lower returns interleaved, as in stream::read()
+        const comma::int64* offsets = &time_offsets_[ block * 32 ];
+        for( unsigned int laser = 0; laser < 32; ++laser, index += 2 )
+        {
+            unsigned int id = first_id + laser;
+            keep_[index] = ( output_invalid || b.lasers[laser].range() != 0 ) && ( !filter || ( *filter )( id, b.lasers[laser].range(), rotation, b.lasers[laser].intensity() ) );
+            if( !keep_[index] ) { continue; } // rejected returns get compacted out below, no need to compute their geometry
+            double raw = double( b.lasers[laser].range() ) / 500;
+            double distance = raw + lasers_.distance_correction[id];
+            double a = degrees + azimuth_offsets_[laser] + 90; // same as impl::azimuth()
+            if( comma::math::less( a, 360 ) ) { if( comma::math::less( a, 0 ) ) { a += 360; } }
+            else { a -= 360; }
+            a += lasers_.rotational[id]; // same as db::laser_data::azimuth()
+            if( a > 360 ) { a -= 360; } else if( a < 0 ) { a += 360; }
+            double c = cos_rotation * cos_[id] - sin_rotation * sin_[id];
+            double s = sin_rotation * cos_[id] + cos_rotation * sin_[id];
+            double xy = distance * lasers_.vertical_cos[id];
+            decoded.t[index] = t + offsets[laser];
+            decoded.id[index] = id;
+            decoded.intensity[index] = b.lasers[laser].intensity();
+            decoded.range[index] = distance;
+            decoded.azimuth[index] = a;
+            decoded.origin_x[index] = -lasers_.horizontal_offset[id] * s - lasers_.vertical_offset_xy[id] * c; // same as db::laser_data::ray()
+            decoded.origin_y[index] = lasers_.horizontal_offset[id] * c - lasers_.vertical_offset_xy[id] * s;
+            decoded.origin_z[index] = lasers_.vertical_offset_z[id];
+            decoded.x[index] = xy * c + decoded.origin_x[index];
+            decoded.y[index] = xy * s + decoded.origin_y[index];
+            decoded.z[index] = distance * lasers_.vertical_sin[id] + decoded.origin_z[index];
+            decoded.valid[index] = b.lasers[laser].range() != 0;
+            decoded.block[index] = block;
+        }
+    }
+    decoded.size = decoded_packet::capacity;
+    if( !compact ) { return decoded.size; }
+    std::size_t size = 0;
+    for( std::size_t i = 0; i < decoded_packet::capacity; ++i )
+    {
+        if( !keep_[i] ) { continue; }
+        if( size < i )
+        {
+            decoded.t[size] = decoded.t[i];
+            decoded.id[size] = decoded.id[i];
+            decoded.intensity[size] = decoded.intensity[i];
+            decoded.range[size] = decoded.range[i];
+            decoded.azimuth[size] = decoded.azimuth[i];
+            decoded.origin_x[size] = decoded.origin_x[i];
+            decoded.origin_y[size] = decoded.origin_y[i];
+            decoded.origin_z[size] = decoded.origin_z[i];
+            decoded.x[size] = decoded.x[i];
+            decoded.y[size] = decoded.y[i];
+            decoded.z[size] = decoded.z[i];
+            decoded.valid[size] = decoded.valid[i];
+            decoded.block[size] = decoded.block[i];
+        }
+        ++size;
+    }
+    decoded.size = size;
+    return size;
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,148 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_PACKET_DECODER_H_
+#define SNARK_SENSORS_VELODYNE_PACKET_DECODER_H_
+
+#include <boost/array.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <comma/base/types.h>
+#include <snark/sensors/velodyne/db.h>
+#include <snark/sensors/velodyne/packet.h>
+#include <snark/sensors/velodyne/return_filter.h>
+
+namespace snark {  namespace velodyne {
+
+/// all laser returns of a packet decoded at once, as structure of arrays
+/// returns are in the same order as output by stream::read()
+struct decoded_packet
+{
+    enum { capacity = 12 * 32 };
+
+    /// number of returns decoded
+    std::size_t size;
+
+    /// scan number
+    comma::uint32 scan;
+
+    /// timestamp, nanoseconds from epoch
+    boost::array< comma::int64, capacity > t;
+
+    /// laser id
+    boost::array< comma::uint32, capacity > id;
+
+    /// intensity
+    boost::array< comma::uint32, capacity > intensity;
+
+    /// range with distance correction, metres
+    boost::array< double, capacity > range;
+
+    /// azimuth with angle correction, degrees
+    boost::array< double, capacity > azimuth;
+
+    /// coordinates of laser relative to velodyne base, i.e. origin of the ray
+    boost::array< double, capacity > origin_x;
+    boost::array< double, capacity > origin_y;
+    boost::array< double, capacity > origin_z;
+
+    /// coordinates of laser return relative to velodyne base
+    boost::array< double, capacity > x;
+    boost::array< double, capacity > y;
+    boost::array< double, capacity > z;
+
+    /// firing block in the packet, 0 to 11
+    boost::array< comma::uint32, capacity > block;
+
+    /// false, if there is no return
+    boost::array< bool, capacity > valid;
+
+    decoded_packet() : size( 0 ), scan( 0 ) {}
+};
+
+/// decodes whole packet into structure of arrays, using
+/// per-laser correction tables precomputed from db
+/// and the rotation sin/cos lookup table
+///
+/// the saving comes from not calling trigonometric functions per return;
+/// the inner loop is plain scalar code, branching on filtered-out returns,
+/// thus do not expect the compiler to vectorise it
+///
+/// not thread-safe: use one decoder per thread
+class packet_decoder
+{
+    public:
+        /// constructor
+        packet_decoder( const db& db );
+
+        /// decode packet into given buffer
+        /// @param timestamp packet timestamp, nanoseconds from epoch
+        /// @param angular_speed degrees per second
+        /// @param output_invalid if false, returns with zero range are omitted
+        /// @param filter if not NULL, returns rejected by the filter are omitted without computing their geometry
+        /// @return number of returns decoded
+        std::size_t decode( const packet& packet
+                          , comma::int64 timestamp
+                          , double angular_speed
+                          , bool output_invalid
+                          , decoded_packet& decoded
+                          , const return_filter* filter = NULL );
+
+        /// convenience overload, converts timestamp to nanoseconds
+        std::size_t decode( const packet& packet
+                          , const boost::posix_time::ptime& timestamp
+                          , double angular_speed
+                          , bool output_invalid
+                          , decoded_packet& decoded
+                          , const return_filter* filter = NULL );
+
+    private:
+        struct laser_table
+        {
+            boost::array< double, 64 > rotational;
+            boost::array< double, 64 > horizontal_offset;
+            boost::array< double, 64 > vertical_offset_xy; // vertical offset projection onto xy plane
+            boost::array< double, 64 > vertical_offset_z; // vertical offset projection onto z axis
+            boost::array< double, 64 > distance_correction;
+            boost::array< double, 64 > vertical_sin;
+            boost::array< double, 64 > vertical_cos;
+        };
+        laser_table lasers_;
+        boost::array< comma::int64, 12 * 32 > time_offsets_; // nanoseconds
+        double angular_speed_;
+        boost::array< double, 32 > azimuth_offsets_; // depends on angular speed; degrees
+        boost::array< double, 64 > sin_; // sin of azimuth offset plus rotational correction
+        boost::array< double, 64 > cos_; // cos of azimuth offset plus rotational correction
+        boost::array< bool, decoded_packet::capacity > keep_;
+        void update_( double angular_speed );
+};
+
+} } // namespace snark {  namespace velodyne {
+
+#endif // SNARK_SENSORS_VELODYNE_PACKET_DECODER_H_
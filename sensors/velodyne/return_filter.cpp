@@ -0,0 +1,100 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <limits>
+#include <comma/base/exception.h>
+#include "./return_filter.h"
+
+namespace snark {  namespace velodyne {
+
+static const double range_resolution = 0.002; // metres per range unit in packet
+
+return_filter::return_filter()
+    : all_( true )
+    , lasers_( ~comma::uint64( 0 ) )
+    , min_range_( 0 )
+    , max_range_( std::numeric_limits< comma::uint16 >::max() )
+    , begin_( 0 )
+    , end_( 36000 )
+    , min_intensity_( 0 )
+    , max_intensity_( 255 )
+{
+}
+
+return_filter& return_filter::lasers( const std::vector< unsigned int >& ids )
+{
+    lasers_ = 0;
+    for( std::size_t i = 0; i < ids.size(); ++i )
+    {
+        if( ids[i] >= 64 ) { COMMA_THROW( comma::exception, "expected laser id less than 64, got " << ids[i] ); }
+        lasers_ |= comma::uint64( 1 ) << ids[i];
+    }
+    all_ = false;
+    return *this;
+}
+
+static comma::uint16 to_rotation( double azimuth ) // output azimuth has 90 degrees added to rotation, see impl::azimuth()
+{
+    double a = std::fmod( azimuth - 90, 360.0 );
+    if( a < 0 ) { a += 360; }
+    comma::uint16 r = static_cast< comma::uint16 >( a * 100 + 0.5 );
+    return r < 36000 ? r : 0;
+}
+
+return_filter& return_filter::azimuth( double from, double to )
+{
+    begin_ = to_rotation( from );
+    end_ = to_rotation( to );
+    if( begin_ == end_ && from < to ) { begin_ = 0; end_ = 36000; } // full circle
+    all_ = false;
+    return *this;
+}
+
+return_filter& return_filter::range( double min, double max )
+{
+    if( min > max ) { COMMA_THROW( comma::exception, "expected min range not greater than max range, got " << min << "," << max ); }
+    double limit = std::numeric_limits< comma::uint16 >::max();
+    min_range_ = static_cast< comma::uint16 >( std::min( std::max( std::ceil( min / range_resolution ), 0.0 ), limit ) );
+    max_range_ = static_cast< comma::uint16 >( std::min( std::max( std::floor( max / range_resolution ), 0.0 ), limit ) );
+    all_ = false;
+    return *this;
+}
+
+return_filter& return_filter::intensity( unsigned int min, unsigned int max )
+{
+    if( min > max ) { COMMA_THROW( comma::exception, "expected min intensity not greater than max intensity, got " << min << "," << max ); }
+    min_intensity_ = std::min( min, 255u );
+    max_intensity_ = std::min( max, 255u );
+    all_ = false;
+    return *this;
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,98 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_RETURN_FILTER_H_
+#define SNARK_SENSORS_VELODYNE_RETURN_FILTER_H_
+
+#include <vector>
+#include <comma/base/types.h>
+#include <snark/sensors/velodyne/packet.h>
+
+namespace snark {  namespace velodyne {
+
+/// filter on raw fields of laser returns, evaluated before any geometry is computed
+/// rejecting a return costs a few integer comparisons
+class return_filter
+{
+    public:
+        /// constructor, accept all returns
+        return_filter();
+
+        /// accept only given laser ids
+        return_filter& lasers( const std::vector< unsigned int >& ids );
+
+        /// accept only returns with azimuth in [from, to) degrees, cyclic, e.g. 350,10
+        /// azimuth is in the same frame as output by velodyne-to-csv, but without
+        /// per-laser rotational correction, i.e. within a few degrees of output azimuth
+        return_filter& azimuth( double from, double to );
+
+        /// accept only returns with range in [min, max] metres
+        /// range is before per-laser distance correction
+        return_filter& range( double min, double max );
+
+        /// accept only returns with intensity in [min, max]
+        return_filter& intensity( unsigned int min, unsigned int max );
+
+        /// return true, if filter accepts all returns
+        bool all() const { return all_; }
+
+        /// return true, if return with given raw fields passes the filter
+        /// @param id laser id
+        /// @param range range in packet units (2mm)
+        /// @param rotation block rotation in packet units (1/100 degree)
+        bool operator()( unsigned int id, comma::uint16 range, comma::uint16 rotation, unsigned char intensity ) const
+        {
+            if( !( ( lasers_ >> id ) & 1 ) ) { return false; }
+            if( range < min_range_ || range > max_range_ ) { return false; }
+            if( intensity < min_intensity_ || intensity > max_intensity_ ) { return false; }
+            return begin_ <= end_ ? rotation >= begin_ && rotation < end_ : rotation >= begin_ || rotation < end_;
+        }
+
+        /// same as above, for return in packet
+        bool operator()( const packet& p, unsigned int block, unsigned int laser ) const
+        {
+            const packet::laser_return& r = p.blocks[block].lasers[laser];
+            return operator()( laser + ( block & 0x1 ? 32 : 0 ), r.range(), p.blocks[block].rotation(), r.intensity() );
+        }
+
+    private:
+        bool all_;
+        comma::uint64 lasers_;
+        comma::uint16 min_range_;
+        comma::uint16 max_range_;
+        comma::uint16 begin_;
+        comma::uint16 end_;
+        unsigned char min_intensity_;
+        unsigned char max_intensity_;
+};
+
+} } // namespace snark {  namespace velodyne {
+
+#endif // SNARK_SENSORS_VELODYNE_RETURN_FILTER_H_
@@ -0,0 +1,115 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/time.h>
+#include "./scan_image.h"
+
+namespace snark {  namespace velodyne {
+
+scan_image::scan_image( unsigned int rows, unsigned int bins ) : size_( 0 ), t_( 0 )
+{
+    if( rows == 0 || bins == 0 ) { COMMA_THROW( comma::exception, "expected non-zero image size, got " << rows << "x" << bins ); }
+    header_.rows = rows;
+    header_.cols = bins;
+    cells_.resize( rows * bins );
+}
+
+void scan_image::clear( comma::uint32 scan )
+{
+    if( size_ > 0 ) { std::fill( cells_.begin(), cells_.end(), cell() ); }
+    size_ = 0;
+    header_.scan = scan;
+    header_.t = boost::posix_time::ptime();
+}
+
+unsigned int scan_image::column( double azimuth ) const
+{
+    double a = std::fmod( azimuth, 360.0 );
+    if( a < 0 ) { a += 360; }
+    unsigned int c = static_cast< unsigned int >( a * header_.cols / 360 );
+    return c < header_.cols ? c : header_.cols - 1; // quick and dirty: rounding at 360
+}
+
+void scan_image::insert( const decoded_packet& packet, const laser_map& map )
+{
+    for( std::size_t i = 0; i < packet.size; ++i )
+    {
+        if( !packet.valid[i] ) { continue; }
+        if( size_ == 0 )
+        {
+            t_ = packet.t[i];
+            header_.t = to_ptime( t_ );
+        }
+        unsigned int row = map[ packet.id[i] ];
+        if( row >= header_.rows ) { continue; }
+        cell& c = cells_[ row * header_.cols + column( packet.azimuth[i] ) ];
+        if( c.range == 0 ) { ++size_; }
+        else if( c.range <= packet.range[i] ) { continue; }
+        c.range = packet.range[i];
+        c.intensity = packet.intensity[i];
+        c.x = packet.x[i];
+        c.y = packet.y[i];
+        c.z = packet.z[i];
+        c.t = float( packet.t[i] - t_ ) / 1e9f;
+    }
+}
+
+scan_assembler::scan_assembler( const db& db, unsigned int bins )
+    : map_( db )
+    , current_( 0 )
+    , started_( false )
+{
+    images_[0] = scan_image( 64, bins );
+    images_[1] = scan_image( 64, bins );
+}
+
+const scan_image* scan_assembler::push( const decoded_packet& packet )
+{
+    const scan_image* complete = NULL;
+    if( !started_ || packet.scan != images_[ current_ ].get_header().scan )
+    {
+        if( started_ && !images_[ current_ ].empty() ) { complete = &images_[ current_ ]; current_ = 1 - current_; }
+        images_[ current_ ].clear( packet.scan );
+        started_ = true;
+    }
+    images_[ current_ ].insert( packet, map_ );
+    return complete;
+}
+
+const scan_image* scan_assembler::flush()
+{
+    if( !started_ || images_[ current_ ].empty() ) { return NULL; }
+    started_ = false;
+    return &images_[ current_ ];
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,167 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_SCAN_IMAGE_H_
+#define SNARK_SENSORS_VELODYNE_SCAN_IMAGE_H_
+
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <comma/base/types.h>
+#include <comma/visiting/traits.h>
+#include <snark/sensors/velodyne/db.h>
+#include <snark/sensors/velodyne/laser_map.h>
+#include <snark/sensors/velodyne/packet_decoder.h>
+
+namespace snark {  namespace velodyne {
+
+/// one velodyne revolution as a range image, lasers x azimuth bins
+/// rows are lasers ordered by elevation (see laser_map), i.e. row 0 is the lowest laser
+/// cells are stored contiguously row by row
+class scan_image
+{
+    public:
+        /// image cell; channels are floats, so that image can be viewed as cv::Mat of type CV_32FC(6)
+        struct cell
+        {
+            /// range, metres; 0 if no return
+            float range;
+
+            float intensity;
+
+            /// coordinates relative to velodyne base
+            float x;
+            float y;
+            float z;
+
+            /// seconds since image timestamp
+            float t;
+
+            cell() : range( 0 ), intensity( 0 ), x( 0 ), y( 0 ), z( 0 ), t( 0 ) {}
+        };
+
+        struct header
+        {
+            comma::uint32 scan;
+            boost::posix_time::ptime t;
+            comma::uint32 rows;
+            comma::uint32 cols;
+
+            header() : scan( 0 ), rows( 0 ), cols( 0 ) {}
+        };
+
+        enum { channels = sizeof( cell ) / sizeof( float ) };
+
+        /// constructor
+        /// @param bins number of azimuth bins per revolution
+        scan_image( unsigned int rows = 64, unsigned int bins = 2000 );
+
+        /// clear all cells, set scan number
+        void clear( comma::uint32 scan );
+
+        /// put all returns of decoded packet into image
+        /// if several returns fall into the same cell, the nearest is kept
+        /// @param map maps laser ids to rows
+        void insert( const decoded_packet& packet, const laser_map& map );
+
+        /// return header; timestamp is time of the first return inserted since clear()
+        const header& get_header() const { return header_; }
+
+        /// return number of non-empty cells
+        std::size_t size() const { return size_; }
+
+        /// return true, if no returns inserted since clear()
+        bool empty() const { return size_ == 0; }
+
+        /// return cell
+        const cell& operator()( unsigned int row, unsigned int col ) const { return cells_[ row * header_.cols + col ]; }
+
+        /// return column for given azimuth in degrees
+        unsigned int column( double azimuth ) const;
+
+        /// return all cells, row by row
+        const std::vector< cell >& cells() const { return cells_; }
+
+    private:
+        header header_;
+        std::vector< cell > cells_;
+        std::size_t size_;
+        comma::int64 t_; // nanoseconds
+};
+
+/// assembles decoded packets into scan images, one per revolution
+class scan_assembler
+{
+    public:
+        /// constructor
+        scan_assembler( const db& db, unsigned int bins = 2000 );
+
+        /// add decoded packet
+        /// @return complete image of the previous scan, if the packet starts a new scan; otherwise NULL
+        /// @note the returned image is valid until the next call
+        const scan_image* push( const decoded_packet& packet );
+
+        /// return image of the current (last, possibly incomplete) scan; NULL if empty
+        const scan_image* flush();
+
+    private:
+        laser_map map_;
+        scan_image images_[2];
+        unsigned int current_;
+        bool started_;
+};
+
+} } // namespace snark {  namespace velodyne {
+
+namespace comma { namespace visiting {
+
+template <> struct traits< snark::velodyne::scan_image::header >
+{
+    template < typename Key, class Visitor >
+    static void visit( const Key&, snark::velodyne::scan_image::header& t, Visitor& v )
+    {
+        v.apply( "scan", t.scan );
+        v.apply( "t", t.t );
+        v.apply( "rows", t.rows );
+        v.apply( "cols", t.cols );
+    }
+
+    template < typename Key, class Visitor >
+    static void visit( const Key&, const snark::velodyne::scan_image::header& t, Visitor& v )
+    {
+        v.apply( "scan", t.scan );
+        v.apply( "t", t.t );
+        v.apply( "rows", t.rows );
+        v.apply( "cols", t.cols );
+    }
+};
+
+} } // namespace comma { namespace visiting {
+
+#endif // SNARK_SENSORS_VELODYNE_SCAN_IMAGE_H_
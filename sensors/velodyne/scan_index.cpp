@@ -0,0 +1,71 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/scan_index.h>
+
+namespace snark {  namespace velodyne {
+
+static bool scan_less( const scan_index::entry& lhs, comma::uint32 rhs ) { return lhs.scan < rhs; }
+
+static bool time_less( const scan_index::entry& lhs, const boost::posix_time::ptime& rhs ) { return lhs.t < rhs; }
+
+static bool time_greater( const boost::posix_time::ptime& lhs, const scan_index::entry& rhs ) { return lhs < rhs.t; }
+
+void scan_index::push_back( const entry& e )
+{
+    if( !entries_.empty() && e.scan <= entries_.back().scan ) { COMMA_THROW( comma::exception, "expected scan number greater than " << entries_.back().scan << ", got " << e.scan ); }
+    entries_.push_back( e );
+}
+
+const scan_index::entry* scan_index::lower_bound( comma::uint32 scan ) const
+{
+    std::vector< entry >::const_iterator it = std::lower_bound( entries_.begin(), entries_.end(), scan, scan_less );
+    return it == entries_.end() ? NULL : &*it;
+}
+
+const scan_index::entry* scan_index::find( comma::uint32 scan ) const
+{
+    const entry* e = lower_bound( scan );
+    return e && e->scan == scan ? e : NULL;
+}
+
+bool scan_index::scans( const boost::posix_time::ptime& from, const boost::posix_time::ptime& to, comma::uint32& first, comma::uint32& last ) const
+{
+    std::vector< entry >::const_iterator begin = from.is_special() ? entries_.begin() : std::lower_bound( entries_.begin(), entries_.end(), from, time_less );
+    std::vector< entry >::const_iterator end = to.is_special() ? entries_.end() : std::upper_bound( begin, entries_.end(), to, time_greater );
+    if( begin == end ) { return false; }
+    first = begin->scan;
+    last = ( end - 1 )->scan;
+    return true;
+}
+
+} } // namespace snark {  namespace velodyne {
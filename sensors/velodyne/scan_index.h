@@ -0,0 +1,130 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_SCAN_INDEX_H_
+#define SNARK_SENSORS_VELODYNE_SCAN_INDEX_H_
+
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <comma/base/types.h>
+#include <comma/visiting/traits.h>
+#include <snark/sensors/velodyne/packet.h>
+#include <snark/sensors/velodyne/scan_tick.h>
+#include <snark/sensors/velodyne/impl/stream_traits.h>
+
+namespace snark {  namespace velodyne {
+
+/// index of scan start offsets in a velodyne log
+/// scan numbers are the same as output by velodyne::stream for the whole log
+class scan_index
+{
+    public:
+        struct entry
+        {
+            /// scan number
+            comma::uint32 scan;
+
+            /// offset of the record of the first packet of the scan in the log
+            comma::uint64 offset;
+
+            /// timestamp of the first packet of the scan
+            boost::posix_time::ptime t;
+
+            entry() : scan( 0 ), offset( 0 ) {}
+            entry( comma::uint32 scan, comma::uint64 offset, const boost::posix_time::ptime& t ) : scan( scan ), offset( offset ), t( t ) {}
+        };
+
+        /// build index by reading log till the end
+        /// reader S must provide position(): offset of the current packet record
+        template < typename S >
+        static scan_index make( S& reader );
+
+        /// add entry; scan numbers must be increasing
+        void push_back( const entry& e );
+
+        /// return entries ordered by scan number
+        const std::vector< entry >& entries() const { return entries_; }
+
+        /// return entry for given scan, NULL if not found
+        const entry* find( comma::uint32 scan ) const;
+
+        /// return first entry with scan not less than given, NULL if none
+        const entry* lower_bound( comma::uint32 scan ) const;
+
+        /// return range of scans that started within given time interval
+        /// @return [first, last] scan numbers or false, if no scans in the interval
+        bool scans( const boost::posix_time::ptime& from, const boost::posix_time::ptime& to, comma::uint32& first, comma::uint32& last ) const;
+
+    private:
+        std::vector< entry > entries_;
+};
+
+template < typename S >
+inline scan_index scan_index::make( S& reader )
+{
+    scan_index index;
+    scan_tick tick;
+    comma::uint32 scan = 0;
+    while( true )
+    {
+        const packet* p = reinterpret_cast< const packet* >( impl::stream_traits< S >::read( reader, sizeof( packet ) ) );
+        if( p == NULL ) { break; }
+        if( !impl::stream_traits< S >::is_new_scan( tick, reader, *p ) ) { continue; }
+        index.entries_.push_back( entry( ++scan, reader.position(), impl::stream_traits< S >::timestamp( reader ) ) );
+    }
+    return index;
+}
+
+} } // namespace snark {  namespace velodyne {
+
+namespace comma { namespace visiting {
+
+template <> struct traits< snark::velodyne::scan_index::entry >
+{
+    template < typename Key, class Visitor >
+    static void visit( const Key&, snark::velodyne::scan_index::entry& t, Visitor& v )
+    {
+        v.apply( "scan", t.scan );
+        v.apply( "offset", t.offset );
+        v.apply( "t", t.t );
+    }
+
+    template < typename Key, class Visitor >
+    static void visit( const Key&, const snark::velodyne::scan_index::entry& t, Visitor& v )
+    {
+        v.apply( "scan", t.scan );
+        v.apply( "offset", t.offset );
+        v.apply( "t", t.t );
+    }
+};
+
+} } // namespace comma { namespace visiting {
+
+#endif // SNARK_SENSORS_VELODYNE_SCAN_INDEX_H_
@@ -39,8 +39,10 @@
 #include <comma/math/compare.h>
 #include <snark/sensors/velodyne/db.h>
 #include <snark/sensors/velodyne/laser_return.h>
+#include <snark/sensors/velodyne/return_filter.h>
 #include <snark/sensors/velodyne/impl/stream_traits.h>
 #include <snark/sensors/velodyne/scan_tick.h>
+#include <snark/sensors/velodyne/time.h>
 
 namespace snark {  namespace velodyne {
 
@@ -58,6 +60,19 @@ class stream : public boost::noncopyable
         /// read point, return NULL, if end of stream
         laser_return* read();
 
+        /// read whole packet, return NULL, if end of stream
+        /// @note do not mix with read() on the same stream
+        const packet* read_packet();
+
+        /// return timestamp of the current packet
+        boost::posix_time::ptime timestamp() const;
+
+        /// return timestamp of the current packet, nanoseconds from epoch
+        comma::int64 nanoseconds() const { return m_nanoseconds; }
+
+        /// return angular speed for the current packet
+        double angular_speed();
+
         /// skip given number of scans including the current one
         /// @todo: the same for packets and points, once needed
         void skip_scan();
@@ -65,6 +80,19 @@ class stream : public boost::noncopyable
         /// return current scan number
         unsigned int scan() const;
 
+        /// start counting scans from given scan number, once the underlying
+        /// reader is positioned at the first packet of that scan (e.g. using scan_index)
+        void reset_scan( unsigned int scan );
+
+        /// return underlying reader
+        S& reader() { return *m_stream; }
+
+        /// set filter on raw fields, applied by read() before converting laser returns
+        void filter( const return_filter& f ) { m_filter = f; }
+
+        /// return filter
+        const return_filter& filter() const { return m_filter; }
+
         /// interrupt reading
         void close();
 
@@ -73,7 +101,8 @@ class stream : public boost::noncopyable
         bool m_outputInvalid;
         bool m_outputRaw;
         boost::scoped_ptr< S > m_stream;
-        boost::posix_time::ptime m_timestamp;
+        comma::int64 m_nanoseconds;
+        double m_packetAngularSpeed; // computed once per packet in read_packet()
         const packet* m_packet;
         enum { m_size = 12 * 32 };
         struct index // quick and dirty
@@ -102,7 +131,9 @@ class stream : public boost::noncopyable
         unsigned int m_scan;
         scan_tick m_tick;
         bool m_closed;
+        bool m_pending; // packet has been read by skip_scan() but not consumed yet
         laser_return m_laserReturn;
+        return_filter m_filter;
         double angularSpeed();
 };
 
@@ -112,8 +143,11 @@ inline stream< S >::stream( S* stream, unsigned int rpm, bool outputInvalid, boo
     , m_outputInvalid( outputInvalid )
     , m_outputRaw( outputRaw )
     , m_stream( stream )
+    , m_nanoseconds( 0 )
+    , m_packetAngularSpeed( 0 )
     , m_scan( 0 )
     , m_closed( false )
+    , m_pending( false )
 {
     m_index.idx = m_size;
 }
@@ -123,8 +157,11 @@ inline stream< S >::stream( S* stream, bool outputInvalid, bool outputRaw )
     : m_outputInvalid( outputInvalid )
     , m_outputRaw( outputRaw )
     , m_stream( stream )
+    , m_nanoseconds( 0 )
+    , m_packetAngularSpeed( 0 )
     , m_scan( 0 )
     , m_closed( false )
+    , m_pending( false )
 {
     m_index.idx = m_size;
 }
@@ -133,11 +170,32 @@ template < typename S >
 inline double stream< S >::angularSpeed()
 {
     if( m_angularSpeed ) { return *m_angularSpeed; }
+    static const double dt = double( ( impl::time_offset( 0, 0 ) - impl::time_offset( 11, 0 ) ).total_microseconds() ) / 1e6;
     double da = double( m_packet->blocks[0].rotation() - m_packet->blocks[11].rotation() ) / 100;
-    double dt = double( ( impl::time_offset( 0, 0 ) - impl::time_offset( 11, 0 ) ).total_microseconds() ) / 1e6;
     return da / dt;
 }
 
+template < typename S >
+inline double stream< S >::angular_speed() { return m_packetAngularSpeed; }
+
+template < typename S >
+inline boost::posix_time::ptime stream< S >::timestamp() const { return to_ptime( m_nanoseconds ); }
+
+template < typename S >
+inline const packet* stream< S >::read_packet()
+{
+    if( m_closed ) { return NULL; }
+    m_index = index();
+    if( m_pending ) { m_pending = false; return m_packet; }
+    m_packet = reinterpret_cast< const packet* >( impl::stream_traits< S >::read( *m_stream, sizeof( packet ) ) );
+    if( m_packet == NULL ) { return NULL; }
+    //if( m_tick.is_new_scan( *m_packet ) ) { ++m_scan; }
+    if( impl::stream_traits< S >::is_new_scan( m_tick, *m_stream, *m_packet ) ) { ++m_scan; }
+    m_nanoseconds = impl::stream_traits< S >::nanoseconds( *m_stream );
+    m_packetAngularSpeed = angularSpeed();
+    return m_packet;
+}
+
 template < typename S >
 inline laser_return* stream< S >::read()
 {
@@ -145,15 +203,11 @@ inline laser_return* stream< S >::read()
     {
         if( m_index.idx >= m_size )
         {
-            m_index = index();
-            m_packet = reinterpret_cast< const packet* >( impl::stream_traits< S >::read( *m_stream, sizeof( packet ) ) );
-            if( m_packet == NULL ) { return NULL; }
-            //if( m_tick.is_new_scan( *m_packet ) ) { ++m_scan; }
-            if( impl::stream_traits< S >::is_new_scan( m_tick, *m_stream, *m_packet ) ) { ++m_scan; }
-            m_timestamp = impl::stream_traits< S >::timestamp( *m_stream );
+            if( read_packet() == NULL ) { return NULL; }
         }
+        if( !m_filter.all() && !m_filter( *m_packet, m_index.block, m_index.laser ) ) { ++m_index; continue; }
         // todo: scan number will be slightly different, depending on m_outputRaw value
-        m_laserReturn = impl::get_laser_return( *m_packet, m_index.block, m_index.laser, m_timestamp, angularSpeed(), m_outputRaw );
+        m_laserReturn = impl::get_laser_return( *m_packet, m_index.block, m_index.laser, m_nanoseconds, m_packetAngularSpeed, m_outputRaw );
         ++m_index;
         bool valid = !comma::math::equal( m_laserReturn.range, 0 );
         if( valid || m_outputInvalid ) { return &m_laserReturn; }
@@ -167,16 +221,23 @@ inline unsigned int stream< S >::scan() const { return m_scan; }
 template < typename S >
 inline void stream< S >::close() { m_closed = true; impl::stream_traits< S >::close( *m_stream ); }
 
+template < typename S >
+inline void stream< S >::reset_scan( unsigned int scan )
+{
+    m_scan = scan > 0 ? scan - 1 : 0; // the first packet read will tick the scan
+    m_tick = scan_tick();
+    m_index.idx = m_size;
+    m_pending = false;
+}
+
 template < typename S >
 inline void stream< S >::skip_scan()
 {
     while( !m_closed )
     {
-        m_index = index();
-        m_packet = reinterpret_cast< const packet* >( impl::stream_traits< S >::read( *m_stream, sizeof( packet ) ) );
-        if( m_packet == NULL ) { return; }
-        if( m_tick.is_new_scan( *m_packet ) ) { ++m_scan; return; }
-        if( impl::stream_traits< S >::is_new_scan( m_tick, *m_stream, *m_packet ) ) { ++m_scan; return; }
+        unsigned int scan = m_scan;
+        if( read_packet() == NULL ) { return; }
+        if( m_scan != scan ) { m_pending = true; m_index.idx = m_size; return; } // first packet of the new scan will be output
     }
 }
 
@@ -0,0 +1,105 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/thin/bandwidth.h>
+
+namespace snark {  namespace velodyne {
+
+// quick and dirty model of thin output: bytes per point shrink as points get sparser, plus per-packet overhead
+static std::size_t bytes( double rate, unsigned int points )
+{
+    double kept = rate * points;
+    double packets = kept < 3000 ? kept : 3000;
+    return std::size_t( kept * ( 1.0 + 1.5 * rate ) + packets * 19 );
+}
+
+TEST( bandwidth, converges_under_target )
+{
+    thin::bandwidth b( thin::bandwidth::config( 400000 ) );
+    boost::posix_time::ptime t( boost::gregorian::date( 2014, 1, 1 ) );
+    const unsigned int points[] = { 130000, 300000, 40000, 200000 }; // point density changes every 50 scans
+    for( unsigned int i = 0; i < 4; ++i )
+    {
+        for( unsigned int scan = 0; scan < 50; ++scan )
+        {
+            double rate = b.update( t );
+            if( scan >= 15 && b.scans() > 1 )
+            {
+                EXPECT_GE( 400000, b.last() );
+                EXPECT_LE( 400000 * 0.85, b.last() );
+            }
+            b.add( bytes( rate, points[i] ) );
+            t += boost::posix_time::milliseconds( 100 );
+        }
+    }
+    EXPECT_GT( 400000 * 1.1, b.achieved() ); // including overshoot on first scans at full rate
+}
+
+TEST( bandwidth, stable )
+{
+    thin::bandwidth b( thin::bandwidth::config( 400000 ) );
+    boost::posix_time::ptime t( boost::gregorian::date( 2014, 1, 1 ) );
+    double previous = 0;
+    for( unsigned int scan = 0; scan < 100; ++scan )
+    {
+        double rate = b.update( t );
+        if( scan > 20 ) { EXPECT_NEAR( previous, rate, previous * 0.01 ); }
+        previous = rate;
+        b.add( bytes( rate, 200000 ) );
+        t += boost::posix_time::milliseconds( 100 );
+    }
+}
+
+TEST( bandwidth, limits )
+{
+    thin::bandwidth b( thin::bandwidth::config( 1000, 0.05, 0.5, 0.01 ) );
+    boost::posix_time::ptime t( boost::gregorian::date( 2014, 1, 1 ) );
+    EXPECT_EQ( 1.0, b.update( t ) );
+    for( unsigned int scan = 0; scan < 20; ++scan ) // budget never met
+    {
+        b.add( 1000000 );
+        t += boost::posix_time::milliseconds( 100 );
+        b.update( t );
+    }
+    EXPECT_EQ( 0.01, b.rate() );
+    for( unsigned int scan = 0; scan < 20; ++scan ) // nothing output
+    {
+        t += boost::posix_time::milliseconds( 100 );
+        b.update( t );
+    }
+    EXPECT_EQ( 1.0, b.rate() );
+    EXPECT_EQ( 40u, b.scans() );
+    EXPECT_THROW( thin::bandwidth( thin::bandwidth::config( 0 ) ), comma::exception );
+    EXPECT_THROW( thin::bandwidth( thin::bandwidth::config( 1000, 0.05, 2 ) ), comma::exception );
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,154 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifdef __linux__
+
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <gtest/gtest.h>
+#include <snark/sensors/velodyne/packet.h>
+#include <snark/sensors/velodyne/impl/batched_udp_reader.h>
+#include <snark/sensors/velodyne/impl/stream_traits.h>
+
+namespace snark {  namespace velodyne {
+
+class loopback_sender
+{
+    public:
+        loopback_sender( unsigned short port ) : socket_( ::socket( AF_INET, SOCK_DGRAM, 0 ) )
+        {
+            ::memset( &address_, 0, sizeof( address_ ) );
+            address_.sin_family = AF_INET;
+            address_.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+            address_.sin_port = htons( port );
+        }
+
+        ~loopback_sender() { ::close( socket_ ); }
+
+        void send( unsigned int rotation, std::size_t size = packet::size ) // packet with rotation advancing by 20 hundredths of degree per firing
+        {
+            packet p;
+            ::memset( &p, 0, packet::size );
+            for( unsigned int i = 0; i < 12; ++i ) { p.blocks[i].rotation = ( rotation + ( i / 2 ) * 20 ) % 36000; }
+            ::sendto( socket_, p.data(), size, 0, reinterpret_cast< const ::sockaddr* >( &address_ ), sizeof( address_ ) );
+        }
+
+    private:
+        int socket_;
+        ::sockaddr_in address_;
+};
+
+TEST( batched_udp_reader, receive )
+{
+    batched_udp_reader reader( batched_udp_reader::config( 0, 8 ) );
+    loopback_sender sender( reader.port() );
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for( unsigned int i = 0; i < 20; ++i ) { sender.send( 35000 + i * 120 ); }
+    boost::posix_time::ptime previous;
+    for( unsigned int i = 0; i < 20; ++i )
+    {
+        const char* p = reader.read();
+        ASSERT_TRUE( p != NULL );
+        EXPECT_EQ( packet::size, reader.size() );
+        EXPECT_EQ( ( 35000 + i * 120 ) % 36000, reinterpret_cast< const packet* >( p )->blocks[0].rotation() );
+        EXPECT_TRUE( reader.timestamp() >= start - boost::posix_time::seconds( 1 ) );
+        if( i > 0 ) { EXPECT_TRUE( reader.timestamp() >= previous ); }
+        previous = reader.timestamp();
+    }
+    EXPECT_EQ( 20u, reader.received() );
+    EXPECT_EQ( 0u, reader.dropped() );
+    EXPECT_EQ( 0u, reader.gaps() );
+}
+
+TEST( batched_udp_reader, gaps )
+{
+    batched_udp_reader reader( batched_udp_reader::config( 0, 4 ) );
+    loopback_sender sender( reader.port() );
+    unsigned int sent[] = { 0, 1, 2, 5, 6, 7, 8, 12 };
+    for( unsigned int i = 0; i < 8; ++i ) { sender.send( 35800 + sent[i] * 120 ); }
+    for( unsigned int i = 0; i < 8; ++i ) { ASSERT_TRUE( reader.read() != NULL ); }
+    EXPECT_EQ( 5u, reader.gaps() );
+}
+
+TEST( batched_udp_reader, drops )
+{
+    batched_udp_reader reader( batched_udp_reader::config( 0, 16, 1 ) ); // minimum receive buffer size
+    loopback_sender sender( reader.port() );
+    for( unsigned int i = 0; i < 200; ++i ) { sender.send( i * 120 ); }
+    ASSERT_TRUE( reader.read() != NULL ); // drains whatever fitted into the receive buffer
+    sender.send( 12345 ); // the next packet to arrive carries the drop count
+    while( true )
+    {
+        const char* p = reader.read();
+        ASSERT_TRUE( p != NULL );
+        if( reinterpret_cast< const packet* >( p )->blocks[0].rotation() == 12345 ) { break; }
+    }
+    EXPECT_LT( 0u, reader.dropped() );
+    EXPECT_EQ( 201u, reader.received() + reader.dropped() );
+}
+
+TEST( batched_udp_reader, skip_short_datagrams )
+{
+    batched_udp_reader reader( batched_udp_reader::config( 0, 8 ) );
+    loopback_sender sender( reader.port() );
+    sender.send( 100 );
+    sender.send( 200, 10 );
+    sender.send( 300, packet::size - 1 );
+    sender.send( 400 );
+    const char* p = impl::stream_traits< batched_udp_reader >::read( reader, packet::size );
+    ASSERT_TRUE( p != NULL );
+    EXPECT_EQ( 100u, reinterpret_cast< const packet* >( p )->blocks[0].rotation() );
+    p = impl::stream_traits< batched_udp_reader >::read( reader, packet::size );
+    ASSERT_TRUE( p != NULL );
+    EXPECT_EQ( 400u, reinterpret_cast< const packet* >( p )->blocks[0].rotation() );
+    EXPECT_EQ( 4u, reader.received() );
+    EXPECT_EQ( 2u, reader.truncated() );
+}
+
+static void read_all( batched_udp_reader* reader, bool* done ) { while( reader->read() != NULL ); *done = true; }
+
+TEST( batched_udp_reader, shutdown )
+{
+    batched_udp_reader reader( batched_udp_reader::config( 0, 4 ) );
+    bool done = false;
+    boost::thread thread( boost::bind( &read_all, &reader, &done ) ); // blocks in receive, since nothing is sent
+    boost::this_thread::sleep( boost::posix_time::milliseconds( 50 ) );
+    reader.shutdown();
+    EXPECT_TRUE( thread.timed_join( boost::posix_time::seconds( 5 ) ) );
+    EXPECT_TRUE( done );
+}
+
+} } // namespace snark {  namespace velodyne {
+
+#endif // #ifdef __linux__
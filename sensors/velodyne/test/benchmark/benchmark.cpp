@@ -0,0 +1,166 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <cstring>
+#ifdef WIN32
+#include <boost/date_time/posix_time/posix_time.hpp>
+#else
+#include <time.h>
+#endif
+#include <comma/application/command_line_options.h>
+#include <comma/string/string.h>
+#include "./benchmark.h"
+
+namespace snark {  namespace velodyne { namespace benchmark {
+
+volatile double sink = 0;
+
+void print_header( std::ostream& os ) { os << "name,points,seconds,ns/point,points/s,bytes/point" << std::endl; }
+
+void print( std::ostream& os, const result& r )
+{
+    os << r.name << "," << r.points << "," << r.seconds
+       << "," << ( r.points == 0 ? 0.0 : r.seconds * 1e9 / r.points )
+       << "," << ( r.seconds == 0 ? 0.0 : r.points / r.seconds )
+       << "," << ( r.points == 0 ? 0.0 : r.bytes / r.points ) << std::endl;
+}
+
+double now()
+{
+    #ifdef WIN32
+    static const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time(); // quick and dirty: wall clock, not monotonic
+    return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6;
+    #else
+    ::timespec t;
+    ::clock_gettime( CLOCK_MONOTONIC, &t );
+    return double( t.tv_sec ) + double( t.tv_nsec ) / 1e9;
+    #endif
+}
+
+std::vector< packet > make_packets( unsigned int size, double rate )
+{
+    std::vector< packet > packets( size );
+    comma::uint32 seed = 12345;
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        packet& p = packets[i];
+        ::memset( &p, 0, packet::size );
+        for( unsigned int block = 0; block < 12; ++block )
+        {
+            comma::uint16 rotation = ( i * 6 * 18 + ( block / 2 ) * 18 ) % 36000; // about 10Hz
+            p.blocks[block].id = ( block & 0x1 ) ? packet::lower_block_id() : packet::upper_block_id();
+            p.blocks[block].rotation = rotation;
+            for( unsigned int laser = 0; laser < 32; ++laser )
+            {
+                seed = seed * 1664525 + 1013904223; // quick and dirty: deterministic and cheap
+                if( ( seed >> 8 ) % 1000 >= rate * 1000 ) { continue; }
+                double a = double( rotation ) * M_PI / 18000;
+                double range = 10 + 5 * std::sin( a * 3 ) + ( block & 0x1 ? laser * 0.2 : laser * 0.5 ); // smooth scene
+                p.blocks[block].lasers[laser].range = static_cast< comma::uint16 >( range * 500 ) + ( seed >> 28 );
+                p.blocks[block].lasers[laser].intensity = ( seed >> 16 ) & 0xff;
+            }
+        }
+    }
+    return packets;
+}
+
+comma::uint64 count_points( const std::vector< packet >& packets )
+{
+    comma::uint64 count = 0;
+    for( std::size_t i = 0; i < packets.size(); ++i )
+    {
+        for( unsigned int block = 0; block < 12; ++block )
+        {
+            for( unsigned int laser = 0; laser < 32; ++laser ) { if( packets[i].blocks[block].lasers[laser].range() != 0 ) { ++count; } }
+        }
+    }
+    return count;
+}
+
+} } } // namespace snark {  namespace velodyne { namespace benchmark {
+
+static void usage()
+{
+    std::cerr << std::endl;
+    std::cerr << "velodyne decoding benchmarks on synthetic hdl-64e packets in memory" << std::endl;
+    std::cerr << "output: csv, one line per benchmark, to diff between versions" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "usage: velodyne_benchmark [<options>]" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "options" << std::endl;
+    std::cerr << "    --packets=<n>: number of packets; default 20000" << std::endl;
+    std::cerr << "    --rate=<rate>: ratio of valid returns, e.g. for thinned data; default 1" << std::endl;
+    std::cerr << "    --no-header: do not output csv header" << std::endl;
+    std::cerr << "    --only=<groups>: run only given comma-separated groups: decode,readers,thin,focus; default: all" << std::endl;
+    std::cerr << "    --repeat=<n>: run each benchmark n times, output the fastest run; default 1" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "example: compare two versions" << std::endl;
+    std::cerr << "    velodyne_benchmark --repeat=5 > before.csv" << std::endl;
+    std::cerr << "    # rebuild" << std::endl;
+    std::cerr << "    velodyne_benchmark --repeat=5 > after.csv" << std::endl;
+    std::cerr << "    paste -d, before.csv after.csv | cut -d, -f1,4,10" << std::endl;
+    std::cerr << std::endl;
+    exit( -1 );
+}
+
+int main( int ac, char** av )
+{
+    try
+    {
+        comma::command_line_options options( ac, av );
+        if( options.exists( "--help,-h" ) ) { usage(); }
+        using namespace snark::velodyne;
+        std::vector< packet > packets = benchmark::make_packets( options.value( "--packets", 20000u ), options.value( "--rate", 1.0 ) );
+        std::vector< std::string > only = comma::split( options.value< std::string >( "--only", "decode,readers,thin,focus" ), ',' );
+        unsigned int repeat = options.value( "--repeat", 1u );
+        std::vector< benchmark::result > results;
+        for( unsigned int i = 0; i < repeat; ++i )
+        {
+            std::vector< benchmark::result > r;
+            for( std::size_t j = 0; j < only.size(); ++j )
+            {
+                if( only[j] == "decode" ) { benchmark::decode( packets, r ); }
+                else if( only[j] == "readers" ) { benchmark::readers( packets, r ); }
+                else if( only[j] == "thin" ) { benchmark::thin( packets, r ); }
+                else if( only[j] == "focus" ) { benchmark::focus( packets, r ); }
+                else { std::cerr << "velodyne_benchmark: expected benchmark group, got \"" << only[j] << "\"" << std::endl; return 1; }
+            }
+            if( results.empty() ) { results = r; continue; }
+            for( std::size_t k = 0; k < r.size(); ++k ) { if( r[k].seconds < results[k].seconds ) { results[k] = r[k]; } }
+        }
+        if( !options.exists( "--no-header" ) ) { benchmark::print_header( std::cout ); }
+        for( std::size_t i = 0; i < results.size(); ++i ) { benchmark::print( std::cout, results[i] ); }
+        return 0;
+    }
+    catch( std::exception& ex ) { std::cerr << "velodyne_benchmark: " << ex.what() << std::endl; }
+    catch( ... ) { std::cerr << "velodyne_benchmark: unknown exception" << std::endl; }
+    return 1;
+}
@@ -0,0 +1,85 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_TEST_BENCHMARK_BENCHMARK_H_
+#define SNARK_SENSORS_VELODYNE_TEST_BENCHMARK_BENCHMARK_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <comma/base/types.h>
+#include <snark/sensors/velodyne/packet.h>
+
+namespace snark {  namespace velodyne { namespace benchmark {
+
+/// benchmark result, printed as one csv line
+struct result
+{
+    std::string name;
+    comma::uint64 points;
+    double seconds;
+    double bytes; /// bytes produced or consumed, 0 if not applicable
+
+    result( const std::string& name, comma::uint64 points, double seconds, double bytes = 0 ) : name( name ), points( points ), seconds( seconds ), bytes( bytes ) {}
+};
+
+/// print csv header
+void print_header( std::ostream& os );
+
+/// print result as csv: name,points,seconds,ns/point,points/s,bytes/point
+void print( std::ostream& os, const result& r );
+
+/// return monotonic time in seconds (wall clock on windows)
+double now();
+
+/// make synthetic hdl-64e packets of a smooth scene, with given rate of valid returns
+std::vector< packet > make_packets( unsigned int size, double rate = 1.0 );
+
+/// return number of valid returns in packets
+comma::uint64 count_points( const std::vector< packet >& packets );
+
+/// keeps results alive, so that the compiler does not optimise the benchmarked code away
+extern volatile double sink;
+
+/// decoding layers: raw return fields, azimuth, timestamps, ray geometry, whole returns and packets
+void decode( const std::vector< packet >& packets, std::vector< result >& results );
+
+/// stream_traits readers over a memory stream; pcap readers over a temporary file
+void readers( const std::vector< packet >& packets, std::vector< result >& results );
+
+/// thin serialize/deserialize, v1 and v2
+void thin( const std::vector< packet >& packets, std::vector< result >& results );
+
+/// focus thinning, per-return reference vs lookup table
+void focus( const std::vector< packet >& packets, std::vector< result >& results );
+
+} } } // namespace snark {  namespace velodyne { namespace benchmark {
+
+#endif // SNARK_SENSORS_VELODYNE_TEST_BENCHMARK_BENCHMARK_H_
@@ -0,0 +1,142 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <snark/sensors/velodyne/db.h>
+#include <snark/sensors/velodyne/packet_decoder.h>
+#include <snark/sensors/velodyne/time.h>
+#include <snark/sensors/velodyne/impl/get_laser_return.h>
+#include <snark/sensors/velodyne/impl/velodyne_stream.h>
+#include "../db.h"
+#include "./benchmark.h"
+
+namespace snark {  namespace velodyne { namespace benchmark {
+
+static const double angular_speed = 3600; // 10Hz
+
+// run f( packet, block, laser ) on every return of every packet, valid or not
+template < typename F >
+static void run( const std::string& name, const std::vector< packet >& packets, F f, std::vector< result >& results )
+{
+    double sum = 0;
+    double start = now();
+    for( std::size_t i = 0; i < packets.size(); ++i )
+    {
+        for( unsigned int block = 0; block < 12; ++block )
+        {
+            for( unsigned int laser = 0; laser < 32; ++laser ) { sum += f( packets[i], block, laser ); }
+        }
+    }
+    double elapsed = now() - start;
+    sink = sum;
+    results.push_back( result( name, comma::uint64( packets.size() ) * 12 * 32, elapsed ) );
+}
+
+static double raw( const packet& p, unsigned int block, unsigned int laser )
+{
+    const packet::laser_block& b = p.blocks[block];
+    unsigned int id = laser + ( block & 0x1 ) * 32;
+    return id + b.lasers[laser].range() + b.lasers[laser].intensity() + b.rotation();
+}
+
+struct azimuth
+{
+    const velodyne::db& db;
+    azimuth( const velodyne::db& db ) : db( db ) {}
+    double operator()( const packet& p, unsigned int block, unsigned int laser ) const { return db.lasers[ laser + ( block & 0x1 ) * 32 ].azimuth( impl::azimuth( p, block, laser, angular_speed ) ); }
+};
+
+struct ptime_timestamp
+{
+    boost::posix_time::ptime t;
+    ptime_timestamp() : t( boost::posix_time::from_iso_string( "20140101T000000" ) ) {}
+    double operator()( const packet&, unsigned int block, unsigned int laser ) const { return ( t + impl::time_offset( block, laser ) ).time_of_day().total_microseconds(); }
+};
+
+struct timestamp
+{
+    comma::int64 t;
+    timestamp() : t( to_nanoseconds( boost::posix_time::from_iso_string( "20140101T000000" ) ) ) {}
+    double operator()( const packet&, unsigned int block, unsigned int laser ) const { return double( t + impl::time_offset_nanoseconds( block, laser ) ); }
+};
+
+struct ray
+{
+    const velodyne::db& db;
+    ray( const velodyne::db& db ) : db( db ) {}
+    double operator()( const packet& p, unsigned int block, unsigned int laser ) const
+    {
+        const packet::laser_block& b = p.blocks[block];
+        return db.lasers[ laser + ( block & 0x1 ) * 32 ].ray( double( b.lasers[laser].range() ) / 500, double( b.rotation() ) / 100 ).second.x();
+    }
+};
+
+struct laser_return
+{
+    comma::int64 t;
+    laser_return() : t( to_nanoseconds( boost::posix_time::from_iso_string( "20140101T000000" ) ) ) {}
+    double operator()( const packet& p, unsigned int block, unsigned int laser ) const { return impl::get_laser_return( p, block, laser, t, angular_speed ).range; }
+};
+
+struct point
+{
+    const velodyne::db& db;
+    comma::int64 t;
+    point( const velodyne::db& db ) : db( db ), t( to_nanoseconds( boost::posix_time::from_iso_string( "20140101T000000" ) ) ) {}
+    double operator()( const packet& p, unsigned int block, unsigned int laser ) const
+    {
+        velodyne_point point;
+        to_velodyne_point( db, impl::get_laser_return( p, block, laser, t, angular_speed ), 0, point );
+        return point.ray.second.x();
+    }
+};
+
+void decode( const std::vector< packet >& packets, std::vector< result >& results )
+{
+    velodyne::db db = test::testdb();
+    run( "decode/raw", packets, raw, results );
+    run( "decode/azimuth", packets, azimuth( db ), results );
+    run( "decode/timestamp", packets, timestamp(), results );
+    run( "decode/timestamp/ptime", packets, ptime_timestamp(), results );
+    run( "decode/ray", packets, ray( db ), results );
+    run( "decode/get_laser_return", packets, laser_return(), results );
+    run( "decode/velodyne_point", packets, point( db ), results );
+    packet_decoder decoder( db );
+    decoded_packet decoded;
+    comma::int64 t = to_nanoseconds( boost::posix_time::from_iso_string( "20140101T000000" ) );
+    double sum = 0;
+    double start = now();
+    for( std::size_t i = 0; i < packets.size(); ++i ) { sum += decoder.decode( packets[i], t, angular_speed, true, decoded ) + decoded.x[0]; }
+    double elapsed = now() - start;
+    sink = sum;
+    results.push_back( result( "decode/packet_decoder", comma::uint64( packets.size() ) * 12 * 32, elapsed ) );
+}
+
+} } } // namespace snark {  namespace velodyne { namespace benchmark {
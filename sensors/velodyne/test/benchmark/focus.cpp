@@ -0,0 +1,96 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <vector>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <snark/sensors/velodyne/thin/focus_table.h>
+#include <snark/sensors/velodyne/thin/thin.h>
+#include "./benchmark.h"
+
+namespace snark {  namespace velodyne { namespace benchmark {
+
+template < typename Thin >
+static void run( const std::string& name, const std::vector< packet >& packets, Thin thin, std::vector< result >& results )
+{
+    comma::uint64 points = count_points( packets );
+    std::vector< packet > thinned( packets );
+    double start = now();
+    for( std::size_t i = 0; i < thinned.size(); ++i ) { thin( thinned[i] ); }
+    double elapsed = now() - start;
+    sink = count_points( thinned );
+    results.push_back( result( name, points, elapsed ) );
+}
+
+struct reference
+{
+    const thin::focus& focus;
+    const velodyne::db& db;
+    boost::mt19937& generator;
+    reference( const thin::focus& focus, const velodyne::db& db, boost::mt19937& generator ) : focus( focus ), db( db ), generator( generator ) {}
+    void operator()( packet& p ) const
+    {
+        boost::uniform_real< float > distribution( 0, 1 );
+        boost::variate_generator< boost::mt19937&, boost::uniform_real< float > > random( generator, distribution );
+        thin::thin( p, focus, db, 3600, random );
+    }
+};
+
+struct table
+{
+    const thin::focus_table& t;
+    thin::counter_random& random;
+    table( const thin::focus_table& t, thin::counter_random& random ) : t( t ), random( random ) {}
+    void operator()( packet& p ) const { t.thin( p, random ); }
+};
+
+void focus( const std::vector< packet >& packets, std::vector< result >& results )
+{
+    velodyne::db db;
+    for( unsigned int i = 0; i < db.lasers.size(); ++i ) { db.lasers[i].elevation = ( 2.0 - 26.8 * i / 63 ) * M_PI / 180; } // roughly hdl-64e vertical field of view
+    boost::mt19937 generator;
+    thin::counter_random random;
+    thin::focus sector( 0.2, 0.8 );
+    sector.insert( 0, new thin::sector( 0, 30, 10 ) );
+    thin::focus extents( 0.2, 0.8 );
+    extents.insert( 0, new thin::extents( Eigen::Vector3d( 0, -5, -2 ), Eigen::Vector3d( 20, 5, 2 ) ) );
+    thin::focus_table sector_table( db );
+    sector_table.update( sector );
+    thin::focus_table extents_table( db );
+    extents_table.update( extents );
+    run( "focus/sector/reference", packets, reference( sector, db, generator ), results );
+    run( "focus/sector/table", packets, table( sector_table, random ), results );
+    run( "focus/extents/reference", packets, reference( extents, db, generator ), results );
+    run( "focus/extents/table", packets, table( extents_table, random ), results );
+}
+
+} } } // namespace snark {  namespace velodyne { namespace benchmark {
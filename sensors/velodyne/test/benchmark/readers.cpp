@@ -0,0 +1,189 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/impl/stream_traits.h>
+#include <snark/sensors/velodyne/impl/stream_reader.h>
+#include "./benchmark.h"
+
+namespace snark {  namespace velodyne { namespace benchmark {
+
+template < typename S >
+static void run( const std::string& name, S& s, std::size_t size, std::size_t bytes, std::vector< result >& results )
+{
+    std::size_t count = 0;
+    double sum = 0;
+    double start = now();
+    for( const char* p = impl::stream_traits< S >::read( s, packet::size ); p; p = impl::stream_traits< S >::read( s, packet::size ) )
+    {
+        sum += reinterpret_cast< const packet* >( p )->blocks[11].lasers[31].range();
+        sum += impl::stream_traits< S >::timestamp( s ).time_of_day().total_microseconds();
+        ++count;
+    }
+    double elapsed = now() - start;
+    sink = sum;
+    if( count != size ) { COMMA_THROW( comma::exception, name << ": expected " << size << " packets, got " << count ); }
+    results.push_back( result( name, comma::uint64( size ) * 12 * 32, elapsed, bytes ) );
+}
+
+static void append( std::string& s, const void* p, std::size_t size ) { s.append( reinterpret_cast< const char* >( p ), size ); }
+
+static std::string stream_format( const std::vector< packet >& packets )
+{
+    std::string s;
+    for( std::size_t i = 0; i < packets.size(); ++i )
+    {
+        comma::uint64 microseconds = 1388534400000000ULL + i * 578; // about 1730 packets per second
+        append( s, &microseconds, sizeof( microseconds ) );
+        append( s, &packets[i], packet::size );
+    }
+    return s;
+}
+
+static std::string proprietary_format( const std::vector< packet >& packets )
+{
+    static const char start[] = { -78, 85 };
+    static const char end[] = { 117, -97 };
+    std::string s;
+    for( std::size_t i = 0; i < packets.size(); ++i )
+    {
+        char header[16] = { 0 };
+        ::memcpy( header, start, 2 );
+        append( s, header, sizeof( header ) );
+        comma::uint64 seconds = 1388534400 + i / 1730;
+        comma::uint32 nanoseconds = ( i % 1730 ) * 578000;
+        append( s, &seconds, sizeof( seconds ) );
+        append( s, &nanoseconds, sizeof( nanoseconds ) );
+        append( s, &packets[i], packet::size );
+        char footer[4] = { 0 };
+        ::memcpy( footer + 2, end, 2 );
+        append( s, footer, sizeof( footer ) );
+    }
+    return s;
+}
+
+static std::string thin_format( const std::vector< packet >& packets, bool v2 )
+{
+    std::string s;
+    std::vector< char > buf( thin::v2::maxBufferSize > thin::maxBufferSize ? thin::v2::maxBufferSize : thin::maxBufferSize );
+    for( std::size_t i = 0; i < packets.size(); ++i )
+    {
+        comma::uint16 size = v2 ? thin::v2::serialize( packets[i], &buf[0], i / 180 ) : thin::serialize( packets[i], &buf[0], i / 180 );
+        comma::uint16 header = ( size + 12 ) | ( v2 ? comma::uint16( thin::v2::record_flag ) : 0 );
+        comma::int64 seconds = 1388534400 + i / 1730;
+        comma::int32 nanoseconds = ( i % 1730 ) * 578000;
+        append( s, &header, sizeof( header ) );
+        append( s, &seconds, sizeof( seconds ) );
+        append( s, &nanoseconds, sizeof( nanoseconds ) );
+        append( s, &buf[0], size );
+    }
+    return s;
+}
+
+static std::string pcap_format( const std::vector< packet >& packets )
+{
+    std::string s;
+    comma::uint32 header[6] = { 0xa1b2c3d4, 0x00040002, 0, 0, 65535, 1 }; // magic, version 2.4, zone, sigfigs, snaplen, ethernet
+    append( s, header, sizeof( header ) );
+    char udp[42] = { 0 };
+    for( std::size_t i = 0; i < packets.size(); ++i )
+    {
+        comma::uint32 record[4] = { comma::uint32( 1388534400 + i / 1730 ), comma::uint32( ( i % 1730 ) * 578 ), 42 + packet::size, 42 + packet::size };
+        append( s, record, sizeof( record ) );
+        append( s, udp, sizeof( udp ) );
+        append( s, &packets[i], packet::size );
+    }
+    return s;
+}
+
+struct temporary_file // quick and dirty: pcap readers need a file, it is still in page cache when read
+{
+    std::string name;
+    temporary_file( const std::string& content )
+    {
+        char pattern[] = "/tmp/velodyne-benchmark.XXXXXX";
+        int fd = ::mkstemp( pattern );
+        if( fd < 0 ) { COMMA_THROW( comma::exception, "failed to create temporary file" ); }
+        ::close( fd );
+        name = pattern;
+        std::ofstream ofs( name.c_str(), std::ios::binary );
+        ofs.write( &content[0], content.size() );
+        if( !ofs.good() ) { COMMA_THROW( comma::exception, "failed to write temporary file " << name ); }
+    }
+    ~temporary_file() { ::remove( name.c_str() ); }
+};
+
+void readers( const std::vector< packet >& packets, std::vector< result >& results )
+{
+    {
+        std::string s = stream_format( packets );
+        std::istringstream iss( s );
+        stream_reader reader( iss );
+        run( "reader/stream", reader, packets.size(), s.size(), results );
+    }
+    {
+        std::string s = proprietary_format( packets );
+        std::istringstream iss( s );
+        proprietary_reader reader( iss );
+        run( "reader/proprietary", reader, packets.size(), s.size(), results );
+    }
+    {
+        std::string s = thin_format( packets, false );
+        std::istringstream iss( s );
+        thin_reader reader( iss );
+        run( "reader/thin/v1", reader, packets.size(), s.size(), results );
+    }
+    {
+        std::string s = thin_format( packets, true );
+        std::istringstream iss( s );
+        thin_reader reader( iss );
+        run( "reader/thin/v2", reader, packets.size(), s.size(), results );
+    }
+    std::string s = pcap_format( packets );
+    temporary_file file( s );
+    {
+        pcap_reader reader( file.name );
+        run( "reader/pcap", reader, packets.size(), s.size(), results );
+    }
+    #ifndef WIN32
+    {
+        mmap_pcap_reader reader( file.name );
+        run( "reader/mmap_pcap", reader, packets.size(), s.size(), results );
+    }
+    #endif
+}
+
+} } } // namespace snark {  namespace velodyne { namespace benchmark {
@@ -0,0 +1,70 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <vector>
+#include <snark/sensors/velodyne/thin/thin.h>
+#include <snark/sensors/velodyne/thin/v2.h>
+#include "./benchmark.h"
+
+namespace snark {  namespace velodyne { namespace benchmark {
+
+template < typename Serialize, typename Deserialize >
+static void run( const std::string& name, const std::vector< packet >& packets, Serialize serialize, Deserialize deserialize, std::vector< result >& results )
+{
+    comma::uint64 points = count_points( packets );
+    std::vector< char > buf( packets.size() * thin::v2::maxBufferSize );
+    std::vector< std::size_t > offsets( packets.size() + 1, 0 );
+    double start = now();
+    for( std::size_t i = 0; i < packets.size(); ++i ) { offsets[ i + 1 ] = offsets[i] + serialize( packets[i], &buf[ offsets[i] ] ); }
+    double elapsed = now() - start;
+    results.push_back( result( name + "/serialize", points, elapsed, offsets.back() ) );
+    packet p;
+    comma::uint64 sum = 0;
+    start = now();
+    for( std::size_t i = 0; i < packets.size(); ++i ) { sum += deserialize( p, &buf[ offsets[i] ] ) + p.blocks[11].lasers[31].range(); }
+    elapsed = now() - start;
+    sink = sum;
+    results.push_back( result( name + "/deserialize", points, elapsed, offsets.back() ) );
+}
+
+static std::size_t serialize_v1( const packet& p, char* buf ) { return thin::serialize( p, buf, 1 ); }
+static std::size_t serialize_v2( const packet& p, char* buf ) { return thin::v2::serialize( p, buf, 1 ); }
+static std::size_t serialize_v2_intensity( const packet& p, char* buf ) { return thin::v2::serialize( p, buf, 1, 4 ); }
+static comma::uint32 deserialize_v1( packet& p, const char* buf ) { return thin::deserialize( p, buf ); }
+static comma::uint32 deserialize_v2( packet& p, const char* buf ) { return thin::v2::deserialize( p, buf ); }
+
+void thin( const std::vector< packet >& packets, std::vector< result >& results )
+{
+    run( "thin/v1", packets, serialize_v1, deserialize_v1, results );
+    run( "thin/v2", packets, serialize_v2, deserialize_v2, results );
+    run( "thin/v2/intensity-4-bits", packets, serialize_v2_intensity, deserialize_v2, results );
+}
+
+} } } // namespace snark {  namespace velodyne { namespace benchmark {
@@ -0,0 +1,168 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstring>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <gtest/gtest.h>
+#include <snark/sensors/velodyne/thin/focus_table.h>
+#include <snark/sensors/velodyne/thin/thin.h>
+#include "./db.h"
+
+namespace snark {  namespace velodyne {
+
+static packet make_packet( unsigned int rotation, boost::mt19937& generator )
+{
+    boost::uniform_int< int > uniform( 200, 30000 );
+    boost::variate_generator< boost::mt19937&, boost::uniform_int< int > > range( generator, uniform );
+    packet p;
+    ::memset( &p, 0, packet::size );
+    for( unsigned int block = 0; block < 12; ++block )
+    {
+        p.blocks[block].id = ( block & 0x1 ) ? packet::lower_block_id() : packet::upper_block_id();
+        p.blocks[block].rotation = ( rotation + ( block / 2 ) * 17 ) % 36000;
+        for( unsigned int laser = 0; laser < 32; ++laser ) { p.blocks[block].lasers[laser].range = range(); }
+    }
+    return p;
+}
+
+struct half { float operator()() const { return 0.5; } };
+
+// compare table against reference focus thinning with rates 1 in focus and 0 out of focus
+static double mismatch( const db& db, const thin::focus& focus, unsigned int bins )
+{
+    thin::focus_table table( db, bins );
+    table.update( focus );
+    boost::mt19937 generator;
+    thin::counter_random random;
+    half h;
+    unsigned int total = 0;
+    unsigned int mismatched = 0;
+    unsigned int kept = 0;
+    for( unsigned int rotation = 0; rotation < 36000; rotation += 37 )
+    {
+        packet expected = make_packet( rotation, generator );
+        packet actual = expected;
+        thin::thin( expected, focus, db, 3600, h );
+        table.thin( actual, random );
+        for( unsigned int block = 0; block < 12; ++block )
+        {
+            for( unsigned int laser = 0; laser < 32; ++laser, ++total )
+            {
+                if( expected.blocks[block].lasers[laser].range() != 0 ) { ++kept; }
+                if( expected.blocks[block].lasers[laser].range() != actual.blocks[block].lasers[laser].range() ) { ++mismatched; }
+            }
+        }
+    }
+    EXPECT_LT( 0u, kept );
+    EXPECT_GT( total, kept );
+    return double( mismatched ) / total;
+}
+
+TEST( focus_table, sector )
+{
+    db db = test::testdb();
+    thin::focus focus( 1.0, 1.0 );
+    focus.insert( 0, new thin::sector( 45, 60, 20 ) );
+    EXPECT_EQ( 1.0, focus.rate_in_focus() );
+    EXPECT_EQ( 0.0, focus.rate_out_of_focus() );
+    EXPECT_GT( 0.01, mismatch( db, focus, 720 ) );
+    EXPECT_GT( 0.001, mismatch( db, focus, 36000 ) );
+}
+
+TEST( focus_table, extents )
+{
+    db db = test::testdb();
+    thin::focus focus( 0.3, 1.0 );
+    focus.insert( 0, new thin::extents( Eigen::Vector3d( -5, -20, -3 ), Eigen::Vector3d( 30, 20, 2 ) ) );
+    ASSERT_EQ( 1.0, focus.rate_in_focus() );
+    EXPECT_GT( 0.01, mismatch( db, focus, 720 ) );
+    EXPECT_GT( 0.001, mismatch( db, focus, 36000 ) );
+}
+
+TEST( focus_table, update )
+{
+    db db = test::testdb();
+    thin::focus focus( 1.0, 1.0 );
+    focus.insert( 0, new thin::sector( 0, 20 ) );
+    thin::focus_table table( db );
+    table.update( focus );
+    EXPECT_FALSE( table.in_focus( 0, 18000, 1000 ) );
+    focus.insert( 1, new thin::sector( 180, 20 ) );
+    EXPECT_FALSE( table.in_focus( 0, 18000, 1000 ) ); // not updated until asked
+    table.update( focus );
+    EXPECT_EQ( 1.0, focus.rate_in_focus() );
+    EXPECT_GT( 0.01, mismatch( db, focus, 720 ) );
+}
+
+TEST( focus_table, rates )
+{
+    db db = test::testdb();
+    thin::focus focus( 0.2, 0.5 );
+    focus.insert( 0, new thin::sector( 90, 90 ) );
+    thin::focus_table table( db );
+    table.update( focus );
+    boost::mt19937 generator;
+    thin::counter_random random( 1 );
+    unsigned int in = 0, in_kept = 0, out = 0, out_kept = 0;
+    for( unsigned int i = 0; i < 2000; ++i )
+    {
+        packet p = make_packet( ( i * 1777 ) % 36000, generator );
+        packet q = p;
+        table.thin( q, random );
+        for( unsigned int block = 0; block < 12; ++block )
+        {
+            for( unsigned int laser = 0; laser < 32; ++laser )
+            {
+                bool f = table.in_focus( laser + ( block & 0x1 ) * 32, p.blocks[block].rotation(), p.blocks[block].lasers[laser].range() );
+                bool kept = q.blocks[block].lasers[laser].range() != 0;
+                ( f ? in : out ) += 1;
+                ( f ? in_kept : out_kept ) += kept;
+            }
+        }
+    }
+    ASSERT_LT( 0u, in );
+    ASSERT_LT( 0u, out );
+    EXPECT_NEAR( focus.rate_in_focus(), double( in_kept ) / in, 0.01 );
+    EXPECT_NEAR( focus.rate_out_of_focus(), double( out_kept ) / out, 0.01 );
+}
+
+TEST( focus_table, counter_random )
+{
+    thin::counter_random a( 5 ), b( 5 ), c( 6 );
+    for( unsigned int i = 0; i < 100; ++i ) { EXPECT_EQ( a.next(), b.next() ); }
+    EXPECT_NE( a.next(), c.next() );
+    double sum = 0;
+    for( unsigned int i = 0; i < 100000; ++i ) { float f = a(); EXPECT_LE( 0, f ); EXPECT_GT( 1, f ); sum += f; }
+    EXPECT_NEAR( 0.5, sum / 100000, 0.01 );
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,121 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <vector>
+#include <gtest/gtest.h>
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/merge.h>
+
+namespace snark {  namespace velodyne {
+
+// merge given sources, each split into packets of given size
+static std::vector< std::pair< comma::int64, unsigned int > > merged( const std::vector< std::vector< comma::int64 > >& sources, std::size_t packet_size )
+{
+    std::vector< std::pair< comma::int64, unsigned int > > result;
+    std::vector< std::size_t > offsets( sources.size(), 0 );
+    std::vector< std::size_t > starts( sources.size(), 0 ); // offset of the current packet
+    merge m( sources.size() );
+    while( true )
+    {
+        while( m.waiting() )
+        {
+            unsigned int s = *m.waiting();
+            if( offsets[s] >= sources[s].size() ) { m.close( s ); continue; }
+            std::size_t size = std::min( packet_size, sources[s].size() - offsets[s] );
+            m.push( s, &sources[s][ offsets[s] ], size );
+            starts[s] = offsets[s];
+            offsets[s] += size;
+        }
+        if( m.empty() ) { break; }
+        result.push_back( std::make_pair( m.top().t, m.top().source ) );
+        EXPECT_EQ( sources[ m.top().source ][ starts[ m.top().source ] + m.top().index ], m.top().t );
+        m.pop();
+    }
+    return result;
+}
+
+TEST( merge, ordered )
+{
+    std::vector< std::vector< comma::int64 > > sources( 3 );
+    for( comma::int64 t = 0; t < 100; ++t ) { sources[ ( t * 7 ) % 3 ].push_back( t ); }
+    for( std::size_t packet_size = 1; packet_size < 10; ++packet_size )
+    {
+        std::vector< std::pair< comma::int64, unsigned int > > r = merged( sources, packet_size );
+        ASSERT_EQ( 100u, r.size() );
+        for( std::size_t i = 0; i < r.size(); ++i )
+        {
+            EXPECT_EQ( comma::int64( i ), r[i].first );
+            EXPECT_EQ( ( i * 7 ) % 3, r[i].second );
+        }
+    }
+}
+
+TEST( merge, ties )
+{
+    std::vector< std::vector< comma::int64 > > sources( 2, std::vector< comma::int64 >( 5, 10 ) );
+    std::vector< std::pair< comma::int64, unsigned int > > r = merged( sources, 2 );
+    ASSERT_EQ( 10u, r.size() );
+    for( std::size_t i = 0; i < 5; ++i ) { EXPECT_EQ( 0u, r[i].second ); } // ties go to the lower source
+    for( std::size_t i = 5; i < 10; ++i ) { EXPECT_EQ( 1u, r[i].second ); }
+}
+
+TEST( merge, uneven )
+{
+    std::vector< std::vector< comma::int64 > > sources( 4 );
+    sources[1].push_back( 5 );
+    for( comma::int64 t = 0; t < 20; ++t ) { sources[3].push_back( t * 2 ); }
+    for( comma::int64 t = 0; t < 10; ++t ) { sources[2].push_back( t * 3 + 1 ); }
+    std::vector< std::pair< comma::int64, unsigned int > > r = merged( sources, 4 );
+    ASSERT_EQ( 31u, r.size() );
+    for( std::size_t i = 1; i < r.size(); ++i ) { EXPECT_LE( r[ i - 1 ].first, r[i].first ); }
+}
+
+TEST( merge, closed_source_pushed_again )
+{
+    comma::int64 a[] = { 1, 2, 3 };
+    comma::int64 b[] = { 4, 5 };
+    merge m( 2 );
+    m.push( 0, a, 3 );
+    m.close( 1 ); // e.g. source 1 stalled
+    EXPECT_FALSE( m.waiting() );
+    EXPECT_EQ( 1, m.top().t );
+    m.pop();
+    m.push( 1, b, 2 ); // source 1 is back
+    EXPECT_EQ( 2, m.top().t );
+    m.pop();
+    m.pop();
+    EXPECT_EQ( 4, m.top().t );
+    EXPECT_EQ( 1u, m.top().source );
+    ASSERT_TRUE( bool( m.waiting() ) );
+    EXPECT_EQ( 0u, *m.waiting() );
+    EXPECT_THROW( m.push( 1, b, 2 ), comma::exception );
+}
+
+} } // namespace snark {  namespace velodyne {
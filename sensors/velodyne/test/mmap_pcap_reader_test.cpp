@@ -0,0 +1,137 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <gtest/gtest.h>
+#include <comma/base/types.h>
+#include <snark/sensors/velodyne/impl/mmap_pcap_reader.h>
+#include <snark/sensors/velodyne/impl/stream_traits.h>
+
+namespace snark {  namespace velodyne {
+
+static comma::uint32 swapped( comma::uint32 v ) { return ( v >> 24 ) | ( ( v >> 8 ) & 0xff00 ) | ( ( v << 8 ) & 0xff0000 ) | ( v << 24 ); }
+
+static void write( std::ofstream& ofs, comma::uint32 v, bool swap ) { if( swap ) { v = swapped( v ); } ofs.write( reinterpret_cast< const char* >( &v ), 4 ); }
+
+static void write_pcap( const std::string& filename, comma::uint32 magic, bool swap, unsigned int count, bool truncated = false, std::size_t size = 10 )
+{
+    std::ofstream ofs( filename.c_str(), std::ios::binary );
+    write( ofs, magic, swap );
+    write( ofs, 0x00040002, swap ); // version 2.4, byte order does not matter for the test
+    write( ofs, 0, swap );
+    write( ofs, 0, swap );
+    write( ofs, 65535, swap );
+    write( ofs, 1, swap );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        std::string payload( size + i, char( 'a' + i ) );
+        write( ofs, 1000 + i, swap );
+        write( ofs, 500 + i, swap );
+        write( ofs, payload.size(), swap );
+        write( ofs, payload.size(), swap );
+        ofs.write( &payload[0], truncated && i + 1 == count ? 3 : payload.size() );
+    }
+}
+
+static void check( comma::uint32 magic, bool swap, bool nanoseconds )
+{
+    const std::string filename = "mmap_pcap_reader_test.pcap";
+    write_pcap( filename, magic, swap, 5 );
+    {
+        mmap_pcap_reader reader( filename );
+        EXPECT_EQ( nanoseconds, reader.nanosecond_resolution() );
+        for( unsigned int i = 0; i < 5; ++i )
+        {
+            const char* p = reader.read();
+            ASSERT_TRUE( p != NULL );
+            EXPECT_EQ( 10 + i, reader.size() );
+            EXPECT_EQ( std::string( 10 + i, char( 'a' + i ) ), std::string( p, reader.size() ) );
+            EXPECT_EQ( comma::int64( 1000 + i ) * 1000000000 + ( 500 + i ) * ( nanoseconds ? 1 : 1000 ), reader.nanoseconds() );
+        }
+        EXPECT_TRUE( reader.read() == NULL );
+        EXPECT_TRUE( reader.eof() );
+        EXPECT_EQ( 5u, reader.build_index() );
+        reader.seek( 3 );
+        const char* p = reader.read();
+        ASSERT_TRUE( p != NULL );
+        EXPECT_EQ( 'd', *p );
+        EXPECT_EQ( comma::int64( 1003 ), reader.nanoseconds() / 1000000000 );
+        reader.seek_offset( reader.index()[1] );
+        p = reader.read();
+        ASSERT_TRUE( p != NULL );
+        EXPECT_EQ( 'b', *p );
+    }
+    std::remove( filename.c_str() );
+}
+
+TEST( mmap_pcap_reader, read )
+{
+    check( 0xa1b2c3d4, false, false );
+    check( 0xa1b2c3d4, true, false );
+    check( 0xa1b23c4d, false, true );
+    check( 0xa1b23c4d, true, true );
+}
+
+TEST( mmap_pcap_reader, truncated )
+{
+    const std::string filename = "mmap_pcap_reader_test.pcap";
+    write_pcap( filename, 0xa1b2c3d4, false, 3, true );
+    {
+        mmap_pcap_reader reader( filename );
+        EXPECT_TRUE( reader.read() != NULL );
+        EXPECT_TRUE( reader.read() != NULL );
+        EXPECT_TRUE( reader.read() == NULL );
+        EXPECT_EQ( 2u, reader.build_index() );
+    }
+    std::remove( filename.c_str() );
+}
+
+TEST( mmap_pcap_reader, stream_traits_skip_short_records )
+{
+    const std::string filename = "mmap_pcap_reader_test.pcap";
+    write_pcap( filename, 0xa1b2c3d4, false, 5, false, 40 ); // records of 40 to 44 bytes
+    {
+        mmap_pcap_reader reader( filename );
+        const char* p = impl::stream_traits< mmap_pcap_reader >::read( reader, 1 ); // records shorter than 42 + 1 bytes skipped
+        ASSERT_TRUE( p != NULL );
+        EXPECT_EQ( 43u, reader.size() );
+        EXPECT_EQ( 'd', *p );
+        p = impl::stream_traits< mmap_pcap_reader >::read( reader, 1 );
+        ASSERT_TRUE( p != NULL );
+        EXPECT_EQ( 'e', *p );
+        EXPECT_TRUE( impl::stream_traits< mmap_pcap_reader >::read( reader, 1 ) == NULL );
+    }
+    std::remove( filename.c_str() );
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,101 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <sstream>
+#include <gtest/gtest.h>
+#include <snark/sensors/velodyne/nav_frame.h>
+
+namespace snark {  namespace velodyne {
+
+static boost::posix_time::ptime time( unsigned int milliseconds ) { return boost::posix_time::ptime( boost::gregorian::date( 2014, 1, 1 ) ) + boost::posix_time::milliseconds( milliseconds ); }
+
+TEST( nav_frame, interpolate )
+{
+    std::istringstream iss( "20140101T000000,0,0,0,0,0,0\n"
+                            "20140101T000001,10,0,0,0,0,1\n"
+                            "20140101T000002,10,20,0,0,0,1\n" );
+    nav_frame nav( iss, comma::csv::options() );
+    nav_frame::transform t;
+    EXPECT_TRUE( nav.at( time( 0 ), t ) );
+    EXPECT_TRUE( t.translation.isApprox( Eigen::Vector3d::Zero() ) );
+    EXPECT_TRUE( nav.at( time( 500 ), t ) );
+    EXPECT_TRUE( t.translation.isApprox( Eigen::Vector3d( 5, 0, 0 ) ) );
+    EXPECT_TRUE( ( t * Eigen::Vector3d( 1, 0, 0 ) ).isApprox( Eigen::Vector3d( 5 + std::cos( 0.5 ), std::sin( 0.5 ), 0 ) ) );
+    EXPECT_TRUE( nav.at( time( 1250 ), t ) );
+    EXPECT_TRUE( t.translation.isApprox( Eigen::Vector3d( 10, 5, 0 ) ) );
+    EXPECT_FALSE( nav.at( time( 900 ), t ) ); // out of order, before current pair of nav records
+    EXPECT_TRUE( nav.at( time( 2000 ), t ) );
+    EXPECT_FALSE( nav.eof() );
+    EXPECT_FALSE( nav.at( time( 2001 ), t ) );
+    EXPECT_TRUE( nav.eof() );
+}
+
+TEST( nav_frame, before_first )
+{
+    std::istringstream iss( "20140101T000001,0,0,0,0,0,0\n20140101T000002,1,0,0,0,0,0\n" );
+    nav_frame nav( iss, comma::csv::options() );
+    nav_frame::transform t;
+    EXPECT_FALSE( nav.at( time( 999 ), t ) );
+    EXPECT_TRUE( nav.at( time( 1500 ), t ) );
+    EXPECT_NEAR( 0.5, t.translation.x(), 1e-9 );
+}
+
+TEST( nav_frame, yaw_across_pi )
+{
+    std::istringstream iss( "20140101T000000,0,0,0,0,0,3.04159265358979\n20140101T000001,0,0,0,0,0,-3.04159265358979\n" );
+    nav_frame nav( iss, comma::csv::options() );
+    nav_frame::transform t;
+    EXPECT_TRUE( nav.at( time( 500 ), t ) );
+    EXPECT_TRUE( ( t * Eigen::Vector3d( 1, 0, 0 ) ).isApprox( Eigen::Vector3d( -1, 0, 0 ), 1e-9 ) );
+}
+
+TEST( nav_frame, nearest_and_max_gap )
+{
+    std::istringstream iss( "20140101T000000,0,0,0,0,0,0\n20140101T000001,1,0,0,0,0,0\n20140101T000005,2,0,0,0,0,0\n" );
+    nav_frame nav( iss, comma::csv::options(), false, boost::posix_time::seconds( 2 ) );
+    nav_frame::transform t;
+    EXPECT_TRUE( nav.at( time( 400 ), t ) );
+    EXPECT_EQ( 0, t.translation.x() );
+    EXPECT_TRUE( nav.at( time( 600 ), t ) );
+    EXPECT_EQ( 1, t.translation.x() );
+    EXPECT_FALSE( nav.at( time( 3000 ), t ) ); // gap
+}
+
+TEST( nav_frame, sensor )
+{
+    std::istringstream iss( "20140101T000000,10,0,0,0,0,1.57079632679490\n20140101T000001,10,0,0,0,0,1.57079632679490\n" );
+    nav_frame nav( iss, comma::csv::options() );
+    nav.sensor( nav_frame::pose( Eigen::Vector3d( 1, 0, 2 ) ) );
+    nav_frame::transform t;
+    EXPECT_TRUE( nav.at( time( 500 ), t ) );
+    EXPECT_TRUE( ( t * Eigen::Vector3d( 1, 0, 0 ) ).isApprox( Eigen::Vector3d( 10, 2, 2 ), 1e-9 ) ); // sensor at 1,0,2 in body, body yawed 90 degrees
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,132 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <snark/sensors/velodyne/packet_decoder.h>
+#include <snark/sensors/velodyne/impl/get_laser_return.h>
+#include "./db.h"
+
+namespace snark {  namespace velodyne {
+
+static packet make_packet( unsigned int rotation )
+{
+    packet p;
+    ::memset( &p, 0, packet::size );
+    for( unsigned int block = 0; block < 12; ++block )
+    {
+        p.blocks[block].id = ( block & 0x1 ) ? packet::lower_block_id() : packet::upper_block_id();
+        p.blocks[block].rotation = ( rotation + ( block / 2 ) * 17 ) % 36000;
+        for( unsigned int laser = 0; laser < 32; ++laser )
+        {
+            p.blocks[block].lasers[laser].range = ( block * 32 + laser ) % 7 == 0 ? 0 : 1000 + block * 300 + laser * 11;
+            p.blocks[block].lasers[laser].intensity = laser * 3 + block;
+        }
+    }
+    return p;
+}
+
+static void check( const packet& p, const db& db, double angular_speed )
+{
+    boost::posix_time::ptime timestamp( boost::gregorian::date( 2014, 1, 1 ), boost::posix_time::seconds( 5 ) );
+    packet_decoder decoder( db );
+    decoded_packet decoded;
+    EXPECT_EQ( 384u, decoder.decode( p, timestamp, angular_speed, true, decoded ) );
+    for( unsigned int i = 0; i < decoded.size; ++i )
+    {
+        unsigned int block = ( i / 64 ) * 2 + ( i & 0x1 );
+        unsigned int laser = ( i % 64 ) / 2;
+        laser_return r = impl::get_laser_return( p, block, laser, timestamp, angular_speed );
+        std::pair< ::Eigen::Vector3d, ::Eigen::Vector3d > ray = db.lasers[ r.id ].ray( r.range, r.azimuth );
+        EXPECT_EQ( r.id, decoded.id[i] );
+        EXPECT_EQ( r.intensity, decoded.intensity[i] );
+        EXPECT_EQ( r.timestamp, decoded.t[i] );
+        EXPECT_DOUBLE_EQ( db.lasers[ r.id ].range( r.range ), decoded.range[i] );
+        EXPECT_DOUBLE_EQ( db.lasers[ r.id ].azimuth( r.azimuth ), decoded.azimuth[i] );
+        EXPECT_NEAR( ray.first.x(), decoded.origin_x[i], 1e-6 );
+        EXPECT_NEAR( ray.first.y(), decoded.origin_y[i], 1e-6 );
+        EXPECT_NEAR( ray.first.z(), decoded.origin_z[i], 1e-6 );
+        EXPECT_NEAR( ray.second.x(), decoded.x[i], 1e-6 );
+        EXPECT_NEAR( ray.second.y(), decoded.y[i], 1e-6 );
+        EXPECT_NEAR( ray.second.z(), decoded.z[i], 1e-6 );
+        EXPECT_EQ( r.range != 0, decoded.valid[i] );
+        EXPECT_EQ( block, decoded.block[i] );
+    }
+    std::size_t size = decoder.decode( p, timestamp, angular_speed, false, decoded );
+    EXPECT_EQ( size, decoded.size );
+    for( unsigned int i = 0; i < decoded.size; ++i ) { EXPECT_TRUE( decoded.valid[i] ); }
+}
+
+TEST( packet_decoder, consistency )
+{
+    check( make_packet( 0 ), test::testdb(), 3600 );
+    check( make_packet( 17950 ), test::testdb(), 3600 );
+    check( make_packet( 35990 ), test::testdb(), 3580 );
+    check( make_packet( 9000 ), test::zerodb(), 3600 );
+}
+
+static void check_filter( const packet& p, const db& db, const return_filter& filter, bool output_invalid )
+{
+    boost::posix_time::ptime timestamp( boost::gregorian::date( 2014, 1, 1 ), boost::posix_time::seconds( 5 ) );
+    packet_decoder decoder( db );
+    decoded_packet all;
+    decoder.decode( p, timestamp, 3600, true, all );
+    decoded_packet filtered;
+    decoder.decode( p, timestamp, 3600, output_invalid, filtered, &filter );
+    std::size_t size = 0;
+    for( unsigned int i = 0; i < all.size; ++i )
+    {
+        unsigned int block = ( i / 64 ) * 2 + ( i & 0x1 );
+        unsigned int laser = ( i % 64 ) / 2;
+        if( !filter( p, block, laser ) || ( !output_invalid && !all.valid[i] ) ) { continue; }
+        ASSERT_LT( size, filtered.size );
+        EXPECT_EQ( all.id[i], filtered.id[size] );
+        EXPECT_EQ( all.t[i], filtered.t[size] );
+        EXPECT_EQ( all.valid[i], filtered.valid[size] );
+        EXPECT_EQ( all.block[i], filtered.block[size] );
+        EXPECT_DOUBLE_EQ( all.x[i], filtered.x[size] );
+        ++size;
+    }
+    EXPECT_EQ( size, filtered.size );
+}
+
+TEST( packet_decoder, filter )
+{
+    std::vector< unsigned int > lasers;
+    lasers.push_back( 3 );
+    lasers.push_back( 40 );
+    check_filter( make_packet( 100 ), test::testdb(), return_filter().lasers( lasers ), false );
+    check_filter( make_packet( 100 ), test::testdb(), return_filter().lasers( lasers ), true );
+    check_filter( make_packet( 100 ), test::testdb(), return_filter().range( 3, 6 ), false );
+    check_filter( make_packet( 35990 ), test::testdb(), return_filter().azimuth( 89, 90.5 ), true );
+    check_filter( make_packet( 100 ), test::testdb(), return_filter(), false );
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,104 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/return_filter.h>
+
+namespace snark {  namespace velodyne {
+
+TEST( return_filter, all )
+{
+    return_filter f;
+    EXPECT_TRUE( f.all() );
+    EXPECT_TRUE( f( 0, 0, 0, 0 ) );
+    EXPECT_TRUE( f( 63, 65535, 35999, 255 ) );
+}
+
+TEST( return_filter, lasers )
+{
+    std::vector< unsigned int > ids;
+    ids.push_back( 0 );
+    ids.push_back( 33 );
+    ids.push_back( 63 );
+    return_filter f;
+    f.lasers( ids );
+    EXPECT_FALSE( f.all() );
+    EXPECT_TRUE( f( 0, 100, 0, 0 ) );
+    EXPECT_FALSE( f( 1, 100, 0, 0 ) );
+    EXPECT_FALSE( f( 32, 100, 0, 0 ) );
+    EXPECT_TRUE( f( 33, 100, 0, 0 ) );
+    EXPECT_TRUE( f( 63, 100, 0, 0 ) );
+    ids.push_back( 64 );
+    EXPECT_THROW( f.lasers( ids ), comma::exception );
+}
+
+TEST( return_filter, range )
+{
+    return_filter f;
+    f.range( 1, 2 );
+    EXPECT_FALSE( f( 0, 499, 0, 0 ) );
+    EXPECT_TRUE( f( 0, 500, 0, 0 ) );
+    EXPECT_TRUE( f( 0, 1000, 0, 0 ) );
+    EXPECT_FALSE( f( 0, 1001, 0, 0 ) );
+    EXPECT_FALSE( f( 0, 0, 0, 0 ) );
+    EXPECT_THROW( f.range( 2, 1 ), comma::exception );
+}
+
+TEST( return_filter, azimuth )
+{
+    return_filter f;
+    f.azimuth( 100, 110 ); // output azimuth is rotation plus 90 degrees
+    EXPECT_FALSE( f( 0, 100, 999, 0 ) );
+    EXPECT_TRUE( f( 0, 100, 1000, 0 ) );
+    EXPECT_TRUE( f( 0, 100, 1999, 0 ) );
+    EXPECT_FALSE( f( 0, 100, 2000, 0 ) );
+    f.azimuth( 80, 100 ); // across zero rotation
+    EXPECT_TRUE( f( 0, 100, 35000, 0 ) );
+    EXPECT_TRUE( f( 0, 100, 0, 0 ) );
+    EXPECT_TRUE( f( 0, 100, 999, 0 ) );
+    EXPECT_FALSE( f( 0, 100, 1000, 0 ) );
+    EXPECT_FALSE( f( 0, 100, 34999, 0 ) );
+    f.azimuth( 0, 360 );
+    EXPECT_TRUE( f( 0, 100, 0, 0 ) );
+    EXPECT_TRUE( f( 0, 100, 35999, 0 ) );
+}
+
+TEST( return_filter, intensity )
+{
+    return_filter f;
+    f.intensity( 10, 20 );
+    EXPECT_FALSE( f( 0, 100, 0, 9 ) );
+    EXPECT_TRUE( f( 0, 100, 0, 10 ) );
+    EXPECT_TRUE( f( 0, 100, 0, 20 ) );
+    EXPECT_FALSE( f( 0, 100, 0, 21 ) );
+}
+
+} } // namespace snark {  namespace velodyne {
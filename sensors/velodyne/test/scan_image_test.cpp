@@ -0,0 +1,119 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+#include <snark/sensors/velodyne/scan_image.h>
+#include "./db.h"
+
+namespace snark {  namespace velodyne {
+
+static void add( decoded_packet& p, unsigned int id, double azimuth, double range, comma::int64 t )
+{
+    p.id[ p.size ] = id;
+    p.azimuth[ p.size ] = azimuth;
+    p.range[ p.size ] = range;
+    p.intensity[ p.size ] = 100;
+    p.x[ p.size ] = range;
+    p.y[ p.size ] = 0;
+    p.z[ p.size ] = 0;
+    p.t[ p.size ] = t;
+    p.valid[ p.size ] = range > 0;
+    ++p.size;
+}
+
+TEST( scan_image, column )
+{
+    scan_image image( 64, 360 );
+    EXPECT_EQ( 0u, image.column( 0 ) );
+    EXPECT_EQ( 0u, image.column( 0.5 ) );
+    EXPECT_EQ( 1u, image.column( 1.5 ) );
+    EXPECT_EQ( 359u, image.column( 359.9 ) );
+    EXPECT_EQ( 359u, image.column( -0.5 ) );
+    EXPECT_EQ( 0u, image.column( 360 ) );
+    EXPECT_EQ( 10u, image.column( 370.5 ) );
+}
+
+TEST( scan_image, insert )
+{
+    db db( test::testdb() );
+    laser_map map( db );
+    scan_image image( 64, 360 );
+    image.clear( 5 );
+    decoded_packet p;
+    add( p, 0, 10.5, 20, 1000000000 );
+    add( p, 0, 10.7, 10, 1001000000 ); // same cell, nearer: kept
+    add( p, 0, 10.9, 30, 1002000000 ); // same cell, farther: ignored
+    add( p, 1, 20.0, 0, 1003000000 ); // invalid
+    add( p, 1, 30.0, 15, 1004000000 );
+    image.insert( p, map );
+    EXPECT_EQ( 5u, image.get_header().scan );
+    EXPECT_EQ( 2u, image.size() );
+    EXPECT_EQ( boost::posix_time::ptime( boost::gregorian::date( 1970, 1, 1 ), boost::posix_time::seconds( 1 ) ), image.get_header().t );
+    const scan_image::cell& c = image( map[0], 10 );
+    EXPECT_FLOAT_EQ( 10, c.range );
+    EXPECT_FLOAT_EQ( 100, c.intensity );
+    EXPECT_FLOAT_EQ( 0.001, c.t );
+    EXPECT_FLOAT_EQ( 15, image( map[1], 30 ).range );
+    EXPECT_FLOAT_EQ( 0, image( map[1], 20 ).range );
+    image.clear( 6 );
+    EXPECT_TRUE( image.empty() );
+    EXPECT_FLOAT_EQ( 0, image( map[0], 10 ).range );
+}
+
+TEST( scan_image, assembler )
+{
+    db db( test::testdb() );
+    laser_map map( db );
+    scan_assembler assembler( db, 360 );
+    decoded_packet p;
+    p.scan = 1;
+    add( p, 0, 10, 10, 1000000000 );
+    EXPECT_TRUE( assembler.push( p ) == NULL );
+    p.size = 0;
+    add( p, 0, 20, 11, 1001000000 );
+    EXPECT_TRUE( assembler.push( p ) == NULL );
+    p.size = 0;
+    p.scan = 2;
+    add( p, 0, 10, 12, 1100000000 );
+    const scan_image* image = assembler.push( p );
+    ASSERT_TRUE( image != NULL );
+    EXPECT_EQ( 1u, image->get_header().scan );
+    EXPECT_EQ( 2u, image->size() );
+    EXPECT_FLOAT_EQ( 10, ( *image )( map[0], 10 ).range );
+    EXPECT_FLOAT_EQ( 11, ( *image )( map[0], 20 ).range );
+    image = assembler.flush();
+    ASSERT_TRUE( image != NULL );
+    EXPECT_EQ( 2u, image->get_header().scan );
+    EXPECT_EQ( 1u, image->size() );
+    EXPECT_FLOAT_EQ( 12, ( *image )( map[0], 10 ).range );
+    EXPECT_TRUE( assembler.flush() == NULL );
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,105 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstring>
+#include <sstream>
+#include <gtest/gtest.h>
+#include <snark/sensors/velodyne/scan_index.h>
+#include <snark/sensors/velodyne/stream.h>
+#include <snark/sensors/velodyne/impl/stream_reader.h>
+
+namespace snark {  namespace velodyne {
+
+static std::string make_log( unsigned int size )
+{
+    std::string log;
+    packet p;
+    ::memset( &p, 0, packet::size );
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        comma::uint64 microseconds = 1000000000000ULL + i * 500;
+        for( unsigned int block = 0; block < 12; ++block )
+        {
+            p.blocks[block].rotation = ( i * 1000 ) % 36000;
+            for( unsigned int laser = 0; laser < 32; ++laser ) { p.blocks[block].lasers[laser].range = 100 + laser; }
+        }
+        log.append( reinterpret_cast< const char* >( &microseconds ), sizeof( comma::uint64 ) );
+        log.append( p.data(), packet::size );
+    }
+    return log;
+}
+
+TEST( scan_index, make )
+{
+    std::istringstream iss( make_log( 200 ) );
+    stream_reader reader( iss );
+    scan_index index = scan_index::make( reader );
+    ASSERT_EQ( 6u, index.entries().size() ); // 36 packets per revolution
+    for( unsigned int i = 0; i < index.entries().size(); ++i ) { EXPECT_EQ( i + 1, index.entries()[i].scan ); }
+    EXPECT_EQ( 0u, index.entries()[0].offset );
+    EXPECT_TRUE( index.find( 3 ) != NULL );
+    EXPECT_TRUE( index.find( 7 ) == NULL );
+    ASSERT_TRUE( index.lower_bound( 0 ) != NULL );
+    EXPECT_EQ( 1u, index.lower_bound( 0 )->scan );
+    EXPECT_TRUE( index.lower_bound( 7 ) == NULL );
+    comma::uint32 first;
+    comma::uint32 last;
+    EXPECT_TRUE( index.scans( index.entries()[1].t, index.entries()[3].t, first, last ) );
+    EXPECT_EQ( 2u, first );
+    EXPECT_EQ( 4u, last );
+    EXPECT_FALSE( index.scans( index.entries()[5].t + boost::posix_time::seconds( 1 ), boost::posix_time::ptime(), first, last ) );
+}
+
+TEST( scan_index, seek )
+{
+    std::string log = make_log( 200 );
+    std::istringstream iss( log );
+    stream_reader reader( iss );
+    scan_index index = scan_index::make( reader );
+    const scan_index::entry* e = index.find( 4 );
+    ASSERT_TRUE( e != NULL );
+    ASSERT_EQ( 0u, e->offset % ( sizeof( comma::uint64 ) + packet::size ) );
+    std::istringstream all_iss( log );
+    stream< stream_reader > all( new stream_reader( all_iss ) );
+    for( unsigned int i = 0; i < e->offset / ( sizeof( comma::uint64 ) + packet::size ) + 5; ++i ) { all.read_packet(); }
+    std::istringstream jss( log );
+    stream< stream_reader > s( new stream_reader( jss ) );
+    s.reader().seek_offset( e->offset );
+    s.reset_scan( e->scan );
+    const packet* p = s.read_packet();
+    ASSERT_TRUE( p != NULL );
+    EXPECT_EQ( 4u, s.scan() );
+    EXPECT_EQ( e->t, s.timestamp() );
+    for( unsigned int i = 0; i < 4; ++i ) { s.read_packet(); }
+    EXPECT_EQ( all.timestamp(), s.timestamp() );
+    EXPECT_EQ( all.scan(), s.scan() );
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,184 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+#include <gtest/gtest.h>
+#include <snark/sensors/velodyne/thin/thin.h>
+#include <snark/sensors/velodyne/thin/v2.h>
+#include <snark/sensors/velodyne/impl/thin_reader.h>
+
+namespace snark {  namespace velodyne {
+
+static packet make_packet( unsigned int rotation, double rate, boost::mt19937& generator )
+{
+    boost::uniform_int< int > noise( -40, 40 );
+    boost::uniform_int< int > uniform( 0, 999 );
+    boost::variate_generator< boost::mt19937&, boost::uniform_int< int > > n( generator, noise );
+    boost::variate_generator< boost::mt19937&, boost::uniform_int< int > > u( generator, uniform );
+    packet p;
+    ::memset( &p, 0, packet::size );
+    for( unsigned int block = 0; block < 12; ++block )
+    {
+        p.blocks[block].id = ( block & 0x1 ) ? packet::lower_block_id() : packet::upper_block_id();
+        p.blocks[block].rotation = ( rotation + ( block / 2 ) * 17 ) % 36000;
+        for( unsigned int laser = 0; laser < 32; ++laser )
+        {
+            if( u() >= rate * 1000 ) { continue; }
+            p.blocks[block].lasers[laser].range = 5000 + ( block & 0x1 ) * 3000 + laser * 50 + n();
+            p.blocks[block].lasers[laser].intensity = u() % 256;
+        }
+    }
+    return p;
+}
+
+static void check_v2( const packet& p, unsigned int intensity_bits )
+{
+    char buf[ thin::v2::maxBufferSize ];
+    std::size_t size = thin::v2::serialize( p, buf, 1234, intensity_bits );
+    EXPECT_LE( size, std::size_t( thin::v2::maxBufferSize ) );
+    packet q;
+    EXPECT_EQ( 1234u, thin::v2::deserialize( q, buf ) );
+    for( unsigned int block = 0; block < 12; block += 2 )
+    {
+        bool empty = true;
+        for( unsigned int i = 0; i < 64 && empty; ++i ) { empty = p.blocks[ block + i / 32 ].lasers[ i % 32 ].range() == 0; }
+        if( empty ) { continue; }
+        EXPECT_EQ( p.blocks[block].rotation(), q.blocks[block].rotation() );
+        EXPECT_EQ( p.blocks[block].rotation(), q.blocks[ block + 1 ].rotation() );
+        EXPECT_EQ( std::string( packet::upper_block_id(), 2 ), std::string( q.blocks[block].id.data(), 2 ) );
+        EXPECT_EQ( std::string( packet::lower_block_id(), 2 ), std::string( q.blocks[ block + 1 ].id.data(), 2 ) );
+        for( unsigned int b = block; b < block + 2; ++b )
+        {
+            for( unsigned int laser = 0; laser < 32; ++laser )
+            {
+                const packet::laser_return& expected = p.blocks[b].lasers[laser];
+                const packet::laser_return& actual = q.blocks[b].lasers[laser];
+                EXPECT_EQ( expected.range(), actual.range() );
+                if( expected.range() == 0 || intensity_bits == 0 ) { EXPECT_EQ( 0, actual.intensity() ); continue; }
+                unsigned int step = 1 << ( 8 - intensity_bits );
+                EXPECT_EQ( expected.intensity() / step, actual.intensity() / step );
+            }
+        }
+    }
+}
+
+TEST( thin, v2_round_trip )
+{
+    boost::mt19937 generator;
+    for( unsigned int i = 0; i < 100; ++i )
+    {
+        for( unsigned int bits = 0; bits <= 8; bits += 4 )
+        {
+            check_v2( make_packet( i * 360, 1.0, generator ), bits );
+            check_v2( make_packet( i * 360 + 50, 0.5, generator ), bits );
+            check_v2( make_packet( i * 360 + 100, 0.05, generator ), bits );
+        }
+    }
+    check_v2( make_packet( 35950, 0.7, generator ), 3 ); // rotation wraps within packet
+    check_v2( make_packet( 0, 0, generator ), 0 );
+    packet p = make_packet( 100, 1.0, generator );
+    p.blocks[4].rotation = 65000; // invalid rotation still gets restored
+    p.blocks[2].lasers[3].range = 65535;
+    p.blocks[2].lasers[4].range = 1;
+    check_v2( p, 8 );
+}
+
+TEST( thin, v2_compression )
+{
+    boost::mt19937 generator;
+    std::size_t v1 = 0;
+    std::size_t v2 = 0;
+    for( unsigned int i = 0; i < 100; ++i )
+    {
+        packet p = make_packet( i * 360, 0.5, generator );
+        char buf[ thin::v2::maxBufferSize ];
+        v1 += thin::serialize( p, buf, 1 );
+        v2 += thin::v2::serialize( p, buf, 1 );
+    }
+    EXPECT_LT( v2, v1 );
+}
+
+static void write_record( std::ofstream& ofs, const packet& p, comma::uint32 scan, comma::int64 seconds, bool v2 )
+{
+    char buf[ 12 + thin::v2::maxBufferSize ];
+    comma::int32 nanoseconds = 0;
+    ::memcpy( buf, &seconds, sizeof( comma::int64 ) );
+    ::memcpy( buf + sizeof( comma::int64 ), &nanoseconds, sizeof( comma::int32 ) );
+    comma::uint16 size = 12 + ( v2 ? thin::v2::serialize( p, buf + 12, scan, 8 ) : thin::serialize( p, buf + 12, scan ) );
+    comma::uint16 header = v2 ? size | thin::v2::record_flag : size;
+    ofs.write( reinterpret_cast< const char* >( &header ), 2 );
+    ofs.write( buf, size );
+}
+
+TEST( thin, reader )
+{
+    const std::string filename = "thin_test.bin";
+    boost::mt19937 generator;
+    std::vector< packet > packets;
+    {
+        std::ofstream ofs( filename.c_str(), std::ios::binary );
+        for( unsigned int i = 0; i < 6; ++i )
+        {
+            packets.push_back( make_packet( i * 360, 0.5, generator ) );
+            write_record( ofs, packets.back(), i / 2, 1000 + i, i % 3 == 0 );
+        }
+    }
+    comma::uint64 third = 0;
+    {
+        thin_reader reader( filename );
+        for( unsigned int i = 0; i < 6; ++i )
+        {
+            const packet* p = reinterpret_cast< const packet* >( reader.read() );
+            ASSERT_TRUE( p != NULL );
+            EXPECT_EQ( i % 2 == 0, reader.is_new_scan() );
+            EXPECT_EQ( boost::posix_time::ptime( boost::gregorian::date( 1970, 1, 1 ), boost::posix_time::seconds( 1000 + i ) ), reader.timestamp() );
+            for( unsigned int b = 0; b < 12; ++b )
+            {
+                for( unsigned int l = 0; l < 32; ++l ) { EXPECT_EQ( packets[i].blocks[b].lasers[l].range(), p->blocks[b].lasers[l].range() ); }
+            }
+            if( i == 2 ) { third = reader.position(); }
+        }
+        EXPECT_TRUE( reader.read() == NULL );
+        reader.seek_offset( third );
+        const packet* p = reinterpret_cast< const packet* >( reader.read() );
+        ASSERT_TRUE( p != NULL );
+        EXPECT_TRUE( reader.is_new_scan() );
+        EXPECT_EQ( third, reader.position() );
+        EXPECT_EQ( packets[2].blocks[5].lasers[7].range(), p->blocks[5].lasers[7].range() );
+    }
+    std::remove( filename.c_str() );
+}
+
+} } // namespace snark {  namespace velodyne {
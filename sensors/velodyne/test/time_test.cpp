@@ -0,0 +1,59 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <gtest/gtest.h>
+#include <snark/sensors/velodyne/time.h>
+
+namespace snark {  namespace velodyne {
+
+TEST( time, round_trip )
+{
+    boost::posix_time::ptime t( boost::gregorian::date( 2014, 1, 1 ), boost::posix_time::microseconds( 123456789 ) );
+    comma::int64 n = to_nanoseconds( t );
+    EXPECT_EQ( ( comma::int64( 1388534400 ) + 123 ) * 1000000000 + 456789000, n );
+    EXPECT_EQ( t, to_ptime( n ) );
+    EXPECT_EQ( t, to_ptime( n + 999 ) ); // truncated to microseconds
+    EXPECT_EQ( n, to_nanoseconds( 1388534400 + 123, 456789000 ) );
+}
+
+TEST( time, before_epoch )
+{
+    boost::posix_time::ptime t( boost::gregorian::date( 1969, 12, 31 ), boost::posix_time::hours( 23 ) + boost::posix_time::microseconds( 1500 ) );
+    EXPECT_EQ( t, to_ptime( to_nanoseconds( t ) ) );
+    EXPECT_EQ( t - boost::posix_time::microseconds( 1 ), to_ptime( to_nanoseconds( t ) - 1 ) );
+}
+
+TEST( time, invalid )
+{
+    EXPECT_EQ( invalid_time, to_nanoseconds( boost::posix_time::not_a_date_time ) );
+    EXPECT_TRUE( to_ptime( invalid_time ).is_not_a_date_time() );
+}
+
+} } // namespace snark {  namespace velodyne {
@@ -0,0 +1,75 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <comma/base/exception.h>
+#include "./bandwidth.h"
+
+namespace snark {  namespace velodyne { namespace thin {
+
+bandwidth::bandwidth( const config& c )
+    : config_( c )
+    , rate_( 1.0 )
+    , bytes_( 0 )
+    , total_bytes_( 0 )
+    , total_seconds_( 0 )
+    , last_( 0 )
+    , scans_( 0 )
+{
+    if( !( c.target > 0 ) ) { COMMA_THROW( comma::exception, "expected positive target bandwidth, got " << c.target ); }
+    if( c.headroom < 0 || c.headroom >= 1 ) { COMMA_THROW( comma::exception, "expected headroom in [0, 1), got " << c.headroom ); }
+    if( !( c.gain > 0 ) || c.gain > 1 ) { COMMA_THROW( comma::exception, "expected gain in (0, 1], got " << c.gain ); }
+    if( !( c.min_rate > 0 ) || c.min_rate > 1 ) { COMMA_THROW( comma::exception, "expected min rate in (0, 1], got " << c.min_rate ); }
+    if( !( c.max_step > 1 ) ) { COMMA_THROW( comma::exception, "expected max step greater than 1, got " << c.max_step ); }
+}
+
+double bandwidth::update( const boost::posix_time::ptime& t )
+{
+    if( start_.is_special() || t.is_special() || t <= start_ ) { start_ = t; bytes_ = 0; return rate_; } // first scan or timestamps out of order: nothing to measure
+    double seconds = double( ( t - start_ ).total_microseconds() ) / 1e6;
+    double budget = config_.target * ( 1 - config_.headroom ) * seconds;
+    double step = bytes_ == 0 ? config_.max_step : std::pow( budget / bytes_, config_.gain );
+    if( step > config_.max_step ) { step = config_.max_step; }
+    else if( step < 1 / config_.max_step ) { step = 1 / config_.max_step; }
+    rate_ *= step;
+    if( rate_ > 1 ) { rate_ = 1; }
+    else if( rate_ < config_.min_rate ) { rate_ = config_.min_rate; }
+    last_ = bytes_ / seconds;
+    total_bytes_ += bytes_;
+    total_seconds_ += seconds;
+    ++scans_;
+    bytes_ = 0;
+    start_ = t;
+    return rate_;
+}
+
+double bandwidth::achieved() const { return total_seconds_ > 0 ? total_bytes_ / total_seconds_ : 0; }
+
+} } } // namespace snark {  namespace velodyne { namespace thin {
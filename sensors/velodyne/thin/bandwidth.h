@@ -0,0 +1,97 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_THIN_BANDWIDTH_H_
+#define SNARK_SENSORS_VELODYNE_THIN_BANDWIDTH_H_
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <comma/base/types.h>
+
+namespace snark {  namespace velodyne { namespace thin {
+
+/// closed-loop thinning rate controller keeping output under a budget in bytes per second
+///
+/// bytes written are accounted with add(); on each new scan, update() compares
+/// the bytes of the finished scan against the budget for its duration and scales
+/// the rate by ( budget / bytes ) ^ gain, i.e. an integral controller in log domain,
+/// which converges for any output size monotonous in the rate for gain in (0, 1]
+/// and does not depend on the current point density or compression ratio
+class bandwidth
+{
+    public:
+        struct config
+        {
+            double target; /// bytes per second
+            double headroom; /// fraction of target kept in reserve, e.g. for bursts
+            double gain; /// controller gain in (0, 1]; lower: slower, smoother
+            double min_rate; /// never thin below this rate
+            double max_step; /// max rate change factor per scan
+            config( double target = 0, double headroom = 0.05, double gain = 0.5, double min_rate = 0.001, double max_step = 4 )
+                : target( target ), headroom( headroom ), gain( gain ), min_rate( min_rate ), max_step( max_step ) {}
+        };
+
+        bandwidth( const config& c );
+
+        /// account bytes emitted
+        void add( std::size_t bytes ) { bytes_ += bytes; }
+
+        /// call on the first packet of each new scan
+        /// @return thinning rate for the new scan
+        double update( const boost::posix_time::ptime& t );
+
+        /// current thinning rate
+        double rate() const { return rate_; }
+
+        /// target bytes per second
+        double target() const { return config_.target; }
+
+        /// bytes per second over all finished scans, 0 if none
+        double achieved() const;
+
+        /// bytes per second over last finished scan, 0 if none
+        double last() const { return last_; }
+
+        /// number of finished scans
+        comma::uint64 scans() const { return scans_; }
+
+    private:
+        config config_;
+        double rate_;
+        comma::uint64 bytes_; // bytes in current scan
+        comma::uint64 total_bytes_; // bytes in finished scans
+        double total_seconds_; // duration of finished scans
+        double last_;
+        comma::uint64 scans_;
+        boost::posix_time::ptime start_; // start of current scan
+};
+
+} } } // namespace snark {  namespace velodyne { namespace thin {
+
+#endif // SNARK_SENSORS_VELODYNE_THIN_BANDWIDTH_H_
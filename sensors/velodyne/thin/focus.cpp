@@ -48,6 +48,8 @@ double focus::rate_in_focus() const { return m_rate_in_focus; }
 
 double focus::rate_out_of_focus() const { return m_rate_out_of_focus; }
 
+const focus::Map& focus::regions() const { return m_regions; }
+
 double focus::coverage() const
 {
     double c = 0;
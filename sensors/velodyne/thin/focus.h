@@ -49,9 +49,10 @@ class focus
         double coverage() const;
         void insert( std::size_t id, region* r );
         void erase( std::size_t id );
+        typedef std::map< std::size_t, boost::shared_ptr< region > > Map;
+        const Map& regions() const;
 
     private:
-        typedef std::map< std::size_t, boost::shared_ptr< region > > Map;
         double m_rate;
         double m_ratio;
         Map m_regions;
@@ -0,0 +1,103 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cmath>
+#include <comma/base/exception.h>
+#include <snark/sensors/velodyne/impl/get_laser_return.h>
+#include "./focus_table.h"
+
+namespace snark {  namespace velodyne { namespace thin {
+
+static comma::uint64 threshold( double rate )
+{
+    if( rate <= 0 ) { return 0; }
+    if( rate >= 1 ) { return comma::uint64( 1 ) << 32; }
+    return comma::uint64( rate * double( comma::uint64( 1 ) << 32 ) );
+}
+
+static comma::uint16 to_raw( double range ) // quick and dirty: clamp to valid raw ranges
+{
+    if( range <= 0 ) { return 0; }
+    if( range >= 65535 ) { return 65535; }
+    return comma::uint16( range );
+}
+
+focus_table::focus_table( const velodyne::db& db, unsigned int bins, double angular_speed )
+    : db_( db )
+    , bins_( bins )
+    , angular_speed_( angular_speed )
+    , cells_( bins * 64 )
+    , in_( 0 )
+    , out_( 0 )
+{
+    if( bins == 0 || bins > 36000 ) { COMMA_THROW( comma::exception, "expected number of bins between 1 and 36000, got " << bins ); }
+}
+
+void focus_table::update( const focus& focus )
+{
+    in_ = threshold( focus.rate_in_focus() );
+    out_ = threshold( focus.rate_out_of_focus() );
+    for( unsigned int bin = 0; bin < bins_; ++bin )
+    {
+        double rotation = ( double( bin ) + 0.5 ) * 360 / bins_;
+        for( unsigned int id = 0; id < 64; ++id )
+        {
+            const db::laser_data& laser = db_.lasers[id];
+            double bearing = laser.azimuth( impl::azimuth( rotation, id % 32, angular_speed_ ) );
+            cell& c = cells_[ bin * 64 + id ];
+            c = cell();
+            double begin = 0;
+            double end = 0;
+            bool found = false;
+            for( focus::Map::const_iterator it = focus.regions().begin(); it != focus.regions().end(); ++it )
+            {
+                double b, e;
+                if( !it->second->span( bearing, laser.elevation, b, e ) ) { continue; }
+                if( !found || b < begin ) { begin = b; }
+                if( !found || e > end ) { end = e; }
+                found = true;
+            }
+            if( !found ) { continue; }
+            double raw_begin = std::ceil( ( begin - laser.distance_correction ) * 500 ); // see get_laser_return() and db::laser_data::range()
+            double raw_end = std::floor( ( end - laser.distance_correction ) * 500 );
+            if( raw_end < 1 || raw_begin > raw_end ) { continue; }
+            c.begin = to_raw( raw_begin );
+            c.end = to_raw( raw_end );
+        }
+    }
+}
+
+bool focus_table::in_focus( unsigned int id, unsigned int rotation, unsigned int range ) const
+{
+    const cell& c = cells_[ bin( rotation ) * 64 + id ];
+    return c.begin <= range && range <= c.end;
+}
+
+} } } // namespace snark {  namespace velodyne { namespace thin {
@@ -0,0 +1,129 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_THIN_FOCUS_TABLE_H_
+#define SNARK_SENSORS_VELODYNE_THIN_FOCUS_TABLE_H_
+
+#include <vector>
+#include <comma/base/types.h>
+#include <snark/sensors/velodyne/db.h>
+#include <snark/sensors/velodyne/packet.h>
+#include <snark/sensors/velodyne/thin/focus.h>
+
+namespace snark {  namespace velodyne { namespace thin {
+
+/// counter-based random numbers: cheap, reproducible, no state shared between sensors
+/// (splitmix64 finalizer over seed and a running counter)
+class counter_random
+{
+    public:
+        counter_random( comma::uint64 seed = 0 ) : counter_( seed * 0x9E3779B97F4A7C15ULL ) {}
+
+        /// @return uniformly distributed 32-bit number
+        comma::uint32 next()
+        {
+            comma::uint64 z = ( counter_ += 0x9E3779B97F4A7C15ULL );
+            z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+            z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+            return comma::uint32( ( z ^ ( z >> 31 ) ) >> 32 );
+        }
+
+        /// @return uniformly distributed number in [0, 1), as used by thin::thin()
+        float operator()() { return float( next() >> 8 ) / float( 1 << 24 ); }
+
+    private:
+        comma::uint64 counter_;
+};
+
+/// focus compiled into a table of keep thresholds per azimuth bin and laser
+///
+/// each cell holds the raw range interval (in packet units, i.e. 2mm) where
+/// the laser ray at the bin centre is in focus; returns inside the interval are
+/// kept with focus::rate_in_focus(), others with focus::rate_out_of_focus()
+///
+/// approximations: azimuth is quantized to the bin centre; if several regions
+/// intersect the same ray, the cell holds the hull of their range intervals
+///
+/// the table is not updated automatically: call update() after the focus changes
+class focus_table
+{
+    public:
+        /// @param bins number of azimuth bins per revolution
+        /// @param angular_speed nominal angular speed in degrees/second, used for firing offsets of lasers within block
+        focus_table( const velodyne::db& db, unsigned int bins = 720, double angular_speed = 3600 );
+
+        /// rebuild the table for given focus
+        void update( const focus& focus );
+
+        /// thin packet in place by setting range of dropped returns to 0
+        template < typename Random >
+        void thin( velodyne::packet& packet, Random& random ) const;
+
+        /// @return true, if return of given laser with given raw rotation (1/100 degree) and raw range is in focus
+        bool in_focus( unsigned int id, unsigned int rotation, unsigned int range ) const;
+
+        unsigned int bins() const { return bins_; }
+
+    private:
+        struct cell
+        {
+            comma::uint16 begin;
+            comma::uint16 end;
+            cell() : begin( 1 ), end( 0 ) {} // empty
+        };
+        const velodyne::db& db_;
+        unsigned int bins_;
+        double angular_speed_;
+        std::vector< cell > cells_; // bin-major: cells_[ bin * 64 + id ]
+        comma::uint64 in_; // keep threshold in focus, scaled to 2^32
+        comma::uint64 out_; // keep threshold out of focus, scaled to 2^32
+        unsigned int bin( unsigned int rotation ) const { return rotation < 36000 ? rotation * bins_ / 36000 : ( rotation % 36000 ) * bins_ / 36000; }
+};
+
+template < typename Random >
+void focus_table::thin( velodyne::packet& packet, Random& random ) const
+{
+    for( unsigned int block = 0; block < packet.blocks.size(); ++block )
+    {
+        velodyne::packet::laser_block& b = packet.blocks[block];
+        const cell* cells = &cells_[ bin( b.rotation() ) * 64 + ( block & 0x1 ) * 32 ];
+        for( unsigned int laser = 0; laser < b.lasers.size(); ++laser )
+        {
+            comma::uint16 range = b.lasers[laser].range();
+            if( range == 0 ) { continue; }
+            comma::uint64 threshold = cells[laser].begin <= range && range <= cells[laser].end ? in_ : out_;
+            if( random.next() >= threshold ) { b.lasers[laser].range = 0; }
+        }
+    }
+}
+
+} } } // namespace snark {  namespace velodyne { namespace thin {
+
+#endif // SNARK_SENSORS_VELODYNE_THIN_FOCUS_TABLE_H_
@@ -29,8 +29,10 @@
 
 /// @author vsevolod vlaskine
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 #include <comma/base/exception.h>
 #include <comma/math/compare.h>
 #include <snark/math/range_bearing_elevation.h>
@@ -59,6 +61,14 @@ bool sector::has( double r, double b, double ) const
 
 double sector::coverage() const { return comma::math::equal( range, 0 ) ? ken / 360 : ( range / 30 ) * ( ken / 360 ); } // quick and dirty
 
+bool sector::span( double b, double, double& begin, double& end ) const
+{
+    if( !has( 0, b, 0 ) ) { return false; }
+    begin = 0;
+    end = comma::math::equal( range, 0 ) ? std::numeric_limits< double >::max() : range;
+    return true;
+}
+
 extents::extents( const Eigen::Vector3d& min, const Eigen::Vector3d& max ) : interval( min, max ) {}
 
 extents::extents( const math::closed_interval< double, 3 >& interval ) : interval( interval ) {}
@@ -66,7 +76,7 @@ extents::extents( const math::closed_interval< double, 3 >& interval ) : interva
 bool extents::has( double range, double bearing, double elevation ) const // quick and dirty, watch performance
 {
     //std::cerr << "xyz: " << range_bearing_elevation( range, bearing, elevation ).to_cartesian().transpose() << std::endl;
-    return interval.contains( range_bearing_elevation( range, bearing, elevation ).to_cartesian() );
+    return interval.contains( range_bearing_elevation( range, bearing * M_PI / 180, elevation ).to_cartesian() ); // bearing in degrees as in sector, elevation in radians as in db
 }
 
 double extents::coverage() const // todo: quick and dirty; by right need to take cross-section of the extents with a conic section
@@ -76,4 +86,26 @@ double extents::coverage() const // todo: quick and dirty; by right need to take
     return std::pow( roughly_radius / max_radius, 3 );
 }
 
+bool extents::span( double bearing, double elevation, double& begin, double& end ) const // ray-box intersection, point at range r is r * direction
+{
+    const Eigen::Vector3d direction = range_bearing_elevation( 1, bearing * M_PI / 180, elevation ).to_cartesian();
+    begin = 0;
+    end = std::numeric_limits< double >::max();
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        if( comma::math::equal( direction[i], 0 ) )
+        {
+            if( interval.min()[i] > 0 || interval.max()[i] < 0 ) { return false; }
+            continue;
+        }
+        double a = interval.min()[i] / direction[i];
+        double b = interval.max()[i] / direction[i];
+        if( a > b ) { std::swap( a, b ); }
+        if( a > begin ) { begin = a; }
+        if( b < end ) { end = b; }
+        if( begin > end ) { return false; }
+    }
+    return true;
+}
+
 } } } // namespace snark {  namespace velodyne { namespace thin {
@@ -44,6 +44,9 @@ struct region
     virtual ~region() {}
     virtual bool has( double range, double bearing, double elevation ) const = 0;
     virtual double coverage() const = 0;
+    /// range interval [begin, end] along the ray of given bearing and elevation, for which has() is true
+    /// @return false, if the ray does not intersect the region
+    virtual bool span( double bearing, double elevation, double& begin, double& end ) const = 0;
 };
 
 /// sector, quick and dirty
@@ -53,6 +56,7 @@ struct sector : public region
     sector( double bearing, double ken, double range = 0 );
     bool has( double range, double bearing, double ) const;
     double coverage() const;
+    bool span( double bearing, double, double& begin, double& end ) const;
     comma::math::cyclic< double > bearing;
     double ken;
     double range;
@@ -66,6 +70,7 @@ struct extents : public region
     extents( const math::closed_interval< double, 3 >& interval );
     bool has( double range, double bearing, double elevation ) const;
     double coverage() const;
+    bool span( double bearing, double elevation, double& begin, double& end ) const;
     math::closed_interval< double, 3 > interval;
 };
 
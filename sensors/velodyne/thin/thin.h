@@ -87,7 +87,7 @@ void thin( velodyne::packet& packet, const focus& focus, const velodyne::db& db,
     {
         for( unsigned int laser = 0; laser < packet.blocks[block].lasers.size(); ++laser )
         {
-            velodyne::laser_return r = impl::get_laser_return( packet, block, laser, boost::posix_time::not_a_date_time, angularSpeed );
+            velodyne::laser_return r = impl::get_laser_return( packet, block, laser, velodyne::invalid_time, angularSpeed );
             double azimuth = db.lasers[r.id].azimuth( r.azimuth );
             double range = db.lasers[r.id].range( r.range );
             if( !focus.has( range, azimuth, db.lasers[r.id].elevation, random ) ) { packet.blocks[block].lasers[laser].range = 0; }
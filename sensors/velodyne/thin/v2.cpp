@@ -0,0 +1,243 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <string.h>
+#include <boost/array.hpp>
+#include <comma/base/exception.h>
+#include "./v2.h"
+
+namespace snark {  namespace velodyne { namespace thin { namespace v2 {
+
+namespace {
+
+class bit_writer // least significant bits first
+{
+    public:
+        bit_writer( char* buf ) : buf_( buf ), value_( 0 ), size_( 0 ) {}
+
+        void put( comma::uint32 value, unsigned int size ) // size <= 32, value < 2^size
+        {
+            value_ |= comma::uint64( value ) << size_;
+            size_ += size;
+            while( size_ >= 8 ) { *buf_++ = static_cast< char >( value_ & 0xff ); value_ >>= 8; size_ -= 8; }
+        }
+
+        char* flush()
+        {
+            if( size_ > 0 ) { *buf_++ = static_cast< char >( value_ & 0xff ); }
+            value_ = 0;
+            size_ = 0;
+            return buf_;
+        }
+
+    private:
+        char* buf_;
+        comma::uint64 value_;
+        unsigned int size_;
+};
+
+class bit_reader
+{
+    public:
+        bit_reader( const char* buf ) : buf_( reinterpret_cast< const unsigned char* >( buf ) ), value_( 0 ), size_( 0 ) {}
+
+        comma::uint32 get( unsigned int size ) // size <= 32
+        {
+            while( size_ < size ) { value_ |= comma::uint64( *buf_++ ) << size_; size_ += 8; }
+            comma::uint32 v = static_cast< comma::uint32 >( value_ & ( ( comma::uint64( 1 ) << size ) - 1 ) );
+            value_ >>= size;
+            size_ -= size;
+            return v;
+        }
+
+    private:
+        const unsigned char* buf_;
+        comma::uint64 value_;
+        unsigned int size_;
+};
+
+enum { escape = 20, escape_size = 17 }; // values with unary part not less than escape are written in escape_size bits
+
+/// adaptive golomb-rice code, parameter estimated from running mean of coded values (as in LOCO-I)
+class rice
+{
+    public:
+        rice( comma::uint32 mean = 64 ) : sum_( mean ), count_( 1 ) {}
+
+        void put( bit_writer& w, comma::uint32 v )
+        {
+            unsigned int k = this->k();
+            comma::uint32 q = v >> k;
+            if( q < escape ) { w.put( ( comma::uint32( 1 ) << q ) - 1, q + 1 ); w.put( v & ( ( comma::uint32( 1 ) << k ) - 1 ), k ); }
+            else { w.put( ( comma::uint32( 1 ) << escape ) - 1, escape ); w.put( v, escape_size ); }
+            update( v );
+        }
+
+        comma::uint32 get( bit_reader& r )
+        {
+            unsigned int k = this->k();
+            comma::uint32 q = 0;
+            while( q < escape && r.get( 1 ) ) { ++q; }
+            comma::uint32 v = q < escape ? ( q << k ) | r.get( k ) : r.get( escape_size );
+            update( v );
+            return v;
+        }
+
+    private:
+        comma::uint32 sum_;
+        comma::uint32 count_;
+        unsigned int k() const { unsigned int k = 0; while( ( count_ << k ) < sum_ && k < 16 ) { ++k; } return k; }
+        void update( comma::uint32 v ) { sum_ += v; if( ++count_ == 32 ) { sum_ >>= 1; count_ >>= 1; } }
+};
+
+inline comma::uint32 zigzag( comma::int32 v ) { return ( comma::uint32( v ) << 1 ) ^ comma::uint32( v >> 31 ); }
+
+inline comma::int32 unzigzag( comma::uint32 v ) { return comma::int32( v >> 1 ) ^ -comma::int32( v & 1 ); }
+
+inline comma::int32 rotation_delta( comma::int32 rotation, comma::int32 previous )
+{
+    comma::int32 d = rotation - previous;
+    if( d > 18000 ) { d -= 36000; } else if( d < -18000 ) { d += 36000; }
+    return d;
+}
+
+inline comma::int32 add_rotation( comma::int32 previous, comma::int32 delta )
+{
+    comma::int32 r = previous + delta;
+    if( r < 0 ) { r += 36000; } else if( r >= 36000 ) { r -= 36000; }
+    return r;
+}
+
+enum { scan_size = sizeof( comma::uint32 ), header_size = empty_size };
+
+} // namespace {
+
+std::size_t serialize( const velodyne::packet& packet, char* buf, comma::uint32 scan, unsigned int intensity_bits )
+{
+    if( intensity_bits > max_intensity_bits ) { COMMA_THROW( comma::exception, "expected intensity bits not greater than " << max_intensity_bits << ", got " << intensity_bits ); }
+    ::memcpy( buf, &scan, scan_size );
+    buf[ scan_size ] = static_cast< char >( intensity_bits );
+    char& pairs = buf[ scan_size + 1 ];
+    pairs = 0;
+    bit_writer w( buf + header_size );
+    rice rotations( 256 );
+    rice along_laser;
+    rice across_lasers( 1024 );
+    boost::array< comma::uint16, 64 > last;
+    last.assign( 0 );
+    comma::int32 previous_rotation = -1;
+    for( unsigned int p = 0; p < 6; ++p )
+    {
+        const velodyne::packet::laser_block& upper = packet.blocks[ p * 2 ];
+        const velodyne::packet::laser_block& lower = packet.blocks[ p * 2 + 1 ];
+        comma::uint32 masks[2] = { 0, 0 };
+        for( unsigned int i = 0; i < 32; ++i )
+        {
+            if( upper.lasers[i].range() != 0 ) { masks[0] |= comma::uint32( 1 ) << i; }
+            if( lower.lasers[i].range() != 0 ) { masks[1] |= comma::uint32( 1 ) << i; }
+        }
+        if( masks[0] == 0 && masks[1] == 0 ) { continue; }
+        pairs |= 1 << p;
+        comma::int32 rotation = upper.rotation();
+        if( previous_rotation < 0 ) { w.put( rotation, 16 ); }
+        else
+        {
+            comma::int32 d = rotation_delta( rotation, previous_rotation );
+            bool delta = previous_rotation < 36000 && rotation < 36000; // quick and dirty: invalid rotations get written as is
+            w.put( delta ? 0 : 1, 1 );
+            if( delta ) { rotations.put( w, zigzag( d ) ); } else { w.put( rotation, 16 ); }
+        }
+        previous_rotation = rotation;
+        bool full = masks[0] == 0xffffffff && masks[1] == 0xffffffff;
+        w.put( full ? 1 : 0, 1 );
+        if( !full ) { w.put( masks[0], 32 ); w.put( masks[1], 32 ); }
+        comma::int32 previous = 0;
+        for( unsigned int id = 0; id < 64; ++id )
+        {
+            const velodyne::packet::laser_return& r = id < 32 ? upper.lasers[id] : lower.lasers[ id - 32 ];
+            comma::uint16 range = r.range();
+            if( range == 0 ) { continue; }
+            if( last[id] == 0 ) { across_lasers.put( w, zigzag( comma::int32( range ) - previous ) ); }
+            else { along_laser.put( w, zigzag( comma::int32( range ) - last[id] ) ); }
+            last[id] = range;
+            previous = range;
+            if( intensity_bits > 0 ) { w.put( r.intensity() >> ( 8 - intensity_bits ), intensity_bits ); }
+        }
+    }
+    return w.flush() - ( buf + header_size ) + header_size;
+}
+
+comma::uint32 deserialize( velodyne::packet& packet, const char* buf )
+{
+    ::memset( &packet, 0, velodyne::packet::size );
+    comma::uint32 scan;
+    ::memcpy( &scan, buf, scan_size );
+    unsigned int intensity_bits = static_cast< unsigned char >( buf[ scan_size ] );
+    if( intensity_bits > max_intensity_bits ) { COMMA_THROW( comma::exception, "expected intensity bits not greater than " << max_intensity_bits << ", got " << intensity_bits ); }
+    unsigned char intensity_offset = intensity_bits == 0 || intensity_bits == 8 ? 0 : 1 << ( 7 - intensity_bits ); // middle of quantisation step
+    unsigned char pairs = static_cast< unsigned char >( buf[ scan_size + 1 ] );
+    bit_reader r( buf + header_size );
+    rice rotations( 256 );
+    rice along_laser;
+    rice across_lasers( 1024 );
+    boost::array< comma::uint16, 64 > last;
+    last.assign( 0 );
+    comma::int32 previous_rotation = -1;
+    for( unsigned int p = 0; p < 6; ++p )
+    {
+        if( !( pairs & ( 1 << p ) ) ) { continue; }
+        velodyne::packet::laser_block& upper = packet.blocks[ p * 2 ];
+        velodyne::packet::laser_block& lower = packet.blocks[ p * 2 + 1 ];
+        upper.id = velodyne::packet::upper_block_id();
+        lower.id = velodyne::packet::lower_block_id();
+        comma::int32 rotation;
+        if( previous_rotation < 0 || r.get( 1 ) ) { rotation = r.get( 16 ); }
+        else { rotation = add_rotation( previous_rotation, unzigzag( rotations.get( r ) ) ); }
+        upper.rotation = rotation;
+        lower.rotation = rotation;
+        previous_rotation = rotation;
+        comma::uint32 masks[2] = { 0xffffffff, 0xffffffff };
+        if( !r.get( 1 ) ) { masks[0] = r.get( 32 ); masks[1] = r.get( 32 ); }
+        comma::int32 previous = 0;
+        for( unsigned int id = 0; id < 64; ++id )
+        {
+            if( !( masks[ id >> 5 ] & ( comma::uint32( 1 ) << ( id & 31 ) ) ) ) { continue; }
+            velodyne::packet::laser_return& l = id < 32 ? upper.lasers[id] : lower.lasers[ id - 32 ];
+            comma::int32 range = last[id] == 0 ? previous + unzigzag( across_lasers.get( r ) ) : last[id] + unzigzag( along_laser.get( r ) );
+            l.range = range;
+            last[id] = range;
+            previous = range;
+            if( intensity_bits > 0 ) { l.intensity = static_cast< unsigned char >( ( r.get( intensity_bits ) << ( 8 - intensity_bits ) ) | intensity_offset ); }
+        }
+    }
+    return scan;
+}
+
+} } } } // namespace snark {  namespace velodyne { namespace thin { namespace v2 {
@@ -0,0 +1,76 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_THIN_V2_H_
+#define SNARK_SENSORS_VELODYNE_THIN_V2_H_
+
+#include <stdlib.h>
+#include <comma/base/types.h>
+#include <snark/sensors/velodyne/packet.h>
+
+namespace snark {  namespace velodyne { namespace thin { namespace v2 {
+
+/// thin format v2: compressed thinned packet
+///
+/// each pair of upper and lower blocks (a firing) that has any returns is coded as
+///     - block rotation: delta from the previous firing
+///     - 64-bit mask of laser returns, unless all lasers have returns
+///     - ranges: each range predicted from the range of the same laser in the previous firing,
+///       or, if none, from the previous range in the same firing
+///     - optionally, intensity quantised to given number of bits
+/// prediction residuals are coded with adaptive Golomb-Rice codes
+///
+/// each packet is coded independently, thus the stream can be read from any record
+/// as v1, v2 does not keep the packet status bytes
+
+/// flag set in the size field of a thin record, if the record is in v2 format
+enum { record_flag = 0x8000 };
+
+/// size of serialized packet without returns
+enum { empty_size = 4 + 2 };
+
+/// max intensity bits
+enum { max_intensity_bits = 8 };
+
+/// max buffer size
+enum { maxBufferSize = 4 + 2 + 12 / 2 * ( ( 37 + 65 + 64 * ( 37 + max_intensity_bits ) ) / 8 + 1 ) + 8 };
+
+/// write packet to buffer
+/// @param intensity_bits number of most significant intensity bits to keep, 0 to drop intensity as v1 does
+/// @return number of bytes written
+std::size_t serialize( const velodyne::packet& packet, char* buf, comma::uint32 scan, unsigned int intensity_bits = 0 );
+
+/// refill given packet from buffer
+/// @return scan id
+comma::uint32 deserialize( velodyne::packet& packet, const char* buf );
+
+} } } } // namespace snark {  namespace velodyne { namespace thin { namespace v2 {
+
+#endif // SNARK_SENSORS_VELODYNE_THIN_V2_H_
@@ -0,0 +1,69 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_SENSORS_VELODYNE_TIME_H_
+#define SNARK_SENSORS_VELODYNE_TIME_H_
+
+#include <limits>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <comma/base/types.h>
+#include <snark/timing/time.h>
+
+namespace snark {  namespace velodyne {
+
+/// timestamps in the velodyne stream path are nanoseconds from snark::timing::epoch;
+/// they are converted to ptime only on output, since ptime arithmetic per return is expensive
+
+/// nanoseconds value for not_a_date_time
+static const comma::int64 invalid_time = std::numeric_limits< comma::int64 >::min();
+
+/// convert ptime to nanoseconds from epoch
+inline comma::int64 to_nanoseconds( const boost::posix_time::ptime& t )
+{
+    static const boost::posix_time::ptime epoch( timing::epoch );
+    return t.is_special() ? invalid_time : ( t - epoch ).total_microseconds() * 1000;
+}
+
+/// convert seconds and nanoseconds from epoch to nanoseconds from epoch
+inline comma::int64 to_nanoseconds( comma::int64 seconds, comma::int64 nanoseconds ) { return seconds * 1000000000LL + nanoseconds; }
+
+/// convert nanoseconds from epoch to ptime, truncating to microseconds
+inline boost::posix_time::ptime to_ptime( comma::int64 nanoseconds )
+{
+    static const boost::posix_time::ptime epoch( timing::epoch );
+    if( nanoseconds == invalid_time ) { return boost::posix_time::not_a_date_time; }
+    comma::int64 microseconds = nanoseconds >= 0 ? nanoseconds / 1000 : -( ( -nanoseconds + 999 ) / 1000 );
+    comma::int64 seconds = microseconds >= 0 ? microseconds / 1000000 : -( ( -microseconds + 999999 ) / 1000000 );
+    return epoch + boost::posix_time::seconds( static_cast< long >( seconds ) ) + boost::posix_time::microseconds( microseconds - seconds * 1000000 ); // seconds first: microseconds from epoch overflow long on 32-bit systems
+}
+
+} } // namespace snark {  namespace velodyne {
+
+#endif // SNARK_SENSORS_VELODYNE_TIME_H_